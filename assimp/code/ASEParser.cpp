@@ -2115,7 +2115,10 @@ void Parser::ParseLV4MeshFloatTriple(float* apOut)
 {
 	ai_assert(NULL != apOut);
 
-	for (unsigned int i = 0; i < 3;++i)
+	// parse the run at once, and the rest (if any) one by one to report errors
+	unsigned int i;
+	filePtr = fast_atoreal_run<float>(filePtr,apOut,3,i);
+	for (;i < 3;++i)
 		ParseLV4MeshFloat(apOut[i]);
 }
 // ------------------------------------------------------------------------------------------------
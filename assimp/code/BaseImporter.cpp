@@ -46,6 +46,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "AssimpPCH.h"
 #include "BaseImporter.h"
 #include "FileSystemFilter.h"
+#include "MMapIOSystem.h"
 
 #include "Importer.h"
 
@@ -402,6 +403,43 @@ void BaseImporter::TextFileToBuffer(IOStream* stream,
 	data.push_back(0);
 }
 
+// ------------------------------------------------------------------------------------------------
+void BaseImporter::TextFileToRange(IOStream* stream,
+	std::vector<char>& data,
+	const char*& begin,
+	const char*& end)
+{
+	ai_assert(NULL != stream);
+
+	const MMapIOStream* mapped = dynamic_cast<const MMapIOStream*>(stream);
+	if(mapped && mapped->IsZeroTerminated() && mapped->FileSize() >= 8) {
+		const char* text = mapped->Data();
+
+		uint32_t bom32;
+		uint16_t bom16;
+		::memcpy(&bom32,text,sizeof(bom32));
+		::memcpy(&bom16,text,sizeof(bom16));
+
+		// UTF 16 and UTF 32 need to be converted, which copies (see ConvertToUTF8)
+		if(bom32 != 0xFFFE0000 && bom32 != 0x0000FFFE && bom16 != 0xFFFE && bom16 != 0xFEFF) {
+			begin = text;
+			end = text + mapped->FileSize() + 1;
+
+			// UTF 8 with BOM
+			if((uint8_t)text[0] == 0xEF && (uint8_t)text[1] == 0xBB && (uint8_t)text[2] == 0xBF) {
+				DefaultLogger::get()->debug("Found UTF-8 BOM ...");
+				begin += 3;
+			}
+			data.clear();
+			return;
+		}
+	}
+
+	TextFileToBuffer(stream,data);
+	begin = &data.front();
+	end = &data.back() + 1;
+}
+
 // ------------------------------------------------------------------------------------------------
 namespace Assimp
 {
@@ -343,6 +343,23 @@ public: // static utilities
 		IOStream* stream,
 		std::vector<char>& data);
 
+	// -------------------------------------------------------------------
+	/** Zero-copy variant of TextFileToBuffer for loaders that parse
+	 *  in place. If the stream is memory mapped (see MMapIOSystem) and
+	 *  holds zero terminated ASCII or UTF8 text, the range points into
+	 *  the mapping. Otherwise the text is copied into data, exactly as
+	 *  TextFileToBuffer does, and the range points into data.
+	 *  @param stream Stream to read from, must outlive the range.
+	 *  @param data Fallback buffer, must outlive the range.
+	 *  @param begin Receives the start of the text.
+	 *  @param end Receives the end of the text, which includes the
+	 *   terminating binary 0 (as with TextFileToBuffer). */
+	static void TextFileToRange(
+		IOStream* stream,
+		std::vector<char>& data,
+		const char*& begin,
+		const char*& end);
+
 protected:
 
 	/** Error description in case there was one. */
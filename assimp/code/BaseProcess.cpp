@@ -54,6 +54,7 @@ using namespace Assimp;
 BaseProcess::BaseProcess()
 : shared()
 , progress()
+, numThreads(0)
 {
 }
 
@@ -72,6 +73,7 @@ void BaseProcess::ExecuteOnScene( Importer* pImp)
 	progress = pImp->GetProgressHandler();
 	ai_assert(progress);
 
+	numThreads = pImp->GetPropertyInteger(AI_CONFIG_GLOB_MULTITHREADING,-1);
 	SetupProperties( pImp );
 
 	// catch exceptions thrown inside the PostProcess-Step
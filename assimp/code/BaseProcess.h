@@ -43,11 +43,19 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define INCLUDED_AI_BASEPROCESS_H
 
 #include <map>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#	include <omp.h>
+#endif
 
 #include "../include/assimp/types.h"
 #include "GenericProperty.h"
+#include "Exceptional.h"
 
 struct aiScene;
+struct aiMesh;
 
 namespace Assimp	{
 
@@ -279,6 +287,56 @@ public:
 		return shared;
 	}
 
+protected:
+
+	// -------------------------------------------------------------------
+	/** Calls a per-mesh member function of the step for all meshes,
+	 *  on up to #numThreads threads. Meshes are handed out one at a time,
+	 *  so a few large meshes don't keep the other threads idle.
+	 *
+	 *  The result for each mesh is stored at its index, callers reduce
+	 *  them in mesh order, thus the outcome is the same for any number
+	 *  of threads. The per-mesh function must not touch other meshes or
+	 *  modify members of the step. If any mesh fails, the error of the
+	 *  mesh with the lowest index is thrown once all meshes are done.
+	 *  @param meshes Meshes to process, usually aiScene::mMeshes
+	 *  @param numMeshes Number of meshes
+	 *  @param fn Member function, called with the mesh and its index
+	 *  @param results Receives one result per mesh. Must not be a
+	 *    std::vector<bool>, which can't be written concurrently. */
+	template <typename Step, typename Result, typename Stored>
+	void ExecutePerMesh(aiMesh** meshes, unsigned int numMeshes,
+		Result (Step::*fn)(aiMesh*, unsigned int),
+		std::vector<Stored>& results)
+	{
+		Step* const step = static_cast<Step*>(this);
+		const int num = static_cast<int>(numMeshes);
+
+		results.resize(numMeshes);
+		std::vector<std::string> errors(numMeshes);
+		std::vector<unsigned char> failed(numMeshes,0);
+
+#ifdef _OPENMP
+		const int threads = numThreads < 0 ? omp_get_max_threads() : (numThreads > 0 ? numThreads : 1);
+		#pragma omp parallel for schedule(dynamic,1) num_threads(threads) if(threads > 1 && num > 1)
+#endif
+		for (int i = 0; i < num; ++i)	{
+			try	{
+				results[i] = (step->*fn)(meshes[i],static_cast<unsigned int>(i));
+			}
+			catch (const std::exception& err)	{
+				errors[i] = err.what();
+				failed[i] = 1;
+			}
+		}
+
+		for (unsigned int i = 0; i < numMeshes; ++i)	{
+			if (failed[i])	{
+				throw DeadlyImportError(errors[i]);
+			}
+		}
+	}
+
 protected:
 
 	/** See the doc of #SharedPostProcessInfo for more details */
@@ -286,6 +344,10 @@ protected:
 
 	/** Currently active progress handler */
 	ProgressHandler* progress;
+
+	/** Number of threads for per-mesh work, see #AI_CONFIG_GLOB_MULTITHREADING.
+	 *  -1 uses all cores, 0 and 1 process all meshes on the calling thread. */
+	int numThreads;
 };
 
 
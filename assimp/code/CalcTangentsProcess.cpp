@@ -91,9 +91,12 @@ void CalcTangentsProcess::Execute( aiScene* pScene)
 {
 	DefaultLogger::get()->debug("CalcTangentsProcess begin");
 
+	std::vector<unsigned char> calculated;
+	ExecutePerMesh(pScene->mMeshes,pScene->mNumMeshes,&CalcTangentsProcess::ProcessMesh,calculated);
+
 	bool bHas = false;
 	for( unsigned int a = 0; a < pScene->mNumMeshes; a++)
-		if(ProcessMesh( pScene->mMeshes[a],a))bHas = true;
+		if(calculated[a])bHas = true;
 
 	if (bHas)DefaultLogger::get()->info("CalcTangentsProcess finished. Tangents have been calculated");
 	else DefaultLogger::get()->debug("CalcTangentsProcess finished");
@@ -1683,17 +1683,23 @@ void ColladaParser::ReadDataArray()
 			}
 		} else
 		{
-			data.mValues.reserve( count);
+			data.mValues.resize( count);
 
-			for( unsigned int a = 0; a < count; a++)
+			// read runs of numbers at once, stops at anything that is not a number
+			unsigned int a = 0;
+			if( count > 0)
+			{
+				content = fast_atoreal_run<float>( content, &data.mValues[0], count, a, true);
+				SkipSpacesAndLineEnd( &content);
+			}
+
+			for( ; a < count; a++)
 			{
 				if( *content == 0)
 					ThrowException( "Expected more values while reading float_array contents.");
 
-				float value;
 				// read a number
-				content = fast_atoreal_move<float>( content, value);
-				data.mValues.push_back( value);
+				content = fast_atoreal_move<float>( content, data.mValues[a]);
 				// skip whitespace after it
 				SkipSpacesAndLineEnd( &content);
 			}
@@ -376,33 +376,41 @@ void DefaultLogger::WriteToStreams(const char *message,
 {
 	ai_assert(NULL != message);
 
-	// Check whether this is a repeated message
-	if (! ::strncmp( message,lastMsg, lastLen-1))
+	// Postprocessing steps may log from several threads (OpenMP), the
+	// repeated message check and the streams need to be guarded.
+#ifdef _OPENMP
+#	pragma omp critical(aiDefaultLoggerStreams)
+#endif
 	{
-		if (!noRepeatMsg)
+		// Check whether this is a repeated message
+		if (! ::strncmp( message,lastMsg, lastLen-1))
 		{
-			noRepeatMsg = true;
-			message = "Skipping one or more lines with the same contents\n";
+			if (!noRepeatMsg)
+			{
+				noRepeatMsg = true;
+				message = "Skipping one or more lines with the same contents\n";
+			}
+			// no return, which would leave the critical section
+			else message = NULL;
+		}
+		else
+		{
+			// append a new-line character to the message to be printed
+			lastLen = ::strlen(message);
+			::memcpy(lastMsg,message,lastLen+1);
+			::strcat(lastMsg+lastLen,"\n");
+
+			message = lastMsg;
+			noRepeatMsg = false;
+			++lastLen;
+		}
+		for ( ConstStreamIt it = m_StreamArray.begin();
+			message && it != m_StreamArray.end();
+			++it)
+		{
+			if ( ErrorSev & (*it)->m_uiErrorSeverity )
+				(*it)->m_pStream->write( message);
 		}
-		else return;
-	}
-	else
-	{
-		// append a new-line character to the message to be printed
-		lastLen = ::strlen(message);
-		::memcpy(lastMsg,message,lastLen+1);
-		::strcat(lastMsg+lastLen,"\n");
-
-		message = lastMsg;
-		noRepeatMsg = false;
-		++lastLen;
-	}
-	for ( ConstStreamIt it = m_StreamArray.begin();
-		it != m_StreamArray.end();
-		++it)
-	{
-		if ( ErrorSev & (*it)->m_uiErrorSeverity )
-			(*it)->m_pStream->write( message);
 	}
 }
 
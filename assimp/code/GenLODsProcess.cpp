@@ -0,0 +1,840 @@
+/*
+---------------------------------------------------------------------------
+Open Asset Import Library (assimp)
+---------------------------------------------------------------------------
+
+Copyright (c) 2006-2012, assimp team
+
+All rights reserved.
+
+Redistribution and use of this software in source and binary forms, 
+with or without modification, are permitted provided that the following 
+conditions are met:
+
+* Redistributions of source code must retain the above
+  copyright notice, this list of conditions and the
+  following disclaimer.
+
+* Redistributions in binary form must reproduce the above
+  copyright notice, this list of conditions and the
+  following disclaimer in the documentation and/or other
+  materials provided with the distribution.
+
+* Neither the name of the assimp team, nor the names of its
+  contributors may be used to endorse or promote products
+  derived from this software without specific prior
+  written permission of the assimp team.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+---------------------------------------------------------------------------
+*/
+
+/** @file Implementation of the post processing step to generate simplified
+ * levels of detail.
+ * <br>
+ * The simplification follows Garland and Heckbert, 'Surface Simplification
+ * Using Quadric Error Metrics' (1997), restricted to half-edge collapses so
+ * that the levels can share the vertices of the mesh. Instead of updating a
+ * priority queue after each collapse, the collapses are performed in passes:
+ * all candidates are ranked by their error and the best ones whose 
+ * neighbourhoods don't overlap are performed at once. Collapses which break
+ * the link condition (Dey et al., 'Topology Preserving Edge Contraction', 1999)
+ * or fold faces over are rejected.
+ */
+
+#include "AssimpPCH.h"
+#ifndef ASSIMP_BUILD_NO_GENLODS_PROCESS
+
+// internal headers
+#include "GenLODsProcess.h"
+#include "ProcessHelper.h"
+
+using namespace Assimp;
+
+namespace {
+
+	// Levels aren't simplified below this number of faces
+	const unsigned int MinFaces = 8;
+
+	// Maximum number of collapse passes per level
+	const unsigned int MaxPasses = 64;
+
+	// Cosine of the largest rotation of a face by a collapse
+	const float MaxRotation = 0.25f;
+
+	// Weight of the planes which keep borders and seams in place, 
+	// relative to the planes of the faces
+	const double BorderWeight = 10.0;
+
+	// --------------------------------------------------------------------------------------------
+	// Vertices are collapsed only along edges which keep the topology of the mesh
+	enum VertexKind
+	{
+		// all edges are shared by two faces, collapses onto any neighbour
+		Kind_Manifold,
+
+		// on an open border, collapses along the border only
+		Kind_Border,
+
+		// split into exactly two vertices by different normals or texture
+		// coordinates, both collapse along the seam only
+		Kind_Seam,
+
+		// anything else (e.g., corners, non-manifold vertices) stays in place
+		Kind_Locked
+	};
+
+	// --------------------------------------------------------------------------------------------
+	// Weighted sum of the squared distances to a set of planes
+	struct Quadric
+	{
+		Quadric() : a00(), a11(), a22(), a10(), a20(), a21(), b0(), b1(), b2(), c(), w() {}
+
+		void AddPlane(const aiVector3D& n, float d, double weight) {
+			a00 += weight*n.x*n.x; a11 += weight*n.y*n.y; a22 += weight*n.z*n.z;
+			a10 += weight*n.y*n.x; a20 += weight*n.z*n.x; a21 += weight*n.z*n.y;
+			b0  += weight*n.x*d;   b1  += weight*n.y*d;   b2  += weight*n.z*d;
+			c   += weight*d*d;
+			w   += weight;
+		}
+
+		const Quadric& operator += (const Quadric& o) {
+			a00 += o.a00; a11 += o.a11; a22 += o.a22;
+			a10 += o.a10; a20 += o.a20; a21 += o.a21;
+			b0  += o.b0;  b1  += o.b1;  b2  += o.b2;
+			c   += o.c;
+			w   += o.w;
+			return *this;
+		}
+
+		// weighted mean of the squared distances of p to the planes
+		double Error(const aiVector3D& p) const {
+			const double x = p.x, y = p.y, z = p.z;
+			const double r = a00*x*x + a11*y*y + a22*z*z
+				+ 2.0 * (a10*x*y + a20*x*z + a21*y*z)
+				+ 2.0 * (b0*x + b1*y + b2*z) + c;
+			return w > 0.0 ? std::fabs(r) / w : 0.0;
+		}
+
+		double a00, a11, a22, a10, a20, a21;
+		double b0, b1, b2, c;
+		double w;
+	};
+
+	// --------------------------------------------------------------------------------------------
+	// Candidate collapse of vertex v onto its neighbour u
+	struct Collapse
+	{
+		unsigned int v, u;
+		float error;
+
+		bool operator < (const Collapse& o) const {
+			if (error != o.error) {
+				return error < o.error;
+			}
+			return v != o.v ? v < o.v : u < o.u;
+		}
+	};
+
+	// --------------------------------------------------------------------------------------------
+	// Orders vertex indices by their positions, equal positions by index
+	struct PositionLess
+	{
+		explicit PositionLess(const aiVector3D* p) : positions(p) {}
+
+		bool operator () (unsigned int a, unsigned int b) const {
+			const aiVector3D& pa = positions[a];
+			const aiVector3D& pb = positions[b];
+			if (pa.x != pb.x) return pa.x < pb.x;
+			if (pa.y != pb.y) return pa.y < pb.y;
+			if (pa.z != pb.z) return pa.z < pb.z;
+			return a < b;
+		}
+
+		const aiVector3D* positions;
+	};
+
+	// --------------------------------------------------------------------------------------------
+	// Simplifies the triangles of a mesh step by step, each call to Simplify() continues
+	// with the result of the previous one. Vertices at the same position (split by other 
+	// components) are treated as one, their quadrics are stored with the first of them.
+	class Simplifier
+	{
+	public:
+		explicit Simplifier(const aiMesh* mesh);
+
+		// Simplifies the triangles to the target number of faces or less, unless no
+		// collapse within the error limit (squared) is left. Returns the largest
+		// squared error of all collapses so far.
+		double Simplify(unsigned int target, double errorLimit);
+
+		// the current triangles, three indices each
+		std::vector<unsigned int> indices;
+
+	private:
+		void BuildAdjacency();
+		void Classify();
+		void ComputeQuadrics();
+
+		bool CanCollapse(unsigned int v, unsigned int u, unsigned int& v2, unsigned int& u2) const;
+
+		// number of faces removed by collapsing all vertices at v's position onto
+		// u's position, or UINT_MAX if that would break the link condition or 
+		// flip any of the remaining faces
+		unsigned int CheckCollapse(unsigned int v, unsigned int u) const;
+
+		// whether the positions adjacent to both v's and u's position are just the
+		// ones opposite to their edge, i.e., the collapse keeps the mesh manifold
+		bool CheckLink(unsigned int v, unsigned int u) const;
+
+		unsigned int NumTriangles(unsigned int v) const {
+			return triOffsets[v+1] - triOffsets[v];
+		}
+
+		// the vertex following v in triangle t
+		unsigned int Next(unsigned int t, unsigned int v) const {
+			const unsigned int* tri = &indices[t*3];
+			return tri[0] == v ? tri[1] : (tri[1] == v ? tri[2] : tri[0]);
+		}
+
+		// number of triangles with the edge a -> b
+		unsigned int CountEdges(unsigned int a, unsigned int b) const;
+
+		// whether a triangle has an edge from a's to b's position
+		bool HasPositionEdge(unsigned int a, unsigned int b) const;
+
+	private:
+		const aiVector3D* positions;
+		const unsigned int numVertices;
+
+		std::vector<unsigned int> remap;  // first vertex at the same position
+		std::vector<unsigned int> wedge;  // next vertex at the same position (circular)
+		std::vector<Quadric> quadrics;    // by remap
+		std::vector<aiVector3D> normals;  // area weighted normals of the input, by remap
+
+		// triangles of each vertex, rebuilt by each pass
+		std::vector<unsigned int> triOffsets, vertexTris;
+
+		// kinds by remap, open edges (without an opposite edge) by vertex
+		std::vector<unsigned char> kind;
+		std::vector<unsigned int> openOut, openIn, openNext, openPrev;
+		std::vector<unsigned int> seamPair;
+		std::vector<unsigned char> complex;
+
+		double maxError;
+	};
+
+	// --------------------------------------------------------------------------------------------
+	Simplifier::Simplifier(const aiMesh* mesh)
+		: positions(mesh->mVertices)
+		, numVertices(mesh->mNumVertices)
+		, remap(mesh->mNumVertices)
+		, wedge(mesh->mNumVertices)
+		, maxError()
+	{
+		std::vector<unsigned int> order(numVertices);
+		for (unsigned int i = 0; i < numVertices; ++i) {
+			order[i] = i;
+		}
+		std::sort(order.begin(),order.end(),PositionLess(positions));
+
+		for (unsigned int i = 0; i < numVertices;) {
+			unsigned int end = i+1;
+			while (end < numVertices && positions[order[end]] == positions[order[i]]) {
+				++end;
+			}
+			for (unsigned int k = i; k < end; ++k) {
+				remap[order[k]] = order[i];
+				wedge[order[k]] = order[k+1 < end ? k+1 : i];
+			}
+			i = end;
+		}
+
+		// faces which are degenerate already are dropped
+		indices.reserve(mesh->mNumFaces*3);
+		for (unsigned int f = 0; f < mesh->mNumFaces; ++f) {
+			const unsigned int* idx = mesh->mFaces[f].mIndices;
+			if (remap[idx[0]] != remap[idx[1]] && remap[idx[1]] != remap[idx[2]] && remap[idx[2]] != remap[idx[0]]) {
+				indices.insert(indices.end(),idx,idx+3);
+			}
+		}
+
+		BuildAdjacency();
+		ComputeQuadrics();
+	}
+
+	// --------------------------------------------------------------------------------------------
+	void Simplifier::BuildAdjacency()
+	{
+		triOffsets.assign(numVertices+1,0);
+		for (std::vector<unsigned int>::const_iterator it = indices.begin(); it != indices.end(); ++it) {
+			++triOffsets[*it+1];
+		}
+		for (unsigned int v = 0; v < numVertices; ++v) {
+			triOffsets[v+1] += triOffsets[v];
+		}
+
+		std::vector<unsigned int> fill(triOffsets.begin(),triOffsets.end()-1);
+		vertexTris.resize(indices.size());
+		for (unsigned int i = 0; i < indices.size(); ++i) {
+			vertexTris[fill[indices[i]]++] = i/3;
+		}
+	}
+
+	// --------------------------------------------------------------------------------------------
+	unsigned int Simplifier::CountEdges(unsigned int a, unsigned int b) const
+	{
+		unsigned int n = 0;
+		for (unsigned int i = triOffsets[a]; i < triOffsets[a+1]; ++i) {
+			n += Next(vertexTris[i],a) == b;
+		}
+		return n;
+	}
+
+	// --------------------------------------------------------------------------------------------
+	bool Simplifier::HasPositionEdge(unsigned int a, unsigned int b) const
+	{
+		unsigned int w = a;
+		do {
+			for (unsigned int i = triOffsets[w]; i < triOffsets[w+1]; ++i) {
+				if (remap[Next(vertexTris[i],w)] == remap[b]) {
+					return true;
+				}
+			}
+			w = wedge[w];
+		}
+		while (w != a);
+		return false;
+	}
+
+	// --------------------------------------------------------------------------------------------
+	void Simplifier::Classify()
+	{
+		openOut.assign(numVertices,0);
+		openIn.assign(numVertices,0);
+		openNext.assign(numVertices,UINT_MAX);
+		openPrev.assign(numVertices,UINT_MAX);
+		complex.assign(numVertices,0);
+
+		// open edges have no opposite edge between the same vertices, those 
+		// having an opposite edge between other vertices at the same positions
+		// are seams
+		for (unsigned int i = 0; i < indices.size(); ++i) {
+			const unsigned int a = indices[i];
+			const unsigned int b = indices[i % 3 == 2 ? i-2 : i+1];
+
+			if (CountEdges(a,b) > 1) {
+				complex[a] = complex[b] = 1;
+			}
+			if (!CountEdges(b,a)) {
+				++openOut[a];
+				++openIn[b];
+				openNext[a] = b;
+				openPrev[b] = a;
+			}
+		}
+
+		kind.assign(numVertices,Kind_Locked);
+		seamPair.assign(numVertices,UINT_MAX);
+
+		for (unsigned int v = 0; v < numVertices; ++v) {
+			if (remap[v] != v) {
+				continue;
+			}
+
+			unsigned int used[2], numUsed = 0;
+			unsigned int w = v;
+			do {
+				if (NumTriangles(w)) {
+					if (numUsed < 2) {
+						used[numUsed] = w;
+					}
+					++numUsed;
+				}
+				w = wedge[w];
+			}
+			while (w != v);
+
+			if (numUsed == 1) {
+				const unsigned int a = used[0];
+				if (complex[a]) {
+					continue;
+				}
+				if (!openOut[a] && !openIn[a]) {
+					kind[v] = Kind_Manifold;
+				}
+				else if (openOut[a] == 1 && openIn[a] == 1 && 
+					!HasPositionEdge(openNext[a],a) && !HasPositionEdge(a,openPrev[a])) {
+					kind[v] = Kind_Border;
+				}
+			}
+			else if (numUsed == 2) {
+				bool seam = true;
+				for (unsigned int k = 0; k < 2; ++k) {
+					const unsigned int a = used[k];
+					seam = seam && !complex[a] && openOut[a] == 1 && openIn[a] == 1 && 
+						HasPositionEdge(openNext[a],a) && HasPositionEdge(a,openPrev[a]);
+				}
+				if (seam) {
+					kind[v] = Kind_Seam;
+					seamPair[used[0]] = used[1];
+					seamPair[used[1]] = used[0];
+				}
+			}
+		}
+	}
+
+	// --------------------------------------------------------------------------------------------
+	void Simplifier::ComputeQuadrics()
+	{
+		quadrics.assign(numVertices,Quadric());
+		normals.assign(numVertices,aiVector3D());
+
+		for (unsigned int t = 0; t < indices.size() / 3; ++t) {
+			const unsigned int* tri = &indices[t*3];
+			const aiVector3D& p0 = positions[tri[0]];
+
+			aiVector3D n = (positions[tri[1]] - p0) ^ (positions[tri[2]] - p0);
+			const float area = n.Length();
+			if (area <= 0.f) {
+				continue;
+			}
+			for (unsigned int k = 0; k < 3; ++k) {
+				normals[remap[tri[k]]] += n;
+			}
+			n /= area;
+
+			// planes of the faces, weighted by their area
+			for (unsigned int k = 0; k < 3; ++k) {
+				quadrics[remap[tri[k]]].AddPlane(n,-(n*p0),0.5*area);
+			}
+
+			// open edges (borders and seams) get planes perpendicular to the face
+			for (unsigned int k = 0; k < 3; ++k) {
+				const unsigned int a = tri[k], b = tri[(k+1)%3];
+				if (CountEdges(b,a)) {
+					continue;
+				}
+
+				const aiVector3D edge = positions[b] - positions[a];
+				aiVector3D en = edge ^ n;
+				const float length = en.Length();
+				if (length <= 0.f) {
+					continue;
+				}
+				en /= length;
+
+				const float d = -(en*positions[a]);
+				const double weight = BorderWeight * edge.SquareLength();
+				quadrics[remap[a]].AddPlane(en,d,weight);
+				quadrics[remap[b]].AddPlane(en,d,weight);
+			}
+		}
+	}
+
+	// --------------------------------------------------------------------------------------------
+	bool Simplifier::CanCollapse(unsigned int v, unsigned int u, unsigned int& v2, unsigned int& u2) const
+	{
+		v2 = u2 = UINT_MAX;
+
+		switch (kind[remap[v]])
+		{
+		case Kind_Manifold:
+			return true;
+
+		case Kind_Border:
+			return u == openNext[v] || u == openPrev[v];
+
+		case Kind_Seam:
+			// the vertices on the other side of the seam collapse as well,
+			// the seam runs in the opposite direction there
+			if (kind[remap[u]] != Kind_Seam) {
+				return false;
+			}
+			v2 = seamPair[v];
+			if (u == openNext[v]) {
+				u2 = openPrev[v2];
+			}
+			else if (u == openPrev[v]) {
+				u2 = openNext[v2];
+			}
+			else return false;
+			return u2 != UINT_MAX && u2 != u && remap[u2] == remap[u];
+
+		default:
+			return false;
+		};
+	}
+
+	// --------------------------------------------------------------------------------------------
+	bool Simplifier::CheckLink(unsigned int v, unsigned int u) const
+	{
+		const unsigned int pv = remap[v], pu = remap[u];
+		std::vector<unsigned int> ring, opposite;
+
+		unsigned int w = v;
+		do {
+			for (unsigned int i = triOffsets[w]; i < triOffsets[w+1]; ++i) {
+				const unsigned int* tri = &indices[vertexTris[i]*3];
+				const bool edge = remap[tri[0]] == pu || remap[tri[1]] == pu || remap[tri[2]] == pu;
+				for (unsigned int k = 0; k < 3; ++k) {
+					const unsigned int r = remap[tri[k]];
+					if (r == pv || r == pu) {
+						continue;
+					}
+					ring.push_back(r);
+					if (edge) {
+						opposite.push_back(r);
+					}
+				}
+			}
+			w = wedge[w];
+		}
+		while (w != v);
+
+		w = u;
+		do {
+			for (unsigned int i = triOffsets[w]; i < triOffsets[w+1]; ++i) {
+				const unsigned int* tri = &indices[vertexTris[i]*3];
+				for (unsigned int k = 0; k < 3; ++k) {
+					const unsigned int r = remap[tri[k]];
+					if (r != pv && r != pu && std::find(ring.begin(),ring.end(),r) != ring.end() &&
+						std::find(opposite.begin(),opposite.end(),r) == opposite.end()) {
+						return false;
+					}
+				}
+			}
+			w = wedge[w];
+		}
+		while (w != u);
+		return true;
+	}
+
+	// --------------------------------------------------------------------------------------------
+	unsigned int Simplifier::CheckCollapse(unsigned int v, unsigned int u) const
+	{
+		// Otherwise, the collapse would merge edges (which become non-manifold)
+		// or leave two faces on the same vertices
+		if (!CheckLink(v,u)) {
+			return UINT_MAX;
+		}
+
+		const aiVector3D& p = positions[u];
+		unsigned int removed = 0;
+
+		unsigned int w = v;
+		do {
+			for (unsigned int i = triOffsets[w]; i < triOffsets[w+1]; ++i) {
+				const unsigned int* tri = &indices[vertexTris[i]*3];
+				if (remap[tri[0]] == remap[u] || remap[tri[1]] == remap[u] || remap[tri[2]] == remap[u]) {
+					++removed;
+					continue;
+				}
+
+				const unsigned int k = tri[0] == w ? 0 : (tri[1] == w ? 1 : 2);
+				aiVector3D moved[3] = {positions[tri[0]], positions[tri[1]], positions[tri[2]]};
+				const aiVector3D n0 = (moved[1] - moved[0]) ^ (moved[2] - moved[0]);
+				moved[k] = p;
+				const aiVector3D n1 = (moved[1] - moved[0]) ^ (moved[2] - moved[0]);
+
+				// Faces may not rotate by more than about 75 degrees, since a series of
+				// collapses close to 90 degrees flips them as well. Faces which were 
+				// degenerate before are ignored.
+				const float area0 = n0.SquareLength();
+				if (area0 > 0.f && n0*n1 <= MaxRotation * ::sqrt(area0 * n1.SquareLength())) {
+					return UINT_MAX;
+				}
+
+				// Neither may they face away from the input surface at their corners,
+				// which a series of smaller rotations can still lead to
+				aiVector3D reference = normals[remap[u]];
+				for (unsigned int j = 0; j < 3; ++j) {
+					if (j != k) {
+						reference += normals[remap[tri[j]]];
+					}
+				}
+				if (n1*reference <= 0.f) {
+					return UINT_MAX;
+				}
+			}
+			w = wedge[w];
+		}
+		while (w != v);
+		return removed;
+	}
+
+	// --------------------------------------------------------------------------------------------
+	double Simplifier::Simplify(unsigned int target, double errorLimit)
+	{
+		std::vector<Collapse> collapses;
+		std::vector<unsigned int> dest(numVertices);
+		std::vector<unsigned char> locked(numVertices);
+
+		unsigned int numFaces = (unsigned int)indices.size() / 3;
+		for (unsigned int pass = 0; pass < MaxPasses && numFaces > target; ++pass) {
+			BuildAdjacency();
+			Classify();
+
+			// the cheaper direction of each edge (edges shared by two faces are
+			// found twice, which doesn't matter)
+			collapses.clear();
+			for (unsigned int i = 0; i < indices.size(); ++i) {
+				const unsigned int a = indices[i];
+				const unsigned int b = indices[i % 3 == 2 ? i-2 : i+1];
+
+				unsigned int v2, u2;
+				Collapse c;
+				c.error = -1.f;
+				if (CanCollapse(a,b,v2,u2)) {
+					c.v = a;
+					c.u = b;
+					c.error = (float)quadrics[remap[a]].Error(positions[b]);
+				}
+				if (CanCollapse(b,a,v2,u2)) {
+					const float error = (float)quadrics[remap[b]].Error(positions[a]);
+					if (c.error < 0.f || error < c.error) {
+						c.v = b;
+						c.u = a;
+						c.error = error;
+					}
+				}
+				if (c.error >= 0.f && c.error <= errorLimit) {
+					collapses.push_back(c);
+				}
+			}
+			if (collapses.empty()) {
+				break;
+			}
+			std::sort(collapses.begin(),collapses.end());
+
+			// Each collapse removes about two faces. Collapses much worse than
+			// the ones needed to reach the target are left for the next pass,
+			// when the errors are up to date.
+			const unsigned int goal = numFaces - target;
+			const float passLimit = 1.5f * collapses[std::min((size_t)goal/2,collapses.size()-1)].error;
+
+			for (unsigned int v = 0; v < numVertices; ++v) {
+				dest[v] = v;
+			}
+			std::fill(locked.begin(),locked.end(),0);
+
+			unsigned int removed = 0;
+			for (std::vector<Collapse>::const_iterator it = collapses.begin(); it != collapses.end() && removed < goal; ++it) {
+				const Collapse& c = *it;
+				if (c.error > passLimit) {
+					break;
+				}
+
+				// faces around a collapsed vertex change, so their vertices can't 
+				// be collapsed in the same pass
+				const unsigned int pv = remap[c.v], pu = remap[c.u];
+				if (locked[pv] || locked[pu]) {
+					continue;
+				}
+
+				unsigned int v2, u2;
+				CanCollapse(c.v,c.u,v2,u2);
+
+				const unsigned int faces = CheckCollapse(c.v,c.u);
+				if (faces == UINT_MAX) {
+					continue;
+				}
+
+				dest[c.v] = c.u;
+				if (v2 != UINT_MAX) {
+					dest[v2] = u2;
+				}
+				quadrics[pu] += quadrics[pv];
+				maxError = std::max(maxError,(double)c.error);
+				removed += faces;
+
+				unsigned int w = c.v;
+				do {
+					for (unsigned int i = triOffsets[w]; i < triOffsets[w+1]; ++i) {
+						const unsigned int* tri = &indices[vertexTris[i]*3];
+						locked[remap[tri[0]]] = locked[remap[tri[1]]] = locked[remap[tri[2]]] = 1;
+					}
+					w = wedge[w];
+				}
+				while (w != c.v);
+				locked[pu] = 1;
+			}
+			if (!removed) {
+				break;
+			}
+
+			// remove the collapsed faces
+			unsigned int out = 0;
+			for (unsigned int i = 0; i < indices.size(); i += 3) {
+				const unsigned int a = dest[indices[i]], b = dest[indices[i+1]], c = dest[indices[i+2]];
+				if (remap[a] != remap[b] && remap[b] != remap[c] && remap[c] != remap[a]) {
+					indices[out++] = a;
+					indices[out++] = b;
+					indices[out++] = c;
+				}
+			}
+			indices.resize(out);
+			numFaces = out / 3;
+		}
+		return maxError;
+	}
+
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+// Constructor to be privately used by Importer
+GenLODsProcess::GenLODsProcess()
+: configLevels(PP_GLOD_LEVELS)
+, configRatio(PP_GLOD_RATIO)
+, configMaxError(PP_GLOD_MAX_ERROR)
+{
+}
+
+// ------------------------------------------------------------------------------------------------
+// Destructor, private as well
+GenLODsProcess::~GenLODsProcess()
+{
+	// nothing to do here
+}
+
+// ------------------------------------------------------------------------------------------------
+// Returns whether the processing step is present in the given flag field.
+bool GenLODsProcess::IsActive( unsigned int pFlags) const
+{
+	return (pFlags & aiProcess_GenLODs) != 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Setup configuration
+void GenLODsProcess::SetupProperties(const Importer* pImp)
+{
+	configLevels = std::max(0, pImp->GetPropertyInteger(AI_CONFIG_PP_GLOD_LEVELS,PP_GLOD_LEVELS));
+
+	const float ratio = pImp->GetPropertyFloat(AI_CONFIG_PP_GLOD_RATIO,PP_GLOD_RATIO);
+	configRatio = std::max(0.05f, std::min(0.95f, ratio));
+
+	configMaxError = pImp->GetPropertyFloat(AI_CONFIG_PP_GLOD_MAX_ERROR,PP_GLOD_MAX_ERROR);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Executes the post processing step on the given imported data.
+void GenLODsProcess::Execute( aiScene* pScene)
+{
+	DefaultLogger::get()->debug("GenLODsProcess begin");
+
+	std::vector<unsigned int> levels;
+	ExecutePerMesh(pScene->mMeshes,pScene->mNumMeshes,&GenLODsProcess::ProcessMesh,levels);
+
+	if (!DefaultLogger::isNullLogger()) {
+		unsigned int numm = 0, numl = 0, numf = 0, numc = 0;
+		for (unsigned int a = 0; a < pScene->mNumMeshes; ++a) {
+			if (levels[a]) {
+				const aiMesh* mesh = pScene->mMeshes[a];
+				++numm;
+				numl += levels[a];
+				numf += mesh->mNumFaces;
+				numc += mesh->mLODs[mesh->mNumLODs-1]->mNumFaces;
+			}
+		}
+
+		if (numm) {
+			char szBuff[256]; // should be sufficiently large in every case
+			::sprintf(szBuff,"GenLODsProcess finished. Generated %u levels for %u meshes, "
+				"the coarsest ones have %u of %u faces",numl,numm,numc,numf);
+			DefaultLogger::get()->info(szBuff);
+		}
+		else DefaultLogger::get()->debug("GenLODsProcess finished. No levels generated");
+	}
+}
+
+// ------------------------------------------------------------------------------------------------
+// Generates the levels of a specific mesh
+unsigned int GenLODsProcess::ProcessMesh( aiMesh* pMesh, unsigned int meshNum)
+{
+	ai_assert(NULL != pMesh);
+
+	// levels generated before are replaced
+	for (unsigned int a = 0; a < pMesh->mNumLODs; ++a) {
+		delete pMesh->mLODs[a];
+	}
+	delete[] pMesh->mLODs;
+	pMesh->mLODs = NULL;
+	pMesh->mNumLODs = 0;
+
+	if (!pMesh->HasFaces() || !pMesh->HasPositions()) {
+		return 0;
+	}
+
+	if (pMesh->mPrimitiveTypes != aiPrimitiveType_TRIANGLE)	{
+		DefaultLogger::get()->error("This algorithm works on triangle meshes only");
+		return 0;
+	}
+
+	// the error limit is relative to the size of the mesh
+	aiVector3D min, max;
+	ArrayBounds(pMesh->mVertices,pMesh->mNumVertices,min,max);
+	const double errorLimit = configMaxError * (max - min).Length();
+
+	Simplifier simplifier(pMesh);
+	std::vector<aiMeshLOD*> lods;
+
+	unsigned int numFaces = (unsigned int)simplifier.indices.size() / 3;
+	while (lods.size() < configLevels) {
+		const unsigned int target = (unsigned int)(numFaces * configRatio);
+		if (target < MinFaces) {
+			break;
+		}
+
+		const double error = simplifier.Simplify(target,errorLimit*errorLimit);
+		const unsigned int simplified = (unsigned int)simplifier.indices.size() / 3;
+
+		// stop if the simplification stalls (limited by the error or the topology)
+		if ((numFaces - simplified) * 4 < numFaces - target) {
+			break;
+		}
+		numFaces = simplified;
+
+		aiMeshLOD* lod = new aiMeshLOD();
+		lod->mNumFaces = numFaces;
+		lod->mFaces = new aiFace[numFaces];
+		lod->mError = (float)::sqrt(error);
+		for (unsigned int f = 0; f < numFaces; ++f) {
+			aiFace& face = lod->mFaces[f];
+			face.mNumIndices = 3;
+			face.mIndices = new unsigned int[3];
+			std::copy(&simplifier.indices[f*3],&simplifier.indices[f*3]+3,face.mIndices);
+		}
+		lods.push_back(lod);
+	}
+
+	if (!lods.empty()) {
+		pMesh->mNumLODs = (unsigned int)lods.size();
+		pMesh->mLODs = new aiMeshLOD*[lods.size()];
+		std::copy(lods.begin(),lods.end(),pMesh->mLODs);
+	}
+
+	// very intense verbose logging ... prepare for much text if there are many meshes
+	if (!DefaultLogger::isNullLogger() && DefaultLogger::get()->getLogSeverity() == Logger::VERBOSE) {
+		char szBuff[128]; // should be sufficiently large in every case
+		::sprintf(szBuff,"Mesh %u | %u faces | %u levels",meshNum,pMesh->mNumFaces,pMesh->mNumLODs);
+		std::string msg = szBuff;
+		for (unsigned int a = 0; a < pMesh->mNumLODs; ++a) {
+			::sprintf(szBuff," | %u faces, error %f",pMesh->mLODs[a]->mNumFaces,pMesh->mLODs[a]->mError);
+			msg += szBuff;
+		}
+		DefaultLogger::get()->debug(msg);
+	}
+	return pMesh->mNumLODs;
+}
+
+#endif // !! ASSIMP_BUILD_NO_GENLODS_PROCESS
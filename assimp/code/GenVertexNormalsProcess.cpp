@@ -90,10 +90,13 @@ void GenVertexNormalsProcess::Execute( aiScene* pScene)
 	if (pScene->mFlags & AI_SCENE_FLAGS_NON_VERBOSE_FORMAT)
 		throw DeadlyImportError("Post-processing order mismatch: expecting pseudo-indexed (\"verbose\") vertices here");
 
+	std::vector<unsigned char> generated;
+	ExecutePerMesh(pScene->mMeshes,pScene->mNumMeshes,&GenVertexNormalsProcess::GenMeshVertexNormals,generated);
+
 	bool bHas = false;
 	for( unsigned int a = 0; a < pScene->mNumMeshes; a++)
 	{
-		if(GenMeshVertexNormals( pScene->mMeshes[a],a))
+		if(generated[a])
 			bHas = true;
 	}
 
@@ -205,12 +208,15 @@ bool GenVertexNormalsProcess::GenMeshVertexNormals (aiMesh* pMesh, unsigned int
 	// the effect, this one is the most straightforward one.
 	else	{
 		const float fLimit = ::cos(configMaxAngle); 
-		for (unsigned int i = 0; i < pMesh->mNumVertices;++i)	{
-			// Get all vertices that share this one ...
-			vertexFinder->FindPositions( pMesh->mVertices[i] , posEpsilon, verticesFound);
 
+		// Get all vertices that share a vertex, for all vertices at once ...
+		std::vector<unsigned int> offsets;
+		vertexFinder->FindPositions( pMesh->mVertices, pMesh->mNumVertices, sizeof( aiVector3D),
+			posEpsilon, offsets, verticesFound);
+
+		for (unsigned int i = 0; i < pMesh->mNumVertices;++i)	{
 			aiVector3D pcNor; 
-			for (unsigned int a = 0; a < verticesFound.size(); ++a)	{
+			for (unsigned int a = offsets[i]; a < offsets[i+1]; ++a)	{
 				const aiVector3D& v = pMesh->mNormals[verticesFound[a]];
 
 				// check whether the angle between the two normals is not too large
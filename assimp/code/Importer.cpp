@@ -66,6 +66,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "DefaultIOStream.h"
 #include "DefaultIOSystem.h"
+#include "MMapIOSystem.h"
 #include "DefaultProgressHandler.h"
 #include "GenericProperty.h"
 #include "ProcessHelper.h"
@@ -141,8 +142,8 @@ Importer::Importer()
 	pimpl->mScene = NULL;
 	pimpl->mErrorString = "";
 
-	// Allocate a default IO handler
-	pimpl->mIOHandler = new DefaultIOSystem;
+	// Allocate a default IO handler, mapping files read by the loaders
+	pimpl->mIOHandler = new MMapIOSystem;
 	pimpl->mIsDefaultHandler = true; 
 	pimpl->bExtraVerbose     = false; // disable extra verbose mode by default
 
@@ -306,7 +307,7 @@ void Importer::SetIOHandler( IOSystem* pIOHandler)
 	if (!pIOHandler)
 	{
 		// Release pointer in the possession of the caller
-		pimpl->mIOHandler = new DefaultIOSystem();
+		pimpl->mIOHandler = new MMapIOSystem();
 		pimpl->mIsDefaultHandler = true;
 	}
 	// Otherwise register the custom handler
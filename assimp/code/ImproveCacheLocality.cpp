@@ -71,7 +71,8 @@ ImproveCacheLocalityProcess::~ImproveCacheLocalityProcess()
 // Returns whether the processing step is present in the given flag field.
 bool ImproveCacheLocalityProcess::IsActive( unsigned int pFlags) const
 {
-	return (pFlags & aiProcess_ImproveCacheLocality) != 0;
+	// superseded by aiProcess_OptimizeVertexCache
+	return (pFlags & aiProcess_ImproveCacheLocality) != 0 && (pFlags & aiProcess_OptimizeVertexCache) == 0;
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -93,10 +94,14 @@ void ImproveCacheLocalityProcess::Execute( aiScene* pScene)
 
 	DefaultLogger::get()->debug("ImproveCacheLocalityProcess begin");
 
+	std::vector<float> acmr;
+	ExecutePerMesh(pScene->mMeshes,pScene->mNumMeshes,&ImproveCacheLocalityProcess::ProcessMesh,acmr);
+
+	// summed in mesh order, so the statistics don't depend on the threads
 	float out = 0.f;
 	unsigned int numf = 0, numm = 0;
 	for( unsigned int a = 0; a < pScene->mNumMeshes; a++){
-		const float res = ProcessMesh( pScene->mMeshes[a],a);
+		const float res = acmr[a];
 		if (res) {
 			numf += pScene->mMeshes[a]->mNumFaces;
 			out  += res;
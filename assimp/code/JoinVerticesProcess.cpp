@@ -52,6 +52,148 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "TinyFormatter.h"
 
 using namespace Assimp;
+
+namespace {
+
+// ------------------------------------------------------------------------------------------------
+// Vertex components present in a mesh, absent components are zero in all vertices
+struct VertexFormat
+{
+	explicit VertexFormat(const aiMesh* pMesh)
+		: normals(pMesh->HasNormals())
+		, tangents(pMesh->HasTangentsAndBitangents())
+		, numUVs(pMesh->GetNumUVChannels())
+		, numColors(pMesh->GetNumColorChannels())
+	{}
+
+	bool normals, tangents;
+	unsigned int numUVs, numColors;
+};
+
+// ------------------------------------------------------------------------------------------------
+// Bit pattern of a float, -0 is mapped to 0 since both compare equal
+inline uint32_t FloatBits(float f)
+{
+	if (f == 0.f) {
+		return 0;
+	}
+	uint32_t bits;
+	::memcpy(&bits,&f,sizeof(float));
+	return bits;
+}
+
+// ------------------------------------------------------------------------------------------------
+// MurmurHash3 (32 bit) steps
+inline uint32_t HashMix(uint32_t h, float f)
+{
+	uint32_t k = FloatBits(f) * 0xcc9e2d51;
+	k = (k << 15) | (k >> 17);
+	h ^= k * 0x1b873593;
+	h = (h << 13) | (h >> 19);
+	return h * 5 + 0xe6546b64;
+}
+
+inline uint32_t HashFinalize(uint32_t h)
+{
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	return h ^ (h >> 16);
+}
+
+inline uint32_t HashVector(uint32_t h, const aiVector3D& v)
+{
+	return HashMix(HashMix(HashMix(h,v.x),v.y),v.z);
+}
+
+// ------------------------------------------------------------------------------------------------
+inline uint32_t HashPosition(const aiVector3D& position)
+{
+	return HashFinalize(HashVector(0,position));
+}
+
+// ------------------------------------------------------------------------------------------------
+// Hash of the complete vertex, continuing the hash of its position
+inline uint32_t HashAttributes(uint32_t positionHash, const Vertex& v, const VertexFormat& format)
+{
+	uint32_t h = positionHash;
+	if (format.normals) {
+		h = HashVector(h,v.normal);
+	}
+	if (format.tangents) {
+		h = HashVector(HashVector(h,v.tangent),v.bitangent);
+	}
+	for (unsigned int i = 0; i < format.numUVs; ++i) {
+		h = HashVector(h,v.texcoords[i]);
+	}
+	for (unsigned int i = 0; i < format.numColors; ++i) {
+		const aiColor4D& c = v.colors[i];
+		h = HashMix(HashMix(HashMix(HashMix(h,c.r),c.g),c.b),c.a);
+	}
+	return HashFinalize(h);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Positions are compared by their bits, consistent with HashPosition()
+inline bool IsSamePosition(const aiVector3D& a, const aiVector3D& b)
+{
+	return FloatBits(a.x) == FloatBits(b.x) && FloatBits(a.y) == FloatBits(b.y) && FloatBits(a.z) == FloatBits(b.z);
+}
+
+// ------------------------------------------------------------------------------------------------
+inline bool IsIdentical(const Vertex& a, const Vertex& b, const VertexFormat& format)
+{
+	if (a.position != b.position) {
+		return false;
+	}
+	if (format.normals && a.normal != b.normal) {
+		return false;
+	}
+	if (format.tangents && (a.tangent != b.tangent || a.bitangent != b.bitangent)) {
+		return false;
+	}
+	for (unsigned int i = 0; i < format.numUVs; ++i) {
+		if (a.texcoords[i] != b.texcoords[i]) {
+			return false;
+		}
+	}
+	for (unsigned int i = 0; i < format.numColors; ++i) {
+		if (a.colors[i] != b.colors[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Compares all attributes but the position within epsilon. Non-present attributes are
+// zero in both vertices, thus they are effectively ignored.
+inline bool IsSimilar(const Vertex& a, const Vertex& b, const VertexFormat& format, float squareEpsilon)
+{
+	if( (a.normal - b.normal).SquareLength() > squareEpsilon)
+		return false;
+	if( (a.texcoords[0] - b.texcoords[0]).SquareLength() > squareEpsilon)
+		return false;
+	if( (a.tangent - b.tangent).SquareLength() > squareEpsilon)
+		return false;
+	if( (a.bitangent - b.bitangent).SquareLength() > squareEpsilon)
+		return false;
+
+	// Usually we won't have vertex colors or multiple UVs
+	for (unsigned int i = 1; i < format.numUVs; ++i) {
+		if( (a.texcoords[i] - b.texcoords[i]).SquareLength() > squareEpsilon)
+			return false;
+	}
+	for (unsigned int i = 0; i < format.numColors; ++i) {
+		if( GetColorDifference( a.colors[i], b.colors[i]) > squareEpsilon)
+			return false;
+	}
+	return true;
+}
+
+} // namespace
+
 // ------------------------------------------------------------------------------------------------
 // Constructor to be privately used by Importer
 JoinVerticesProcess::JoinVerticesProcess()
@@ -87,9 +229,12 @@ void JoinVerticesProcess::Execute( aiScene* pScene)
 	}
 
 	// execute the step
+	std::vector<int> meshVertices;
+	ExecutePerMesh(pScene->mMeshes,pScene->mNumMeshes,&JoinVerticesProcess::ProcessMesh,meshVertices);
+
 	int iNumVertices = 0;
 	for( unsigned int a = 0; a < pScene->mNumMeshes; a++)
-		iNumVertices +=	ProcessMesh( pScene->mMeshes[a],a);
+		iNumVertices +=	meshVertices[a];
 
 	// if logging is active, print detailed statistics
 	if (!DefaultLogger::isNullLogger())
@@ -135,128 +280,69 @@ int JoinVerticesProcess::ProcessMesh( aiMesh* pMesh, unsigned int meshIndex)
 	BOOST_STATIC_ASSERT(AI_MAX_VERTICES == 0x7fffffff);
 	std::vector<unsigned int> replaceIndex( pMesh->mNumVertices, 0xffffffff);
 
-	// A little helper to find locally close vertices faster.
-	// Try to reuse the lookup table from the last step.
+	// Positions need to be identical (but for the sign of zero), all other attributes
+	// may differ by epsilon.
 	const static float epsilon = 1e-5f;
-	// float posEpsilonSqr;
-	SpatialSort* vertexFinder = NULL;
-	SpatialSort _vertexFinder;
-
-	typedef std::pair<SpatialSort,float> SpatPair;
-	if (shared)	{
-		std::vector<SpatPair >* avf;
-		shared->GetProperty(AI_SPP_SPATIAL_SORT,avf);
-		if (avf)	{
-			SpatPair& blubb = (*avf)[meshIndex];
-			vertexFinder  = &blubb.first;
-			// posEpsilonSqr = blubb.second;
-		}
-	}
-	if (!vertexFinder)	{
-		// bad, need to compute it.
-		_vertexFinder.Fill(pMesh->mVertices, pMesh->mNumVertices, sizeof( aiVector3D));
-		vertexFinder = &_vertexFinder; 
-		// posEpsilonSqr = ComputePositionEpsilon(pMesh);
-	}
-
-	// Squared because we check against squared length of the vector difference
 	static const float squareEpsilon = epsilon * epsilon;
 
-	// Again, better waste some bytes than a realloc ...
-	std::vector<unsigned int> verticesFound;
-	verticesFound.reserve(10);
+	const VertexFormat format(pMesh);
+
+	// Two open addressing tables of unique vertices. The first is keyed by the complete
+	// vertex and finds exact duplicates, which are by far the most common case. The second
+	// is keyed by the position; each of its entries starts a list of all unique vertices
+	// at that position, which are compared within epsilon if there's no exact duplicate.
+	size_t tableSize = 16;
+	while (tableSize < pMesh->mNumVertices * (size_t)2) {
+		tableSize <<= 1;
+	}
+	const size_t mask = tableSize - 1;
+
+	std::vector<unsigned int> vertexTable( tableSize, 0xffffffff);
+	std::vector<unsigned int> positionTable( tableSize, 0xffffffff);
 
-	// Run an optimized code path if we don't have multiple UVs or vertex colors.
-	// This should yield false in more than 99% of all imports ...
-	const bool complex = ( pMesh->GetNumColorChannels() > 0 || pMesh->GetNumUVChannels() > 1);
+	// Next unique vertex at the same position, and the last one of each list (set for the
+	// first unique vertex at a position only). Appending keeps the lists in index order.
+	std::vector<unsigned int> nextAtPosition, lastAtPosition;
+	nextAtPosition.reserve( pMesh->mNumVertices);
+	lastAtPosition.reserve( pMesh->mNumVertices);
 
 	// Now check each vertex if it brings something new to the table
 	for( unsigned int a = 0; a < pMesh->mNumVertices; a++)	{
 		// collect the vertex data
-		Vertex v(pMesh,a);
+		const Vertex v(pMesh,a);
+
+		const uint32_t positionHash = HashPosition( v.position);
+		size_t vertexSlot = HashAttributes( positionHash, v, format) & mask;
 
-		// collect all vertices that are close enough to the given position
-		vertexFinder->FindIdenticalPositions( v.position, verticesFound);
 		unsigned int matchIndex = 0xffffffff;
+		for( ; vertexTable[vertexSlot] != 0xffffffff; vertexSlot = (vertexSlot + 1) & mask)	{
+			if (IsIdentical( uniqueVertices[vertexTable[vertexSlot]], v, format))	{
+				matchIndex = vertexTable[vertexSlot];
+				break;
+			}
+		}
 
-		// check all unique vertices close to the position if this vertex is already present among them
-		for( unsigned int b = 0; b < verticesFound.size(); b++)	{
-
-			const unsigned int vidx = verticesFound[b];
-			const unsigned int uidx = replaceIndex[ vidx];
-			if( uidx & 0x80000000)
-				continue;
-
-			const Vertex& uv = uniqueVertices[ uidx];
-			// Position mismatch is impossible - the vertex finder already discarded all non-matching positions
-
-			// We just test the other attributes even if they're not present in the mesh.
-			// In this case they're initialized to 0 so the comparision succeeds. 
-			// By this method the non-present attributes are effectively ignored in the comparision.
-			if( (uv.normal - v.normal).SquareLength() > squareEpsilon)
-				continue;
-			if( (uv.texcoords[0] - v.texcoords[0]).SquareLength() > squareEpsilon)
-				continue;
-			if( (uv.tangent - v.tangent).SquareLength() > squareEpsilon)
-				continue;
-			if( (uv.bitangent - v.bitangent).SquareLength() > squareEpsilon)
-				continue;
-
-			// Usually we won't have vertex colors or multiple UVs, so we can skip from here
-			// Actually this increases runtime performance slightly, at least if branch
-			// prediction is on our side.
-			if (complex){
-				// manually unrolled because continue wouldn't work as desired in an inner loop, 
-				// also because some compilers seem to fail the task. Colors and UV coords
-				// are interleaved since the higher entries are most likely to be
-				// zero and thus useless. By interleaving the arrays, vertices are,
-				// on average, rejected earlier.
-
-				if( (uv.texcoords[1] - v.texcoords[1]).SquareLength() > squareEpsilon)
-					continue;
-				if( GetColorDifference( uv.colors[0], v.colors[0]) > squareEpsilon)
-					continue;
-
-				if( (uv.texcoords[2] - v.texcoords[2]).SquareLength() > squareEpsilon)
-					continue;
-				if( GetColorDifference( uv.colors[1], v.colors[1]) > squareEpsilon)
-					continue;
-
-				if( (uv.texcoords[3] - v.texcoords[3]).SquareLength() > squareEpsilon)
-					continue;
-				if( GetColorDifference( uv.colors[2], v.colors[2]) > squareEpsilon)
-					continue;
-
-				if( (uv.texcoords[4] - v.texcoords[4]).SquareLength() > squareEpsilon)
-					continue;
-				if( GetColorDifference( uv.colors[3], v.colors[3]) > squareEpsilon)
-					continue;
-
-				if( (uv.texcoords[5] - v.texcoords[5]).SquareLength() > squareEpsilon)
-					continue;
-				if( GetColorDifference( uv.colors[4], v.colors[4]) > squareEpsilon)
-					continue;
-
-				if( (uv.texcoords[6] - v.texcoords[6]).SquareLength() > squareEpsilon)
-					continue;
-				if( GetColorDifference( uv.colors[5], v.colors[5]) > squareEpsilon)
-					continue;
-
-				if( (uv.texcoords[7] - v.texcoords[7]).SquareLength() > squareEpsilon)
-					continue;
-				if( GetColorDifference( uv.colors[6], v.colors[6]) > squareEpsilon)
-					continue;
-				
-				if( GetColorDifference( uv.colors[7], v.colors[7]) > squareEpsilon)
-					continue;
+		// found an identical vertex among the uniques?
+		if( matchIndex != 0xffffffff)	{
+			replaceIndex[a] = matchIndex | 0x80000000;
+			continue;
+		}
+
+		// no, check all unique vertices at the same position if one is close enough
+		size_t positionSlot = positionHash & mask;
+		for( ; positionTable[positionSlot] != 0xffffffff; positionSlot = (positionSlot + 1) & mask)	{
+			if (IsSamePosition( uniqueVertices[positionTable[positionSlot]].position, v.position))	{
+				break;
 			}
+		}
 
-			// we're still here -> this vertex perfectly matches our given vertex
-			matchIndex = uidx;
-			break;
+		for( unsigned int uidx = positionTable[positionSlot]; uidx != 0xffffffff; uidx = nextAtPosition[uidx])	{
+			if (IsSimilar( uniqueVertices[uidx], v, format, squareEpsilon))	{
+				matchIndex = uidx;
+				break;
+			}
 		}
 
-		// found a replacement vertex among the uniques?
 		if( matchIndex != 0xffffffff)
 		{
 			// store where to found the matching unique vertex
@@ -265,8 +351,23 @@ int JoinVerticesProcess::ProcessMesh( aiMesh* pMesh, unsigned int meshIndex)
 		else
 		{
 			// no unique vertex matches it upto now -> so add it
-			replaceIndex[a] = (unsigned int)uniqueVertices.size();
+			const unsigned int uidx = (unsigned int)uniqueVertices.size();
+			replaceIndex[a] = uidx;
 			uniqueVertices.push_back( v);
+
+			vertexTable[vertexSlot] = uidx;
+
+			nextAtPosition.push_back( 0xffffffff);
+			lastAtPosition.push_back( uidx);
+
+			const unsigned int first = positionTable[positionSlot];
+			if (first == 0xffffffff)	{
+				positionTable[positionSlot] = uidx;
+			}
+			else	{
+				nextAtPosition[lastAtPosition[first]] = uidx;
+				lastAtPosition[first] = uidx;
+			}
 		}
 	}
 
@@ -0,0 +1,258 @@
+/*
+---------------------------------------------------------------------------
+Open Asset Import Library (assimp)
+---------------------------------------------------------------------------
+
+Copyright (c) 2006-2012, assimp team
+
+All rights reserved.
+
+Redistribution and use of this software in source and binary forms, 
+with or without modification, are permitted provided that the following 
+conditions are met:
+
+* Redistributions of source code must retain the above
+  copyright notice, this list of conditions and the
+  following disclaimer.
+
+* Redistributions in binary form must reproduce the above
+  copyright notice, this list of conditions and the
+  following disclaimer in the documentation and/or other
+  materials provided with the distribution.
+
+* Neither the name of the assimp team, nor the names of its
+  contributors may be used to endorse or promote products
+  derived from this software without specific prior
+  written permission of the assimp team.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+---------------------------------------------------------------------------
+*/
+
+/** @file  MMapIOSystem.cpp
+ *  @brief Memory mapped file I/O for #Importer
+ */
+
+#include "AssimpPCH.h"
+
+#include "MMapIOSystem.h"
+
+#ifdef _WIN32
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+using namespace Assimp;
+
+// ----------------------------------------------------------------------------------
+MMapIOStream::MMapIOStream() :
+	mData	(NULL),
+	mSize	(0),
+	mPos	(0)
+#ifdef _WIN32
+	,mFile	(NULL)
+	,mMapping(NULL)
+#endif
+{
+	// empty
+}
+
+// ----------------------------------------------------------------------------------
+MMapIOStream::~MMapIOStream()
+{
+#ifdef _WIN32
+	if (mData) {
+		::UnmapViewOfFile(mData);
+	}
+	if (mMapping) {
+		::CloseHandle(mMapping);
+	}
+	if (mFile) {
+		::CloseHandle(mFile);
+	}
+#else
+	if (mData) {
+		::munmap(const_cast<char*>(mData), mSize);
+	}
+#endif
+}
+
+// ----------------------------------------------------------------------------------
+bool MMapIOStream::Map(const char* pFile)
+{
+#ifdef _WIN32
+	mFile = ::CreateFileA(pFile, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (INVALID_HANDLE_VALUE == mFile) {
+		mFile = NULL;
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!::GetFileSizeEx(mFile, &size) || 0 == size.QuadPart) {
+		return false;
+	}
+	mSize = (size_t) size.QuadPart;
+
+	mMapping = ::CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mMapping) {
+		return false;
+	}
+	mData = (const char*) ::MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+	return NULL != mData;
+#else
+	const int file = ::open(pFile, O_RDONLY);
+	if (-1 == file) {
+		return false;
+	}
+
+	struct stat fileStat;
+	if (0 != ::fstat(file, &fileStat) || !S_ISREG(fileStat.st_mode) || 0 == fileStat.st_size) {
+		::close(file);
+		return false;
+	}
+	mSize = (size_t) fileStat.st_size;
+
+	// the mapping remains valid after closing the descriptor
+	void* data = ::mmap(NULL, mSize, PROT_READ, MAP_PRIVATE, file, 0);
+	::close(file);
+
+	if (MAP_FAILED == data) {
+		return false;
+	}
+	mData = (const char*) data;
+
+	// loaders mostly scan front to back
+	::madvise(data, mSize, MADV_SEQUENTIAL);
+	return true;
+#endif
+}
+
+// ----------------------------------------------------------------------------------
+size_t MMapIOStream::Read(void* pvBuffer, 
+	size_t pSize, 
+	size_t pCount)
+{
+	ai_assert(NULL != pvBuffer && 0 != pSize && 0 != pCount);
+
+	const size_t cnt = std::min(pCount,(mSize-mPos)/pSize), ofs = pSize*cnt;
+
+	::memcpy(pvBuffer,mData+mPos,ofs);
+	mPos += ofs;
+
+	return cnt;
+}
+
+// ----------------------------------------------------------------------------------
+size_t MMapIOStream::Write(const void* /*pvBuffer*/, 
+	size_t /*pSize*/,
+	size_t /*pCount*/)
+{
+	return 0;
+}
+
+// ----------------------------------------------------------------------------------
+aiReturn MMapIOStream::Seek(size_t pOffset,
+	 aiOrigin pOrigin)
+{
+	// same semantics as fseek, the offset is negative for aiOrigin_END
+	size_t pos;
+	if (aiOrigin_SET == pOrigin) {
+		pos = pOffset;
+	}
+	else if (aiOrigin_END == pOrigin) {
+		pos = mSize + pOffset;
+	}
+	else {
+		pos = mPos + pOffset;
+	}
+
+	if (pos > mSize) {
+		return AI_FAILURE;
+	}
+	mPos = pos;
+	return AI_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------------
+size_t MMapIOStream::Tell() const
+{
+	return mPos;
+}
+
+// ----------------------------------------------------------------------------------
+size_t MMapIOStream::FileSize() const
+{
+	return mSize;
+}
+
+// ----------------------------------------------------------------------------------
+void MMapIOStream::Flush()
+{
+	// nothing to do
+}
+
+// ----------------------------------------------------------------------------------
+const char* MMapIOStream::Data() const
+{
+	return mData;
+}
+
+// ----------------------------------------------------------------------------------
+bool MMapIOStream::IsZeroTerminated() const
+{
+	// the remainder of the last page is mapped and filled with zeros
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	::GetSystemInfo(&info);
+	const size_t pageSize = info.dwPageSize;
+#else
+	const size_t pageSize = (size_t) ::sysconf(_SC_PAGESIZE);
+#endif
+	return mData && 0 != mSize % pageSize;
+}
+
+// ------------------------------------------------------------------------------------------------
+MMapIOSystem::MMapIOSystem()
+{
+	// nothing to do here
+}
+
+// ------------------------------------------------------------------------------------------------
+MMapIOSystem::~MMapIOSystem()
+{
+	// nothing to do here
+}
+
+// ------------------------------------------------------------------------------------------------
+// Open a new file with a given path.
+IOStream* MMapIOSystem::Open( const char* strFile, const char* strMode)
+{
+	ai_assert(NULL != strFile);
+	ai_assert(NULL != strMode);
+
+	if (::strchr(strMode,'w') || ::strchr(strMode,'a') || ::strchr(strMode,'+')) {
+		return DefaultIOSystem::Open(strFile,strMode);
+	}
+
+	MMapIOStream* stream = new MMapIOStream();
+	if (!stream->Map(strFile)) {
+		delete stream;
+		return DefaultIOSystem::Open(strFile,strMode);
+	}
+	return stream;
+}
@@ -0,0 +1,142 @@
+/*
+Open Asset Import Library (assimp)
+----------------------------------------------------------------------
+
+Copyright (c) 2006-2012, assimp team
+All rights reserved.
+
+Redistribution and use of this software in source and binary forms, 
+with or without modification, are permitted provided that the 
+following conditions are met:
+
+* Redistributions of source code must retain the above
+  copyright notice, this list of conditions and the
+  following disclaimer.
+
+* Redistributions in binary form must reproduce the above
+  copyright notice, this list of conditions and the
+  following disclaimer in the documentation and/or other
+  materials provided with the distribution.
+
+* Neither the name of the assimp team, nor the names of its
+  contributors may be used to endorse or promote products
+  derived from this software without specific prior
+  written permission of the assimp team.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+----------------------------------------------------------------------
+*/
+
+/** @file MMapIOSystem.h
+ *  @brief IOSystem whose read-only streams map the whole file into memory
+ */
+#ifndef AI_MMAPIOSYSTEM_H_INC
+#define AI_MMAPIOSYSTEM_H_INC
+
+#include "DefaultIOSystem.h"
+
+namespace Assimp	{
+
+// ----------------------------------------------------------------------------------
+//!	@class	MMapIOStream
+//!	@brief	Read-only stream over a memory mapped file
+//! @note   Loaders can parse the mapped region in place (see Data()), instead
+//!         of copying the file into a buffer first. The OS pages the file in
+//!         on access, so even very large files are not duplicated in RAM.
+class MMapIOStream : public IOStream
+{
+	friend class MMapIOSystem;
+
+protected:
+	MMapIOStream ();
+
+public:
+	/** Destructor public to allow simple deletion to unmap the file. */
+	~MMapIOStream ();
+
+	// -------------------------------------------------------------------
+	// Read from stream (copies out of the mapping)
+    size_t Read(void* pvBuffer, 
+		size_t pSize, 
+		size_t pCount);
+
+	// -------------------------------------------------------------------
+	// Write to stream, always fails
+    size_t Write(const void* pvBuffer, 
+		size_t pSize,
+		size_t pCount);
+
+	// -------------------------------------------------------------------
+	// Seek specific position
+	aiReturn Seek(size_t pOffset,
+		aiOrigin pOrigin);
+
+	// -------------------------------------------------------------------
+	// Get current seek position
+    size_t Tell() const;
+
+	// -------------------------------------------------------------------
+	// Get size of file
+	size_t FileSize() const;
+
+	// -------------------------------------------------------------------
+	// Flush file contents, nothing to do
+	void Flush();
+
+	// -------------------------------------------------------------------
+	/** Start of the mapped file (FileSize() bytes), valid as long as
+	 *  the stream exists. */
+	const char* Data() const;
+
+	// -------------------------------------------------------------------
+	/** Returns true if the byte following the file is mapped as well
+	 *  and zero, i.e. the file does not end at a page boundary. Text
+	 *  parsers relying on a terminating zero can then parse in place. */
+	bool IsZeroTerminated() const;
+
+private:
+	bool Map(const char* pFile);
+
+private:
+	const char* mData;
+	size_t mSize;
+	size_t mPos;
+
+#ifdef _WIN32
+	void* mFile;
+	void* mMapping;
+#endif
+};
+
+// ---------------------------------------------------------------------------
+/** IOSystem that memory maps files opened for reading (see MMapIOStream).
+ *  Files opened for writing, and files that cannot be mapped (e.g. empty
+ *  ones), are handled by the DefaultIOSystem. */
+class MMapIOSystem : public DefaultIOSystem
+{
+public:
+	/** Constructor. */
+    MMapIOSystem();
+
+	/** Destructor. */
+	~MMapIOSystem();
+
+	// -------------------------------------------------------------------
+	/** Open a new file with a given path. */
+	IOStream* Open( const char* pFile, const char* pMode = "rb");
+};
+
+} //!ns Assimp
+
+#endif //AI_MMAPIOSYSTEM_H_INC
@@ -70,7 +70,8 @@ using namespace std;
 ObjFileImporter::ObjFileImporter() :
 	m_Buffer(),	
 	m_pRootObject( NULL ),
-	m_strAbsPath( "" )
+	m_strAbsPath( "" ),
+	m_bParallel( true )
 {
     DefaultIOSystem io;
 	m_strAbsPath = io.getOsSeparator();
@@ -109,6 +110,13 @@ const aiImporterDesc* ObjFileImporter::GetInfo () const
 	return &desc;
 }
 
+// ------------------------------------------------------------------------------------------------
+//	Setup configuration properties for the loader
+void ObjFileImporter::SetupProperties(const Importer* pImp)
+{
+	m_bParallel = pImp->GetPropertyInteger(AI_CONFIG_IMPORT_OBJ_PARALLEL,1) ? true : false;
+}
+
 // ------------------------------------------------------------------------------------------------
 //	Obj-file import implementation
 void ObjFileImporter::InternReadFile( const std::string& pFile, aiScene* pScene, IOSystem* pIOHandler)
@@ -126,8 +134,9 @@ void ObjFileImporter::InternReadFile( const std::string& pFile, aiScene* pScene,
 	if( fileSize < 16)
 		throw DeadlyImportError( "OBJ-file is too small.");
 
-	// Allocate buffer and read file into it
-	TextFileToBuffer(file.get(),m_Buffer);
+	// Map the file or, if it cannot be parsed in place, read it into the buffer
+	const char *begin, *end;
+	TextFileToRange(file.get(),m_Buffer,begin,end);
 
 	// Get the model name
 	std::string  strModelName;
@@ -142,7 +151,7 @@ void ObjFileImporter::InternReadFile( const std::string& pFile, aiScene* pScene,
 	}
 	
 	// parse the file into a temporary representation
-	ObjFileParser parser(m_Buffer, strModelName, pIOHandler);
+	ObjFileParser parser(begin, end, strModelName, pIOHandler, m_bParallel);
 
 	// And create the proper return structures out of it
 	CreateDataFromImport(parser.GetModel(), pScene);
@@ -80,6 +80,9 @@ private:
 	//! \brief	Appends the supported extention.
 	const aiImporterDesc* GetInfo () const;
 
+	//!	\brief	Reads the loader's configuration.
+	void SetupProperties(const Importer* pImp);
+
 	//!	\brief	File import implementation.
 	void InternReadFile(const std::string& pFile, aiScene* pScene, IOSystem* pIOHandler);
 	
@@ -117,6 +120,8 @@ private:
 	ObjFile::Object *m_pRootObject;
 	//!	Absolute pathname of model in filesystem
 	std::string m_strAbsPath;
+	//!	Parse large files on multiple threads
+	bool m_bParallel;
 };
 
 // ------------------------------------------------------------------------------------------------
@@ -50,6 +50,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../include/assimp/types.h"
 #include "DefaultIOSystem.h"
 
+#ifdef _OPENMP
+#	include <omp.h>
+#endif
+
 namespace Assimp	
 {
 
@@ -58,12 +62,13 @@ const std::string ObjFileParser::DEFAULT_MATERIAL = AI_DEFAULT_MATERIAL_NAME;
 
 // -------------------------------------------------------------------
 //	Constructor with loaded data and directories.
-ObjFileParser::ObjFileParser(std::vector<char> &Data,const std::string &strModelName, IOSystem *io ) :
-	m_DataIt(Data.begin()),
-	m_DataItEnd(Data.end()),
+ObjFileParser::ObjFileParser(const char* begin, const char* end,const std::string &strModelName, IOSystem *io, bool parallel ) :
+	m_DataIt(begin),
+	m_DataItEnd(end),
 	m_pModel(NULL),
 	m_uiLine(0),
-	m_pIO( io )
+	m_pIO( io ),
+	m_bParallel( parallel )
 {
 	std::fill_n(m_buffer,BUFFERSIZE,0);
 
@@ -98,6 +103,52 @@ ObjFile::Model *ObjFileParser::GetModel() const
 	return m_pModel;
 }
 
+// -------------------------------------------------------------------
+//	Statements and vertex data of a chunk of lines, parsed on one thread.
+struct ObjFileParser::Chunk
+{
+	//	A statement to handle while merging, or an already parsed face
+	struct Record
+	{
+		const char *pLine;
+		ObjFile::Face *pFace;
+		bool hasNormal;
+		//	Vertex data of the chunk preceding the statement
+		size_t numVertices;
+		size_t numTextureCoords;
+		size_t numNormals;
+	};
+
+	Chunk() :
+		pBegin(NULL),
+		pEnd(NULL)
+	{
+		// empty
+	}
+
+	~Chunk()
+	{
+		// Faces not merged into the model
+		for (std::vector<Record>::iterator it = records.begin(); it != records.end(); ++it)
+			delete it->pFace;
+	}
+
+	const char *pBegin;
+	const char *pEnd;
+	std::vector<aiVector3D> vertices;
+	std::vector<aiVector2D> textureCoords;
+	std::vector<aiVector3D> normals;
+	std::vector<Record> records;
+};
+
+// -------------------------------------------------------------------
+//	Returns true, if a chunk may start at the given position. Statements
+//	start at the first character of a line, blanks are skipped (see skipLine).
+static bool isChunkBoundary(const char *it)
+{
+	return it[-1] == '\n' && *it != ' ' && *it != '\t';
+}
+
 // -------------------------------------------------------------------
 //	File parsing method.
 void ObjFileParser::parseFile()
@@ -105,81 +156,261 @@ void ObjFileParser::parseFile()
 	if (m_DataIt == m_DataItEnd)
 		return;
 
+	if (m_bParallel)
+	{
+#ifdef _OPENMP
+		const size_t numThreads = omp_get_max_threads();
+#else
+		const size_t numThreads = 1;
+#endif
+		const size_t size = m_DataItEnd - m_DataIt;
+		const size_t numChunks = std::min(size / MIN_CHUNKSIZE, numThreads * CHUNKS_PER_THREAD);
+		if (numThreads > 1 && numChunks > 1)
+		{
+			parseFileParallel(numChunks);
+			return;
+		}
+	}
+
 	while (m_DataIt != m_DataItEnd)
+		parseStatement();
+}
+
+// -------------------------------------------------------------------
+//	Parses the file in chunks of whole lines. Vertex data and faces are
+//	parsed on multiple threads, all other statements (objects, groups,
+//	and materials) are handled in order while merging the chunks. As the
+//	vertex data is appended in order, too, the indices of the faces need
+//	no rebasing.
+void ObjFileParser::parseFileParallel(size_t numChunks)
+{
+	const char *pBegin = m_DataIt;
+	const char *pEnd = m_DataItEnd;
+	const size_t size = pEnd - pBegin;
+
+	std::vector<Chunk> chunks(numChunks);
+	const char *pChunkBegin = pBegin;
+	for (size_t i = 0; i < numChunks; ++i)
+	{
+		const char *pChunkEnd = pEnd;
+		if (i + 1 < numChunks)
+		{
+			pChunkEnd = std::max(pChunkBegin, pBegin + size / numChunks * (i + 1));
+			while (pChunkEnd != pEnd && !isChunkBoundary(pChunkEnd))
+				++pChunkEnd;
+		}
+		chunks[i].pBegin = pChunkBegin;
+		chunks[i].pEnd = pChunkEnd;
+		pChunkBegin = pChunkEnd;
+	}
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < static_cast<int>(numChunks); ++i)
+		parseChunk(chunks[i]);
+
+	size_t numVertices = 0, numTextureCoords = 0, numNormals = 0;
+	for (size_t i = 0; i < numChunks; ++i)
+	{
+		numVertices += chunks[i].vertices.size();
+		numTextureCoords += chunks[i].textureCoords.size();
+		numNormals += chunks[i].normals.size();
+	}
+	m_pModel->m_Vertices.reserve(m_pModel->m_Vertices.size() + numVertices);
+	m_pModel->m_TextureCoord.reserve(m_pModel->m_TextureCoord.size() + numTextureCoords);
+	m_pModel->m_Normals.reserve(m_pModel->m_Normals.size() + numNormals);
+
+	for (size_t i = 0; i < numChunks; ++i)
+		mergeChunk(chunks[i]);
+
+	m_DataIt = m_DataItEnd = pEnd;
+}
+
+// -------------------------------------------------------------------
+//	Parses a statement, or the beginning of one.
+void ObjFileParser::parseStatement()
+{
+	switch (*m_DataIt)
 	{
-		switch (*m_DataIt)
+	case 'v': // Parse a vertex texture coordinate
 		{
-		case 'v': // Parse a vertex texture coordinate
+			++m_DataIt;
+			if (*m_DataIt == ' ')
+			{
+				// Read in vertex definition
+				getVector3(m_pModel->m_Vertices);
+			}
+			else if (*m_DataIt == 't')
 			{
+				// Read in texture coordinate (2D)
 				++m_DataIt;
-				if (*m_DataIt == ' ')
+				getVector2(m_pModel->m_TextureCoord);
+			}
+			else if (*m_DataIt == 'n')
+			{
+				// Read in normal vector definition
+				++m_DataIt;
+				getVector3( m_pModel->m_Normals );
+			}
+		}
+		break;
+
+	case 'p': // Parse a face, line or point statement
+	case 'l':
+	case 'f':
+		{
+			getFace(*m_DataIt == 'f' ? aiPrimitiveType_POLYGON : (*m_DataIt == 'l' 
+				? aiPrimitiveType_LINE : aiPrimitiveType_POINT));
+		}
+		break;
+
+	case '#': // Parse a comment
+		{
+			getComment();
+		}
+		break;
+
+	case 'u': // Parse a material desc. setter
+		{
+			getMaterialDesc();
+		}
+		break;
+
+	case 'm': // Parse a material library
+		{
+			getMaterialLib();
+		}
+		break;
+
+	case 'g': // Parse group name
+		{
+			getGroupName();
+		}
+		break;
+
+	case 's': // Parse group number
+		{
+			getGroupNumber();
+		}
+		break;
+
+	case 'o': // Parse object name
+		{
+			getObjectName();
+		}
+		break;
+	
+	default:
+		{
+			m_DataIt = skipLine<DataArrayIt>( m_DataIt, m_DataItEnd, m_uiLine );
+		}
+		break;
+	}
+}
+
+// -------------------------------------------------------------------
+//	Mirrors parseStatement, but only stores vertex data and faces. All
+//	other statements are recorded for mergeChunk, as are faces whose
+//	indices cannot be parsed without logging.
+void ObjFileParser::parseChunk(Chunk &chunk)
+{
+	const char *it = chunk.pBegin;
+	const char *end = chunk.pEnd;
+	unsigned int uiLine = 0;
+
+	while (it != end)
+	{
+		Chunk::Record record = { it, NULL, false,
+			chunk.vertices.size(), chunk.textureCoords.size(), chunk.normals.size() };
+
+		switch (*it)
+		{
+		case 'v':
+			{
+				// see getVector3 and getVector2, lines end within the chunk
+				float xyz[3] = { 0.f, 0.f, 0.f };
+				unsigned int num;
+				++it;
+				if (*it == ' ')
 				{
-					// Read in vertex definition
-					getVector3(m_pModel->m_Vertices);
+					it = fast_atoreal_run<float>(it, xyz, 3, num);
+					chunk.vertices.push_back(aiVector3D(xyz[0], xyz[1], xyz[2]));
+					it = skipLine<const char*>(it, end, uiLine);
 				}
-				else if (*m_DataIt == 't')
+				else if (*it == 't')
 				{
-					// Read in texture coordinate (2D)
-					++m_DataIt;
-					getVector2(m_pModel->m_TextureCoord);
+					++it;
+					it = fast_atoreal_run<float>(it, xyz, 2, num);
+					chunk.textureCoords.push_back(aiVector2D(xyz[0], xyz[1]));
+					it = skipLine<const char*>(it, end, uiLine);
 				}
-				else if (*m_DataIt == 'n')
+				else if (*it == 'n')
 				{
-					// Read in normal vector definition
-					++m_DataIt;
-					getVector3( m_pModel->m_Normals );
+					++it;
+					it = fast_atoreal_run<float>(it, xyz, 3, num);
+					chunk.normals.push_back(aiVector3D(xyz[0], xyz[1], xyz[2]));
+					it = skipLine<const char*>(it, end, uiLine);
 				}
 			}
 			break;
 
-		case 'p': // Parse a face, line or point statement
+		case 'p':
 		case 'l':
 		case 'f':
 			{
-				getFace(*m_DataIt == 'f' ? aiPrimitiveType_POLYGON : (*m_DataIt == 'l' 
+				const aiPrimitiveType type = (*it == 'f' ? aiPrimitiveType_POLYGON : (*it == 'l'
 					? aiPrimitiveType_LINE : aiPrimitiveType_POINT));
-			}
-			break;
 
-		case '#': // Parse a comment
-			{
-				getComment();
-			}
-			break;
+				// The face must end within the chunk (see copyNextLine)
+				const char *pLineEnd = it;
+				while (pLineEnd != end && *pLineEnd != '\n' && *pLineEnd != '\r')
+					++pLineEnd;
 
-		case 'u': // Parse a material desc. setter
-			{
-				getMaterialDesc();
-			}
-			break;
-
-		case 'm': // Parse a material library
-			{
-				getMaterialLib();
+				const char *pPtr = getNextToken<const char*>(it, end);
+				if (pLineEnd != end && pPtr < pLineEnd)
+				{
+					std::vector<unsigned int> *pIndices = new std::vector<unsigned int>;
+					std::vector<unsigned int> *pTexID = new std::vector<unsigned int>;
+					std::vector<unsigned int> *pNormalID = new std::vector<unsigned int>;
+
+					const unsigned int errors = getFaceIndices(pPtr, pLineEnd, type,
+						!chunk.textureCoords.empty(), !chunk.normals.empty(),
+						*pIndices, *pTexID, *pNormalID, record.hasNormal);
+
+					if (0 == errors && !pIndices->empty())
+						record.pFace = new ObjFile::Face(pIndices, pNormalID, pTexID, type);
+					else
+					{
+						delete pIndices;
+						delete pTexID;
+						delete pNormalID;
+					}
+				}
+				chunk.records.push_back(record);
+				it = skipLine<const char*>(it, end, uiLine);
 			}
 			break;
 
-		case 'g': // Parse group name
+		case '#':
 			{
-				getGroupName();
+				// see getComment
+				while (it != end && *it++ != '\n')
+					;
 			}
 			break;
 
-		case 's': // Parse group number
+		case 'u':
+		case 'm':
+		case 'g':
+		case 'o':
 			{
-				getGroupNumber();
+				chunk.records.push_back(record);
+				it = skipLine<const char*>(it, end, uiLine);
 			}
 			break;
 
-		case 'o': // Parse object name
-			{
-				getObjectName();
-			}
-			break;
-		
 		default:
 			{
-				m_DataIt = skipLine<DataArrayIt>( m_DataIt, m_DataItEnd, m_uiLine );
+				it = skipLine<const char*>(it, end, uiLine);
 			}
 			break;
 		}
@@ -187,20 +418,62 @@ void ObjFileParser::parseFile()
 }
 
 // -------------------------------------------------------------------
-//	Copy the next word in a temporary buffer
-void ObjFileParser::copyNextWord(char *pBuffer, size_t length)
+//	Appends the vertex data of a chunk and handles its statements in
+//	order, so that objects, groups, and materials are assigned as when
+//	parsing serially.
+void ObjFileParser::mergeChunk(Chunk &chunk)
 {
-	size_t index = 0;
-	m_DataIt = getNextWord<DataArrayIt>(m_DataIt, m_DataItEnd);
-	while ( m_DataIt != m_DataItEnd && !isSeparator(*m_DataIt) )
+	size_t numVertices = 0, numTextureCoords = 0, numNormals = 0;
+	for (std::vector<Chunk::Record>::iterator it = chunk.records.begin(); it != chunk.records.end(); ++it)
 	{
-		pBuffer[index] = *m_DataIt;
-		index++;
-		if (index == length-1)
-			break;
-		++m_DataIt;
+		m_pModel->m_Vertices.insert(m_pModel->m_Vertices.end(),
+			chunk.vertices.begin() + numVertices, chunk.vertices.begin() + it->numVertices);
+		m_pModel->m_TextureCoord.insert(m_pModel->m_TextureCoord.end(),
+			chunk.textureCoords.begin() + numTextureCoords, chunk.textureCoords.begin() + it->numTextureCoords);
+		m_pModel->m_Normals.insert(m_pModel->m_Normals.end(),
+			chunk.normals.begin() + numNormals, chunk.normals.begin() + it->numNormals);
+		numVertices = it->numVertices;
+		numTextureCoords = it->numTextureCoords;
+		numNormals = it->numNormals;
+
+		// Faces are parsed differently, if normals but no texture coordinates
+		// precede them. The preceding chunks were unknown to the thread.
+		if (NULL != it->pFace)
+		{
+			const bool vt = !m_pModel->m_TextureCoord.empty();
+			const bool vn = !m_pModel->m_Normals.empty();
+			if ((!vt && vn) != (0 == it->numTextureCoords && 0 != it->numNormals))
+			{
+				delete it->pFace;
+				it->pFace = NULL;
+			}
+		}
+
+		if (NULL != it->pFace)
+		{
+			storeFace(it->pFace, it->hasNormal);
+			it->pFace = NULL;
+		}
+		else
+		{
+			m_DataIt = it->pLine;
+			m_DataItEnd = chunk.pEnd;
+			parseStatement();
+		}
 	}
-	pBuffer[index] = '\0';
+
+	m_pModel->m_Vertices.insert(m_pModel->m_Vertices.end(),
+		chunk.vertices.begin() + numVertices, chunk.vertices.end());
+	m_pModel->m_TextureCoord.insert(m_pModel->m_TextureCoord.end(),
+		chunk.textureCoords.begin() + numTextureCoords, chunk.textureCoords.end());
+	m_pModel->m_Normals.insert(m_pModel->m_Normals.end(),
+		chunk.normals.begin() + numNormals, chunk.normals.end());
+
+	// Release the chunk's storage early
+	std::vector<aiVector3D>().swap(chunk.vertices);
+	std::vector<aiVector2D>().swap(chunk.textureCoords);
+	std::vector<aiVector3D>().swap(chunk.normals);
+	std::vector<Chunk::Record>().swap(chunk.records);
 }
 
 // -------------------------------------------------------------------
@@ -224,18 +497,12 @@ void ObjFileParser::copyNextLine(char *pBuffer, size_t length)
 //	Get values for a new 3D vector instance
 void ObjFileParser::getVector3(std::vector<aiVector3D> &point3d_array)
 {
-	float x, y, z;
-	copyNextWord(m_buffer, BUFFERSIZE);
-	x = (float) fast_atof(m_buffer);	
-	
-	copyNextWord(m_buffer, BUFFERSIZE);
-	y = (float) fast_atof(m_buffer);
+	// Missing components are zero
+	float xyz[3] = { 0.f, 0.f, 0.f };
+	unsigned int num;
+	m_DataIt = fast_atoreal_run<float>(m_DataIt, xyz, 3, num);
 
-	copyNextWord(m_buffer, BUFFERSIZE);
-	z = (float) fast_atof(m_buffer);
-
-	point3d_array.push_back( aiVector3D( x, y, z ) );
-	//skipLine();
+	point3d_array.push_back( aiVector3D( xyz[0], xyz[1], xyz[2] ) );
 	m_DataIt = skipLine<DataArrayIt>( m_DataIt, m_DataItEnd, m_uiLine );
 }
 
@@ -243,14 +510,11 @@ void ObjFileParser::getVector3(std::vector<aiVector3D> &point3d_array)
 //	Get values for a new 2D vector instance
 void ObjFileParser::getVector2( std::vector<aiVector2D> &point2d_array )
 {
-	float x, y;
-	copyNextWord(m_buffer, BUFFERSIZE);
-	x = (float) fast_atof(m_buffer);	
-	
-	copyNextWord(m_buffer, BUFFERSIZE);
-	y = (float) fast_atof(m_buffer);
+	float xy[2] = { 0.f, 0.f };
+	unsigned int num;
+	m_DataIt = fast_atoreal_run<float>(m_DataIt, xy, 2, num);
 
-	point2d_array.push_back(aiVector2D(x, y));
+	point2d_array.push_back(aiVector2D(xy[0], xy[1]));
 
 	m_DataIt = skipLine<DataArrayIt>( m_DataIt, m_DataItEnd, m_uiLine );
 }
@@ -276,8 +540,40 @@ void ObjFileParser::getFace(aiPrimitiveType type)
 
 	const bool vt = (!m_pModel->m_TextureCoord.empty());
 	const bool vn = (!m_pModel->m_Normals.empty());
+	const unsigned int errors = getFaceIndices(pPtr, pEnd, type, vt, vn, 
+		*pIndices, *pTexID, *pNormalID, hasNormal);
+
+	if (errors & FaceError_SeparatorInPoint)
+		DefaultLogger::get()->error("Obj: Separator unexpected in point statement");
+	if (errors & FaceError_InvalidToken)
+		reportErrorTokenInFace();
+
+	if ( pIndices->empty() ) 
+	{
+		DefaultLogger::get()->error("Obj: Ignoring empty face");
+		delete pIndices;
+		delete pTexID;
+		delete pNormalID;
+		m_DataIt = skipLine<DataArrayIt>( m_DataIt, m_DataItEnd, m_uiLine );
+		return;
+	}
+
+	ObjFile::Face *face = new ObjFile::Face( pIndices, pNormalID, pTexID, type );
+	storeFace(face, hasNormal);
+
+	// Skip the rest of the line
+	m_DataIt = skipLine<DataArrayIt>( m_DataIt, m_DataItEnd, m_uiLine );
+}
+
+// -------------------------------------------------------------------
+//	Parses the indices of a face, the line ends at pEnd at the latest.
+unsigned int ObjFileParser::getFaceIndices(const char *pPtr, const char *pEnd, aiPrimitiveType type,
+	bool vt, bool vn, std::vector<unsigned int> &indices, std::vector<unsigned int> &texID,
+	std::vector<unsigned int> &normalID, bool &hasNormal)
+{
+	unsigned int errors = 0;
 	int iStep = 0, iPos = 0;
-	while (pPtr != pEnd)
+	while (pPtr < pEnd)
 	{
 		iStep = 1;
 
@@ -287,7 +583,7 @@ void ObjFileParser::getFace(aiPrimitiveType type)
 		if (*pPtr=='/' )
 		{
 			if (type == aiPrimitiveType_POINT) {
-				DefaultLogger::get()->error("Obj: Separator unexpected in point statement");
+				errors |= FaceError_SeparatorInPoint;
 			}
 			if (iPos == 0)
 			{
@@ -306,7 +602,7 @@ void ObjFileParser::getFace(aiPrimitiveType type)
 		else 
 		{
 			//OBJ USES 1 Base ARRAYS!!!!
-			const int iVal = atoi( pPtr );
+			const int iVal = strtol10( pPtr );
 			int tmp = iVal;
 			while ( ( tmp = tmp / 10 )!=0 )
 				++iStep;
@@ -316,35 +612,32 @@ void ObjFileParser::getFace(aiPrimitiveType type)
 				// Store parsed index
 				if ( 0 == iPos )
 				{
-					pIndices->push_back( iVal-1 );
+					indices.push_back( iVal-1 );
 				}
 				else if ( 1 == iPos )
 				{	
-					pTexID->push_back( iVal-1 );
+					texID.push_back( iVal-1 );
 				}
 				else if ( 2 == iPos )
 				{
-					pNormalID->push_back( iVal-1 );
+					normalID.push_back( iVal-1 );
 					hasNormal = true;
 				}
 				else
 				{
-					reportErrorTokenInFace();
+					errors |= FaceError_InvalidToken;
 				}
 			}
 		}
 		pPtr += iStep;
 	}
+	return errors;
+}
 
-	if ( pIndices->empty() ) 
-	{
-		DefaultLogger::get()->error("Obj: Ignoring empty face");
-		m_DataIt = skipLine<DataArrayIt>( m_DataIt, m_DataItEnd, m_uiLine );
-		return;
-	}
-
-	ObjFile::Face *face = new ObjFile::Face( pIndices, pNormalID, pTexID, type );
-	
+// -------------------------------------------------------------------
+//	Stores a face in the current mesh
+void ObjFileParser::storeFace(ObjFile::Face *face, bool hasNormal)
+{
 	// Set active material, if one set
 	if (NULL != m_pModel->m_pCurrentMaterial) 
 		face->m_pMaterial = m_pModel->m_pCurrentMaterial;
@@ -369,8 +662,6 @@ void ObjFileParser::getFace(aiPrimitiveType type)
 	{
 		m_pModel->m_pCurrentMesh->m_hasNormals = true;
 	}
-	// Skip the rest of the line
-	m_DataIt = skipLine<DataArrayIt>( m_DataIt, m_DataItEnd, m_uiLine );
 }
 
 // -------------------------------------------------------------------
@@ -391,7 +682,7 @@ void ObjFileParser::getMaterialDesc()
 	if (m_DataIt == m_DataItEnd)
 		return;
 
-	char *pStart = &(*m_DataIt);
+	const char *pStart = &(*m_DataIt);
 	while ( m_DataIt != m_DataItEnd && !isSeparator(*m_DataIt) )
 		++m_DataIt;
 
@@ -450,7 +741,7 @@ void ObjFileParser::getMaterialLib()
 	if (m_DataIt ==  m_DataItEnd)
 		return;
 	
-	char *pStart = &(*m_DataIt);
+	const char *pStart = &(*m_DataIt);
 	while (m_DataIt != m_DataItEnd && !isNewLine(*m_DataIt))
 		m_DataIt++;
 
@@ -483,7 +774,7 @@ void ObjFileParser::getNewMaterial()
 	if ( m_DataIt == m_DataItEnd )
 		return;
 
-	char *pStart = &(*m_DataIt);
+	const char *pStart = &(*m_DataIt);
 	std::string strMat( pStart, *m_DataIt );
 	while ( m_DataIt != m_DataItEnd && isSeparator( *m_DataIt ) )
 		m_DataIt++;
@@ -535,7 +826,7 @@ void ObjFileParser::getGroupName()
 		return;
 
 	// Store the group name in the group library 
-	char *pStart = &(*m_DataIt);
+	const char *pStart = &(*m_DataIt);
 	while ( m_DataIt != m_DataItEnd && !isSeparator(*m_DataIt) )
 		m_DataIt++;
 	std::string strGroupName( pStart, &(*m_DataIt) );
@@ -582,7 +873,7 @@ void ObjFileParser::getObjectName()
 	m_DataIt = getNextToken<DataArrayIt>(m_DataIt, m_DataItEnd);
 	if (m_DataIt == m_DataItEnd)
 		return;
-	char *pStart = &(*m_DataIt);
+	const char *pStart = &(*m_DataIt);
 	while ( m_DataIt != m_DataItEnd && !isSeparator( *m_DataIt ) )
 		++m_DataIt;
 
@@ -674,7 +965,6 @@ bool ObjFileParser::needsNewMesh( const std::string &rMaterialName )
 //	Shows an error in parsing process.
 void ObjFileParser::reportErrorTokenInFace()
 {		
-	m_DataIt = skipLine<DataArrayIt>( m_DataIt, m_DataItEnd, m_uiLine );
 	DefaultLogger::get()->error("OBJ: Not supported token in face description detected");
 }
 
@@ -56,6 +56,7 @@ struct Object;
 struct Material;
 struct Point3;
 struct Point2;
+struct Face;
 }
 class ObjFileImporter;
 class IOSystem;
@@ -67,22 +68,43 @@ class ObjFileParser
 public:
 	static const size_t BUFFERSIZE = 4096;
 	typedef std::vector<char> DataArray;
-	typedef std::vector<char>::iterator DataArrayIt;
-	typedef std::vector<char>::const_iterator ConstDataArrayIt;
+	typedef const char* DataArrayIt;
+	typedef const char* ConstDataArrayIt;
+
+	///	Minimum size of a chunk parsed by a thread
+	static const size_t MIN_CHUNKSIZE = 1 << 20;
+	///	Upper bound of chunks per thread, more chunks balance the load better
+	static const size_t CHUNKS_PER_THREAD = 8;
+
+	///	Errors detected while parsing face indices
+	enum FaceError
+	{
+		FaceError_SeparatorInPoint = 0x1,
+		FaceError_InvalidToken = 0x2
+	};
 
 public:
-	///	\brief	Constructor with data array.
-	ObjFileParser(std::vector<char> &Data,const std::string &strModelName, IOSystem* io);
+	///	\brief	Constructor with the range of the data, which is parsed in place.
+	///	\param	parallel	Parse large files in chunks on multiple threads
+	ObjFileParser(const char* begin, const char* end,const std::string &strModelName, IOSystem* io, bool parallel = false);
 	///	\brief	Destructor
 	~ObjFileParser();
 	///	\brief	Model getter.
 	ObjFile::Model *GetModel() const;
 
 private:
+	struct Chunk;
+
 	///	Parse the loadedfile
 	void parseFile();
-	///	Method to copy the new delimited word in the current line.
-	void copyNextWord(char *pBuffer, size_t length);
+	///	Parse the loaded file in chunks on multiple threads
+	void parseFileParallel(size_t numChunks);
+	///	Parses the statement at the current position
+	void parseStatement();
+	///	Parses the vertex data and the faces of a chunk, may run on any thread
+	static void parseChunk(Chunk &chunk);
+	///	Merges a parsed chunk into the model
+	void mergeChunk(Chunk &chunk);
 	///	Method to copy the new line.
 	void copyNextLine(char *pBuffer, size_t length);
 	///	Stores the following 3d vector.
@@ -91,6 +113,12 @@ private:
 	void getVector2(std::vector<aiVector2D> &point2d_array);
 	///	Stores the following face.
 	void getFace(aiPrimitiveType type);
+	///	Parses the indices of the face in the given line, returns FaceError flags.
+	static unsigned int getFaceIndices(const char *pPtr, const char *pEnd, aiPrimitiveType type,
+		bool vt, bool vn, std::vector<unsigned int> &indices, std::vector<unsigned int> &texID,
+		std::vector<unsigned int> &normalID, bool &hasNormal);
+	///	Stores a face in the current mesh.
+	void storeFace(ObjFile::Face *face, bool hasNormal);
 	void getMaterialDesc();
 	///	Gets a comment.
 	void getComment();
@@ -130,6 +158,8 @@ private:
 	char m_buffer[BUFFERSIZE];
 	///	Pointer to IO system instance.
 	IOSystem *m_pIO;
+	///	Parse large files on multiple threads
+	bool m_bParallel;
 };
 
 }	// Namespace Assimp
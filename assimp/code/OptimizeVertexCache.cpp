@@ -0,0 +1,691 @@
+/*
+---------------------------------------------------------------------------
+Open Asset Import Library (assimp)
+---------------------------------------------------------------------------
+
+Copyright (c) 2006-2012, assimp team
+
+All rights reserved.
+
+Redistribution and use of this software in source and binary forms, 
+with or without modification, are permitted provided that the following 
+conditions are met:
+
+* Redistributions of source code must retain the above
+  copyright notice, this list of conditions and the
+  following disclaimer.
+
+* Redistributions in binary form must reproduce the above
+  copyright notice, this list of conditions and the
+  following disclaimer in the documentation and/or other
+  materials provided with the distribution.
+
+* Neither the name of the assimp team, nor the names of its
+  contributors may be used to endorse or promote products
+  derived from this software without specific prior
+  written permission of the assimp team.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+---------------------------------------------------------------------------
+*/
+
+/** @file Implementation of the post processing step to optimize meshes for the
+ * post-transform vertex cache, overdraw and vertex fetch.
+ * <br>
+ * The faces are ordered with Tom Forsyth's 'Linear-Speed Vertex Cache Optimisation':
+ * http://home.comcast.net/~tom_forsyth/papers/fast_vert_cache_opt.html
+ * The overdraw reduction follows Sander et al., 'Fast Triangle Reordering for 
+ * Vertex Locality and Reduced Overdraw' (2007). The overdraw is estimated by
+ * rasterizing the mesh from a fixed set of directions, as proposed by Nehab et al.,
+ * 'Triangle Order Optimization for Graphics Hardware Computation Culling' (2006).
+ */
+
+#include "AssimpPCH.h"
+#ifndef ASSIMP_BUILD_NO_OPTIMIZEVERTEXCACHE_PROCESS
+
+// internal headers
+#include "OptimizeVertexCache.h"
+#include "ProcessHelper.h"
+#include "VertexTriangleAdjacency.h"
+
+using namespace Assimp;
+
+namespace {
+
+	// Largest cache size supported by the score tables
+	const unsigned int MaxCacheSize = 64;
+
+	// Vertices with more live triangles share a score
+	const unsigned int MaxValence = 32;
+
+	// Scoring parameters as proposed by Forsyth
+	const float CacheDecayPower   = 1.5f;
+	const float LastTriScore      = 0.75f;
+	const float ValenceBoostScale = 2.0f;
+	const float ValenceBoostPower = 0.5f;
+
+	// Size of the depth buffer the overdraw is estimated with, per view
+	const unsigned int OverdrawResolution = 64;
+
+	// View directions of the overdraw estimate: the axes and the diagonals
+	const float OverdrawViews[14][3] = {
+		{ 1, 0, 0}, {-1, 0, 0}, { 0, 1, 0}, { 0,-1, 0}, { 0, 0, 1}, { 0, 0,-1},
+		{ 1, 1, 1}, { 1, 1,-1}, { 1,-1, 1}, { 1,-1,-1},
+		{-1, 1, 1}, {-1, 1,-1}, {-1,-1, 1}, {-1,-1,-1}
+	};
+
+	// --------------------------------------------------------------------------------------------
+	// Precomputed vertex scores by cache position and by number of live triangles
+	struct ScoreTables
+	{
+		explicit ScoreTables(unsigned int cacheSize) {
+			for (unsigned int i = 0; i < cacheSize; ++i) {
+				// the vertices of the last triangle get a fixed score, so that
+				// the next triangle doesn't simply continue a strip
+				cache[i] = i < 3 ? LastTriScore : 
+					::pow(1.f - (i - 3) / (float)(cacheSize - 3), CacheDecayPower);
+			}
+
+			// vertices with few triangles left are preferred to get rid of them
+			valence[0] = 0.f;
+			for (unsigned int i = 1; i < MaxValence; ++i) {
+				valence[i] = ValenceBoostScale * ::pow((float)i, -ValenceBoostPower);
+			}
+		}
+
+		float VertexScore(int cachePos, unsigned int liveTriangles) const {
+			if (!liveTriangles) {
+				return -1.f;
+			}
+			return (cachePos >= 0 ? cache[cachePos] : 0.f) + valence[std::min(liveTriangles,MaxValence-1)];
+		}
+
+		float cache[MaxCacheSize];
+		float valence[MaxValence];
+	};
+
+	// --------------------------------------------------------------------------------------------
+	// Simulated FIFO cache. A vertex is cached if less than 'size' misses occurred since
+	// its own miss, which is tracked by time stamps.
+	struct FifoCache
+	{
+		FifoCache(unsigned int numVertices, unsigned int cacheSize) 
+			: stamps(numVertices,0), time(cacheSize+1), size(cacheSize) {}
+
+		unsigned int Access(unsigned int v) {
+			if (time - stamps[v] > size) {
+				stamps[v] = time++;
+				return 1;
+			}
+			return 0;
+		}
+
+		// evicts all vertices
+		void Flush() {
+			time += size+1;
+		}
+
+		std::vector<unsigned int> stamps;
+		unsigned int time, size;
+	};
+
+	// --------------------------------------------------------------------------------------------
+	// Moves an array of per-vertex data to the new vertex indices
+	template <typename T>
+	void Remap(T*& data, const std::vector<unsigned int>& remap) {
+		if (!data) {
+			return;
+		}
+		T* out = new T[remap.size()];
+		for (size_t i = 0; i < remap.size(); ++i) {
+			out[remap[i]] = data[i];
+		}
+		delete[] data;
+		data = out;
+	}
+
+} // namespace
+
+// ------------------------------------------------------------------------------------------------
+// Constructor to be privately used by Importer
+OptimizeVertexCacheProcess::OptimizeVertexCacheProcess()
+: configCacheSize(PP_OVC_CACHE_SIZE)
+, configOverdrawThreshold(PP_OVC_OVERDRAW_THRESHOLD)
+{
+}
+
+// ------------------------------------------------------------------------------------------------
+// Destructor, private as well
+OptimizeVertexCacheProcess::~OptimizeVertexCacheProcess()
+{
+	// nothing to do here
+}
+
+// ------------------------------------------------------------------------------------------------
+// Returns whether the processing step is present in the given flag field.
+bool OptimizeVertexCacheProcess::IsActive( unsigned int pFlags) const
+{
+	return (pFlags & aiProcess_OptimizeVertexCache) != 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Setup configuration
+void OptimizeVertexCacheProcess::SetupProperties(const Importer* pImp)
+{
+	const int cacheSize = pImp->GetPropertyInteger(AI_CONFIG_PP_OVC_CACHE_SIZE,PP_OVC_CACHE_SIZE);
+	configCacheSize = std::max(4, std::min((int)MaxCacheSize, cacheSize));
+
+	configOverdrawThreshold = pImp->GetPropertyFloat(AI_CONFIG_PP_OVC_OVERDRAW_THRESHOLD,PP_OVC_OVERDRAW_THRESHOLD);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Executes the post processing step on the given imported data.
+void OptimizeVertexCacheProcess::Execute( aiScene* pScene)
+{
+	if (!pScene->mNumMeshes) {
+		DefaultLogger::get()->debug("OptimizeVertexCacheProcess skipped; there are no meshes");
+		return;
+	}
+
+	DefaultLogger::get()->debug("OptimizeVertexCacheProcess begin");
+
+	std::vector<MeshStats> stats;
+	ExecutePerMesh(pScene->mMeshes,pScene->mNumMeshes,&OptimizeVertexCacheProcess::ProcessMesh,stats);
+
+	if (!DefaultLogger::isNullLogger()) {
+		unsigned int numm = 0, numf = 0, numv = 0, missesIn = 0, missesOut = 0;
+		float overdrawIn = 0.f, overdrawOut = 0.f;
+		for (std::vector<MeshStats>::const_iterator it = stats.begin(); it != stats.end(); ++it) {
+			if ((*it).faces) {
+				++numm;
+				numf += (*it).faces;
+				numv += (*it).vertices;
+				missesIn  += (*it).missesIn;
+				missesOut += (*it).missesOut;
+
+				// weighted by faces
+				overdrawIn  += (*it).overdrawIn * (*it).faces;
+				overdrawOut += (*it).overdrawOut * (*it).faces;
+			}
+		}
+
+		if (numf) {
+			char szBuff[256]; // should be sufficiently large in every case
+			::sprintf(szBuff,"OptimizeVertexCacheProcess finished | %u meshes (%u faces) | "
+				"ACMR in: %f out: %f | ATVR in: %f out: %f | overdraw in: %f out: %f",numm,numf,
+				(float)missesIn / numf,(float)missesOut / numf,
+				(float)missesIn / numv,(float)missesOut / numv,
+				overdrawIn / numf,overdrawOut / numf);
+			DefaultLogger::get()->info(szBuff);
+		}
+		else DefaultLogger::get()->debug("OptimizeVertexCacheProcess finished, no triangle meshes");
+	}
+}
+
+// ------------------------------------------------------------------------------------------------
+// Optimizes a specific mesh
+OptimizeVertexCacheProcess::MeshStats OptimizeVertexCacheProcess::ProcessMesh( aiMesh* pMesh, unsigned int meshNum)
+{
+	ai_assert(NULL != pMesh);
+	MeshStats stats;
+
+	// Check whether the input data is valid
+	// - there must be vertices and faces 
+	// - all faces must be triangulated or we can't operate on them
+	if (!pMesh->HasFaces() || !pMesh->HasPositions())
+		return stats;
+
+	if (pMesh->mPrimitiveTypes != aiPrimitiveType_TRIANGLE)	{
+		DefaultLogger::get()->error("This algorithm works on triangle meshes only");
+		return stats;
+	}
+
+	// one large index buffer instead of the faces
+	std::vector<unsigned int> indices(pMesh->mNumFaces*3);
+	for (unsigned int i = 0; i < pMesh->mNumFaces; ++i) {
+		const aiFace& face = pMesh->mFaces[i];
+		std::copy(face.mIndices,face.mIndices+3,indices.begin()+i*3);
+	}
+
+	stats.faces    = pMesh->mNumFaces;
+	stats.vertices = pMesh->mNumVertices;
+	stats.missesIn = CountCacheMisses(&indices[0],(unsigned int)indices.size(),pMesh->mNumVertices,configCacheSize);
+	stats.overdrawIn = EstimateOverdraw(pMesh->mVertices,pMesh->mNumVertices,&indices[0],(unsigned int)indices.size());
+
+	OptimizeCache(pMesh->mFaces,pMesh->mNumFaces,pMesh->mNumVertices,indices);
+	stats.overdrawOut = OptimizeOverdraw(pMesh,indices);
+
+	// levels of detail are optimized on their own, but share the vertex order
+	std::vector< std::vector<unsigned int> > lodIndices(pMesh->mNumLODs);
+	for (unsigned int a = 0; a < pMesh->mNumLODs; ++a) {
+		const aiMeshLOD* lod = pMesh->mLODs[a];
+		lodIndices[a].resize(lod->mNumFaces*3);
+		OptimizeCache(lod->mFaces,lod->mNumFaces,pMesh->mNumVertices,lodIndices[a]);
+		OptimizeOverdraw(pMesh,lodIndices[a]);
+	}
+
+	OptimizeFetch(pMesh,indices,lodIndices);
+
+	stats.missesOut = CountCacheMisses(&indices[0],(unsigned int)indices.size(),pMesh->mNumVertices,configCacheSize);
+
+	// sort the output index buffer back to the input array
+	for (unsigned int i = 0; i < pMesh->mNumFaces; ++i) {
+		aiFace& face = pMesh->mFaces[i];
+		std::copy(indices.begin()+i*3,indices.begin()+i*3+3,face.mIndices);
+	}
+	for (unsigned int a = 0; a < pMesh->mNumLODs; ++a) {
+		aiMeshLOD* lod = pMesh->mLODs[a];
+		for (unsigned int i = 0; i < lod->mNumFaces; ++i) {
+			std::copy(lodIndices[a].begin()+i*3,lodIndices[a].begin()+i*3+3,lod->mFaces[i].mIndices);
+		}
+	}
+
+	// very intense verbose logging ... prepare for much text if there are many meshes
+	if (!DefaultLogger::isNullLogger() && DefaultLogger::get()->getLogSeverity() == Logger::VERBOSE) {
+		char szBuff[192]; // should be sufficiently large in every case
+		::sprintf(szBuff,"Mesh %u | ACMR in: %f out: %f | ATVR in: %f out: %f | overdraw in: %f out: %f",meshNum,
+			(float)stats.missesIn / stats.faces,(float)stats.missesOut / stats.faces,
+			(float)stats.missesIn / stats.vertices,(float)stats.missesOut / stats.vertices,
+			stats.overdrawIn,stats.overdrawOut);
+		DefaultLogger::get()->debug(szBuff);
+	}
+	return stats;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Counts the cache misses of an index buffer
+unsigned int OptimizeVertexCacheProcess::CountCacheMisses(const unsigned int* pIndices, 
+	unsigned int iNumIndices, unsigned int iNumVertices, unsigned int iCacheSize)
+{
+	FifoCache cache(iNumVertices,iCacheSize);
+
+	unsigned int misses = 0;
+	for (unsigned int i = 0; i < iNumIndices; ++i) {
+		misses += cache.Access(pIndices[i]);
+	}
+	return misses;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Estimates the overdraw of an index buffer, averaged over a fixed set of views
+float OptimizeVertexCacheProcess::EstimateOverdraw(const aiVector3D* pVertices,
+	unsigned int iNumVertices, const unsigned int* pIndices, unsigned int iNumIndices)
+{
+	// the views are fit to the bounding sphere of the mesh
+	aiVector3D min, max;
+	ArrayBounds(pVertices,iNumVertices,min,max);
+	const aiVector3D center = (min + max) * 0.5f;
+	const float radius = (max - min).Length() * 0.5f;
+	if (radius <= 0.f) {
+		return 1.f;
+	}
+	const float half = OverdrawResolution * 0.5f;
+	const float scale = half / radius;
+
+	std::vector<float> depth(OverdrawResolution*OverdrawResolution);
+	std::vector<aiVector3D> projected(iNumVertices);
+	unsigned int passed = 0, covered = 0;
+
+	for (unsigned int d = 0; d < sizeof(OverdrawViews) / sizeof(OverdrawViews[0]); ++d) {
+
+		// the viewer looks along -w, u ^ v = w keeps counter-clockwise faces in front
+		const aiVector3D w = aiVector3D(OverdrawViews[d][0],OverdrawViews[d][1],OverdrawViews[d][2]).Normalize();
+		const aiVector3D u = (w ^ (::fabs(w.x) < 0.9f ? aiVector3D(1.f,0.f,0.f) : aiVector3D(0.f,1.f,0.f))).Normalize();
+		const aiVector3D v = w ^ u;
+
+		for (unsigned int i = 0; i < iNumVertices; ++i) {
+			const aiVector3D p = pVertices[i] - center;
+			projected[i] = aiVector3D((p * u) * scale + half, (p * v) * scale + half, -(p * w));
+		}
+		std::fill(depth.begin(),depth.end(),1e30f);
+
+		for (unsigned int i = 0; i + 2 < iNumIndices; i += 3) {
+			const aiVector3D& a = projected[pIndices[i]];
+			const aiVector3D& b = projected[pIndices[i+1]];
+			const aiVector3D& c = projected[pIndices[i+2]];
+
+			// back faces and degenerates are culled
+			const float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+			if (area <= 0.f) {
+				continue;
+			}
+
+			const int x0 = std::max(0,(int)::floor(std::min(a.x,std::min(b.x,c.x))));
+			const int x1 = std::min((int)OverdrawResolution-1,(int)::ceil(std::max(a.x,std::max(b.x,c.x))));
+			const int y0 = std::max(0,(int)::floor(std::min(a.y,std::min(b.y,c.y))));
+			const int y1 = std::min((int)OverdrawResolution-1,(int)::ceil(std::max(a.y,std::max(b.y,c.y))));
+
+			// pixel centers inside the triangle pass if nearer than the depth buffer
+			for (int y = y0; y <= y1; ++y) {
+				const float py = y + 0.5f;
+				for (int x = x0; x <= x1; ++x) {
+					const float px = x + 0.5f;
+					const float w0 = ((b.x - px) * (c.y - py) - (b.y - py) * (c.x - px)) / area;
+					const float w1 = ((c.x - px) * (a.y - py) - (c.y - py) * (a.x - px)) / area;
+					const float w2 = 1.f - w0 - w1;
+					if (w0 < 0.f || w1 < 0.f || w2 < 0.f) {
+						continue;
+					}
+
+					float& z = depth[y*OverdrawResolution+x];
+					const float fz = w0 * a.z + w1 * b.z + w2 * c.z;
+					if (fz < z) {
+						covered += z == 1e30f;
+						passed++;
+						z = fz;
+					}
+				}
+			}
+		}
+	}
+	return covered ? (float)passed / covered : 1.f;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Reorders the triangles for the vertex cache
+void OptimizeVertexCacheProcess::OptimizeCache(aiFace* pcFaces, unsigned int numFaces, 
+	unsigned int numVertices, std::vector<unsigned int>& indices) const
+{
+	const ScoreTables scores(configCacheSize);
+
+	// the live triangles of each vertex are kept at the front of its adjacency list
+	VertexTriangleAdjacency adj(pcFaces,numFaces,numVertices,true);
+	unsigned int* const live = adj.mLiveTriangles;
+
+	std::vector<int> cachePos(numVertices,-1);
+	std::vector<float> vertexScore(numVertices);
+	for (unsigned int v = 0; v < numVertices; ++v) {
+		vertexScore[v] = scores.VertexScore(-1,live[v]);
+	}
+
+	// start with the best triangle overall
+	unsigned int best = 0;
+	float bestScore = -1.f;
+	for (unsigned int f = 0; f < numFaces; ++f) {
+		const unsigned int* idx = pcFaces[f].mIndices;
+		const float score = vertexScore[idx[0]] + vertexScore[idx[1]] + vertexScore[idx[2]];
+		if (score > bestScore) {
+			bestScore = score;
+			best = f;
+		}
+	}
+
+	std::vector<unsigned char> emitted(numFaces,0);
+	std::vector<unsigned int> cache, newCache;
+	cache.reserve(configCacheSize+3);
+	newCache.reserve(configCacheSize+3);
+
+	unsigned int cursor = 0;
+	unsigned int* out = &indices[0];
+
+	while (best != UINT_MAX) {
+		const unsigned int* idx = pcFaces[best].mIndices;
+		emitted[best] = 1;
+
+		// emit the triangle, its vertices move to the front of the LRU cache
+		newCache.clear();
+		for (unsigned int k = 0; k < 3; ++k) {
+			const unsigned int v = idx[k];
+			*out++ = v;
+
+			unsigned int* tris = adj.GetAdjacentTriangles(v);
+			const unsigned int n = live[v]--;
+			for (unsigned int i = 0; i < n; ++i) {
+				if (tris[i] == best) {
+					std::swap(tris[i],tris[n-1]);
+					break;
+				}
+			}
+
+			if (std::find(newCache.begin(),newCache.end(),v) == newCache.end()) {
+				newCache.push_back(v);
+			}
+		}
+		for (std::vector<unsigned int>::const_iterator it = cache.begin(); it != cache.end(); ++it) {
+			if (*it != idx[0] && *it != idx[1] && *it != idx[2]) {
+				newCache.push_back(*it);
+			}
+		}
+
+		// update the scores of all cached vertices and the ones just evicted
+		for (unsigned int i = 0; i < newCache.size(); ++i) {
+			const unsigned int v = newCache[i];
+			cachePos[v] = i < configCacheSize ? (int)i : -1;
+			vertexScore[v] = scores.VertexScore(cachePos[v],live[v]);
+		}
+
+		// the next triangle is the best one using these vertices
+		best = UINT_MAX;
+		bestScore = -1.f;
+		for (unsigned int i = 0; i < newCache.size(); ++i) {
+			const unsigned int v = newCache[i];
+			const unsigned int* tris = adj.GetAdjacentTriangles(v);
+			for (unsigned int t = 0; t < live[v]; ++t) {
+				const unsigned int* tidx = pcFaces[tris[t]].mIndices;
+				const float score = vertexScore[tidx[0]] + vertexScore[tidx[1]] + vertexScore[tidx[2]];
+				if (score > bestScore) {
+					bestScore = score;
+					best = tris[t];
+				}
+			}
+		}
+
+		if (newCache.size() > configCacheSize) {
+			newCache.resize(configCacheSize);
+		}
+		cache.swap(newCache);
+
+		// nothing left around the cache, continue with the next triangle in input order
+		if (best == UINT_MAX) {
+			while (cursor < numFaces && emitted[cursor]) {
+				++cursor;
+			}
+			if (cursor < numFaces) {
+				best = cursor;
+			}
+		}
+	}
+	ai_assert(out == &indices[0] + indices.size());
+}
+
+// ------------------------------------------------------------------------------------------------
+// Reorders clusters of triangles to reduce overdraw
+float OptimizeVertexCacheProcess::OptimizeOverdraw(const aiMesh* pMesh, std::vector<unsigned int>& indices) const
+{
+	const unsigned int numFaces = (unsigned int)indices.size() / 3;
+	if (numFaces < 2) {
+		return 1.f;
+	}
+
+	const float overdraw = EstimateOverdraw(pMesh->mVertices,pMesh->mNumVertices,&indices[0],(unsigned int)indices.size());
+	if (configOverdrawThreshold < 1.f) {
+		return overdraw;
+	}
+
+	FifoCache cache(pMesh->mNumVertices,configCacheSize);
+
+	// Hard boundaries are where the optimized order misses all vertices of a face,
+	// so reordering there does not cost any cache efficiency.
+	std::vector<unsigned int> hard;
+	for (unsigned int f = 0; f < numFaces; ++f) {
+		const unsigned int* idx = &indices[f*3];
+		if (cache.Access(idx[0]) + cache.Access(idx[1]) + cache.Access(idx[2]) == 3) {
+			hard.push_back(f);
+		}
+	}
+	hard.push_back(numFaces);
+
+	// Each hard cluster is split into clusters as soon as their ACMR (starting
+	// with an empty cache) is within the threshold of the hard cluster's ACMR.
+	std::vector<unsigned int> clusters;
+	for (unsigned int h = 0; h + 1 < hard.size(); ++h) {
+		const unsigned int begin = hard[h], end = hard[h+1];
+
+		cache.Flush();
+		unsigned int misses = 0;
+		for (unsigned int i = begin*3; i < end*3; ++i) {
+			misses += cache.Access(indices[i]);
+		}
+		const float threshold = configOverdrawThreshold * misses / (end - begin);
+
+		cache.Flush();
+		clusters.push_back(begin);
+		unsigned int runMisses = 0, runFaces = 0;
+		for (unsigned int f = begin; f < end; ++f) {
+			const unsigned int* idx = &indices[f*3];
+			runMisses += cache.Access(idx[0]) + cache.Access(idx[1]) + cache.Access(idx[2]);
+			++runFaces;
+
+			if (f + 1 < end && runMisses <= threshold * runFaces) {
+				clusters.push_back(f+1);
+				cache.Flush();
+				runMisses = runFaces = 0;
+			}
+		}
+	}
+	clusters.push_back(numFaces);
+
+	const unsigned int numClusters = (unsigned int)clusters.size() - 1;
+	if (numClusters < 2) {
+		return overdraw;
+	}
+
+	// Area weighted centroid and normal of each cluster. Clusters far out on the
+	// mesh' outside are most likely to occlude others, thus they go first.
+	std::vector<aiVector3D> centroids(numClusters), normals(numClusters);
+	std::vector<float> areas(numClusters,0.f);
+	aiVector3D meshCentroid;
+	float meshArea = 0.f;
+
+	for (unsigned int c = 0; c < numClusters; ++c) {
+		for (unsigned int f = clusters[c]; f < clusters[c+1]; ++f) {
+			const aiVector3D& p0 = pMesh->mVertices[indices[f*3]];
+			const aiVector3D& p1 = pMesh->mVertices[indices[f*3+1]];
+			const aiVector3D& p2 = pMesh->mVertices[indices[f*3+2]];
+
+			const aiVector3D normal = (p1 - p0) ^ (p2 - p0);
+			const float area = normal.Length();
+
+			centroids[c] += (p0 + p1 + p2) * (area / 3.f);
+			normals[c] += normal;
+			areas[c] += area;
+		}
+		meshCentroid += centroids[c];
+		meshArea += areas[c];
+
+		if (areas[c] > 0.f) {
+			centroids[c] /= areas[c];
+		}
+	}
+	if (meshArea > 0.f) {
+		meshCentroid /= meshArea;
+	}
+
+	std::vector<std::pair<float,unsigned int> > order(numClusters);
+	for (unsigned int c = 0; c < numClusters; ++c) {
+		const float length = normals[c].Length();
+		const float dist = length > 0.f ? ((centroids[c] - meshCentroid) * normals[c]) / length : 0.f;
+
+		// negated, so that sorting ascending puts the outmost clusters first
+		order[c] = std::make_pair(-dist,c);
+	}
+	std::sort(order.begin(),order.end());
+
+	std::vector<unsigned int> sorted;
+	sorted.reserve(indices.size());
+	for (unsigned int i = 0; i < numClusters; ++i) {
+		const unsigned int c = order[i].second;
+		sorted.insert(sorted.end(),indices.begin()+clusters[c]*3,indices.begin()+clusters[c+1]*3);
+	}
+
+	// The sorting is a heuristic, which can fail on concave meshes. In
+	// that case, the order optimized for the cache is kept.
+	const float sortedOverdraw = EstimateOverdraw(pMesh->mVertices,pMesh->mNumVertices,&sorted[0],(unsigned int)sorted.size());
+	if (sortedOverdraw >= overdraw) {
+		return overdraw;
+	}
+	indices.swap(sorted);
+	return sortedOverdraw;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Reorders the vertices in the order of their first use
+void OptimizeVertexCacheProcess::OptimizeFetch(aiMesh* pMesh, std::vector<unsigned int>& indices,
+	std::vector< std::vector<unsigned int> >& lodIndices) const
+{
+	std::vector<unsigned int> remap(pMesh->mNumVertices,UINT_MAX);
+	unsigned int next = 0;
+	for (std::vector<unsigned int>::const_iterator it = indices.begin(); it != indices.end(); ++it) {
+		if (remap[*it] == UINT_MAX) {
+			remap[*it] = next++;
+		}
+	}
+
+	// unreferenced vertices are kept at the end
+	bool identity = true;
+	for (unsigned int v = 0; v < pMesh->mNumVertices; ++v) {
+		if (remap[v] == UINT_MAX) {
+			remap[v] = next++;
+		}
+		identity = identity && remap[v] == v;
+	}
+	if (identity) {
+		return;
+	}
+
+	for (std::vector<unsigned int>::iterator it = indices.begin(); it != indices.end(); ++it) {
+		*it = remap[*it];
+	}
+	for (unsigned int a = 0; a < lodIndices.size(); ++a) {
+		for (std::vector<unsigned int>::iterator it = lodIndices[a].begin(); it != lodIndices[a].end(); ++it) {
+			*it = remap[*it];
+		}
+	}
+
+	Remap(pMesh->mVertices,remap);
+	Remap(pMesh->mNormals,remap);
+	Remap(pMesh->mTangents,remap);
+	Remap(pMesh->mBitangents,remap);
+	for (unsigned int i = 0; i < AI_MAX_NUMBER_OF_COLOR_SETS; ++i) {
+		Remap(pMesh->mColors[i],remap);
+	}
+	for (unsigned int i = 0; i < AI_MAX_NUMBER_OF_TEXTURECOORDS; ++i) {
+		Remap(pMesh->mTextureCoords[i],remap);
+	}
+
+	for (unsigned int a = 0; a < pMesh->mNumBones; ++a) {
+		aiBone* bone = pMesh->mBones[a];
+		for (unsigned int b = 0; b < bone->mNumWeights; ++b) {
+			bone->mWeights[b].mVertexId = remap[bone->mWeights[b].mVertexId];
+		}
+	}
+
+	for (unsigned int a = 0; a < pMesh->mNumAnimMeshes; ++a) {
+		aiAnimMesh* anim = pMesh->mAnimMeshes[a];
+		if (anim->mNumVertices != pMesh->mNumVertices) {
+			continue;
+		}
+		Remap(anim->mVertices,remap);
+		Remap(anim->mNormals,remap);
+		Remap(anim->mTangents,remap);
+		Remap(anim->mBitangents,remap);
+		for (unsigned int i = 0; i < AI_MAX_NUMBER_OF_COLOR_SETS; ++i) {
+			Remap(anim->mColors[i],remap);
+		}
+		for (unsigned int i = 0; i < AI_MAX_NUMBER_OF_TEXTURECOORDS; ++i) {
+			Remap(anim->mTextureCoords[i],remap);
+		}
+	}
+}
+
+#endif // !! ASSIMP_BUILD_NO_OPTIMIZEVERTEXCACHE_PROCESS
@@ -0,0 +1,169 @@
+/*
+Open Asset Import Library (assimp)
+----------------------------------------------------------------------
+
+Copyright (c) 2006-2012, assimp team
+All rights reserved.
+
+Redistribution and use of this software in source and binary forms, 
+with or without modification, are permitted provided that the 
+following conditions are met:
+
+* Redistributions of source code must retain the above
+  copyright notice, this list of conditions and the
+  following disclaimer.
+
+* Redistributions in binary form must reproduce the above
+  copyright notice, this list of conditions and the
+  following disclaimer in the documentation and/or other
+  materials provided with the distribution.
+
+* Neither the name of the assimp team, nor the names of its
+  contributors may be used to endorse or promote products
+  derived from this software without specific prior
+  written permission of the assimp team.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS 
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT 
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT 
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT 
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY 
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT 
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+----------------------------------------------------------------------
+*/
+
+/** @file Defines a post processing step to optimize meshes for the
+ *  post-transform vertex cache, overdraw and vertex fetch */
+#ifndef AI_OPTIMIZEVERTEXCACHE_H_INC
+#define AI_OPTIMIZEVERTEXCACHE_H_INC
+
+#include "BaseProcess.h"
+#include "../include/assimp/types.h"
+
+struct aiMesh;
+struct aiFace;
+
+namespace Assimp
+{
+
+// ---------------------------------------------------------------------------
+/** The OptimizeVertexCacheProcess reorders the faces of all meshes for the
+ *  post-transform vertex cache, then reorders clusters of faces to reduce
+ *  overdraw (if that lowers the overdraw estimated from a set of views
+ *  around the mesh) and finally reorders the vertices in the order of their
+ *  first use. It supersedes #ImproveCacheLocalityProcess, which is skipped if
+ *  both steps are requested.
+ *
+ *  @note This step expects triangulated input data.
+ */
+class OptimizeVertexCacheProcess : public BaseProcess
+{
+public:
+
+	OptimizeVertexCacheProcess();
+	~OptimizeVertexCacheProcess();
+
+public:
+
+	// -------------------------------------------------------------------
+	// Check whether the pp step is active
+	bool IsActive( unsigned int pFlags) const;
+
+	// -------------------------------------------------------------------
+	// Executes the pp step on a given scene
+	void Execute( aiScene* pScene);
+
+	// -------------------------------------------------------------------
+	// Configures the pp step
+	void SetupProperties(const Importer* pImp);
+
+public:
+
+	// -------------------------------------------------------------------
+	/** Vertex cache and overdraw statistics of a mesh, before and after
+	 *  the step. ACMR = misses / faces, ATVR = misses / vertices (1.0 is
+	 *  optimal), overdraw as returned by #EstimateOverdraw. All zero if the
+	 *  mesh was not processed. */
+	struct MeshStats
+	{
+		MeshStats() : faces(), vertices(), missesIn(), missesOut(), overdrawIn(), overdrawOut() {}
+
+		unsigned int faces, vertices;
+		unsigned int missesIn, missesOut;
+		float overdrawIn, overdrawOut;
+	};
+
+	// -------------------------------------------------------------------
+	/** Counts the cache misses of a triangle index buffer in a simulated
+	 *  FIFO cache of the given size.
+	 * @param pIndices Indices, three per triangle
+	 * @param iNumIndices Number of indices
+	 * @param iNumVertices Number of vertices referenced
+	 * @param iCacheSize Number of vertices in the cache */
+	static unsigned int CountCacheMisses(const unsigned int* pIndices, 
+		unsigned int iNumIndices, unsigned int iNumVertices, 
+		unsigned int iCacheSize);
+
+	// -------------------------------------------------------------------
+	/** Estimates the overdraw of a triangle index buffer, independent of
+	 *  the view: the front faces are rasterized orthographically from the
+	 *  axes and the diagonals into a small depth buffer each. The result
+	 *  is the number of fragments passing the depth test per covered
+	 *  pixel (1.0 is optimal).
+	 * @param pVertices Vertex positions
+	 * @param iNumVertices Number of vertices referenced
+	 * @param pIndices Indices, three per counter-clockwise triangle
+	 * @param iNumIndices Number of indices */
+	static float EstimateOverdraw(const aiVector3D* pVertices,
+		unsigned int iNumVertices, const unsigned int* pIndices,
+		unsigned int iNumIndices);
+
+protected:
+	// -------------------------------------------------------------------
+	/** Executes the postprocessing step on the given mesh
+	 * @param pMesh The mesh to process.
+	 * @param meshNum Index of the mesh to process
+	 */
+	MeshStats ProcessMesh( aiMesh* pMesh, unsigned int meshNum);
+
+	// -------------------------------------------------------------------
+	/** Reorders the triangles for the vertex cache, using Tom Forsyth's
+	 *  linear-speed algorithm with a simulated LRU cache. The faces are
+	 *  those of the mesh or of one of its levels of detail. */
+	void OptimizeCache(aiFace* pcFaces, unsigned int numFaces, 
+		unsigned int numVertices, std::vector<unsigned int>& indices) const;
+
+	// -------------------------------------------------------------------
+	/** Splits the triangles into clusters which keep the ACMR within
+	 *  the overdraw threshold and sorts them front to back, from the 
+	 *  mesh's point of view (Sander et al. 2007). The sorted order is
+	 *  only kept if it lowers the estimated overdraw.
+	 * @return Estimated overdraw of the resulting order */
+	float OptimizeOverdraw(const aiMesh* pMesh, std::vector<unsigned int>& indices) const;
+
+	// -------------------------------------------------------------------
+	/** Reorders all vertex components in the order of their first use
+	 *  and remaps the indices of the levels of detail accordingly */
+	void OptimizeFetch(aiMesh* pMesh, std::vector<unsigned int>& indices,
+		std::vector< std::vector<unsigned int> >& lodIndices) const;
+
+private:
+	//! Configuration parameter: size of the simulated LRU cache
+	//! (and of the FIFO cache the statistics are computed for)
+	unsigned int configCacheSize;
+
+	//! Configuration parameter: factor by which the ACMR of a cluster
+	//! may exceed the one of the optimized mesh, below 1 disables 
+	//! the overdraw optimization
+	float configOverdrawThreshold;
+};
+
+} // end of namespace Assimp
+
+#endif // AI_OPTIMIZEVERTEXCACHE_H_INC
@@ -109,10 +109,11 @@ void PLYImporter::InternReadFile( const std::string& pFile,
 		throw DeadlyImportError( "Failed to open PLY file " + pFile + ".");
 	}
 
-	// allocate storage and copy the contents of the file to a memory buffer
+	// map the file or copy its contents to a memory buffer
 	std::vector<char> mBuffer2;
-	TextFileToBuffer(file.get(),mBuffer2);
-	mBuffer = (unsigned char*)&mBuffer2[0];
+	const char *begin, *end;
+	TextFileToRange(file.get(),mBuffer2,begin,end);
+	mBuffer = (const unsigned char*)begin;
 
 	// the beginning of the file must be PLY - magic, magic
 	if ((mBuffer[0] != 'P' && mBuffer[0] != 'p') ||
@@ -121,8 +122,8 @@ void PLYImporter::InternReadFile( const std::string& pFile,
 		throw DeadlyImportError( "Invalid .ply file: Magic number \'ply\' is no there");
 	}
 
-	char* szMe = (char*)&this->mBuffer[3];
-	SkipSpacesAndLineEnd(szMe,(const char**)&szMe);
+	const char* szMe = (const char*)&this->mBuffer[3];
+	SkipSpacesAndLineEnd(szMe,&szMe);
 	
 	// determine the format of the file data
 	PLY::DOM sPlyDom;
@@ -130,7 +131,7 @@ void PLYImporter::InternReadFile( const std::string& pFile,
 	{
 		if (TokenMatch(szMe,"ascii",5))
 		{
-			SkipLine(szMe,(const char**)&szMe);
+			SkipLine(szMe,&szMe);
 			if(!PLY::DOM::ParseInstance(szMe,&sPlyDom))
 				throw DeadlyImportError( "Invalid .ply file: Unable to build DOM (#1)");
 		}
@@ -148,7 +149,7 @@ void PLYImporter::InternReadFile( const std::string& pFile,
 #endif // ! AI_BUILD_BIG_ENDIAN
 
 			// skip the line, parse the rest of the header and build the DOM
-			SkipLine(szMe,(const char**)&szMe);
+			SkipLine(szMe,&szMe);
 			if(!PLY::DOM::ParseInstanceBinary(szMe,&sPlyDom,bIsBE))
 				throw DeadlyImportError( "Invalid .ply file: Unable to build DOM (#2)");
 		}
@@ -156,8 +157,6 @@ void PLYImporter::InternReadFile( const std::string& pFile,
 	}
 	else
 	{
-		delete[] this->mBuffer;
-		AI_DEBUG_INVALIDATE_PTR(this->mBuffer);
 		throw DeadlyImportError( "Invalid .ply file: Missing format specification");
 	}
 	this->pcDOM = &sPlyDom;
@@ -158,8 +158,8 @@ protected:
 		PLY::EDataType eType);
 
 
-	/** Buffer to hold the loaded file */
-	unsigned char* mBuffer;
+	/** Contents of the loaded file (mapped or buffered, not owned) */
+	const unsigned char* mBuffer;
 
 	/** Document object model representation extracted from the file */
 	PLY::DOM* pcDOM;
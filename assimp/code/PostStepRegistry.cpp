@@ -81,9 +81,15 @@ corresponding preprocessor flag to selectively disable steps.
 #ifndef ASSIMP_BUILD_NO_VALIDATEDS_PROCESS
 #	include "ValidateDataStructure.h"
 #endif
+#ifndef ASSIMP_BUILD_NO_GENLODS_PROCESS
+#	include "GenLODsProcess.h"
+#endif
 #ifndef ASSIMP_BUILD_NO_IMPROVECACHELOCALITY_PROCESS
 #	include "ImproveCacheLocality.h"
 #endif
+#ifndef ASSIMP_BUILD_NO_OPTIMIZEVERTEXCACHE_PROCESS
+#	include "OptimizeVertexCache.h"
+#endif
 #ifndef ASSIMP_BUILD_NO_FIXINFACINGNORMALS_PROCESS
 #	include "FixNormalsStep.h"
 #endif
@@ -221,9 +227,15 @@ void GetPostProcessingStepInstanceList(std::vector< BaseProcess* >& out)
 #if (!defined ASSIMP_BUILD_NO_LIMITBONEWEIGHTS_PROCESS)
 	out.push_back( new LimitBoneWeightsProcess());
 #endif
+#if (!defined ASSIMP_BUILD_NO_GENLODS_PROCESS)
+	out.push_back( new GenLODsProcess());
+#endif
 #if (!defined ASSIMP_BUILD_NO_IMPROVECACHELOCALITY_PROCESS)
 	out.push_back( new ImproveCacheLocalityProcess());
 #endif
+#if (!defined ASSIMP_BUILD_NO_OPTIMIZEVERTEXCACHE_PROCESS)
+	out.push_back( new OptimizeVertexCacheProcess());
+#endif
 }
 
 }
@@ -323,7 +323,7 @@ class ComputeSpatialSortProcess : public BaseProcess
 	bool IsActive( unsigned int pFlags) const
 	{
 		return NULL != shared && 0 != (pFlags & (aiProcess_CalcTangentSpace | 
-			aiProcess_GenNormals | aiProcess_JoinIdenticalVertices));
+			aiProcess_GenNormals | aiProcess_GenSmoothNormals));
 	}
 
 	void Execute( aiScene* pScene)
@@ -352,7 +352,7 @@ class DestroySpatialSortProcess : public BaseProcess
 	bool IsActive( unsigned int pFlags) const
 	{
 		return NULL != shared && 0 != (pFlags & (aiProcess_CalcTangentSpace | 
-			aiProcess_GenNormals | aiProcess_JoinIdenticalVertices));
+			aiProcess_GenNormals | aiProcess_GenSmoothNormals));
 	}
 
 	void Execute( aiScene* /*pScene*/)
@@ -111,13 +111,14 @@ void STLImporter::InternReadFile( const std::string& pFile,
 
 	fileSize = (unsigned int)file->FileSize();
 
-	// allocate storage and copy the contents of the file to a memory buffer
-	// (terminate it with zero)
+	// map the file or copy its contents to a memory buffer
+	// (terminated with zero either way)
 	std::vector<char> mBuffer2;
-	TextFileToBuffer(file.get(),mBuffer2);
+	const char *begin, *end;
+	TextFileToRange(file.get(),mBuffer2,begin,end);
 
 	this->pScene = pScene;
-	this->mBuffer = &mBuffer2[0];
+	this->mBuffer = begin;
 
 	// the default vertex color is white
 	clrColorDefault.r = clrColorDefault.g = clrColorDefault.b = clrColorDefault.a = 1.0f;
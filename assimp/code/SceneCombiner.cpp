@@ -1004,6 +1004,28 @@ void SceneCombiner::Copy     (aiMesh** _dest, const aiMesh* src)
 		aiFace& f = dest->mFaces[i];
 		GetArrayCopy(f.mIndices,f.mNumIndices);
 	}
+
+	// and of all simplified levels
+	CopyPtrArray(dest->mLODs,dest->mLODs,dest->mNumLODs);
+}
+
+// ------------------------------------------------------------------------------------------------
+void SceneCombiner::Copy (aiMeshLOD** _dest, const aiMeshLOD* src)
+{
+	ai_assert(NULL != _dest && NULL != src);
+
+	aiMeshLOD* dest = *_dest = new aiMeshLOD();
+
+	// get a flat copy
+	::memcpy(dest,src,sizeof(aiMeshLOD));
+
+	// and reallocate all arrays
+	GetArrayCopy(dest->mFaces,dest->mNumFaces);
+	for (unsigned int i = 0; i < dest->mNumFaces;++i)
+	{
+		aiFace& f = dest->mFaces[i];
+		GetArrayCopy(f.mIndices,f.mNumIndices);
+	}
 }
 
 // ------------------------------------------------------------------------------------------------
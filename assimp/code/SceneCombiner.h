@@ -333,6 +333,7 @@ public:
 	static void Copy  (aiAnimation** dest, const aiAnimation* src);
 	static void Copy  (aiCamera** dest, const aiCamera* src);
 	static void Copy  (aiBone** dest, const aiBone* src);
+	static void Copy  (aiMeshLOD** dest, const aiMeshLOD* src);
 	static void Copy  (aiLight** dest, const aiLight* src);
 	static void Copy  (aiNodeAnim** dest, const aiNodeAnim* src);
 
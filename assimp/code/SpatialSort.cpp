@@ -44,6 +44,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "AssimpPCH.h"
 #include "SpatialSort.h"
 
+#ifdef _OPENMP
+#	include <omp.h>
+#endif
+
 using namespace Assimp;
 
 // CHAR_BIT seems to be defined under MVSC, but not under GCC. Pray that the correct value is 8.
@@ -51,6 +55,78 @@ using namespace Assimp;
 #	define CHAR_BIT 8
 #endif
 
+namespace {
+
+	// Below this number of positions, the sorting plane alone is fast enough
+	const size_t MinGridPositions = 64;
+
+	// Queries covering more cells than this use the sorting plane
+	const unsigned int MaxQueryCells = 64;
+
+	// Cell coordinates have 21 bits per axis
+	const unsigned int MaxCellCoord = (1u << 21) - 1;
+
+	// Below this number of positions, Finalize() uses a comparison sort
+	const size_t MinRadixSortPositions = 256;
+
+	// --------------------------------------------------------------------------------------------
+	// Maps a float to an unsigned integer of the same order, -0 to the same value as 0
+	inline uint32_t SortableBits( float f) {
+		if (f == 0.f) {
+			f = 0.f;
+		}
+		uint32_t bits;
+		::memcpy( &bits, &f, sizeof(float));
+		return (bits & 0x80000000) ? ~bits : bits | 0x80000000;
+	}
+
+	// --------------------------------------------------------------------------------------------
+	// Stable LSD radix sort of items by 32 bit keys, 11 bits per pass
+	template <typename T>
+	void RadixSort( std::vector<T>& items, std::vector<uint32_t>& keys) {
+		const size_t num = items.size();
+		std::vector<T> tempItems( num);
+		std::vector<uint32_t> tempKeys( num);
+		std::vector<size_t> histogram( 2048);
+
+		for (unsigned int shift = 0; shift < 32; shift += 11) {
+			std::fill( histogram.begin(), histogram.end(), 0);
+			for (size_t i = 0; i < num; ++i) {
+				++histogram[(keys[i] >> shift) & 2047];
+			}
+
+			// all keys share this digit, nothing to be done
+			if (histogram[(keys[0] >> shift) & 2047] == num) {
+				continue;
+			}
+
+			size_t offset = 0;
+			for (size_t d = 0; d < 2048; ++d) {
+				const size_t count = histogram[d];
+				histogram[d] = offset;
+				offset += count;
+			}
+			for (size_t i = 0; i < num; ++i) {
+				const size_t dest = histogram[(keys[i] >> shift) & 2047]++;
+				tempItems[dest] = items[i];
+				tempKeys[dest] = keys[i];
+			}
+			items.swap( tempItems);
+			keys.swap( tempKeys);
+		}
+	}
+
+	// --------------------------------------------------------------------------------------------
+	inline uint64_t CellKey( unsigned int x, unsigned int y, unsigned int z) {
+		return x | ((uint64_t)y << 21) | ((uint64_t)z << 42);
+	}
+
+	inline size_t HashCellKey( uint64_t key) {
+		return (size_t)((key * 0x9e3779b97f4a7c15ull) >> 32);
+	}
+
+} // namespace
+
 // ------------------------------------------------------------------------------------------------
 // Constructs a spatially sorted representation from the given position array.
 SpatialSort::SpatialSort( const aiVector3D* pPositions, unsigned int pNumPositions, 
@@ -59,6 +135,7 @@ SpatialSort::SpatialSort( const aiVector3D* pPositions, unsigned int pNumPositio
 	// define the reference plane. We choose some arbitrary vector away from all basic axises 
 	// in the hope that no model spreads all its vertices along this plane.
 	: mPlaneNormal(0.8523f, 0.34321f, 0.5736f)
+	, mCellInv(0.f)
 {
 	mPlaneNormal.Normalize();
 	Fill(pPositions,pNumPositions,pElementOffset);
@@ -67,6 +144,7 @@ SpatialSort::SpatialSort( const aiVector3D* pPositions, unsigned int pNumPositio
 // ------------------------------------------------------------------------------------------------
 SpatialSort :: SpatialSort()
 : mPlaneNormal(0.8523f, 0.34321f, 0.5736f)
+, mCellInv(0.f)
 {
 	mPlaneNormal.Normalize();
 }
@@ -90,7 +168,139 @@ void SpatialSort::Fill( const aiVector3D* pPositions, unsigned int pNumPositions
 // ------------------------------------------------------------------------------------------------
 void SpatialSort :: Finalize()
 {
-	std::sort( mPositions.begin(), mPositions.end());
+	// Both sorts are stable, so equal distances keep the order of the indices
+	if (mPositions.size() < MinRadixSortPositions) {
+		std::stable_sort( mPositions.begin(), mPositions.end());
+	}
+	else {
+		std::vector<uint32_t> keys( mPositions.size());
+		for (size_t i = 0; i < mPositions.size(); ++i) {
+			keys[i] = SortableBits( mPositions[i].mDistance);
+		}
+		RadixSort( mPositions, keys);
+	}
+
+	BuildGrid();
+}
+
+// ------------------------------------------------------------------------------------------------
+void SpatialSort :: BuildGrid()
+{
+	mGridEntries.clear();
+	mCellKeys.clear();
+	mCellStart.clear();
+	mCellTable.clear();
+	mCellInv = 0.f;
+
+	const size_t num = mPositions.size();
+	if (num < MinGridPositions) {
+		return;
+	}
+
+	aiVector3D minVec = mPositions[0].mPosition, maxVec = minVec;
+	for (size_t i = 1; i < num; ++i) {
+		const aiVector3D& pos = mPositions[i].mPosition;
+		minVec.x = std::min( minVec.x, pos.x); maxVec.x = std::max( maxVec.x, pos.x);
+		minVec.y = std::min( minVec.y, pos.y); maxVec.y = std::max( maxVec.y, pos.y);
+		minVec.z = std::min( minVec.z, pos.z); maxVec.z = std::max( maxVec.z, pos.z);
+	}
+	const aiVector3D extent = maxVec - minVec;
+	const float maxExtent = std::max( extent.x, std::max( extent.y, extent.z));
+
+	// no grid for degenerated or invalid data
+	if (!(maxExtent > 0.f) || !(maxExtent < 1e30f)) {
+		return;
+	}
+
+	// Assume the positions to lie on surfaces, thus the cell size is a few times
+	// their average spacing.
+	mGridMin = minVec;
+	mCellInv = ::sqrt( (float)num) / (2.f * maxExtent);
+
+	size_t tableSize = 16;
+	while (tableSize < num * 2) {
+		tableSize <<= 1;
+	}
+	const size_t mask = tableSize - 1;
+	mCellTable.assign( tableSize, UINT_MAX);
+
+	// assign cell indices in order of appearance and count the entries per cell
+	std::vector<unsigned int> cellOf( num);
+	std::vector<unsigned int> counts;
+	for (size_t i = 0; i < num; ++i) {
+		const aiVector3D& pos = mPositions[i].mPosition;
+		unsigned int cell[3];
+		FindCells( pos, 0.f, cell, cell);
+		const uint64_t key = CellKey( cell[0], cell[1], cell[2]);
+
+		size_t slot = HashCellKey( key) & mask;
+		for ( ; mCellTable[slot] != UINT_MAX && mCellKeys[mCellTable[slot]] != key; slot = (slot + 1) & mask);
+
+		if (mCellTable[slot] == UINT_MAX) {
+			mCellTable[slot] = (unsigned int)mCellKeys.size();
+			mCellKeys.push_back( key);
+			counts.push_back( 0);
+		}
+		cellOf[i] = mCellTable[slot];
+		++counts[cellOf[i]];
+	}
+
+	mCellStart.resize( mCellKeys.size() + 1);
+	mCellStart[0] = 0;
+	for (size_t c = 0; c < counts.size(); ++c) {
+		mCellStart[c+1] = mCellStart[c] + counts[c];
+		counts[c] = mCellStart[c];
+	}
+
+	// entries are scattered in ascending order, so each cell is sorted
+	mGridEntries.resize( num);
+	for (size_t i = 0; i < num; ++i) {
+		mGridEntries[counts[cellOf[i]]++] = (unsigned int)i;
+	}
+}
+
+// ------------------------------------------------------------------------------------------------
+bool SpatialSort :: FindCells( const aiVector3D& pPosition, float pRadius,
+	unsigned int* pMin, unsigned int* pMax) const
+{
+	if (mCellTable.empty()) {
+		return false;
+	}
+
+	unsigned int numCells = 1;
+	for (unsigned int i = 0; i < 3; ++i) {
+		// the mapping is monotonic, so every position within the radius falls into the range
+		// (NaNs end up in cell 0)
+		const float lo = (pPosition[i] - pRadius - mGridMin[i]) * mCellInv;
+		const float hi = (pPosition[i] + pRadius - mGridMin[i]) * mCellInv;
+
+		pMin[i] = lo > 0.f ? (lo < MaxCellCoord ? (unsigned int)lo : MaxCellCoord) : 0;
+		pMax[i] = hi > 0.f ? (hi < MaxCellCoord ? (unsigned int)hi : MaxCellCoord) : 0;
+
+		if (pMax[i] - pMin[i] >= MaxQueryCells) {
+			return false;
+		}
+		numCells *= pMax[i] - pMin[i] + 1;
+	}
+	return numCells <= MaxQueryCells;
+}
+
+// ------------------------------------------------------------------------------------------------
+bool SpatialSort :: FindCell( unsigned int x, unsigned int y, unsigned int z,
+	unsigned int& pBegin, unsigned int& pEnd) const
+{
+	const uint64_t key = CellKey( x, y, z);
+	const size_t mask = mCellTable.size() - 1;
+
+	for (size_t slot = HashCellKey( key) & mask; mCellTable[slot] != UINT_MAX; slot = (slot + 1) & mask) {
+		const unsigned int cell = mCellTable[slot];
+		if (mCellKeys[cell] == key) {
+			pBegin = mCellStart[cell];
+			pEnd = mCellStart[cell+1];
+			return true;
+		}
+	}
+	return false;
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -137,6 +347,36 @@ void SpatialSort::FindPositions( const aiVector3D& pPosition,
 	if( minDist > mPositions.back().mDistance)
 		return;
 
+	const float pSquared = pRadius*pRadius;
+
+	// If the radius is small, collect the positions from the grid. The same criteria as
+	// for the plane are applied, and the results are sorted in plane order, too.
+	// The box is slightly enlarged to make up for rounding errors.
+	unsigned int cellMin[3], cellMax[3];
+	if (FindCells( pPosition, pRadius * 1.0001f, cellMin, cellMax))
+	{
+		for (unsigned int z = cellMin[2]; z <= cellMax[2]; ++z)	{
+			for (unsigned int y = cellMin[1]; y <= cellMax[1]; ++y)	{
+				for (unsigned int x = cellMin[0]; x <= cellMax[0]; ++x)	{
+					unsigned int begin, end;
+					if (!FindCell( x, y, z, begin, end))
+						continue;
+
+					for ( ; begin < end; ++begin)	{
+						const Entry& e = mPositions[mGridEntries[begin]];
+						if( e.mDistance >= minDist && e.mDistance < maxDist && (e.mPosition - pPosition).SquareLength() < pSquared)
+							poResults.push_back( mGridEntries[begin]);
+					}
+				}
+			}
+		}
+
+		std::sort( poResults.begin(), poResults.end());
+		for (std::vector<unsigned int>::iterator it = poResults.begin(); it != poResults.end(); ++it)
+			*it = mPositions[*it].mIndex;
+		return;
+	}
+
 	// do a binary search for the minimal distance to start the iteration there
 	unsigned int index = (unsigned int)mPositions.size() / 2;
 	unsigned int binaryStepSize = (unsigned int)mPositions.size() / 4;
@@ -160,7 +400,6 @@ void SpatialSort::FindPositions( const aiVector3D& pPosition,
 	// Mow start iterating from there until the first position lays outside of the distance range.
 	// Add all positions inside the distance range within the given radius to the result aray
 	std::vector<Entry>::const_iterator it = mPositions.begin() + index;
-	const float pSquared = pRadius*pRadius;
 	while( it->mDistance < maxDist)
 	{
 		if( (it->mPosition - pPosition).SquareLength() < pSquared)
@@ -173,6 +412,54 @@ void SpatialSort::FindPositions( const aiVector3D& pPosition,
 	// that's it
 }
 
+// ------------------------------------------------------------------------------------------------
+// Returns the positions close to each of the given positions.
+void SpatialSort::FindPositions( const aiVector3D* pPositions, unsigned int pNumPositions,
+	unsigned int pElementOffset, float pRadius,
+	std::vector<unsigned int>& poOffsets, std::vector<unsigned int>& poResults) const
+{
+	// The queries are split into one contiguous block per thread, whose results
+	// are concatenated in order afterwards.
+#ifdef _OPENMP
+	const int numBlocks = omp_in_parallel() ? 1 : std::max( 1, std::min( omp_get_max_threads(), (int)(pNumPositions / 1024)));
+#else
+	const int numBlocks = 1;
+#endif
+	std::vector< std::vector<unsigned int> > blockResults( numBlocks);
+	poOffsets.resize( pNumPositions + 1);
+	poOffsets[0] = 0;
+
+#ifdef _OPENMP
+	#pragma omp parallel for schedule(static,1) num_threads(numBlocks) if(numBlocks > 1)
+#endif
+	for (int b = 0; b < numBlocks; ++b)	{
+		const unsigned int begin = (unsigned int)((uint64_t)pNumPositions * b / numBlocks);
+		const unsigned int end = (unsigned int)((uint64_t)pNumPositions * (b+1) / numBlocks);
+
+		std::vector<unsigned int>& results = blockResults[b];
+		std::vector<unsigned int> found;
+		for (unsigned int a = begin; a < end; ++a)	{
+			const char* tempPointer = reinterpret_cast<const char*> (pPositions);
+			const aiVector3D* vec   = reinterpret_cast<const aiVector3D*> (tempPointer + a * pElementOffset);
+
+			FindPositions( *vec, pRadius, found);
+			results.insert( results.end(), found.begin(), found.end());
+			poOffsets[a+1] = (unsigned int)found.size();
+		}
+	}
+
+	for (unsigned int a = 0; a < pNumPositions; ++a)	{
+		poOffsets[a+1] += poOffsets[a];
+	}
+
+	poResults.resize( poOffsets[pNumPositions]);
+	size_t offset = 0;
+	for (int b = 0; b < numBlocks; ++b)	{
+		std::copy( blockResults[b].begin(), blockResults[b].end(), poResults.begin() + offset);
+		offset += blockResults[b].size();
+	}
+}
+
 namespace {
 
 	// Binary, signed-integer representation of a single-precision floating-point value.
@@ -271,6 +558,36 @@ void SpatialSort::FindIdenticalPositions( const aiVector3D& pPosition,
     // the array which we want to avoid
 	poResults.erase( poResults.begin(), poResults.end());
 
+	// Look in the grid cells around the position first, the box is way larger than the
+	// tolerance. The criteria are the same as below, the results are in plane order, too.
+	const float tolerance = (::fabs( pPosition.x) + ::fabs( pPosition.y) + ::fabs( pPosition.z)) * 1e-5f + 1e-20f;
+	unsigned int cellMin[3], cellMax[3];
+	if (FindCells( pPosition, tolerance, cellMin, cellMax))
+	{
+		for (unsigned int z = cellMin[2]; z <= cellMax[2]; ++z)	{
+			for (unsigned int y = cellMin[1]; y <= cellMax[1]; ++y)	{
+				for (unsigned int x = cellMin[0]; x <= cellMax[0]; ++x)	{
+					unsigned int begin, end;
+					if (!FindCell( x, y, z, begin, end))
+						continue;
+
+					for ( ; begin < end; ++begin)	{
+						const Entry& e = mPositions[mGridEntries[begin]];
+						const BinFloat dist = ToBinary( e.mDistance);
+						if( dist >= minDistBinary && dist < maxDistBinary &&
+							distance3DToleranceInULPs >= ToBinary((e.mPosition - pPosition).SquareLength()))
+							poResults.push_back( mGridEntries[begin]);
+					}
+				}
+			}
+		}
+
+		std::sort( poResults.begin(), poResults.end());
+		for (std::vector<unsigned int>::iterator it = poResults.begin(); it != poResults.end(); ++it)
+			*it = mPositions[*it].mIndex;
+		return;
+	}
+
 	// do a binary search for the minimal distance to start the iteration there
 	unsigned int index = (unsigned int)mPositions.size() / 2;
 	unsigned int binaryStepSize = (unsigned int)mPositions.size() / 4;
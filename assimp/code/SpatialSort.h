@@ -54,7 +54,11 @@ namespace Assimp
  * by their indices and sorts them by their distance to an arbitrary chosen plane.
  * You can then query the instance for all vertices close to a given position in an average O(log n) 
  * time, with O(n) worst case complexity when all vertices lay on the plane. The plane is chosen
- * so that it avoids common planes in usual data sets. */
+ * so that it avoids common planes in usual data sets.
+ *
+ * Larger sets of positions are additionally bucketed in a hashed uniform grid, which answers
+ * queries with a small radius (compared to the spacing of the positions) in O(1) average time,
+ * regardless of the positions' layout. Both ways yield the same results in the same order. */
 // ------------------------------------------------------------------------------------------------
 class SpatialSort
 {
@@ -120,6 +124,22 @@ public:
 	void FindPositions( const aiVector3D& pPosition, float pRadius, 
 		std::vector<unsigned int>& poResults) const;
 
+	// ------------------------------------------------------------------------------------
+	/** Batch version of #FindPositions() for many positions, e.g. all vertices of a mesh.
+	 *  The queries are distributed over all cores if Assimp was built with OpenMP, the
+	 *  results are the same as if #FindPositions() was called for each position.
+	 * @param pPositions Pointer to the first position to look for vertices.
+	 * @param pNumPositions Number of positions to look for.
+	 * @param pElementOffset Offset in bytes from the beginning of one position in memory
+	 *   to the beginning of the next position.
+	 * @param pRadius Maximal distance from the position a vertex may have to be counted in.
+	 * @param poOffsets Receives pNumPositions+1 entries. The results for the i-th position
+	 *   are stored in poResults from poOffsets[i] up to (excluding) poOffsets[i+1].
+	 * @param poResults The container to store the indices of the found positions. */
+	void FindPositions( const aiVector3D* pPositions, unsigned int pNumPositions,
+		unsigned int pElementOffset, float pRadius,
+		std::vector<unsigned int>& poOffsets, std::vector<unsigned int>& poResults) const;
+
 	// ------------------------------------------------------------------------------------
 	/** Fills an array with indices of all positions indentical to the given position. In
 	 *  opposite to FindPositions(), not an epsilon is used but a (very low) tolerance of
@@ -141,6 +161,19 @@ public:
 	unsigned int GenerateMappingTable(std::vector<unsigned int>& fill,
 		float pRadius) const;
 
+protected:
+	/** Buckets the sorted positions in the grid, called by #Finalize() */
+	void BuildGrid();
+
+	/** Computes the range of grid cells covering a box of the given radius around a position.
+	 *  Returns false if there's no grid or the box covers too many cells to be worth it. */
+	bool FindCells( const aiVector3D& pPosition, float pRadius,
+		unsigned int* pMin, unsigned int* pMax) const;
+
+	/** Looks up a grid cell, returns the range of its entries in #mGridEntries */
+	bool FindCell( unsigned int x, unsigned int y, unsigned int z,
+		unsigned int& pBegin, unsigned int& pEnd) const;
+
 protected:
 	/** Normal of the sorting plane, normalized. The center is always at (0, 0, 0) */
 	aiVector3D mPlaneNormal;
@@ -163,6 +196,22 @@ protected:
 
 	// all positions, sorted by distance to the sorting plane
 	std::vector<Entry> mPositions;
+
+	/** The grid starts at the minimum of all positions, its cells are cubes. Cell
+	 *  coordinates are clamped to 21 bits per axis, which form a 64 bit key. */
+	aiVector3D mGridMin;
+	float mCellInv; ///< 1 / edge length of a cell
+
+	/** Indices into mPositions, grouped by cell and ascending within each cell */
+	std::vector<unsigned int> mGridEntries;
+
+	/** Key of each non-empty cell and the start of its entries (one more for the end) */
+	std::vector<uint64_t> mCellKeys;
+	std::vector<unsigned int> mCellStart;
+
+	/** Open addressing hash table of cell indices, UINT_MAX marks empty slots. Empty if
+	 *  there's no grid. */
+	std::vector<unsigned int> mCellTable;
 };
 
 } // end of namespace Assimp
@@ -46,6 +46,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define AI_STREAMREADER_H_INCLUDED
 
 #include "ByteSwap.h"
+#include "MMapIOSystem.h"
 
 namespace Assimp {
 
@@ -105,7 +106,9 @@ public:
 
 	// ---------------------------------------------------------------------
 	~StreamReader() {
-		delete[] buffer;
+		if (owned) {
+			delete[] buffer;
+		}
 	}
 
 public:
@@ -323,7 +326,19 @@ private:
 			throw DeadlyImportError("StreamReader: File is empty or EOF is already reached");
 		}
 
+		// memory mapped streams are read in place (the data is never written to)
+		const MMapIOStream* const mapped = dynamic_cast<const MMapIOStream*>(stream.get());
+		if (mapped) {
+			current = buffer = const_cast<int8_t*>(reinterpret_cast<const int8_t*>(mapped->Data() + stream->Tell()));
+			end = limit = &buffer[s];
+			owned = false;
+
+			stream->Seek(0,aiOrigin_END);
+			return;
+		}
+
 		current = buffer = new int8_t[s];
+		owned = true;
 		const size_t read = stream->Read(current,1,s);
 		// (read < s) can only happen if the stream was opened in text mode, in which case FileSize() is not reliable
 		ai_assert(read <= s);
@@ -335,6 +350,7 @@ private:
 
 	boost::shared_ptr<IOStream> stream;
 	int8_t *buffer, *current, *end, *limit;
+	bool owned;
 	bool le;
 };
 
@@ -102,10 +102,13 @@ void TriangulateProcess::Execute( aiScene* pScene)
 {
 	DefaultLogger::get()->debug("TriangulateProcess begin");
 
+	std::vector<unsigned char> triangulated;
+	ExecutePerMesh(pScene->mMeshes,pScene->mNumMeshes,&TriangulateProcess::ProcessMesh,triangulated);
+
 	bool bHas = false;
 	for( unsigned int a = 0; a < pScene->mNumMeshes; a++)
 	{
-		if(	TriangulateMesh( pScene->mMeshes[a]))
+		if(	triangulated[a])
 			bHas = true;
 	}
 	if (bHas)DefaultLogger::get()->info ("TriangulateProcess finished. All polygons have been triangulated.");
@@ -113,6 +116,13 @@ void TriangulateProcess::Execute( aiScene* pScene)
 }
 
 
+// ------------------------------------------------------------------------------------------------
+// Per-mesh entry point for ExecutePerMesh()
+bool TriangulateProcess::ProcessMesh( aiMesh* pMesh, unsigned int /*meshIndex*/)
+{
+	return TriangulateMesh(pMesh);
+}
+
 // ------------------------------------------------------------------------------------------------
 // Triangulates the given mesh.
 bool TriangulateProcess::TriangulateMesh( aiMesh* pMesh)
@@ -86,6 +86,11 @@ public:
 	 * @param pMesh The mesh to triangulate.
 	 */
 	bool TriangulateMesh( aiMesh* pMesh);
+
+protected:
+	// -------------------------------------------------------------------
+	/** TriangulateMesh() with the signature ExecutePerMesh() expects */
+	bool ProcessMesh( aiMesh* pMesh, unsigned int meshIndex);
 };
 
 } // end of namespace Assimp
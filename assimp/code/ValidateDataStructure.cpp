@@ -423,6 +423,34 @@ void ValidateDSProcess::Validate( const aiMesh* pMesh)
 	abRefList.clear();
 	if (b)ReportWarning("There are unreferenced vertices");
 
+	// levels of detail are triangles referencing the vertices of the mesh
+	if (pMesh->mNumLODs && !pMesh->mLODs)	{
+		ReportError("aiMesh::mLODs is NULL (aiMesh::mNumLODs is %i)",pMesh->mNumLODs);
+	}
+	for (unsigned int i = 0; i < pMesh->mNumLODs;++i)
+	{
+		const aiMeshLOD* lod = pMesh->mLODs[i];
+		if (!lod)	{
+			ReportError("aiMesh::mLODs[%i] is NULL",i);
+		}
+		if (!lod->mNumFaces || !lod->mFaces)	{
+			ReportError("aiMesh::mLODs[%i] contains no faces",i);
+		}
+		for (unsigned int f = 0; f < lod->mNumFaces;++f)
+		{
+			const aiFace& face = lod->mFaces[f];
+			if (3 != face.mNumIndices || !face.mIndices)	{
+				ReportError("aiMesh::mLODs[%i]::mFaces[%i] is not a triangle",i,f);
+			}
+			for (unsigned int a = 0; a < 3;++a)
+			{
+				if (face.mIndices[a] >= pMesh->mNumVertices)	{
+					ReportError("aiMesh::mLODs[%i]::mFaces[%i]::mIndices[%i] is out of range",i,f,a);
+				}
+			}
+		}
+	}
+
 	// texture channel 2 may not be set if channel 1 is zero ...
 	{
 		unsigned int i = 0;
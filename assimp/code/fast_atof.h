@@ -9,6 +9,8 @@
 // Changes:
 //  22nd October 08 (Aramis_acg): Added temporary cast to double, added strtoul10_64
 //     to ensure long numbers are handled correctly
+//  Digits are classified with SSE2 and converted eight at once, fast_atoreal_move
+//     rounds exactly like strtod, fast_atoreal_run parses runs of reals
 // ------------------------------------------------------------------------------------
 
 
@@ -16,47 +18,109 @@
 #define __FAST_A_TO_F_H_INCLUDED__
 
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define AI_FAST_ATOF_SSE2
+#	include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#	include <intrin.h>
+#endif
 
 namespace Assimp
 {
 
-const float fast_atof_table[16] =	{  // we write [16] here instead of [] to work around a swig bug
-	0.f,
-	0.1f,
-	0.01f,
-	0.001f,
-	0.0001f,
-	0.00001f,
-	0.000001f,
-	0.0000001f,
-	0.00000001f,
-	0.000000001f,
-	0.0000000001f,
-	0.00000000001f,
-	0.000000000001f,
-	0.0000000000001f,
-	0.00000000000001f,
-	0.000000000000001f
+// Powers of ten which are exact doubles, see fast_atoreal_move
+const double fast_atof_pow10[23] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+	1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+	1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
 };
 
 
 // ------------------------------------------------------------------------------------
-// Convert a string in decimal format to a number
+// Index of the lowest bit set, in must not be zero
 // ------------------------------------------------------------------------------------
-inline unsigned int strtoul10( const char* in, const char** out=0)
+inline unsigned int fast_atof_ctz( unsigned int in)
 {
-	unsigned int value = 0;
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, in);
+	return static_cast<unsigned int>(index);
+#elif defined(__GNUC__)
+	return static_cast<unsigned int>(__builtin_ctz(in));
+#else
+	unsigned int index = 0;
+	for (; !(in & 1); in >>= 1) {
+		++index;
+	}
+	return index;
+#endif
+}
 
-	bool running = true;
-	while ( running )
+// ------------------------------------------------------------------------------------
+// Count the decimal digits at the beginning of a string. With SSE2, 16 characters
+// are classified at once. Loads never cross a page boundary, thus the string needs
+// no padding, it just needs to be delimited (e.g. zero terminated).
+// ------------------------------------------------------------------------------------
+inline unsigned int fast_atof_count_digits( const char* in)
+{
+	const char* cur = in;
+#ifdef AI_FAST_ATOF_SSE2
+	while ((reinterpret_cast<size_t>(cur) & 4095) <= 4096 - 16)
 	{
-		if ( *in < '0' || *in > '9' )
-			break;
+		// bytes in ['0','9'] map to [0,9], all others to negative values or above 9
+		const __m128i v = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cur)), _mm_set1_epi8('0'));
+		const __m128i digits = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(-1)), _mm_cmplt_epi8(v, _mm_set1_epi8(10)));
+		const unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(digits));
+		if (mask != 0xffff) {
+			return static_cast<unsigned int>(cur - in) + fast_atof_ctz(~mask);
+		}
+		cur += 16;
+	}
+#endif
+	while (*cur >= '0' && *cur <= '9') {
+		++cur;
+	}
+	return static_cast<unsigned int>(cur - in);
+}
 
-		value = ( value * 10 ) + ( *in - '0' );
-		++in;
+// ------------------------------------------------------------------------------------
+// Append num decimal digits, which must have been counted before, to value. Eight
+// digits are converted at once (SWAR, as in Lemire's parse_eight_digits). As with
+// strtoul10, the result wraps on overflow.
+// ------------------------------------------------------------------------------------
+inline uint64_t fast_atof_accumulate( uint64_t value, const char* in, unsigned int num)
+{
+#ifndef AI_BUILD_BIG_ENDIAN
+	for (; num >= 8; num -= 8, in += 8)
+	{
+		uint64_t eight;
+		memcpy(&eight, in, sizeof(eight));
+		eight = ((eight & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+		eight = ((eight & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+		eight = ((eight & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+		value = value * 100000000ULL + eight;
+	}
+#endif
+	for (; num; --num, ++in) {
+		value = value * 10 + static_cast<unsigned int>(*in - '0');
 	}
-	if (out)*out = in;
+	return value;
+}
+
+
+// ------------------------------------------------------------------------------------
+// Convert a string in decimal format to a number
+// ------------------------------------------------------------------------------------
+inline unsigned int strtoul10( const char* in, const char** out=0)
+{
+	const unsigned int num = fast_atof_count_digits(in);
+	const unsigned int value = static_cast<unsigned int>(fast_atof_accumulate(0, in, num));
+
+	if (out)*out = in + num;
 	return value;
 }
 
@@ -214,43 +278,124 @@ inline uint64_t strtoul10_64( const char* in, const char** out=0, unsigned int*
 	return value;
 }
 
-// Number of relevant decimals for floating-point parsing.
-#define AI_FAST_ATOF_RELAVANT_DECIMALS 15
+// ------------------------------------------------------------------------------------
+// Clinger's fast path: if the mantissa and the power of ten are both exact doubles,
+// their product or quotient is correctly rounded. Returns false if that does not
+// hold. For floats, the double is rounded again, which is exact unless it lies
+// halfway between two floats (the double may have been rounded onto the tie).
+// ------------------------------------------------------------------------------------
+inline bool fast_atof_exact( uint64_t mantissa, int exp10, double& out)
+{
+	if (mantissa > (static_cast<uint64_t>(1) << 53) || exp10 < -22 || exp10 > 22) {
+		return false;
+	}
+	const double value = static_cast<double>(mantissa);
+	out = exp10 < 0 ? value / fast_atof_pow10[-exp10] : value * fast_atof_pow10[exp10];
+	return true;
+}
+
+inline bool fast_atof_exact( uint64_t mantissa, int exp10, float& out)
+{
+	double value;
+	if (!fast_atof_exact(mantissa, exp10, value)) {
+		return false;
+	}
+	// The value is within [1e-22,1e38], i.e. a normal float, whose 24 bit significand
+	// leaves the lower 29 bits of the double's. Halfway means exactly the top one set.
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	if ((bits & 0x1fffffffULL) == 0x10000000ULL) {
+		return false;
+	}
+	out = static_cast<float>(value);
+	return true;
+}
+
+// ------------------------------------------------------------------------------------
+// Slow path of fast_atoreal_move: the significant digits are written as an integer
+// with an exponent, which strtod and strtof read regardless of the locale's decimal
+// point. Digits beyond the 767th cannot change the rounding of a double and are
+// dropped (only a nonzero remainder is kept as a last digit, for ties).
+// ------------------------------------------------------------------------------------
+inline void fast_atof_strtoreal( const char* intDigits, unsigned int numInt,
+	const char* fracDigits, unsigned int numFrac, int exp10, double& out, bool single = false)
+{
+	const unsigned int maxDigits = 768;
+	char buffer[maxDigits + 16];
+	char* cur = buffer;
+
+	const unsigned int takeInt = numInt < maxDigits ? numInt : maxDigits;
+	const unsigned int takeFrac = numFrac < maxDigits - takeInt ? numFrac : maxDigits - takeInt;
+	memcpy(cur, intDigits, takeInt);
+	cur += takeInt;
+	memcpy(cur, fracDigits, takeFrac);
+	cur += takeFrac;
+	if (takeInt < numInt || takeFrac < numFrac) {
+		// trailing zeros have been stripped, thus the remainder is nonzero
+		*cur++ = '1';
+		exp10 += static_cast<int>(numInt - takeInt) + static_cast<int>(numFrac - takeFrac) - 1;
+	}
+	if (cur == buffer) {
+		out = 0;
+		return;
+	}
+
+	*cur++ = 'e';
+	if (exp10 < 0) {
+		*cur++ = '-';
+	}
+	char exponent[16];
+	unsigned int numExp = 0;
+	for (unsigned int e = static_cast<unsigned int>(exp10 < 0 ? -exp10 : exp10); e || !numExp; e /= 10) {
+		exponent[numExp++] = static_cast<char>('0' + e % 10);
+	}
+	while (numExp) {
+		*cur++ = exponent[--numExp];
+	}
+	*cur = '\0';
+
+	out = single ? strtof(buffer, NULL) : strtod(buffer, NULL);
+}
+
+inline void fast_atof_strtoreal( const char* intDigits, unsigned int numInt,
+	const char* fracDigits, unsigned int numFrac, int exp10, float& out)
+{
+	double value;
+	fast_atof_strtoreal(intDigits, numInt, fracDigits, numFrac, exp10, value, true);
+	out = static_cast<float>(value);
+}
 
 // ------------------------------------------------------------------------------------
 //! Provides a fast function for converting a string into a float,
 //! about 6 times faster than atof in win32.
-// If you find any bugs, please send them to me, niko (at) irrlicht3d.org.
+// Digits are classified and converted in bulk (see fast_atof_count_digits and
+// fast_atof_accumulate). The result is rounded exactly as by strtod (or strtof):
+// numbers with up to 15 significant digits, not counting leading and trailing zeros,
+// and a decimal exponent within +-22 are converted directly, all others are passed
+// on to fast_atof_strtoreal.
 // ------------------------------------------------------------------------------------
 template <typename Real>
 inline const char* fast_atoreal_move( const char* c, Real& out)
 {
-	Real f;
-
 	bool inv = (*c=='-');
 	if (inv || *c=='+') {
 		++c;
 	}
 
-	f = static_cast<Real>( strtoul10_64 ( c, &c) );
+	const char* intDigits = c;
+	unsigned int numInt = fast_atof_count_digits(c);
+	c += numInt;
+
+	const char* fracDigits = c;
+	unsigned int numFrac = 0;
 	if (*c == '.' || (c[0] == ',' && c[1] >= '0' && c[1] <= '9')) // allow for commas, too
 	{
 		++c;
-
-		// NOTE: The original implementation is highly inaccurate here. The precision of a single
-		// IEEE 754 float is not high enough, everything behind the 6th digit tends to be more 
-		// inaccurate than it would need to be. Casting to double seems to solve the problem.
-		// strtol_64 is used to prevent integer overflow.
-
-		// Another fix: this tends to become 0 for long numbers if we don't limit the maximum 
-		// number of digits to be read. AI_FAST_ATOF_RELAVANT_DECIMALS can be a value between
-		// 1 and 15.
-		unsigned int diff = AI_FAST_ATOF_RELAVANT_DECIMALS;
-		double pl = static_cast<double>( strtoul10_64 ( c, &c, &diff ));
-
-		pl *= fast_atof_table[diff];
-		f += static_cast<Real>( pl );
+		fracDigits = c;
+		numFrac = fast_atof_count_digits(c);
+		c += numFrac;
 	}
+	int exp10 = -static_cast<int>(numFrac);
 
 	// A major 'E' must be allowed. Necessary for proper reading of some DXF files.
 	// Thanks to Zhao Lei to point out that this if() must be outside the if (*c == '.' ..)
@@ -262,20 +407,75 @@ inline const char* fast_atoreal_move( const char* c, Real& out)
 			++c;
 		}
 
-		// The reason float constants are used here is that we've seen cases where compilers
-		// would perform such casts on compile-time constants at runtime, which would be
-		// bad considering how frequently fast_atoreal_move<float> is called in Assimp.
-		Real exp = static_cast<Real>( strtoul10_64(c, &c) );
-		if (einv) {
-			exp = -exp;
+		// Clamped, large enough to over- or underflow any mantissa
+		const uint64_t exp = strtoul10_64(c, &c);
+		const int clamped = static_cast<int>(exp < 100000 ? exp : 100000);
+		exp10 += einv ? -clamped : clamped;
+	}
+
+	// Leading zeros are no significant digits
+	while (numInt && *intDigits == '0') {
+		++intDigits;
+		--numInt;
+	}
+	if (!numInt) {
+		while (numFrac && *fracDigits == '0') {
+			++fracDigits;
+			--numFrac;
 		}
-		f *= pow(static_cast<Real>(10.0f), exp);
 	}
 
-	if (inv) {
-		f = -f;
+	// Trailing zeros neither, they just scale the number. Zero padded mantissas
+	// (e.g. 5.7609570000000000e+07) thus still take the fast path.
+	while (numFrac && fracDigits[numFrac - 1] == '0') {
+		--numFrac;
+		++exp10;
+	}
+	if (!numFrac) {
+		while (numInt && intDigits[numInt - 1] == '0') {
+			--numInt;
+			++exp10;
+		}
+	}
+
+	Real value = 0;
+	if (numInt + numFrac <= 19)
+	{
+		// 19 digits fit into 64 bits
+		const uint64_t mantissa = fast_atof_accumulate(fast_atof_accumulate(0, intDigits, numInt), fracDigits, numFrac);
+		if (!mantissa || !fast_atof_exact(mantissa, exp10, value)) {
+			fast_atof_strtoreal(intDigits, numInt, fracDigits, numFrac, exp10, value);
+		}
+	}
+	else {
+		fast_atof_strtoreal(intDigits, numInt, fracDigits, numFrac, exp10, value);
+	}
+
+	out = inv ? -value : value;
+	return c;
+}
+
+// ------------------------------------------------------------------------------------
+// Parses up to count reals into out, which are separated by spaces and tabs (and line
+// ends, if multiline is set). Stops at the first token which is not a number, the
+// end of the line or the string. Returns the position after the last real parsed,
+// num receives the number of reals parsed. Use it to read whole vectors or arrays.
+// ------------------------------------------------------------------------------------
+template <typename Real>
+inline const char* fast_atoreal_run( const char* c, Real* out, unsigned int count,
+	unsigned int& num, bool multiline = false)
+{
+	for (num = 0; num < count; ++num)
+	{
+		const char* cur = c;
+		while (*cur == ' ' || *cur == '\t' || (multiline && (*cur == '\r' || *cur == '\n' || *cur == '\f'))) {
+			++cur;
+		}
+		if ((*cur < '0' || *cur > '9') && *cur != '-' && *cur != '+' && *cur != '.') {
+			break;
+		}
+		c = fast_atoreal_move<Real>(cur, out[num]);
 	}
-	out = f;
 	return c;
 }
 
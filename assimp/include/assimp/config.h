@@ -77,12 +77,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define AI_CONFIG_GLOB_MEASURE_TIME  \
 	"GLOB_MEASURE_TIME"
 
-# if 0 // not implemented yet
 // ---------------------------------------------------------------------------
 /** @brief Set Assimp's multithreading policy.
  *
- * This setting is ignored if Assimp was built without boost.thread
- * support (ASSIMP_BUILD_NO_THREADING, which is implied by ASSIMP_BUILD_BOOST_WORKAROUND).
+ * This setting is ignored if Assimp was built without OpenMP support.
  * Possible values are: -1 to let Assimp decide what to do, 0 to disable
  * multithreading entirely and any number larger than 0 to force a specific
  * number of threads. Assimp is always free to ignore this settings, which is
@@ -90,12 +88,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  * Assimp is used concurrently from multiple user threads, it might be useful
  * to limit each Importer instance to a specific number of cores.
  *
- * For more information, see the @link threading Threading page@endlink.
+ * Currently, the per-mesh postprocessing steps (#aiProcess_JoinIdenticalVertices,
+ * #aiProcess_GenNormals, #aiProcess_GenSmoothNormals, #aiProcess_CalcTangentSpace,
+ * #aiProcess_ImproveCacheLocality and #aiProcess_Triangulate) process the
+ * meshes of a scene concurrently. Their results do not depend on the number
+ * of threads.
  * Property type: int, default value: -1.
  */
 #define AI_CONFIG_GLOB_MULTITHREADING  \
 	"GLOB_MULTITHREADING"
-#endif
 
 // ###########################################################################
 // POST PROCESSING SETTINGS
@@ -340,6 +341,96 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #define AI_CONFIG_PP_ICL_PTCACHE_SIZE	"PP_ICL_PTCACHE_SIZE"
 
+// ---------------------------------------------------------------------------
+/** @brief Default value for the #AI_CONFIG_PP_OVC_CACHE_SIZE property
+ */
+#ifndef PP_OVC_CACHE_SIZE
+#	define PP_OVC_CACHE_SIZE 16
+#endif
+
+// ---------------------------------------------------------------------------
+/** @brief Set the size of the post-transform vertex cache to optimize the
+ *    vertices for. This configures the #aiProcess_OptimizeVertexCache step.
+ *
+ * The size is given in vertices and clamped to [4, 64]. The step optimizes
+ * for a LRU cache of that size, which also suits the FIFO caches of most
+ * GPUs. The ACMR/ATVR statistics logged by the step are computed for a FIFO
+ * cache of that size.
+ * Property type: integer. Default value: #PP_OVC_CACHE_SIZE.
+ */
+#define AI_CONFIG_PP_OVC_CACHE_SIZE	"PP_OVC_CACHE_SIZE"
+
+// ---------------------------------------------------------------------------
+/** @brief Default value for the #AI_CONFIG_PP_OVC_OVERDRAW_THRESHOLD property
+ */
+#ifndef PP_OVC_OVERDRAW_THRESHOLD
+#	define PP_OVC_OVERDRAW_THRESHOLD 1.05f
+#endif
+
+// ---------------------------------------------------------------------------
+/** @brief Set how much vertex cache efficiency the #aiProcess_OptimizeVertexCache
+ *    step may trade for reduced overdraw.
+ *
+ * The faces are split into clusters whose ACMR is at most this factor of the
+ * optimized mesh' ACMR. The clusters are then ordered so that the ones likely 
+ * to occlude others are drawn first, which is kept if it lowers the estimated
+ * overdraw. Larger values yield smaller clusters, values below 1 disable the
+ * overdraw optimization.
+ * Property type: float. Default value: #PP_OVC_OVERDRAW_THRESHOLD.
+ */
+#define AI_CONFIG_PP_OVC_OVERDRAW_THRESHOLD	"PP_OVC_OVERDRAW_THRESHOLD"
+
+// ---------------------------------------------------------------------------
+/** @brief Default value for the #AI_CONFIG_PP_GLOD_LEVELS property
+ */
+#ifndef PP_GLOD_LEVELS
+#	define PP_GLOD_LEVELS 4
+#endif
+
+// ---------------------------------------------------------------------------
+/** @brief Set the maximum number of simplified levels the #aiProcess_GenLODs
+ *    step generates per mesh.
+ *
+ * The mesh itself is not counted. Fewer levels are generated if the
+ * simplification stalls or reaches #AI_CONFIG_PP_GLOD_MAX_ERROR.
+ * Property type: integer. Default value: #PP_GLOD_LEVELS.
+ */
+#define AI_CONFIG_PP_GLOD_LEVELS	"PP_GLOD_LEVELS"
+
+// ---------------------------------------------------------------------------
+/** @brief Default value for the #AI_CONFIG_PP_GLOD_RATIO property
+ */
+#ifndef PP_GLOD_RATIO
+#	define PP_GLOD_RATIO 0.5f
+#endif
+
+// ---------------------------------------------------------------------------
+/** @brief Set the number of faces of each level generated by the
+ *    #aiProcess_GenLODs step, relative to the previous level.
+ *
+ * The value is clamped to [0.05, 0.95]. A level is dropped if the
+ * simplification removes less than a quarter of the faces asked for.
+ * Property type: float. Default value: #PP_GLOD_RATIO.
+ */
+#define AI_CONFIG_PP_GLOD_RATIO	"PP_GLOD_RATIO"
+
+// ---------------------------------------------------------------------------
+/** @brief Default value for the #AI_CONFIG_PP_GLOD_MAX_ERROR property
+ */
+#ifndef PP_GLOD_MAX_ERROR
+#	define PP_GLOD_MAX_ERROR 0.05f
+#endif
+
+// ---------------------------------------------------------------------------
+/** @brief Set the maximum geometric error of the levels generated by the
+ *    #aiProcess_GenLODs step, relative to the diagonal of the mesh's bounds.
+ *
+ * Edge collapses exceeding the error are not performed, thus the coarsest
+ * level is as simple as the error allows.
+ * Property type: float. Default value: #PP_GLOD_MAX_ERROR.
+ */
+#define AI_CONFIG_PP_GLOD_MAX_ERROR	"PP_GLOD_MAX_ERROR"
+
 // ---------------------------------------------------------------------------
 /** @brief Enumerates components of the aiScene and aiMesh data structures
  *  that can be excluded from the import using the #aiPrpcess_RemoveComponent step.
@@ -735,4 +826,15 @@ enum aiComponent
  */
 #define AI_CONFIG_IMPORT_IFC_CUSTOM_TRIANGULATION "IMPORT_IFC_CUSTOM_TRIANGULATION"
 
+// ---------------------------------------------------------------------------
+/** @brief Specifies whether the OBJ loader parses large files on multiple
+ *    threads.
+ *
+ * The file is split into chunks of lines, whose vertex data and faces are
+ * parsed concurrently. The result equals the one of the serial parser. 
+ * Requires a build with OpenMP, otherwise files are always parsed serially.<br>
+ * Property type: Bool. Default value: true.
+ */
+#define AI_CONFIG_IMPORT_OBJ_PARALLEL "IMPORT_OBJ_PARALLEL"
+
 #endif // !! AI_CONFIG_H_INC
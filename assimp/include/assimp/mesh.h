@@ -438,6 +438,46 @@ struct aiAnimMesh
 };
 
 
+// ---------------------------------------------------------------------------
+/** @brief A simplified level of detail of an #aiMesh, as generated by the
+ *  #aiProcess_GenLODs step.
+ *
+ *  A LOD replaces only the faces of its host mesh. Its indices refer to the
+ *  vertices of the host mesh, which are shared by all levels, so a renderer
+ *  needs a single vertex buffer and one index buffer per level.
+ */
+struct aiMeshLOD
+{
+	/** The number of triangles of this level. */
+	unsigned int mNumFaces;
+
+	/** The triangles of this level, their indices refer to the host
+	 *  mesh's vertices. */
+	C_STRUCT aiFace* mFaces;
+
+	/** Geometric error of this level compared to the host mesh, in the
+	 *  units of the mesh's vertices. This is the distance between the
+	 *  surfaces as estimated by the quadric error metric, which is suited
+	 *  to choose a level by its projected size on screen. */
+	float mError;
+
+#ifdef __cplusplus
+
+	aiMeshLOD()
+		: mNumFaces(0)
+		, mFaces(NULL)
+		, mError(0.f)
+	{
+	}
+
+	~aiMeshLOD()
+	{
+		delete [] mFaces;
+	}
+
+#endif // __cplusplus
+};
+
 // ---------------------------------------------------------------------------
 /** @brief A mesh represents a geometry or model with a single material. 
 *
@@ -599,6 +639,15 @@ struct aiMesh
 	 *  mesh'es vertex components (usually positions, normals). */
 	C_STRUCT aiAnimMesh** mAnimMeshes;
 
+	/** The number of simplified levels of detail of this mesh. 
+	 *  Zero unless the #aiProcess_GenLODs step was executed. */
+	unsigned int mNumLODs;
+
+	/** Simplified levels of detail of this mesh, sorted from fine to coarse.
+	 *  The mesh itself is the finest level. All levels share the vertices
+	 *  of the mesh and replace its faces only. */
+	C_STRUCT aiMeshLOD** mLODs;
+
 
 #ifdef __cplusplus
 
@@ -627,6 +676,8 @@ struct aiMesh
 		mMaterialIndex = 0;
 		mNumAnimMeshes = 0;
 		mAnimMeshes = NULL;
+		mNumLODs = 0;
+		mLODs = NULL;
 	}
 
 	//! Deletes all storage allocated for the mesh
@@ -658,6 +709,13 @@ struct aiMesh
 			delete [] mAnimMeshes;
 		}
 
+		if (mNumLODs && mLODs)	{
+			for( unsigned int a = 0; a < mNumLODs; a++) {
+				delete mLODs[a];
+			}
+			delete [] mLODs;
+		}
+
 		delete [] mFaces;
 	}
 
@@ -723,6 +781,10 @@ struct aiMesh
 	inline bool HasBones() const
 		{ return mBones != NULL && mNumBones > 0; }
 
+	//! Check whether the mesh contains simplified levels of detail
+	inline bool HasLODs() const
+		{ return mLODs != NULL && mNumLODs > 0; }
+
 #endif // __cplusplus
 };
 
@@ -520,7 +520,47 @@ enum aiPostProcessSteps
 	 *  Use <tt>#AI_CONFIG_PP_DB_ALL_OR_NONE</tt> if you want bones removed if and 
 	 *	only if all bones within the scene qualify for removal.
     */
-	aiProcess_Debone  = 0x4000000
+	aiProcess_Debone  = 0x4000000,
+
+	// -------------------------------------------------------------------------
+	/** <hr>Optimizes all meshes for the post-transform vertex cache, overdraw
+	 *  and vertex fetch.
+	 *
+	 * The faces are reordered for a LRU vertex cache (using Tom Forsyth's
+	 * linear-speed algorithm), then clusters of faces are reordered so that
+	 * faces likely to occlude others are drawn first, if that lowers the
+	 * overdraw estimated by rasterizing the mesh from a set of directions.
+	 * Finally, the vertices are reordered in the order of their first use.
+	 * The ACMR, ATVR (average transformed vertices per vertex) and the
+	 * estimated overdraw before and after the step are logged. Use <tt>#AI_CONFIG_PP_OVC_CACHE_SIZE</tt> and 
+	 * <tt>#AI_CONFIG_PP_OVC_OVERDRAW_THRESHOLD</tt> to fine-tune the step.
+	 *
+	 * This step supersedes #aiProcess_ImproveCacheLocality, which is skipped
+	 * if both flags are specified. It requires triangulated meshes (see 
+	 * #aiProcess_Triangulate and #aiProcess_SortByPType). Levels of detail
+	 * generated by #aiProcess_GenLODs are optimized as well.
+	 */
+	aiProcess_OptimizeVertexCache = 0x8000000,
+
+	// -------------------------------------------------------------------------
+	/** <hr>Generates a chain of simplified levels of detail for all meshes.
+	 *
+	 * Each level is simplified from the previous one with edge collapses 
+	 * ranked by the quadric error metric (Garland and Heckbert). Vertices 
+	 * are never moved nor added, so all levels share the mesh's vertices
+	 * and only differ by their faces (see #aiMesh::mLODs). Open borders 
+	 * and seams, where vertices are split by different normals or texture
+	 * coordinates, keep their topology and are collapsed along themselves
+	 * only. Each level stores its geometric error, a renderer chooses
+	 * the level whose error projects to less than a pixel or so.
+	 *
+	 * Use <tt>#AI_CONFIG_PP_GLOD_LEVELS</tt>, <tt>#AI_CONFIG_PP_GLOD_RATIO</tt>
+	 * and <tt>#AI_CONFIG_PP_GLOD_MAX_ERROR</tt> to control the chain. This
+	 * step requires triangulated meshes (see #aiProcess_Triangulate and 
+	 * #aiProcess_SortByPType) and works best if identical vertices were 
+	 * joined (see #aiProcess_JoinIdenticalVertices).
+	 */
+	aiProcess_GenLODs = 0x10000000
 
 	// aiProcess_GenEntityMeshes = 0x100000,
 	// aiProcess_OptimizeAnimations = 0x200000
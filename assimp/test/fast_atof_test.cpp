@@ -0,0 +1,151 @@
+/** @file  fast_atof_test.cpp
+ *  @brief Checks that fast_atod and fast_atof round exactly like strtod and strtof.
+ *
+ *  Fixed cases cover zero padded mantissas, more than 15 (and more than 19)
+ *  significant digits and exponents at the ends of the range. They are followed
+ *  by random numbers in the formats exporters write. Returns the number of
+ *  mismatches, each one is printed.
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include "fast_atof.h"
+
+using namespace Assimp;
+
+namespace {
+
+unsigned int failures = 0;
+
+// ------------------------------------------------------------------------------------
+void check( const char* in)
+{
+	const double d = fast_atod(in);
+	const double dref = strtod(in, NULL);
+	const float f = fast_atof(in);
+	const float fref = strtof(in, NULL);
+
+	// bitwise, so that the sign of zero counts as well
+	if (memcmp(&d, &dref, sizeof(d)) != 0) {
+		if (++failures <= 32) {
+			printf("double mismatch: %s -> %.17g, strtod %.17g\n", in, d, dref);
+		}
+	}
+	if (memcmp(&f, &fref, sizeof(f)) != 0) {
+		if (++failures <= 32) {
+			printf("float mismatch: %s -> %.9g, strtof %.9g\n", in, f, fref);
+		}
+	}
+}
+
+// ------------------------------------------------------------------------------------
+// xorshift, so that the numbers are the same on every platform
+uint64_t nextRandom()
+{
+	static uint64_t state = 0x2545F4914F6CDD1DULL;
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	return state;
+}
+
+// random bits, but neither nan nor infinite
+double randomDouble()
+{
+	for (;;)
+	{
+		const uint64_t bits = nextRandom();
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+		if (value - value == 0) {
+			return value;
+		}
+	}
+}
+
+float randomFloat()
+{
+	for (;;)
+	{
+		const uint32_t bits = static_cast<uint32_t>(nextRandom() >> 32);
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		if (value - value == 0) {
+			return value;
+		}
+	}
+}
+
+} // ! anon namespace
+
+// ------------------------------------------------------------------------------------
+int main()
+{
+	static const char* const cases[] = {
+		"0", "-0", "0.0", "000.000e5", "1", "-1", "+1.5", ".5", "5.", "1e0", "1E+2",
+		// zero padded mantissas, as written with %.16e
+		"5.7609570000000000e+07", "1.0000000000000000e+00", "-2.5000000000000000e-01",
+		"1.2345000000000000000000000000e+10", "123450000000000000000000000", "0.000000000000000000001000",
+		"100000000000000000000000000000000000000", "3.4028234663852886e+38",
+		// more than 15 significant digits
+		"0.1234567890123456789", "9007199254740993", "9007199254740992.5", "1.00000000000000011102230246251565404",
+		"2.2250738585072011e-308", "2.2250738585072014e-308", "4.9406564584124654e-324",
+		"1.7976931348623157e308", "1.7976931348623159e308", "12345678901234567890123456789e-20",
+		// float ties and denormals
+		"1.00000005960464477539062500", "1.0000000596046447753906250001", "16777217", "16777219",
+		"3.4028235677973366e38", "1.4e-45", "7.006492321624085e-46", "1.1754943508222875e-38",
+		// exponent range
+		"1e22", "1e23", "1e-22", "1e-23", "8.5e-22", "1e400", "1e-400", "0e100000", "1e99999999999",
+	};
+	for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+		check(cases[i]);
+	}
+
+	// longer than any buffer, the remainder beyond the 767th digit decides the tie
+	std::string tie = "1.00000005960464477539062500";
+	check((tie + std::string(1000, '0') + "1").c_str());
+	check((tie + std::string(1000, '0')).c_str());
+	check((std::string("0.") + std::string(800, '3') + "e10").c_str());
+
+	char buffer[128];
+	for (unsigned int i = 0; i < 1000000; ++i)
+	{
+		const double value = randomDouble();
+
+		// all precisions, including the zero padded ones of %.16e and more
+		static const char* const formats[] = { "%.*g", "%.*e", "%.*f" };
+		const int precision = static_cast<int>(nextRandom() % 26);
+		const char* format = formats[nextRandom() % 3];
+		if (format[3] == 'f' && (value > 1e30 || value < -1e30)) {
+			format = formats[1];
+		}
+		snprintf(buffer, sizeof(buffer), format, precision, value);
+		check(buffer);
+
+		// floats as written by float exporters, with zero padding
+		snprintf(buffer, sizeof(buffer), "%.16e", randomFloat());
+		check(buffer);
+
+		// random digits, with up to 25 significant ones
+		char* cur = buffer;
+		const unsigned int numDigits = 1 + static_cast<unsigned int>(nextRandom() % 25);
+		const unsigned int point = static_cast<unsigned int>(nextRandom() % (numDigits + 1));
+		for (unsigned int n = 0; n < numDigits; ++n) {
+			if (n == point) {
+				*cur++ = '.';
+			}
+			*cur++ = static_cast<char>('0' + nextRandom() % 10);
+		}
+		sprintf(cur, "e%d", static_cast<int>(nextRandom() % 90) - 45);
+		check(buffer);
+	}
+
+	printf("fast_atof: %u mismatches\n", failures);
+	return failures ? 1 : 0;
+}
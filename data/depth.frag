@@ -0,0 +1,7 @@
+#version 140
+
+// Writes depth only (color writes are masked during the pre-pass).
+
+void main()
+{
+}
@@ -6,6 +6,7 @@ uniform samplerCube cubemap;
 uniform int mapping;
 
 out vec4 fragColor;
+bool overdrawn(inout vec4 color); // see overdraw.frag
 
 in vec3 v_eye;
 
@@ -62,6 +63,9 @@ vec4 env(in vec3 eye)
 
 void main()
 {
+	if (overdrawn(fragColor))
+		return;
+
 	vec3 eye = normalize(v_eye);
 	vec4 color = env(eye);
 
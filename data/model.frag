@@ -0,0 +1,20 @@
+#version 140
+
+uniform vec3 lightDirection;
+bool overdrawn(inout vec4 color); // see overdraw.frag
+
+in vec3 v_normal;
+in vec2 v_texCoord;
+
+out vec4 fragColor;
+
+void main()
+{
+	if (overdrawn(fragColor))
+		return;
+
+	vec3 n = normalize(v_normal);
+	float lambert = max(dot(n, -normalize(lightDirection)), 0.0);
+
+	fragColor = vec4(vec3(0.8) * mix(0.3, 1.0, lambert), 1.0);
+}
@@ -0,0 +1,23 @@
+#version 140
+
+// Models loaded by FileAssociatedModel, with interleaved position, normal,
+// and texture coordinate (see ModelLoader).
+
+uniform mat4 viewProjection;
+uniform mat4 model;
+
+in vec3 a_vertex;
+in vec3 a_normal;
+in vec2 a_texCoord;
+
+out vec3 v_normal;
+out vec2 v_texCoord;
+
+void main()
+{
+	// models are scaled uniformly, so the model matrix suffices for normals
+	v_normal = mat3(model) * a_normal;
+	v_texCoord = a_texCoord;
+
+	gl_Position = viewProjection * model * vec4(a_vertex, 1.0);
+}
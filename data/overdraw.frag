@@ -0,0 +1,15 @@
+#version 140
+
+// Overdraw visualization, linked into every program of the Painter: a
+// shader returns early if overdrawn() is true, so that every shaded fragment
+// just adds its color up (blended additively).
+
+uniform bool overdraw;
+
+bool overdrawn(inout vec4 color)
+{
+	if (overdraw)
+		color = vec4(0.1, 0.05, 0.025, 0.0);
+
+	return overdraw;
+}
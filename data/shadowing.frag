@@ -0,0 +1,30 @@
+#version 140
+
+// Cascaded shadow map lookup (see CascadedShadowMap), linked into the
+// programs of all shadow receivers, which declare shadowing() by prototype.
+
+uniform sampler2DArrayShadow shadowMap;
+uniform mat4 shadowMatrices[4]; // model to shadow map space, per cascade
+uniform mat4 shadowView;        // model to view space, for choosing the cascade
+uniform vec4 shadowSplits;      // far view distance of each cascade
+uniform int shadowCascades;     // 0 disables shadows
+
+// share of light reaching position (model space), with 3x3 PCF
+float shadowing(vec3 position)
+{
+	float distance = -(shadowView * vec4(position, 1.0)).z;
+	int cascade = int(dot(step(shadowSplits, vec4(distance)), vec4(1.0)));
+
+	if (cascade >= shadowCascades)
+		return 1.0;
+
+	vec4 coord = shadowMatrices[cascade] * vec4(position, 1.0);
+	vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+
+	float lit = 0.0;
+	for (int y = -1; y <= 1; ++y)
+		for (int x = -1; x <= 1; ++x)
+			lit += texture(shadowMap, vec4(coord.xy + vec2(x, y) * texel, float(cascade), coord.z));
+
+	return lit / 9.0;
+}
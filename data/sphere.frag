@@ -7,6 +7,7 @@ uniform int mapping;
 uniform float timef;
 
 out vec4 fragColor;
+bool overdrawn(inout vec4 color); // see overdraw.frag
 
 in vec3 v_normal;
 in vec3 v_eye;
@@ -61,6 +62,9 @@ vec4 env(in vec3 eye)
 
 void main()
 {
+	if (overdrawn(fragColor))
+		return;
+
 	vec3 n = normalize(v_normal);
 	vec3 e = normalize(v_eye);
 
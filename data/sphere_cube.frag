@@ -6,11 +6,15 @@ uniform samplerCube cubemap;
 uniform float timef;
 
 out vec4 fragColor;
+bool overdrawn(inout vec4 color); // see overdraw.frag
 uniform int mapping;
 
 in vec3 v_normal;
 in vec3 v_eye;
 
+// share of light reaching position (model space), see shadowing.frag
+float shadowing(vec3 position);
+
 // Task_2_3 - ToDo Begin
 // Copy your env function from 2_1
 const float pi = 3.14159;
@@ -67,6 +71,9 @@ vec4 env(in vec3 eye)
 
 void main()
 {
+	if (overdrawn(fragColor))
+		return;
+
 	vec3 n = normalize(v_normal);
 	vec3 e = normalize(v_eye);
 
@@ -81,6 +88,10 @@ void main()
 
     fragColor = refl;
 
+	// shadowed parts keep half of their color (the unit sphere's vertices are
+	// its normals, thus v_normal is the position in model space)
+	fragColor.rgb *= mix(0.5, 1.0, shadowing(v_normal));
+
 }
 
 // Task_2_3 - ToDo End
@@ -0,0 +1,79 @@
+#version 140
+
+uniform sampler2D envmap;
+uniform samplerCube cubemap;
+
+uniform int mapping;
+uniform vec3 eye;
+
+out vec4 fragColor;
+bool overdrawn(inout vec4 color); // see overdraw.frag
+
+in vec3 v_normal;
+in vec3 v_eye;
+in vec4 v_material;
+
+const float pi = 3.14159;
+float u,v,m;
+
+// share of light reaching position (model space), see shadowing.frag
+float shadowing(vec3 position);
+
+vec4 env(in vec3 eye)
+{
+	vec4 color;
+
+	if(0 == mapping) 		// cube
+	{
+		color = texture(cubemap, eye);
+	}
+	else if(1 == mapping) 	// polar
+	{
+        u = 0.5*atan(eye.x, eye.z)/pi;
+        v = 2.0*asin(-eye.y)/pi;
+
+        color = texture(envmap, vec2(u, v));
+        color = mix(vec4(0.1, 0.1, 0.11, 0.1), color, smoothstep(0.0,0.03, eye.y));
+ 	}
+	else if(2 == mapping) 	// paraboloid
+	{
+		m = 2.0 + 2.0 * eye.y;
+        u = 0.5 + eye.x/m;
+        v = 0.5 + eye.z/m;
+
+        color = texture(envmap, vec2(u, v));
+        color = mix(vec4(0.0, 0.0, 0.0, 0.0), color, smoothstep(0.0,0.03, eye.y));
+	}
+	else if(3 == mapping) 	// sphere
+	{
+		m = 2.0*sqrt(pow(eye.x, 2) + pow(eye.y, 2) + pow(1.0 - eye.z, 2));
+		u = 0.5 - eye.x/m;
+		v = 0.5 - eye.y/m;
+
+        color = texture(envmap, vec2(u, v));
+	}
+	return color;
+}
+
+void main()
+{
+	if (overdrawn(fragColor))
+		return;
+
+	vec3 n = normalize(v_normal);
+	vec3 e = normalize(v_eye);
+
+	vec3 r = reflect(e, n);
+	vec3 q = refract(e, n, 1.0 / 1.05);
+
+	float frsl = clamp(1.8*pow(dot(-e, n), 1.0) - 0.5, 0.0, 1.0);
+
+	vec4 refl = env(r);
+	vec4 refr = env(q);
+
+	// the material tints the reflection, its alpha weights the refraction
+	fragColor = mix(refl, refr, frsl * v_material.a) * vec4(v_material.rgb, 1.0);
+
+	// shadowed parts keep half of their color (instances are in world space)
+	fragColor.rgb *= mix(0.5, 1.0, shadowing(v_eye + eye));
+}
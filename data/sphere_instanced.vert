@@ -0,0 +1,35 @@
+#version 140
+
+// Instanced variant of sphere.vert: the model transform and material of each
+// instance are fetched from a buffer texture (5 texels per instance).
+
+uniform mat4 viewProjection;
+uniform vec3 eye;
+uniform samplerBuffer instances;
+
+in vec3 a_vertex;
+
+out vec3 v_normal;
+out vec3 v_eye;
+out vec4 v_material;
+
+void main()
+{
+	int i = gl_InstanceID * 5;
+
+	mat4 model = mat4(
+		texelFetch(instances, i + 0)
+	,	texelFetch(instances, i + 1)
+	,	texelFetch(instances, i + 2)
+	,	texelFetch(instances, i + 3));
+
+	v_material = texelFetch(instances, i + 4);
+
+	vec4 vertex = model * vec4(a_vertex, 1.0);
+
+	// instances are scaled uniformly, so the model matrix suffices for normals
+	v_normal = mat3(model) * a_vertex;
+	v_eye = vertex.xyz - eye;
+
+	gl_Position = viewProjection * vertex;
+}
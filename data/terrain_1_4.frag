@@ -7,6 +7,12 @@ uniform samplerCube source;
 uniform samplerCube cubemap;
 uniform sampler2D waterheights;
 uniform sampler2D waternormals;
+
+// FFT ocean (see Ocean): waternormals holds the slopes, repeated oceanRepeat
+// times over the plane, with heights scaled by oceanScale.y / oceanScale.x
+uniform bool ocean;
+uniform float oceanRepeat;
+uniform vec2 oceanScale;
 uniform int mapping;
 
 in vec3 a_position;
@@ -15,6 +21,7 @@ in float a_height;
 
 
 out vec4 fragColor;
+bool overdrawn(inout vec4 color); // see overdraw.frag
 
 const float pi = 3.14159;
 float u,v,m;
@@ -71,7 +78,15 @@ vec4 env(in vec3 eye)
 
 void main()
 {
+	if (overdrawn(fragColor))
+		return;
+
 	vec3 n = normalize(f_normal.xyz);
+	if (ocean)
+	{
+		vec2 s = texture(waternormals, a_position.xz * oceanRepeat).xy * oceanScale.y / oceanScale.x;
+		n = normalize(vec3(-s.x, 1.0, -s.y));
+	}
 	vec3 e = normalize(v_eye);
 
 	vec3 r = reflect(e, n);
@@ -7,6 +7,12 @@ uniform vec3 a_offset;
 uniform float a_time;
 uniform mat4 vpi;
 
+// FFT ocean (see Ocean): waterheights holds displacements (x, height, z),
+// repeated oceanRepeat times over the plane and scaled by oceanScale
+uniform bool ocean;
+uniform float oceanRepeat;
+uniform vec2 oceanScale;
+
 in vec3 a_vertex;
 out vec3 a_position;
 out float a_height;
@@ -17,7 +23,10 @@ void main()
     a_position = a_vertex;
     gl_Position = vec4(a_vertex, 1.0);
     gl_Position.y += 0.21;
-    gl_Position.y += texture(waterheights, a_vertex.xz+vec2(a_time)/3).r/12;
+    if (ocean)
+        gl_Position.xyz += texture(waterheights, a_vertex.xz * oceanRepeat).xyz * oceanScale.xyx;
+    else
+        gl_Position.y += texture(waterheights, a_vertex.xz+vec2(a_time)/3).r/12;
 
     a_height = gl_Position.y;
     gl_Position = transform * gl_Position;
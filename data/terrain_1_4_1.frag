@@ -9,6 +9,7 @@ in vec3 a_texelPosition;
 in vec3 a_normal;
 
 out vec4 fragColor;
+bool overdrawn(inout vec4 color); // see overdraw.frag
 
 // Task_1_3 - ToDo Begin
 
@@ -21,8 +22,14 @@ float mixVal;
 
 float shadow;
 
+// share of light reaching position (model space), see shadowing.frag
+float shadowing(vec3 position);
+
 void main()
 {
+	if (overdrawn(fragColor))
+		return;
+
 	// Implement height based texturing using a texture atlas
 	// with known structure ;)
 
@@ -86,6 +93,9 @@ void main()
 	// Task_1_3 - ToDo End
 	fragColor.rgb -= vec3(clamp(shadow, 0.0, 1.0));
 
+	// shadowed parts keep half of their color
+	fragColor.rgb *= mix(0.5, 1.0, shadowing(vec3(a_texelPosition.x, a_texelPosition.y + a_height, a_texelPosition.z)));
+
 	if(a_height <= 0.21)
     {
         fragColor -= texture2D(caustics, a_texelPosition.xz / vec2(1.0, 0.1) + a_time/5)/5;
@@ -0,0 +1,52 @@
+#version 140
+
+uniform sampler2DArray groundLayers;
+uniform sampler2D caustics;
+uniform float a_time;
+
+in float a_height;
+in vec3 a_texelPosition;
+in vec3 a_normal;
+
+out vec4 fragColor;
+bool overdrawn(inout vec4 color); // see overdraw.frag
+
+// Height based texturing as in terrain_1_4_1.frag, but with the atlas' tiles
+// as layers of a mipmapped texture array: no tile offsets, safe margins, or
+// seams, and no branches for choosing the layers.
+
+// layers of the ground atlas from low (3) to high (0) terrain
+const float layers = 4.0;
+// part of each height band that blends into the next layer
+const float blend = 0.1;
+// ground texture repetitions per terrain tile
+const vec2 scale = vec2(10.0, 10.0);
+
+// share of light reaching position (model space), see shadowing.frag
+float shadowing(vec3 position);
+
+void main()
+{
+	if (overdrawn(fragColor))
+		return;
+
+	float band = clamp(floor(a_height * layers), 0.0, layers - 1.0);
+
+	float lower = layers - 1.0 - band;
+	float upper = max(lower - 1.0, 0.0);
+
+	float top = (band + 1.0) / layers;
+	float i = clamp((a_height - top + blend) / blend, 0.0, 1.0);
+
+	vec2 uv = a_texelPosition.xz * scale;
+	fragColor = mix(texture(groundLayers, vec3(uv, lower)), texture(groundLayers, vec3(uv, upper)), i);
+
+	float shadow = 0.4 + dot(a_normal, vec3(0.0, 1.0, 0.0));
+	fragColor.rgb -= vec3(clamp(shadow, 0.0, 1.0));
+
+	// shadowed parts keep half of their color
+	fragColor.rgb *= mix(0.5, 1.0, shadowing(vec3(a_texelPosition.x, a_texelPosition.y + a_height, a_texelPosition.z)));
+
+	// caustics below the water line, selected by step instead of a branch
+	fragColor -= step(a_height, 0.21) * texture(caustics, a_texelPosition.xz / vec2(1.0, 0.1) + a_time / 5.0) / 5.0;
+}
@@ -0,0 +1,65 @@
+#version 140
+
+// Vertex shader for a level of the geometry clipmap (see ClipmapTerrain).
+// Vertices are grid positions within the level, heights are fetched from
+// the level's toroidally addressed layer. Outputs match terrain_1_4_1.vert.
+
+uniform mat4 transform;
+uniform sampler2DArray clipmap;
+
+uniform int level;
+uniform bool coarsest;
+uniform vec2 origin;      // grid position of the first vertex
+uniform vec2 spacing;     // of grid positions in texture space
+uniform vec2 texelCenter;
+uniform float clipmapSize;
+uniform float quads;
+
+in vec3 a_vertex;
+
+out float a_height;
+out vec3 a_texelPosition;
+out vec3 a_normal;
+
+float fetch(vec2 local)
+{
+    // stay within the uploaded region
+    vec2 g = origin + clamp(local, vec2(0.0), vec2(quads));
+    ivec2 t = ivec2(mod(g, vec2(clipmapSize)));
+    return texelFetch(clipmap, ivec3(t, level), 0).r;
+}
+
+void main()
+{
+    vec2 local = a_vertex.xz;
+
+    a_height = fetch(local);
+
+    // odd vertices on the outer border are interpolated along the border,
+    // matching the coarser level's edges
+    if (!coarsest)
+    {
+        bool borderX = local.x == 0.0 || local.x == quads;
+        bool borderZ = local.y == 0.0 || local.y == quads;
+
+        if (borderZ && mod(local.x, 2.0) == 1.0)
+            a_height = 0.5 * (fetch(local - vec2(1.0, 0.0)) + fetch(local + vec2(1.0, 0.0)));
+        else if (borderX && mod(local.y, 2.0) == 1.0)
+            a_height = 0.5 * (fetch(local - vec2(0.0, 1.0)) + fetch(local + vec2(0.0, 1.0)));
+    }
+
+    vec2 uv = (origin + local) * spacing + texelCenter;
+
+    a_texelPosition = vec3(uv.x, 0.0, uv.y);
+    gl_Position = transform * vec4(uv.x, a_height, uv.y, 1.0);
+
+    // central differences on the level's grid
+    float north = fetch(local - vec2(0.0, 1.0));
+    float south = fetch(local + vec2(0.0, 1.0));
+    float east  = fetch(local + vec2(1.0, 0.0));
+    float west  = fetch(local - vec2(1.0, 0.0));
+
+    a_normal = normalize(cross(
+        vec3(0.0, north - south, -2.0 * spacing.y)
+    ,   vec3(2.0 * spacing.x, east - west, 0.0)));
+}
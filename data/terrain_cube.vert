@@ -28,7 +28,7 @@ void main()
 
     gl_Position = vec4(a_vertex, 1.0);
     a_texelPosition = a_vertex;
-    a_height = texture2D(height, gl_Position.xz + a_offset.xz).r;
+    a_height = texture(height, gl_Position.xz + a_offset.xz).r;
     gl_Position.y += a_height + a_offset.y;
     //gl_Position = transform * gl_Position;
 
@@ -40,10 +40,10 @@ void main()
 
 	//
 
-	north.y = texture2D(height, north.xz + a_offset.xy).r;
-    east.y = texture2D(height, east.xz + a_offset.xy).r;
-    south.y = texture2D(height, south.xz + a_offset.xy).r;
-    west.y = texture2D(height, west.xz + a_offset.xy).r;
+	north.y = texture(height, north.xz + a_offset.xy).r;
+    east.y = texture(height, east.xz + a_offset.xy).r;
+    south.y = texture(height, south.xz + a_offset.xy).r;
+    west.y = texture(height, west.xz + a_offset.xy).r;
 	// Task_1_2 - ToDo End
 
 	a_normal = normalize(cross(north - south, east - west));
@@ -0,0 +1,21 @@
+#version 140
+
+// Depth only variant of terrain_1_4_1.vert for the depth pre-pass. The
+// position has to be computed exactly as there (see invariant).
+
+uniform mat4 transform;
+uniform sampler2D height;
+
+in vec3 a_vertex;
+
+invariant gl_Position;
+
+vec3 a_offset = vec3(0.0, 0.0, 0.0);
+
+void main()
+{
+    gl_Position = vec4(a_vertex, 1.0);
+    float a_height = texture(height, gl_Position.xz + a_offset.xz).r;
+    gl_Position.y += a_height + a_offset.y;
+    gl_Position = transform * gl_Position;
+}
@@ -0,0 +1,42 @@
+#version 140
+
+// Depth only variant of terrain_streamed.vert for the depth pre-pass. The
+// position has to be computed exactly as there (see invariant).
+
+uniform mat4 transform;
+
+uniform sampler2DArray heightTiles;
+uniform sampler2D heightIndirection;
+uniform vec2 heightSize;
+uniform vec2 heightTileSize;
+
+in vec3 a_vertex;
+
+invariant gl_Position;
+
+vec3 a_offset = vec3(0.0, 0.0, 0.0);
+
+float streamedHeight(vec2 uv)
+{
+	uv = clamp(uv, vec2(0.0), vec2(1.0));
+
+	ivec2 cells = textureSize(heightIndirection, 0);
+	vec4 entry = texelFetch(heightIndirection, min(ivec2(uv * vec2(cells)), cells - 1), 0);
+
+	if (entry.x < 0.0)
+		return 0.0;
+
+	vec2 levelSize = ceil(heightSize / exp2(entry.y));
+	vec2 local = uv * levelSize - entry.zw * heightTileSize.x;
+	float border = (heightTileSize.y - heightTileSize.x) * 0.5;
+
+	return textureLod(heightTiles, vec3((local + border) / heightTileSize.y, entry.x), 0.0).r;
+}
+
+void main()
+{
+    gl_Position = vec4(a_vertex, 1.0);
+    float a_height = streamedHeight(gl_Position.xz + a_offset.xz);
+    gl_Position.y += a_height + a_offset.y;
+    gl_Position = transform * gl_Position;
+}
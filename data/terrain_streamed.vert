@@ -0,0 +1,84 @@
+#version 140
+
+// Task_1_3 - ToDo Begin
+
+uniform mat4 transform;
+
+// streamed height field, see HeightfieldStreamer
+uniform sampler2DArray heightTiles;
+uniform sampler2D heightIndirection;
+uniform vec2 heightSize;     // texels of level 0
+uniform vec2 heightTileSize; // x: tile size, y: page size (with border)
+
+uniform mat4 v;
+uniform mat4 p;
+uniform mat4 vp;
+uniform mat4 m_transforms;
+
+in vec3 a_vertex;
+
+out float a_height;
+out vec3 a_texelPosition;
+out vec3 a_normal;
+
+// has to match terrain_depth_streamed.vert for the depth pre-pass
+invariant gl_Position;
+
+vec3 north;
+vec3 east;
+vec3 south;
+vec3 west;
+float space;
+vec3 a_offset = vec3(0.0, 0.0, 0.0);
+mat4 viewProjection = v * p;
+
+float streamedHeight(vec2 uv)
+{
+	uv = clamp(uv, vec2(0.0), vec2(1.0));
+
+	// finest resident tile covering uv: layer, level, tile x and y
+	ivec2 cells = textureSize(heightIndirection, 0);
+	vec4 entry = texelFetch(heightIndirection, min(ivec2(uv * vec2(cells)), cells - 1), 0);
+
+	if (entry.x < 0.0)
+		return 0.0;
+
+	vec2 levelSize = ceil(heightSize / exp2(entry.y));
+	vec2 local = uv * levelSize - entry.zw * heightTileSize.x;
+	float border = (heightTileSize.y - heightTileSize.x) * 0.5;
+
+	return textureLod(heightTiles, vec3((local + border) / heightTileSize.y, entry.x), 0.0).r;
+}
+
+void main()
+{
+	// Note: should be similar to 1_2 vertex shader.
+	// In addition, you need to pass the texture coords
+	// to the fragment shader...
+
+	// ..
+
+    gl_Position = vec4(a_vertex, 1.0);
+    a_texelPosition = a_vertex;
+    a_height = streamedHeight(gl_Position.xz + a_offset.xz);
+    gl_Position.y += a_height + a_offset.y;
+    gl_Position = transform * gl_Position;
+
+    space = 0.01;
+    north = a_vertex - vec3(0.0, 0.0, space);
+	east = a_vertex + vec3(space, 0.0, 0.0);
+	south = a_vertex + vec3(0.0, 0.0, space);
+	west = a_vertex - vec3(space, 0.0, 0.0);
+
+	//
+
+	north.y = streamedHeight(north.xz + a_offset.xy);
+    east.y = streamedHeight(east.xz + a_offset.xy);
+    south.y = streamedHeight(south.xz + a_offset.xy);
+    west.y = streamedHeight(west.xz + a_offset.xy);
+	// Task_1_2 - ToDo End
+
+	a_normal = normalize(cross(north - south, east - west));
+
+	// Task_1_3 - ToDo End
+}
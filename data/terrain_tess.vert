@@ -0,0 +1,13 @@
+#version 400
+
+// Patch corners are passed through, tessellation levels and displacement
+// are done in terrain_tess.tcs and terrain_tess.tes.
+
+in vec3 a_vertex;
+
+out vec3 v_vertex;
+
+void main()
+{
+    v_vertex = a_vertex;
+}
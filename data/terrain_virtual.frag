@@ -0,0 +1,78 @@
+#version 140
+
+// virtual texture, see VirtualTexture
+uniform sampler2D virtualPages;
+uniform sampler2D virtualTable;
+uniform vec2 virtualSize;      // texels of level 0
+uniform vec2 virtualTileSize;  // x: tile size, y: page size (with border)
+uniform float virtualPagesPerSide;
+uniform float virtualLevels;
+
+uniform sampler2D caustics;
+uniform float a_time;
+
+in float a_height;
+in vec3 a_texelPosition;
+in vec3 a_normal;
+
+out vec4 fragColor;
+bool overdrawn(inout vec4 color); // see overdraw.frag
+
+// share of light reaching position (model space), see shadowing.frag
+float shadowing(vec3 position);
+
+// has to match virtual_feedback.frag
+float virtualLevel(vec2 uv, float bias)
+{
+	vec2 dx = dFdx(uv * virtualSize);
+	vec2 dy = dFdy(uv * virtualSize);
+
+	float level = floor(0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + bias);
+	return clamp(level, 0.0, virtualLevels - 1.0);
+}
+
+// tile of the given level covering uv
+ivec2 virtualTile(vec2 uv, float level)
+{
+	vec2 levelSize = ceil(virtualSize / exp2(level));
+	vec2 tiles = ceil(levelSize / virtualTileSize.x);
+
+	return ivec2(min(floor(uv * levelSize / virtualTileSize.x), tiles - 1.0));
+}
+
+vec4 virtualTexture(vec2 uv)
+{
+	// the level is chosen before wrapping, fract breaks the derivatives
+	float level = virtualLevel(uv, 0.0);
+	uv = fract(uv);
+
+	// finest resident tile covering uv: page x, page y, and its level
+	vec4 entry = floor(texelFetch(virtualTable, virtualTile(uv, level), int(level)) * 255.0 + 0.5);
+
+	vec2 local = uv * ceil(virtualSize / exp2(entry.z)) - vec2(virtualTile(uv, entry.z)) * virtualTileSize.x;
+	float border = (virtualTileSize.y - virtualTileSize.x) * 0.5;
+
+	vec2 page = entry.xy * virtualTileSize.y + border + local;
+	vec4 color = textureLod(virtualPages, page / (virtualPagesPerSide * virtualTileSize.y), 0.0);
+
+	// nothing is resident before the first tiles are loaded
+	return mix(vec4(0.5, 0.5, 0.5, 1.0), color, step(0.5, entry.a));
+}
+
+void main()
+{
+	if (overdrawn(fragColor))
+		return;
+
+	// the virtual texture spans the terrain once
+	fragColor = virtualTexture(a_texelPosition.xz);
+
+	float shadow = 0.4 + dot(a_normal, vec3(0.0, 1.0, 0.0));
+	fragColor.rgb -= vec3(clamp(shadow, 0.0, 1.0));
+
+	// shadowed parts keep half of their color
+	fragColor.rgb *= mix(0.5, 1.0, shadowing(vec3(a_texelPosition.x, a_texelPosition.y + a_height, a_texelPosition.z)));
+
+	// caustics below the water line, selected by step instead of a branch
+	fragColor -= step(a_height, 0.21) * texture(caustics, a_texelPosition.xz / vec2(1.0, 0.1) + a_time / 5.0) / 5.0;
+}
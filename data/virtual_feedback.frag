@@ -0,0 +1,39 @@
+#version 140
+
+// virtual texture, see VirtualTexture
+uniform vec2 virtualSize;      // texels of level 0
+uniform vec2 virtualTileSize;  // x: tile size, y: page size (with border)
+uniform float virtualLevels;
+uniform float virtualFeedbackBias;
+
+in vec3 a_texelPosition;
+
+out vec4 fragColor;
+
+// has to match terrain_virtual.frag
+float virtualLevel(vec2 uv, float bias)
+{
+	vec2 dx = dFdx(uv * virtualSize);
+	vec2 dy = dFdy(uv * virtualSize);
+
+	float level = floor(0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + bias);
+	return clamp(level, 0.0, virtualLevels - 1.0);
+}
+
+ivec2 virtualTile(vec2 uv, float level)
+{
+	vec2 levelSize = ceil(virtualSize / exp2(level));
+	vec2 tiles = ceil(levelSize / virtualTileSize.x);
+
+	return ivec2(min(floor(uv * levelSize / virtualTileSize.x), tiles - 1.0));
+}
+
+void main()
+{
+	// the feedback is rendered at lower resolution, the bias compensates
+	// for its larger derivatives
+	float level = virtualLevel(a_texelPosition.xz, virtualFeedbackBias);
+
+	// tile x, tile y, level, and alpha marking the request
+	fragColor = vec4(vec2(virtualTile(fract(a_texelPosition.xz), level)), level, 1.0);
+}
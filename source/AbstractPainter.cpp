@@ -4,6 +4,7 @@
 #include <QStringList>
 
 #include "Camera.h"
+#include "DynamicResolution.h"
 
 #include "AbstractPainter.h"
 
@@ -11,6 +12,7 @@
 AbstractPainter::AbstractPainter()
 : m_camera(nullptr)
 , m_mode(PaintMode1)
+, m_resolution(nullptr)
 {
 }
  
@@ -47,6 +49,21 @@ Camera * AbstractPainter::camera()
     return m_camera;
 }
 
+void AbstractPainter::setDynamicResolution(DynamicResolution * resolution)
+{
+    m_resolution = resolution;
+}
+
+QSize AbstractPainter::renderSize() const
+{
+    assert(m_camera);
+
+    if (m_resolution && m_resolution->enabled())
+        return m_resolution->size();
+
+    return m_camera->viewport();
+}
+
 const float AbstractPainter::depthAt(const QPointF & windowCoordinates)
 {
     const GLint x(static_cast<GLint>(windowCoordinates.x()));
@@ -60,6 +77,9 @@ const float AbstractPainter::depthAt(const QPointF & windowCoordinates)
     if (x >= w || y >= h)
         return 1.f;
 
+    if (m_resolution && m_resolution->enabled())
+        return m_resolution->depthAt(x, y);
+
     GLfloat z;
     glReadPixels(x, h - y - 1, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, reinterpret_cast<void*>(&z));
 
@@ -108,6 +128,11 @@ AbstractPainter::PaintMode AbstractPainter::mode() const
     return m_mode;
 }
 
+const Heightfield * AbstractPainter::heightfield() const
+{
+    return nullptr;
+}
+
 void AbstractPainter::keyPressEvent(QKeyEvent * event)
 {
 }
\ No newline at end of file
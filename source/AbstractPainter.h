@@ -12,6 +12,8 @@ class QOpenGLShaderProgram;
 class QKeyEvent;
 
 class Camera;
+class DynamicResolution;
+class Heightfield;
 
 
 class AbstractPainter : public AbstractCoordinateProvider
@@ -40,6 +42,15 @@ public:
     void setCamera(Camera * camera);
     Camera * camera();
 
+    /** if set and enabled, depthAt reads from its offscreen target
+    */
+    void setDynamicResolution(DynamicResolution * resolution);
+
+    /** size of the image rendered, i.e., the camera's viewport, or the scaled
+        sub-rectangle of it while dynamic resolution is enabled
+    */
+    QSize renderSize() const;
+
     /** return list of mandatory extensions (verify results in fatal if one is
         not supported).
     */
@@ -80,9 +91,15 @@ public:
     ,   const float depth
     ,   const QMatrix4x4 & viewProjectionInverted);
 
+    /** cpu side height field of the scene (e.g., for navigation), if any
+    */
+    virtual const Heightfield * heightfield() const;
+
     virtual void keyPressEvent(QKeyEvent * event);
 
 protected:
     Camera * m_camera;
     PaintMode m_mode;
+
+    DynamicResolution * m_resolution;
 };
@@ -1,5 +1,8 @@
 
 #include <cassert>
+#include <cmath>
+
+#include <QtMath>
 
 #include "Camera.h"
 
@@ -149,6 +152,19 @@ void Camera::setViewport(const QSize & viewport)
     dirty();
 }
 
+float Camera::projectedSize(
+    const QVector3D & center
+,   const float radius) const
+{
+    const float height(static_cast<float>(m_viewport.height()));
+    const float distance((center - m_eye).length());
+
+    if (distance <= radius)
+        return height;
+
+    return radius * height / (distance * std::tan(qDegreesToRadians(m_fovy * 0.5f)));
+}
+
 void Camera::update()
 {
     if (!m_dirty)
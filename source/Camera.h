@@ -40,6 +40,14 @@ public:
     const QSize & viewport() const;
     void setViewport(const QSize & viewport);
 
+    /** Approximate height in pixels of a sphere's projection (its diameter
+        at the distance of its center), e.g., to choose levels of detail.
+        This is at least the viewport's height if the eye is inside.
+    */
+    float projectedSize(
+        const QVector3D & center
+    ,   float radius) const;
+
     // lazy matrices getters
 
     const QMatrix4x4 & view();
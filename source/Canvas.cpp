@@ -8,7 +8,10 @@
 
 #include "AbstractPainter.h"
 #include "AdaptiveGrid.h"
+#include "DynamicResolution.h"
 #include "FileAssociatedShader.h"
+#include "FileAssociatedTexture.h"
+#include "FileAssociatedModel.h"
 #include "Camera.h"
 #include "Navigation.h"
 #include "NavigationMath.h"
@@ -121,6 +124,8 @@ void Canvas::initializeGL(const QSurfaceFormat & format)
     m_grid.reset(new AdaptiveGrid(*this));
     m_grid->setNearFar(m_camera->zNear(), m_camera->zFar());
 
+    m_resolution.reset(new DynamicResolution(*this));
+
     connect(m_camera.data(), &Camera::changed, this, &Canvas::cameraChanged);
 
     m_context->doneCurrent();
@@ -151,6 +156,8 @@ void Canvas::paintGL()
 
     m_context->makeCurrent(this);
     auto programsWithInvalidatedUniforms(FileAssociatedShader::process()); // recompile file associated shaders if required
+    FileAssociatedTexture::process(*this); // upload changed or edited regions of file associated textures
+    FileAssociatedModel::process(*this); // upload (re)loaded models within a per frame budget
 
     if (m_update)
     {
@@ -162,10 +169,16 @@ void Canvas::paintGL()
     else
         m_painter->update(programsWithInvalidatedUniforms);
 
+    // scene and grid are rendered offscreen and upscaled to the window
+    m_resolution->resize(size());
+    m_resolution->begin();
+
 	m_painter->paint(m_time->getf(true));
     if (m_showAdaptiveGrid)
         m_grid->draw(*this);
 
+    m_resolution->end(m_context->defaultFramebufferObject());
+
     m_context->swapBuffers(this);
     m_context->doneCurrent();
 
@@ -221,12 +234,14 @@ void Canvas::setPainter(AbstractPainter * painter)
 
     m_painter->initialize();
     m_painter->setCamera(m_camera.data());
+    m_painter->setDynamicResolution(m_resolution.data());
 
     verifyExtensions();
 
     m_context->doneCurrent();
 
     m_navigation->setCoordinateProvider(m_painter);
+    m_navigation->setHeightfield(m_painter->heightfield());
 }
 
 void Canvas::setTime(CyclicTime * time)
@@ -358,6 +373,21 @@ bool Canvas::adaptiveGrid() const
     return m_showAdaptiveGrid;
 }
 
+void Canvas::setDynamicResolution(bool enable)
+{
+    if (!m_resolution || enable == m_resolution->enabled())
+        return;
+
+    m_context->makeCurrent(this);
+    m_resolution->setEnabled(enable);
+    m_context->doneCurrent();
+}
+
+bool Canvas::dynamicResolution() const
+{
+    return m_resolution && m_resolution->enabled();
+}
+
 void Canvas::keyPressEvent(QKeyEvent * event)
 {
     if (!m_navigation)
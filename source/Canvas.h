@@ -20,6 +20,7 @@ class Navigation;
 class Timer;
 class CyclicTime;
 class AdaptiveGrid;
+class DynamicResolution;
 
 
 class Canvas : public QWindow, protected OpenGLFunctions
@@ -58,6 +59,11 @@ public:
     void setAdaptiveGrid(bool enable);
     bool adaptiveGrid() const;
 
+    /** renders at a resolution scaled to meet a target gpu frame time
+    */
+    void setDynamicResolution(bool enable);
+    bool dynamicResolution() const;
+
 public slots:
     void toggleSwapInterval();
     
@@ -116,6 +122,7 @@ protected:
     CyclicTime * m_time; ///< is given and controlled by parent (i.e., viewer)
 
     QScopedPointer<AdaptiveGrid> m_grid;
+    QScopedPointer<DynamicResolution> m_resolution;
 
     long double m_swapts;
     unsigned int m_swaps;
@@ -0,0 +1,315 @@
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include <QDebug>
+#include <QOpenGLShaderProgram>
+#include <QVector4D>
+
+#include "AxisAlignedBoundingBox.h"
+#include "Camera.h"
+
+#include "CascadedShadowMap.h"
+
+
+namespace
+{
+    const float Pi = 3.14159265f;
+
+    // sphere radii are rounded up to this, so that they do not flicker
+    const float RadiusPrecision = 1.f / 16.f;
+
+    // depth bias of the casters, scaled by their slope (see glPolygonOffset)
+    const float SlopeBias = 2.f;
+    const float ConstantBias = 4.f;
+
+    int clampCascades(const int cascades)
+    {
+        return cascades < 0 ? 0 : (cascades > CascadedShadowMap::MaxCascades ? CascadedShadowMap::MaxCascades : cascades);
+    }
+}
+
+
+CascadedShadowMap::CascadedShadowMap(
+    OpenGLFunctions & gl
+,   const int cascades
+,   const int resolution)
+: m_gl(gl)
+, m_cascades(clampCascades(cascades))
+, m_resolution(qMax(1, resolution))
+, m_distance(24.f)
+, m_splitWeight(0.75f)
+, m_fbo(0)
+, m_depths(0)
+, m_allocatedCascades(0)
+, m_allocatedResolution(0)
+, m_pushFramebuffer(0)
+{
+    for (int i = 0; i < MaxCascades; ++i)
+        m_splits[i] = std::numeric_limits<float>::max();
+}
+
+CascadedShadowMap::~CascadedShadowMap()
+{
+    if (m_fbo)
+        m_gl.glDeleteFramebuffers(1, &m_fbo);
+    if (m_depths)
+        m_gl.glDeleteTextures(1, &m_depths);
+}
+
+void CascadedShadowMap::setCascades(const int cascades)
+{
+    m_cascades = clampCascades(cascades);
+
+    for (int i = m_cascades; i < MaxCascades; ++i)
+        m_splits[i] = std::numeric_limits<float>::max();
+}
+
+int CascadedShadowMap::cascades() const
+{
+    return m_cascades;
+}
+
+void CascadedShadowMap::setResolution(const int resolution)
+{
+    m_resolution = qMax(1, resolution);
+}
+
+int CascadedShadowMap::resolution() const
+{
+    return m_resolution;
+}
+
+void CascadedShadowMap::setDistance(const float distance)
+{
+    m_distance = distance;
+}
+
+float CascadedShadowMap::distance() const
+{
+    return m_distance;
+}
+
+void CascadedShadowMap::setSplitWeight(const float weight)
+{
+    m_splitWeight = qBound(0.f, weight, 1.f);
+}
+
+float CascadedShadowMap::splitWeight() const
+{
+    return m_splitWeight;
+}
+
+void CascadedShadowMap::update(
+    Camera & camera
+,   const QVector3D & direction
+,   const AxisAlignedBoundingBox & casters)
+{
+    m_view = camera.view();
+
+    if (0 == m_cascades)
+        return;
+
+    const QMatrix4x4 viewInverted(camera.viewInverted());
+
+    const float zNear(camera.zNear());
+    const float zFar(qMax(zNear, qMin(camera.zFar(), m_distance)));
+
+    // squared slope of the frustum's edges: corners at distance d are
+    // sqrt(k2) * d off the view axis
+    const float tanY(std::tan(camera.fovy() * Pi / 360.f));
+    const float aspect(camera.viewport().width() / qMax<float>(static_cast<float>(camera.viewport().height()), 1.f));
+    const float k2(tanY * tanY * (1.f + aspect * aspect));
+
+    // the light's orientation is fixed, only its position follows the cascades
+    const QVector3D forward(direction.normalized());
+    const QVector3D up(std::abs(forward.y()) > 0.99f ? QVector3D(0.f, 0.f, 1.f) : QVector3D(0.f, 1.f, 0.f));
+
+    QVector3D corners[8];
+    for (int i = 0; i < 8; ++i)
+        corners[i] = QVector3D(
+            i & 1 ? casters.urb().x() : casters.llf().x()
+        ,   i & 2 ? casters.urb().y() : casters.llf().y()
+        ,   i & 4 ? casters.urb().z() : casters.llf().z());
+
+    // orthographic light view projection enclosing the frustum slice [begin;end]
+    auto fit = [&](const float begin, const float end, const bool snap) -> QMatrix4x4
+    {
+        // The sphere's center is on the view axis, equally distant to the
+        // near and far corners (if possible), thus independent of rotation.
+
+        const float c(qMin(0.5f * (begin + end) * (1.f + k2), end));
+        float radius(std::sqrt(qMax((end - c) * (end - c) + k2 * end * end, (c - begin) * (c - begin) + k2 * begin * begin)));
+        radius = std::ceil(radius / RadiusPrecision) * RadiusPrecision;
+
+        const QVector3D center(viewInverted * QVector3D(0.f, 0.f, -c));
+        const QVector3D eye(center - forward * radius);
+
+        QMatrix4x4 view;
+        view.lookAt(eye, center, up);
+
+        // casters in front of the sphere (towards the light) are kept
+        float zNearLight(0.f);
+        for (const QVector3D & corner : corners)
+            zNearLight = qMin(zNearLight, QVector3D::dotProduct(corner - eye, forward));
+
+        QMatrix4x4 projection;
+        projection.ortho(-radius, radius, -radius, radius, zNearLight, 2.f * radius);
+
+        QMatrix4x4 viewProjection(projection * view);
+        if (!snap)
+            return viewProjection;
+
+        // moves the projection by less than a texel, so that the world's
+        // origin (and thus any point) always falls onto the same texel grid
+
+        const float half(m_resolution * 0.5f);
+        const QVector4D origin(viewProjection * QVector4D(0.f, 0.f, 0.f, 1.f));
+
+        const float x(origin.x() * half);
+        const float y(origin.y() * half);
+
+        QMatrix4x4 rounding;
+        rounding.translate((std::floor(x + 0.5f) - x) / half, (std::floor(y + 0.5f) - y) / half, 0.f);
+
+        return rounding * viewProjection;
+    };
+
+    // split distances blend between uniform and logarithmic ones
+
+    float begin(zNear);
+    for (int i = 0; i < m_cascades; ++i)
+    {
+        const float t(static_cast<float>(i + 1) / m_cascades);
+        const float end(m_splitWeight * zNear * std::pow(zFar / zNear, t)
+            + (1.f - m_splitWeight) * (zNear + (zFar - zNear) * t));
+
+        m_viewProjections[i] = fit(begin, end, true);
+        m_splits[i] = end;
+
+        begin = end;
+    }
+
+    m_casterViewProjection = fit(zNear, zFar, false);
+}
+
+const QMatrix4x4 & CascadedShadowMap::viewProjection(const int cascade) const
+{
+    assert(cascade >= 0 && cascade < MaxCascades);
+    return m_viewProjections[cascade];
+}
+
+const QMatrix4x4 & CascadedShadowMap::casterViewProjection() const
+{
+    return m_casterViewProjection;
+}
+
+void CascadedShadowMap::allocate()
+{
+    if (!m_fbo)
+    {
+        m_gl.glGenFramebuffers(1, &m_fbo);
+        m_gl.glGenTextures(1, &m_depths);
+    }
+
+    m_allocatedCascades = m_cascades;
+    m_allocatedResolution = m_resolution;
+
+    // linear filtering with comparison yields 2x2 PCF per lookup, outside
+    // the cascade everything is lit
+
+    const GLfloat border[4] = { 1.f, 1.f, 1.f, 1.f };
+
+    m_gl.glBindTexture(GL_TEXTURE_2D_ARRAY, m_depths);
+    m_gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    m_gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    m_gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    m_gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    m_gl.glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border);
+    m_gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    m_gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+    m_gl.glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32F
+        , m_resolution, m_resolution, m_cascades, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    m_gl.glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    m_gl.glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    m_gl.glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_depths, 0, 0);
+    m_gl.glDrawBuffer(GL_NONE);
+    m_gl.glReadBuffer(GL_NONE);
+
+    if (GL_FRAMEBUFFER_COMPLETE != m_gl.glCheckFramebufferStatus(GL_FRAMEBUFFER))
+        qWarning() << "The shadow map framebuffer is incomplete.";
+}
+
+void CascadedShadowMap::begin(OpenGLFunctions & gl)
+{
+    assert(m_cascades > 0);
+
+    gl.glGetIntegerv(GL_FRAMEBUFFER_BINDING, &m_pushFramebuffer);
+    gl.glGetIntegerv(GL_VIEWPORT, m_pushViewport);
+
+    if (m_cascades != m_allocatedCascades || m_resolution != m_allocatedResolution)
+        allocate();
+
+    gl.glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    gl.glViewport(0, 0, m_resolution, m_resolution);
+
+    gl.glEnable(GL_POLYGON_OFFSET_FILL);
+    gl.glPolygonOffset(SlopeBias, ConstantBias);
+}
+
+void CascadedShadowMap::beginCascade(
+    OpenGLFunctions & gl
+,   const int cascade)
+{
+    assert(cascade >= 0 && cascade < m_cascades);
+
+    gl.glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_depths, 0, cascade);
+    gl.glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void CascadedShadowMap::end(OpenGLFunctions & gl)
+{
+    gl.glDisable(GL_POLYGON_OFFSET_FILL);
+
+    gl.glBindFramebuffer(GL_FRAMEBUFFER, m_pushFramebuffer);
+    gl.glViewport(m_pushViewport[0], m_pushViewport[1], m_pushViewport[2], m_pushViewport[3]);
+}
+
+void CascadedShadowMap::bind(
+    OpenGLFunctions & gl
+,   const GLenum unit)
+{
+    gl.glActiveTexture(unit);
+    gl.glBindTexture(GL_TEXTURE_2D_ARRAY, m_depths);
+}
+
+void CascadedShadowMap::release(
+    OpenGLFunctions & gl
+,   const GLenum unit)
+{
+    gl.glActiveTexture(unit);
+    gl.glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void CascadedShadowMap::setUniforms(
+    QOpenGLShaderProgram & program
+,   const int unit
+,   const QMatrix4x4 & model) const
+{
+    // from clip space of the light to texture coordinates and depth
+    QMatrix4x4 bias;
+    bias.translate(0.5f, 0.5f, 0.5f);
+    bias.scale(0.5f);
+
+    QMatrix4x4 matrices[MaxCascades];
+    for (int i = 0; i < m_cascades; ++i)
+        matrices[i] = bias * m_viewProjections[i] * model;
+
+    program.setUniformValue("shadowMap", unit);
+    program.setUniformValueArray("shadowMatrices", matrices, MaxCascades);
+    program.setUniformValue("shadowView", m_view * model);
+    program.setUniformValue("shadowSplits", QVector4D(m_splits[0], m_splits[1], m_splits[2], m_splits[3]));
+    program.setUniformValue("shadowCascades", m_cascades);
+}
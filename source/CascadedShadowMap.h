@@ -0,0 +1,129 @@
+#pragma once
+
+#include <QMatrix4x4>
+#include <QVector3D>
+
+#include "OpenGLFunctions.h"
+
+class QOpenGLShaderProgram;
+
+class AxisAlignedBoundingBox;
+class Camera;
+
+/** Cascaded shadow map for a directional light.
+
+    The camera's view frustum (up to a maximum distance) is split into slices
+    whose far distances blend between uniform and logarithmic spacing. Each
+    slice is enclosed by a sphere that is invariant to the camera's rotation,
+    and gets an orthographic light projection of that size, whose origin is
+    snapped to whole shadow map texels. Thus, shadow edges do not swim while
+    the camera moves or turns. The projections are extended towards the light
+    to keep all casters.
+
+    The cascades are the layers of a depth texture array, sampled with
+    comparison (sampler2DArrayShadow) and filtered with PCF, see shadowing in
+    data/shadowing.frag, which is linked into the receivers' programs.
+*/
+class CascadedShadowMap
+{
+public:
+    static const int MaxCascades = 4;
+
+public:
+    CascadedShadowMap(
+        OpenGLFunctions & gl
+    ,   int cascades = 3
+    ,   int resolution = 1024);
+    virtual ~CascadedShadowMap();
+
+    /** 0 disables shadows, at most MaxCascades
+    */
+    void setCascades(int cascades);
+    int cascades() const;
+
+    /** texels per side of each cascade
+    */
+    void setResolution(int resolution);
+    int resolution() const;
+
+    /** view distance up to which shadows are cast (at most the camera's far)
+    */
+    void setDistance(float distance);
+    float distance() const;
+
+    /** 0 yields uniform, 1 logarithmic split distances
+    */
+    void setSplitWeight(float weight);
+    float splitWeight() const;
+
+    /** Fits the cascades to the camera for a light shining in direction;
+        casters holds everything that might cast shadows (world space).
+    */
+    void update(
+        Camera & camera
+    ,   const QVector3D & direction
+    ,   const AxisAlignedBoundingBox & casters);
+
+    /** light's view projection of a cascade
+    */
+    const QMatrix4x4 & viewProjection(int cascade) const;
+
+    /** light's view projection enclosing all cascades (e.g., for culling)
+    */
+    const QMatrix4x4 & casterViewProjection() const;
+
+    /** binds the framebuffer for rendering depth only, until end
+    */
+    void begin(OpenGLFunctions & gl);
+
+    /** attaches and clears the given cascade's layer
+    */
+    void beginCascade(
+        OpenGLFunctions & gl
+    ,   int cascade);
+
+    /** restores framebuffer, viewport, and render state
+    */
+    void end(OpenGLFunctions & gl);
+
+    void bind(
+        OpenGLFunctions & gl
+    ,   GLenum unit);
+    void release(
+        OpenGLFunctions & gl
+    ,   GLenum unit);
+
+    /** shadowMap, shadowMatrices, shadowView, shadowSplits, and
+        shadowCascades for receivers with positions in model space
+    */
+    void setUniforms(
+        QOpenGLShaderProgram & program
+    ,   int unit
+    ,   const QMatrix4x4 & model) const;
+
+protected:
+    /** (re)creates the texture array for the current cascades and resolution
+    */
+    void allocate();
+
+protected:
+    OpenGLFunctions & m_gl;
+
+    int m_cascades;
+    int m_resolution;
+    float m_distance;
+    float m_splitWeight;
+
+    GLuint m_fbo;
+    GLuint m_depths;
+    int m_allocatedCascades;
+    int m_allocatedResolution;
+
+    QMatrix4x4 m_view;                          ///< of the camera
+    QMatrix4x4 m_viewProjections[MaxCascades];  ///< of the light
+    QMatrix4x4 m_casterViewProjection;
+    float m_splits[MaxCascades];                ///< far distance per cascade
+
+    GLint m_pushFramebuffer;
+    GLint m_pushViewport[4];
+};
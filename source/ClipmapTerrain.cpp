@@ -0,0 +1,307 @@
+
+#include <cassert>
+#include <cmath>
+
+#include <QOpenGLShaderProgram>
+#include <QVector3D>
+
+#include "Heightfield.h"
+#include "Terrain.h"
+
+#include "ClipmapTerrain.h"
+
+
+ClipmapTerrain::ClipmapTerrain(
+    OpenGLFunctions & gl
+,   const int levels
+,   const int size)
+: m_gl(gl)
+, m_levelCount(levels)
+, m_size(size)
+, m_quads(size - 4)
+, m_source(nullptr)
+, m_texture(0)
+, m_vertices(QOpenGLBuffer::VertexBuffer)
+, m_indices(QOpenGLBuffer::IndexBuffer)
+, m_uploaded(0)
+{
+    // the hole (half the grid) has to be centered at a multiple of 1/4
+    assert(levels > 0 && size >= 8 && 0 == m_quads % 4);
+
+    Level invalid;
+    invalid.x = 0;
+    invalid.y = 0;
+    invalid.valid = false;
+    m_levels.resize(levels, invalid);
+
+    // vertices are grid positions, scaled and offset per level in the shader
+
+    std::vector<QVector3D> vertices;
+    for (int z = 0; z <= m_quads; ++z)
+        for (int x = 0; x <= m_quads; ++x)
+            vertices.push_back(QVector3D(static_cast<float>(x), 0.f, static_cast<float>(z)));
+
+    std::vector<GLuint> indices;
+    std::vector<GLuint> ring;
+
+    for (int i = 0; i < 5; ++i)
+    {
+        if (0 == i)
+            Terrain::ring(m_quads, 0, 0, 0, ring);
+        else
+            Terrain::ring(m_quads, m_quads / 4 + (i - 1) % 2, m_quads / 4 + (i - 1) / 2, m_quads / 2, ring);
+
+        m_ringOffsets[i] = static_cast<int>(indices.size());
+        m_ringCounts[i] = static_cast<int>(ring.size());
+
+        indices.insert(indices.end(), ring.begin(), ring.end());
+    }
+
+    m_vao.create();
+    m_vao.bind();
+
+    m_vertices.create();
+    m_vertices.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    m_vertices.bind();
+    m_vertices.allocate(vertices.data(), static_cast<int>(vertices.size() * sizeof(QVector3D)));
+
+    gl.glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(QVector3D), nullptr);
+    gl.glEnableVertexAttribArray(0);
+
+    m_indices.create();
+    m_indices.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    m_indices.bind();
+    m_indices.allocate(indices.data(), static_cast<int>(indices.size() * sizeof(GLuint)));
+
+    m_vao.release();
+
+    gl.glGenTextures(1, &m_texture);
+    gl.glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+
+    gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    gl.glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R32F, size, size, levels, 0, GL_RED, GL_FLOAT, nullptr);
+
+    gl.glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+ClipmapTerrain::~ClipmapTerrain()
+{
+    m_gl.glDeleteTextures(1, &m_texture);
+}
+
+void ClipmapTerrain::setSource(const Heightfield * heightfield)
+{
+    m_source = heightfield;
+
+    for (Level & level : m_levels)
+        level.valid = false;
+}
+
+void ClipmapTerrain::invalidate(const QRect & texels)
+{
+    if (!m_source || m_source->isNull())
+        return;
+
+    const int extent(m_quads + 1);
+
+    const int w(m_source->width());
+    const int h(m_source->height());
+
+    for (int l = 0; l < m_levelCount; ++l)
+    {
+        const Level & level(m_levels[l]);
+        if (!level.valid)
+            continue;
+
+        // range of grid positions sampling the texels (the source is wrapped)
+
+        int x0(extent);
+        int x1(-1);
+        for (int i = 0; i < extent; ++i)
+        {
+            const int x(((level.x + i) * (1 << l) % w + w) % w);
+            if (x >= texels.left() && x <= texels.right())
+            {
+                x0 = std::min(x0, i);
+                x1 = i;
+            }
+        }
+
+        int y0(extent);
+        int y1(-1);
+        for (int j = 0; j < extent; ++j)
+        {
+            const int y(((level.y + j) * (1 << l) % h + h) % h);
+            if (y >= texels.top() && y <= texels.bottom())
+            {
+                y0 = std::min(y0, j);
+                y1 = j;
+            }
+        }
+
+        if (x1 >= x0 && y1 >= y0)
+            upload(l, level.x + x0, level.y + y0, x1 - x0 + 1, y1 - y0 + 1);
+    }
+}
+
+int ClipmapTerrain::uploaded() const
+{
+    return m_uploaded;
+}
+
+void ClipmapTerrain::update(const QVector2D & eye)
+{
+    m_uploaded = 0;
+
+    if (!m_source || m_source->isNull())
+        return;
+
+    const int extent(m_quads + 1); // vertices per side
+
+    for (int l = 0; l < m_levelCount; ++l)
+    {
+        // eye in grid positions of this level, snapped to the coarser grid
+        // (even positions), so that it is nested properly
+
+        const float scale(static_cast<float>(1 << l));
+        const int cx(2 * static_cast<int>(std::floor(eye.x() * m_source->width() / scale * 0.5f)));
+        const int cy(2 * static_cast<int>(std::floor(eye.y() * m_source->height() / scale * 0.5f)));
+
+        const int x(cx - m_quads / 2);
+        const int y(cy - m_quads / 2);
+
+        Level & level(m_levels[l]);
+
+        const int dx(x - level.x);
+        const int dy(y - level.y);
+
+        if (!level.valid || std::abs(dx) >= extent || std::abs(dy) >= extent)
+            upload(l, x, y, extent, extent);
+        else
+        {
+            // newly exposed columns (all rows), then rows (remaining columns)
+
+            if (dx > 0)
+                upload(l, level.x + extent, y, dx, extent);
+            else if (dx < 0)
+                upload(l, x, y, -dx, extent);
+
+            const int x0(dx > 0 ? x : level.x);
+            const int width(extent - std::abs(dx));
+
+            if (dy > 0)
+                upload(l, x0, level.y + extent, width, dy);
+            else if (dy < 0)
+                upload(l, x0, y, width, -dy);
+        }
+
+        level.x = x;
+        level.y = y;
+        level.valid = true;
+    }
+}
+
+void ClipmapTerrain::upload(
+    const int level
+,   const int x
+,   const int y
+,   const int width
+,   const int height)
+{
+    if (width <= 0 || height <= 0)
+        return;
+
+    m_gl.glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+
+    const int step(1 << level);
+
+    // split at the toroidal wrap, into up to four pieces
+
+    int py = 0;
+    while (py < height)
+    {
+        const int ty(((y + py) % m_size + m_size) % m_size);
+        const int ph(std::min(height - py, m_size - ty));
+
+        int px = 0;
+        while (px < width)
+        {
+            const int tx(((x + px) % m_size + m_size) % m_size);
+            const int pw(std::min(width - px, m_size - tx));
+
+            m_buffer.resize(pw * ph);
+            for (int j = 0; j < ph; ++j)
+                for (int i = 0; i < pw; ++i)
+                    m_buffer[j * pw + i] = m_source->texel((x + px + i) * step, (y + py + j) * step);
+
+            m_gl.glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, tx, ty, level, pw, ph, 1
+                , GL_RED, GL_FLOAT, m_buffer.data());
+
+            m_uploaded += pw * ph;
+            px += pw;
+        }
+        py += ph;
+    }
+
+    m_gl.glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void ClipmapTerrain::draw(
+    OpenGLFunctions & gl
+,   QOpenGLShaderProgram & program
+,   const GLenum clipmapUnit)
+{
+    if (!m_source || m_source->isNull() || !m_levels[0].valid)
+        return;
+
+    gl.glActiveTexture(clipmapUnit);
+    gl.glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+
+    gl.glEnable(GL_DEPTH_TEST);
+    gl.glEnable(GL_CULL_FACE);
+
+    program.setUniformValue("clipmapSize", static_cast<float>(m_size));
+    program.setUniformValue("quads", static_cast<float>(m_quads));
+
+    m_vao.bind();
+
+    for (int l = 0; l < m_levelCount; ++l)
+    {
+        const Level & level(m_levels[l]);
+        const int step(1 << l);
+
+        int ring = 0;
+        if (l > 0)
+        {
+            // offset of the finer level's hole within this one, 0 or 1 cells
+            const Level & finer(m_levels[l - 1]);
+            const int hx(finer.x / 2 - level.x - m_quads / 4);
+            const int hy(finer.y / 2 - level.y - m_quads / 4);
+            assert(hx >= 0 && hx <= 1 && hy >= 0 && hy <= 1);
+
+            ring = 1 + hx + 2 * hy;
+        }
+
+        program.setUniformValue("level", l);
+        program.setUniformValue("coarsest", static_cast<GLint>(l == m_levelCount - 1));
+        program.setUniformValue("origin", QVector2D(static_cast<float>(level.x), static_cast<float>(level.y)));
+        program.setUniformValue("spacing", QVector2D(static_cast<float>(step) / m_source->width()
+            , static_cast<float>(step) / m_source->height()));
+        program.setUniformValue("texelCenter", QVector2D(0.5f / m_source->width(), 0.5f / m_source->height()));
+
+        gl.glDrawElements(GL_TRIANGLES, m_ringCounts[ring], GL_UNSIGNED_INT
+            , reinterpret_cast<void *>(m_ringOffsets[ring] * sizeof(GLuint)));
+    }
+
+    m_vao.release();
+
+    gl.glDisable(GL_DEPTH_TEST);
+    gl.glDisable(GL_CULL_FACE);
+
+    gl.glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    gl.glActiveTexture(GL_TEXTURE0);
+}
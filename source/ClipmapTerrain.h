@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vector>
+
+#include <QOpenGLVertexArrayObject>
+#include <QOpenGLBuffer>
+#include <QRect>
+#include <QVector2D>
+
+#include "OpenGLFunctions.h"
+
+class QOpenGLShaderProgram;
+
+class Heightfield;
+
+/** Geometry clipmap terrain, centered on the camera.
+
+    Each level is a grid of quads x quads cells, twice as wide as the finer
+    one (level 0 has the texel spacing of the source height field), and all
+    levels but the finest leave a hole for their finer neighbor (see
+    Terrain::ring). Since each level snaps to its coarser grid, the hole is
+    off by one cell in x and z in either direction, thus four ring variants
+    exist; the vertex data is shared by all levels.
+
+    Heights are point sampled from the source into a size x size texture per
+    level (of a 2D texture array) that is addressed toroidally: when a level
+    moves, only the newly exposed rows and columns are uploaded. The vertex
+    count is constant regardless of the terrain's size, and the upload
+    bandwidth is proportional to the camera's speed. Outer vertices on odd
+    positions are interpolated to match the coarser level (no cracks).
+*/
+class ClipmapTerrain
+{
+public:
+    ClipmapTerrain(
+        OpenGLFunctions & gl
+    ,   int levels = 5
+    ,   int size = 128);
+    virtual ~ClipmapTerrain();
+
+    /** heights are read from the given height field (wrapped), which has to
+        outlive the clipmap
+    */
+    void setSource(const Heightfield * heightfield);
+
+    /** Centers the levels at eye (given in texture space of the height field)
+        and uploads what became visible.
+    */
+    void update(const QVector2D & eye);
+
+    /** Re-uploads what the levels show of the given texels of the source,
+        e.g., after editing the height field.
+    */
+    void invalidate(const QRect & texels);
+
+    /** Draws the levels (finest first); uniforms of terrain_clipmap.vert are
+        set per level.
+    */
+    void draw(
+        OpenGLFunctions & gl
+    ,   QOpenGLShaderProgram & program
+    ,   GLenum clipmapUnit);
+
+    /** texels uploaded with the last update
+    */
+    int uploaded() const;
+
+protected:
+    struct Level
+    {
+        int x; ///< grid position of the level's first vertex
+        int y;
+        bool valid;
+    };
+
+    /** uploads the region (in grid positions of the level) toroidally
+    */
+    void upload(
+        int level
+    ,   int x
+    ,   int y
+    ,   int width
+    ,   int height);
+
+protected:
+    OpenGLFunctions & m_gl;
+
+    int m_levelCount;
+    int m_size;
+    int m_quads;
+
+    const Heightfield * m_source;
+
+    GLuint m_texture;
+    std::vector<Level> m_levels;
+    std::vector<float> m_buffer;
+
+    QOpenGLVertexArrayObject m_vao;
+    QOpenGLBuffer m_vertices;
+    QOpenGLBuffer m_indices;
+
+    int m_ringOffsets[5]; ///< full grid, then holes at (0, 0), (1, 0), (0, 1), (1, 1)
+    int m_ringCounts[5];
+
+    int m_uploaded;
+};
@@ -0,0 +1,183 @@
+
+#include <cassert>
+
+#include <QDebug>
+#include <QOpenGLContext>
+#include <QSurfaceFormat>
+
+#include "DrawBatcher.h"
+
+
+DrawBatcher::DrawBatcher(OpenGLFunctions & gl)
+: m_gl(gl)
+, m_vertices(QOpenGLBuffer::VertexBuffer)
+, m_indices(QOpenGLBuffer::IndexBuffer)
+, m_multiDrawElementsIndirect(nullptr)
+, m_indirect(0)
+{
+    m_vao.create();
+    m_vao.bind();
+
+    m_vertices.create();
+    m_vertices.setUsagePattern(QOpenGLBuffer::StaticDraw);
+
+    m_indices.create();
+    m_indices.setUsagePattern(QOpenGLBuffer::StaticDraw);
+
+    m_vertices.bind();
+    gl.glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(QVector3D), nullptr);
+    gl.glEnableVertexAttribArray(0);
+
+    m_indices.bind();
+
+    m_vao.release();
+
+    // glMultiDrawElementsIndirect is not part of the 3.2 core functions, so
+    // it is resolved manually if the context supports it.
+
+    QOpenGLContext * context(QOpenGLContext::currentContext());
+    assert(context);
+
+    const QSurfaceFormat format(context->format());
+    const bool core43 = format.majorVersion() > 4
+        || (format.majorVersion() == 4 && format.minorVersion() >= 3);
+
+    if (core43 || context->hasExtension("GL_ARB_multi_draw_indirect"))
+        m_multiDrawElementsIndirect = reinterpret_cast<MULTIDRAWELEMENTSINDIRECTPROC>(
+            context->getProcAddress("glMultiDrawElementsIndirect"));
+
+    if (m_multiDrawElementsIndirect)
+        gl.glGenBuffers(1, &m_indirect);
+    else
+        qDebug() << "Multi draw indirect is not supported, draw batches are submitted per command.";
+}
+
+DrawBatcher::~DrawBatcher()
+{
+    if (m_indirect)
+        m_gl.glDeleteBuffers(1, &m_indirect);
+}
+
+int DrawBatcher::add(
+    const std::vector<QVector3D> & vertices
+,   const std::vector<GLuint> & indices)
+{
+    Mesh mesh;
+    mesh.firstIndex = static_cast<GLuint>(m_indexArena.size());
+    mesh.count      = static_cast<GLuint>(indices.size());
+    mesh.baseVertex = static_cast<GLint>(m_vertexArena.size());
+
+    m_vertexArena.insert(m_vertexArena.end(), vertices.begin(), vertices.end());
+    m_indexArena.insert(m_indexArena.end(), indices.begin(), indices.end());
+
+    m_meshes.push_back(mesh);
+
+    return static_cast<int>(m_meshes.size()) - 1;
+}
+
+int DrawBatcher::meshes() const
+{
+    return static_cast<int>(m_meshes.size());
+}
+
+void DrawBatcher::upload()
+{
+    m_vao.bind();
+
+    m_vertices.bind();
+    m_vertices.allocate(m_vertexArena.data()
+        , static_cast<int>(m_vertexArena.size() * sizeof(QVector3D)));
+
+    m_indices.bind();
+    m_indices.allocate(m_indexArena.data()
+        , static_cast<int>(m_indexArena.size() * sizeof(GLuint)));
+
+    m_vao.release();
+}
+
+void DrawBatcher::clear(const int bucket)
+{
+    m_buckets[bucket].clear();
+}
+
+void DrawBatcher::clearAll()
+{
+    m_buckets.clear();
+}
+
+void DrawBatcher::record(
+    const int bucket
+,   const int mesh
+,   const GLuint instanceCount
+,   const GLuint baseInstance)
+{
+    assert(mesh >= 0 && mesh < meshes());
+
+    const Mesh & m(m_meshes[mesh]);
+
+    DrawElementsIndirectCommand command;
+    command.count         = m.count;
+    command.instanceCount = instanceCount;
+    command.firstIndex    = m.firstIndex;
+    command.baseVertex    = m.baseVertex;
+    command.baseInstance  = baseInstance;
+
+    m_buckets[bucket].push_back(command);
+}
+
+int DrawBatcher::recorded(const int bucket) const
+{
+    std::map<int, std::vector<DrawElementsIndirectCommand> >::const_iterator i(m_buckets.find(bucket));
+    return i == m_buckets.end() ? 0 : static_cast<int>(i->second.size());
+}
+
+bool DrawBatcher::multiDrawIndirectSupported() const
+{
+    return m_multiDrawElementsIndirect != nullptr;
+}
+
+void DrawBatcher::submit(
+    OpenGLFunctions & gl
+,   const int bucket
+,   const GLenum mode)
+{
+    const std::vector<DrawElementsIndirectCommand> & commands(m_buckets[bucket]);
+    if (commands.empty())
+        return;
+
+    m_vao.bind();
+    submit(gl, commands, mode);
+    m_vao.release();
+}
+
+void DrawBatcher::submit(
+    OpenGLFunctions & gl
+,   const std::vector<DrawElementsIndirectCommand> & commands
+,   const GLenum mode)
+{
+    if (commands.empty())
+        return;
+
+    if (m_multiDrawElementsIndirect)
+    {
+        // orphan the previous commands, the buffer is rewritten every submit
+        gl.glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirect);
+        gl.glBufferData(GL_DRAW_INDIRECT_BUFFER
+            , commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STREAM_DRAW);
+
+        m_multiDrawElementsIndirect(mode, GL_UNSIGNED_INT, nullptr
+            , static_cast<GLsizei>(commands.size()), 0);
+
+        gl.glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+    else
+    {
+        // Note: baseInstance cannot be honored without GL 4.2, which only
+        // matters for instanced attributes (gl_InstanceID starts at 0 anyway).
+
+        for (const DrawElementsIndirectCommand & command : commands)
+            gl.glDrawElementsInstancedBaseVertex(mode, command.count, GL_UNSIGNED_INT
+                , reinterpret_cast<const void *>(command.firstIndex * sizeof(GLuint))
+                , command.instanceCount, command.baseVertex);
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include <QVector3D>
+#include <QOpenGLVertexArrayObject>
+#include <QOpenGLBuffer>
+
+#include "OpenGLFunctions.h"
+
+/** Packs many meshes (e.g., terrain tiles and static geometry) into one shared
+    vertex and one shared index arena, so that they can be drawn with a single
+    vertex array binding. Geometry with other vertex layouts can be submitted
+    from its own vertex array as well (see Model).
+
+    Draws are recorded as DrawElementsIndirectCommands into buckets (one bucket
+    per material/program). Each bucket is submitted with a single
+    glMultiDrawElementsIndirect, if GL 4.3 or ARB_multi_draw_indirect is
+    available, or with a CPU loop of glDrawElementsInstancedBaseVertex
+    otherwise. Indices are 32bit, the primitive restart index is applied
+    before the base vertex, so restart strips can be packed as they are.
+*/
+class DrawBatcher
+{
+public:
+    struct DrawElementsIndirectCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint  baseVertex;
+        GLuint baseInstance;
+    };
+
+public:
+    DrawBatcher(OpenGLFunctions & gl);
+    virtual ~DrawBatcher();
+
+    /** Appends a mesh to the arenas and returns its handle. Indices are
+        relative to the given vertices. Requires upload() before drawing.
+    */
+    int add(
+        const std::vector<QVector3D> & vertices
+    ,   const std::vector<GLuint> & indices);
+
+    int meshes() const;
+
+    /** (Re)allocates the arenas on the GPU with all meshes added so far.
+    */
+    void upload();
+
+    void clear(int bucket);
+    void clearAll();
+
+    void record(
+        int bucket
+    ,   int mesh
+    ,   GLuint instanceCount = 1
+    ,   GLuint baseInstance = 0);
+
+    /** number of commands recorded for the given bucket
+    */
+    int recorded(int bucket) const;
+
+    /** Draws all commands of the bucket. The caller is responsible for the
+        program and render state (depth test, primitive restart, etc.).
+    */
+    void submit(
+        OpenGLFunctions & gl
+    ,   int bucket
+    ,   GLenum mode = GL_TRIANGLE_STRIP);
+
+    /** Draws the given commands with the currently bound vertex array, for
+        geometry that lives in buffers of its own (e.g., the parts of a Model).
+        Indices are expected to be 32bit.
+    */
+    void submit(
+        OpenGLFunctions & gl
+    ,   const std::vector<DrawElementsIndirectCommand> & commands
+    ,   GLenum mode = GL_TRIANGLES);
+
+    bool multiDrawIndirectSupported() const;
+
+protected:
+    typedef void (APIENTRY * MULTIDRAWELEMENTSINDIRECTPROC) (
+        GLenum mode, GLenum type, const void * indirect, GLsizei drawcount, GLsizei stride);
+
+    struct Mesh
+    {
+        GLuint firstIndex;
+        GLuint count;
+        GLint  baseVertex;
+    };
+
+protected:
+    OpenGLFunctions & m_gl;
+
+    QOpenGLVertexArrayObject m_vao;
+    QOpenGLBuffer m_vertices;
+    QOpenGLBuffer m_indices;
+
+    std::vector<QVector3D> m_vertexArena;
+    std::vector<GLuint> m_indexArena;
+    std::vector<Mesh> m_meshes;
+
+    std::map<int, std::vector<DrawElementsIndirectCommand> > m_buckets;
+
+    MULTIDRAWELEMENTSINDIRECTPROC m_multiDrawElementsIndirect;
+    GLuint m_indirect;
+};
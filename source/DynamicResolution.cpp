@@ -0,0 +1,259 @@
+
+#include <cassert>
+#include <cmath>
+
+#include <QDebug>
+#include <QOpenGLTimerQuery>
+
+#include "DynamicResolution.h"
+
+
+DynamicResolution::DynamicResolution(OpenGLFunctions & gl)
+: m_gl(gl)
+, m_enabled(true)
+, m_targetFrameTime(14.f)
+, m_frameTime(0.f)
+, m_minScale(0.5f)
+, m_maxScale(1.f)
+, m_scale(1.f)
+, m_fbo(0)
+, m_color(0)
+, m_depth(0)
+, m_query(0)
+, m_timerQueriesSupported(true)
+{
+    for (int i = 0; i < TimerQueries; ++i)
+    {
+        m_queries[i] = new QOpenGLTimerQuery();
+        m_queried[i] = false;
+
+        m_timerQueriesSupported &= m_queries[i]->create();
+    }
+
+    if (!m_timerQueriesSupported)
+        qDebug() << "Timer queries are not supported, the resolution is not scaled dynamically.";
+}
+
+DynamicResolution::~DynamicResolution()
+{
+    deleteTarget();
+
+    for (int i = 0; i < TimerQueries; ++i)
+    {
+        m_queries[i]->destroy();
+        delete m_queries[i];
+    }
+}
+
+void DynamicResolution::setEnabled(const bool enabled)
+{
+    m_enabled = enabled;
+
+    if (m_enabled)
+        createTarget();
+    else
+        deleteTarget();
+
+    m_frameTime = 0.f;
+    m_scale = m_maxScale;
+}
+
+bool DynamicResolution::enabled() const
+{
+    return m_enabled;
+}
+
+void DynamicResolution::setTargetFrameTime(const float milliseconds)
+{
+    m_targetFrameTime = milliseconds;
+}
+
+float DynamicResolution::targetFrameTime() const
+{
+    return m_targetFrameTime;
+}
+
+void DynamicResolution::setScaleRange(
+    const float minScale
+,   const float maxScale)
+{
+    assert(minScale > 0.f && minScale <= maxScale && maxScale <= 1.f);
+
+    m_minScale = minScale;
+    m_maxScale = maxScale;
+    m_scale = qBound(m_minScale, m_scale, m_maxScale);
+}
+
+float DynamicResolution::scale() const
+{
+    return m_scale;
+}
+
+float DynamicResolution::frameTime() const
+{
+    return m_frameTime;
+}
+
+void DynamicResolution::resize(const QSize & window)
+{
+    if (window == m_window)
+        return;
+
+    m_window = window;
+
+    if (m_enabled)
+        createTarget();
+}
+
+QSize DynamicResolution::size() const
+{
+    return QSize(
+        qMax(1, static_cast<int>(m_window.width()  * m_scale + 0.5f))
+    ,   qMax(1, static_cast<int>(m_window.height() * m_scale + 0.5f)));
+}
+
+void DynamicResolution::createTarget()
+{
+    if (m_window.isEmpty())
+        return;
+
+    if (!m_fbo)
+    {
+        m_gl.glGenFramebuffers(1, &m_fbo);
+        m_gl.glGenRenderbuffers(1, &m_color);
+        m_gl.glGenRenderbuffers(1, &m_depth);
+    }
+
+    m_gl.glBindRenderbuffer(GL_RENDERBUFFER, m_color);
+    m_gl.glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_window.width(), m_window.height());
+
+    m_gl.glBindRenderbuffer(GL_RENDERBUFFER, m_depth);
+    m_gl.glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_window.width(), m_window.height());
+
+    m_gl.glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    GLint framebuffer(0);
+    m_gl.glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+
+    m_gl.glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    m_gl.glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color);
+    m_gl.glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depth);
+
+    if (GL_FRAMEBUFFER_COMPLETE != m_gl.glCheckFramebufferStatus(GL_FRAMEBUFFER))
+    {
+        qWarning() << "Offscreen target for dynamic resolution is incomplete, rendering at window resolution.";
+        m_gl.glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+        deleteTarget();
+        m_enabled = false;
+        return;
+    }
+
+    m_gl.glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void DynamicResolution::deleteTarget()
+{
+    if (!m_fbo)
+        return;
+
+    m_gl.glDeleteFramebuffers(1, &m_fbo);
+    m_gl.glDeleteRenderbuffers(1, &m_color);
+    m_gl.glDeleteRenderbuffers(1, &m_depth);
+
+    m_fbo = 0;
+    m_color = 0;
+    m_depth = 0;
+}
+
+void DynamicResolution::adapt(const float milliseconds)
+{
+    m_frameTime = m_frameTime > 0.f ? m_frameTime * 0.9f + milliseconds * 0.1f : milliseconds;
+
+    const float ratio(m_targetFrameTime / m_frameTime);
+
+    // dead zone around the target
+    if (ratio > 0.95f && ratio < 1.05f)
+        return;
+
+    // pixel count is quadratic in scale, limit change to 2% per frame
+    const float scale(m_scale * std::sqrt(ratio));
+    m_scale = qBound(m_minScale, qBound(m_scale * 0.98f, scale, m_scale * 1.02f), m_maxScale);
+}
+
+void DynamicResolution::begin()
+{
+    if (!m_enabled || !m_fbo)
+        return;
+
+    if (m_timerQueriesSupported)
+    {
+        // pick up all finished measurements of the previous frames
+
+        for (int i = 0; i < TimerQueries; ++i)
+        {
+            const int q((m_query + i) % TimerQueries);
+            if (!m_queried[q] || !m_queries[q]->isResultAvailable())
+                continue;
+
+            adapt(static_cast<float>(m_queries[q]->waitForResult()) * 1e-6f);
+            m_queried[q] = false;
+        }
+    }
+
+    m_gl.glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+
+    const QSize rendered(size());
+    m_gl.glViewport(0, 0, rendered.width(), rendered.height());
+
+    // the measurement is skipped if the query is still pending
+    if (m_timerQueriesSupported && !m_queried[m_query])
+        m_queries[m_query]->begin();
+}
+
+void DynamicResolution::end(const GLuint framebuffer)
+{
+    if (!m_enabled || !m_fbo)
+        return;
+
+    if (m_timerQueriesSupported && !m_queried[m_query])
+    {
+        m_queries[m_query]->end();
+        m_queried[m_query] = true;
+    }
+    m_query = (m_query + 1) % TimerQueries;
+
+    const QSize rendered(size());
+
+    m_gl.glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+    m_gl.glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+
+    m_gl.glBlitFramebuffer(0, 0, rendered.width(), rendered.height()
+        , 0, 0, m_window.width(), m_window.height(), GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+    m_gl.glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    m_gl.glViewport(0, 0, m_window.width(), m_window.height());
+}
+
+float DynamicResolution::depthAt(
+    const int x
+,   const int y)
+{
+    if (!m_fbo || x < 0 || y < 0 || x >= m_window.width() || y >= m_window.height())
+        return 1.f;
+
+    const QSize rendered(size());
+
+    const GLint sx(qMin(rendered.width()  - 1, static_cast<int>(x * m_scale)));
+    const GLint sy(qMin(rendered.height() - 1, static_cast<int>((m_window.height() - y - 1) * m_scale)));
+
+    GLint framebuffer(0);
+    m_gl.glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &framebuffer);
+
+    GLfloat z(1.f);
+    m_gl.glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+    m_gl.glReadPixels(sx, sy, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, reinterpret_cast<void*>(&z));
+    m_gl.glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+
+    return z;
+}
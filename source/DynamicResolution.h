@@ -0,0 +1,102 @@
+#pragma once
+
+#include <QSize>
+
+#include "OpenGLFunctions.h"
+
+class QOpenGLTimerQuery;
+
+/** Renders into an offscreen color/depth target whose resolution scales to
+    meet a target gpu frame time, and upscales the result to the window.
+
+    The target is allocated at window size once; a frame is rendered into its
+    lower left sub-rectangle of size() by setting the viewport accordingly,
+    so changing the scale never reallocates. The gpu time of each frame is
+    measured with timer queries (results are picked up frames later, to
+    avoid stalls) and fed into a simple controller: since the fragment work
+    scales with the pixel count, the scale is adjusted by the square root of
+    target over (smoothed) measured time, limited per frame and dead-zoned
+    to avoid oscillation.
+
+    Without timer query support (GL 3.3 or ARB_timer_query) the scale stays
+    at the maximum scale.
+*/
+class DynamicResolution
+{
+public:
+    DynamicResolution(OpenGLFunctions & gl);
+    virtual ~DynamicResolution();
+
+    void setEnabled(bool enabled);
+    bool enabled() const;
+
+    /** in milliseconds, defaults to 14ms (leaving some headroom at 60Hz)
+    */
+    void setTargetFrameTime(float milliseconds);
+    float targetFrameTime() const;
+
+    void setScaleRange(
+        float minScale
+    ,   float maxScale);
+
+    float scale() const;
+
+    /** smoothed gpu time of the last frames in milliseconds (0 if unknown)
+    */
+    float frameTime() const;
+
+    void resize(const QSize & window);
+
+    /** size of the rendered sub-rectangle (window size times scale)
+    */
+    QSize size() const;
+
+    /** Binds the offscreen target, sets the viewport to size(), and starts
+        the gpu time measurement.
+    */
+    void begin();
+
+    /** Stops the measurement and upscales the rendered sub-rectangle to the
+        given framebuffer (usually the context's default framebuffer).
+    */
+    void end(GLuint framebuffer);
+
+    /** Maps window coordinates (origin top left, as with mouse events) to the
+        offscreen target and reads the depth there.
+    */
+    float depthAt(
+        int x
+    ,   int y);
+
+protected:
+    void adapt(float milliseconds);
+
+    void createTarget();
+    void deleteTarget();
+
+protected:
+    static const int TimerQueries = 3;
+
+protected:
+    OpenGLFunctions & m_gl;
+
+    bool m_enabled;
+
+    float m_targetFrameTime;
+    float m_frameTime;
+
+    float m_minScale;
+    float m_maxScale;
+    float m_scale;
+
+    QSize m_window;
+
+    GLuint m_fbo;
+    GLuint m_color;
+    GLuint m_depth;
+
+    QOpenGLTimerQuery * m_queries[TimerQueries];
+    bool m_queried[TimerQueries];
+    int m_query;
+    bool m_timerQueriesSupported;
+};
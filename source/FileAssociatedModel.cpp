@@ -0,0 +1,121 @@
+#include <QDebug>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QQueue>
+#include <QStringList>
+
+#include "FileAssociatedAsset.h"
+#include "Model.h"
+
+#include "FileAssociatedModel.h"
+
+QMap<QString, Model *> FileAssociatedModel::s_modelsByFilePath;
+QQueue<QString> FileAssociatedModel::s_queue;
+
+FileAssociatedModel * FileAssociatedModel::s_instance = nullptr;
+
+FileAssociatedModel::FileAssociatedModel()
+{
+    // shares the watcher with the shaders, see FileAssociatedShader::process
+    connect(FileAssociatedAsset::fileSystemWatcher(), &QFileSystemWatcher::fileChanged
+        , this, &FileAssociatedModel::fileChanged);
+
+    m_loader.start(QThread::LowPriority);
+}
+
+FileAssociatedModel::~FileAssociatedModel()
+{
+    m_loader.stop();
+    s_queue.clear();
+}
+
+FileAssociatedModel * FileAssociatedModel::instance()
+{
+    if (!s_instance)
+        s_instance = new FileAssociatedModel();
+
+    return s_instance;
+}
+
+Model * FileAssociatedModel::getOrCreate(
+    const QString & fileName
+,   OpenGLFunctions & gl)
+{
+    QFileInfo fi(fileName);
+    if (!fi.exists())
+    {
+        qWarning() << fileName << " does not exist: model has no associated file.";
+        return nullptr;
+    }
+    QString filePath(fi.absoluteFilePath());
+
+    if (s_modelsByFilePath.contains(filePath))
+        return s_modelsByFilePath[filePath];
+
+    Model * model = new Model(gl);
+    s_modelsByFilePath[filePath] = model;
+
+    FileAssociatedAsset::fileSystemWatcher()->addPath(filePath);
+    instance()->m_loader.request(filePath);
+
+    return model;
+}
+
+void FileAssociatedModel::fileChanged(const QString & filePath)
+{
+    if (s_modelsByFilePath.contains(filePath) && !s_queue.contains(filePath))
+        s_queue.append(filePath);
+}
+
+void FileAssociatedModel::process(
+    OpenGLFunctions & gl
+,   const int maxBytes)
+{
+    if (!s_instance)
+        return;
+
+    // Editors often save by replacing the file, which drops it from the
+    // watcher, so it is watched (and reloaded) again once it exists.
+
+    QFileSystemWatcher * watcher(FileAssociatedAsset::fileSystemWatcher());
+    const QStringList watched(watcher->files());
+
+    foreach (const QString & filePath, s_modelsByFilePath.keys())
+        if (!watched.contains(filePath) && QFileInfo(filePath).exists())
+        {
+            watcher->addPath(filePath);
+            if (!s_queue.contains(filePath))
+                s_queue.append(filePath);
+        }
+
+    while (!s_queue.isEmpty())
+        s_instance->m_loader.request(s_queue.takeFirst());
+
+    // failed reloads keep the previous geometry
+    foreach (const ModelLoader::Geometry & geometry, s_instance->m_loader.take())
+        if (!geometry.isNull() && s_modelsByFilePath.contains(geometry.filePath))
+        {
+            qDebug() << "Uploading" << geometry.filePath;
+            s_modelsByFilePath[geometry.filePath]->setGeometry(geometry);
+        }
+
+    int budget(maxBytes);
+    foreach (Model * model, s_modelsByFilePath.values())
+    {
+        if (budget <= 0)
+            break;
+        budget -= model->upload(gl, budget);
+    }
+}
+
+void FileAssociatedModel::clear()
+{
+    delete s_instance;
+    s_instance = nullptr;
+
+    foreach (const QString & filePath, s_modelsByFilePath.keys())
+        FileAssociatedAsset::fileSystemWatcher()->removePath(filePath);
+
+    qDeleteAll(s_modelsByFilePath);
+    s_modelsByFilePath.clear();
+}
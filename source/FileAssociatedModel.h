@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QObject>
+#include <QMap>
+#include <QQueue>
+
+#include "ModelLoader.h"
+#include "OpenGLFunctions.h"
+
+class Model;
+
+/** Models (e.g., obj, 3ds, ply, collada, ...) imported by assimp on a
+    loader thread (see ModelLoader). The render thread only uploads, with a
+    bounded number of bytes per frame, thus loading never stalls a frame.
+    Changed files are reloaded the same way, watched by the shared
+    FileAssociatedAsset::fileSystemWatcher.
+
+    ToDo: does not work for multiple contexts yet...
+*/
+class FileAssociatedModel : public QObject
+{
+public:
+    /** Returns the model of the file, which remains null (see Model::isNull)
+        until loading and uploading completed, or nullptr if the file does
+        not exist.
+    */
+    static Model * getOrCreate(
+        const QString & fileName
+    ,   OpenGLFunctions & gl);
+
+    /** Requests reloads of changed files, and uploads loaded geometry of at
+        most maxBytes (in total) per call.
+        Note: This requires context to be made current!
+    */
+    static void process(
+        OpenGLFunctions & gl
+    ,   int maxBytes = 4 * 1024 * 1024);
+
+    /** stops loading and deletes all models (context has to be current)
+    */
+    static void clear();
+
+protected:
+    static FileAssociatedModel * instance();
+
+protected slots:
+    void fileChanged(const QString & path);
+
+private:
+    FileAssociatedModel();
+    virtual ~FileAssociatedModel();
+
+protected:
+    static QMap<QString, Model *> s_modelsByFilePath;
+    static QQueue<QString> s_queue;
+
+    ModelLoader m_loader;
+
+    static FileAssociatedModel * s_instance;
+};
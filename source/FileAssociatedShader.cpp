@@ -126,6 +126,10 @@ QList<QOpenGLShaderProgram *> FileAssociatedShader::process()
         QString filePath = s_queue.first();
         s_queue.removeFirst();
 
+        // the watcher is shared, e.g., with FileAssociatedModel
+        if (!s_shaderByFilePath.contains(filePath))
+            continue;
+
         QOpenGLShader * shader(s_shaderByFilePath[filePath]);
         assert(shader != nullptr);
 
@@ -1,5 +1,10 @@
 
 #include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include <QtEndian>
+#include <QFile>
 
 #include <QFileSystemWatcher>
 #include <QFileInfo>
@@ -12,8 +17,15 @@
 
 QMap<QString, QImage> FileAssociatedTexture::s_imagesByFilePath;
 QMap<QString, GLuint> FileAssociatedTexture::s_texturesByFilePath;
+
+QMap<QString, FileAssociatedTexture::Heights> FileAssociatedTexture::s_heightsByFilePath;
+QMap<QString, GLenum> FileAssociatedTexture::s_heightFormatsByFilePath;
+QMap<QString, QRegion> FileAssociatedTexture::s_dirtyByFilePath;
+QMap<QString, QRegion> FileAssociatedTexture::s_reloadedByFilePath;
 QMultiMap<QString, FileAssociatedTexture::CubeFaceOfTexture>
     FileAssociatedTexture::s_cubefacesByFilePath;
+QMultiMap<QString, FileAssociatedTexture::LayersOfTexture>
+    FileAssociatedTexture::s_layersByFilePath;
 
 QQueue<QString> FileAssociatedTexture::s_queue;
 
@@ -73,6 +85,52 @@ GLuint FileAssociatedTexture::getOrCreate2D(
 	return texture;
 }
 
+GLuint FileAssociatedTexture::getOrCreateHeight2D(
+	const QString & fileName
+,	OpenGLFunctions & gl
+,	const GLenum internalFormat
+,	const GLenum wrap_s
+,	const GLenum wrap_t
+,	const GLenum mag_filter
+,	const GLenum min_filter)
+{
+	QFileInfo fi(fileName);
+	if (!fi.exists())
+	{
+		qWarning() << fileName << " does not exist: texture has no associated file.";
+		return -1;
+	}
+	QString filePath(fi.absoluteFilePath());
+
+	if (s_texturesByFilePath.contains(filePath))
+		return s_texturesByFilePath[filePath];
+
+	const Heights heights(loadHeights(filePath));
+	if (heights.isNull())
+		return -1;
+
+	s_heightsByFilePath[filePath] = heights;
+	s_heightFormatsByFilePath[filePath] = GL_NONE != internalFormat ? internalFormat
+		: ("r32" == fi.suffix().toLower() ? GL_R32F : GL_R16);
+
+	instance()->m_fileSystemWatcher->addPath(filePath);
+
+	GLuint texture = -1;
+	gl.glGenTextures(1, &texture);
+	gl.glBindTexture(GL_TEXTURE_2D, texture);
+
+	gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_s);
+	gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_t);
+
+	gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter);
+	gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
+
+	loadHeightTexture2D(texture, s_heightFormatsByFilePath[filePath], heights, gl);
+	s_texturesByFilePath[filePath] = texture;
+
+	return texture;
+}
+
 GLuint FileAssociatedTexture::getOrCreateCube(
 	const QString & fileNames
 ,   OpenGLFunctions & gl
@@ -136,12 +194,264 @@ GLuint FileAssociatedTexture::getOrCreateCube(
 	return texture;
 }
 
+GLuint FileAssociatedTexture::getOrCreate2DArray(
+	const QString & fileNames
+,	OpenGLFunctions & gl
+,	const int columns
+,	const int rows
+,	const GLenum wrap_s
+,	const GLenum wrap_t
+,	const GLenum mag_filter
+,	const GLenum min_filter)
+{
+	const QString key(QString("%1[%2x%3]").arg(fileNames).arg(columns).arg(rows));
+	if (s_texturesByFilePath.contains(key))
+		return s_texturesByFilePath[key];
+
+	QStringList absolutes;
+	if (fileNames.contains("?"))
+	{
+		for (int i = 0; ; ++i)
+		{
+			QString file(fileNames); file.replace("?", QString::number(i));
+			QFileInfo fi(file);
+			if (!fi.exists())
+				break;
+			absolutes << fi.absoluteFilePath();
+		}
+	}
+	else if (QFileInfo(fileNames).exists())
+		absolutes << QFileInfo(fileNames).absoluteFilePath();
+
+	if (absolutes.isEmpty() || columns < 1 || rows < 1)
+	{
+		qWarning() << fileNames << " does not exist: texture has no associated file.";
+		return -1;
+	}
+
+	QList<QImage> images;
+	foreach(const QString & filePath, absolutes)
+	{
+		images << getOrCreateImage(filePath);
+		if (images.last().isNull())
+			return -1;
+	}
+
+	// all tiles share the size of the first file's tiles
+
+	const QSize tileSize(images.first().width() / columns, images.first().height() / rows);
+	foreach(const QImage & image, images)
+	{
+		if (image.size() != images.first().size() || tileSize.isEmpty())
+		{
+			qWarning() << fileNames << " cannot be split into equally sized layers.";
+			return -1;
+		}
+	}
+
+	const int depth(images.size() * columns * rows);
+
+	GLuint texture = -1;
+	gl.glGenTextures(1, &texture);
+	gl.glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+
+	gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, wrap_s);
+	gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, wrap_t);
+
+	gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, mag_filter);
+	gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, min_filter);
+
+	gl.glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, tileSize.width(), tileSize.height(), depth
+		, 0, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+
+	for (int i = 0; i < absolutes.size(); ++i)
+	{
+		instance()->m_fileSystemWatcher->addPath(absolutes[i]);
+
+		LayersOfTexture lot;
+		lot.texture = texture;
+		lot.layer = i * columns * rows;
+		lot.columns = columns;
+		lot.rows = rows;
+		lot.tileSize = tileSize;
+		s_layersByFilePath.insert(absolutes[i], lot);
+
+		loadTextureLayers(lot, images[i], gl);
+	}
+	s_texturesByFilePath[key] = texture;
+
+	return texture;
+}
+
 void FileAssociatedTexture::fileChanged(const QString & filePath)
 {
+	if (s_heightsByFilePath.contains(filePath))
+	{
+		const Heights heights(loadHeights(filePath));
+		if (heights.isNull())
+			return;
+
+		const Heights & previous(s_heightsByFilePath[filePath]);
+		if (heights.size != previous.size)
+		{
+			s_dirtyByFilePath.remove(filePath);
+			s_reloadedByFilePath[filePath] = QRect(QPoint(0, 0), heights.size);
+		}
+		else
+		{
+			// only the changed span of each row is uploaded
+
+			QRegion changed;
+			const int w(heights.size.width());
+			for (int y = 0; y < heights.size.height(); ++y)
+			{
+				const float * row(heights.values.constData() + y * w);
+				const float * old(previous.values.constData() + y * w);
+
+				int x0(0);
+				int x1(w - 1);
+				while (x0 < w && row[x0] == old[x0])
+					++x0;
+				while (x1 > x0 && row[x1] == old[x1])
+					--x1;
+
+				if (x0 < w)
+					changed += QRect(x0, y, x1 - x0 + 1, 1);
+			}
+
+			if (changed.isEmpty())
+				return;
+
+			if (s_dirtyByFilePath.contains(filePath) || !s_queue.contains(filePath))
+				s_dirtyByFilePath[filePath] += changed;
+
+			s_reloadedByFilePath[filePath] += changed;
+		}
+		s_heightsByFilePath[filePath] = heights;
+
+		if (!s_queue.contains(filePath))
+			s_queue.append(filePath);
+		return;
+	}
+
 	s_imagesByFilePath[filePath] = getOrCreateImage(filePath, true);
+
 	s_queue.append(filePath);
 }
 
+bool FileAssociatedTexture::setHeights(
+	const QString & fileName
+,	const QRect & region
+,	const float * values)
+{
+	const QString filePath(QFileInfo(fileName).absoluteFilePath());
+	if (!s_heightsByFilePath.contains(filePath))
+		return false;
+
+	Heights & heights(s_heightsByFilePath[filePath]);
+	if (!QRect(QPoint(0, 0), heights.size).contains(region))
+	{
+		qWarning() << "Height field edit" << region << "exceeds" << filePath;
+		return false;
+	}
+
+	float * target(heights.values.data());
+	for (int y = 0; y < region.height(); ++y)
+		memcpy(target + (region.y() + y) * heights.size.width() + region.x()
+			, values + y * region.width(), region.width() * sizeof(float));
+
+	// a pending full reload covers the edit as well
+	if (s_dirtyByFilePath.contains(filePath) || !s_queue.contains(filePath))
+		s_dirtyByFilePath[filePath] += region;
+
+	if (!s_queue.contains(filePath))
+		s_queue.append(filePath);
+
+	return true;
+}
+
+QRegion FileAssociatedTexture::takeReloadedHeights(const QString & fileName)
+{
+	return s_reloadedByFilePath.take(QFileInfo(fileName).absoluteFilePath());
+}
+
+FileAssociatedTexture::Heights FileAssociatedTexture::loadHeights(const QString & filePath)
+{
+	Heights heights;
+
+	const QString suffix(QFileInfo(filePath).suffix().toLower());
+
+	if ("r16" == suffix || "r32" == suffix)
+	{
+		// raw files have no header, thus they are expected to be square
+
+		QFile file(filePath);
+		if (!file.open(QIODevice::ReadOnly))
+		{
+			qDebug() << "Loading height field from" << filePath << "failed.";
+			return heights;
+		}
+		const QByteArray data(file.readAll());
+
+		const int bytes("r16" == suffix ? 2 : 4);
+		const int size(static_cast<int>(std::sqrt(static_cast<double>(data.size() / bytes)) + 0.5));
+
+		if (size < 1 || size * size * bytes != data.size())
+		{
+			qDebug() << "Raw height field" << filePath << "is not square.";
+			return heights;
+		}
+
+		heights.size = QSize(size, size);
+		heights.values.resize(size * size);
+
+		const uchar * raw(reinterpret_cast<const uchar *>(data.constData()));
+		for (int i = 0; i < size * size; ++i)
+		{
+			if (2 == bytes)
+				heights.values[i] = qFromLittleEndian<quint16>(raw + i * 2) / 65535.f;
+			else
+			{
+				const quint32 bits(qFromLittleEndian<quint32>(raw + i * 4));
+				memcpy(&heights.values[i], &bits, sizeof(float));
+			}
+		}
+		return heights;
+	}
+
+	const QImage image(filePath);
+	if (image.isNull())
+	{
+		qDebug() << "Loading image from" << filePath << "failed.";
+		return heights;
+	}
+
+	heights.size = image.size();
+	heights.values.resize(image.width() * image.height());
+
+	float * values(heights.values.data());
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+	// keeps the precision of 16bit images
+	const QImage gray(image.convertToFormat(QImage::Format_Grayscale16));
+	for (int y = 0; y < gray.height(); ++y)
+	{
+		const quint16 * line(reinterpret_cast<const quint16 *>(gray.constScanLine(y)));
+		for (int x = 0; x < gray.width(); ++x)
+			*values++ = line[x] / 65535.f;
+	}
+#else
+	const QImage argb(image.convertToFormat(QImage::Format_ARGB32));
+	for (int y = 0; y < argb.height(); ++y)
+	{
+		const QRgb * line(reinterpret_cast<const QRgb *>(argb.constScanLine(y)));
+		for (int x = 0; x < argb.width(); ++x)
+			*values++ = qRed(line[x]) / 255.f;
+	}
+#endif
+	return heights;
+}
+
 QImage FileAssociatedTexture::getOrCreateImage(
     const QString & filePath
 ,   const bool forceReload)
@@ -167,7 +477,20 @@ void FileAssociatedTexture::process(OpenGLFunctions & gl)
 		QString filePath = s_queue.first();
 		s_queue.removeFirst();
 
-		loadTexture2D(s_texturesByFilePath[filePath], s_imagesByFilePath[filePath], gl);
+		foreach(const LayersOfTexture & lot, s_layersByFilePath.values(filePath))
+			loadTextureLayers(lot, s_imagesByFilePath[filePath], gl);
+
+		if (!s_texturesByFilePath.contains(filePath))
+			continue;
+
+		if (s_heightsByFilePath.contains(filePath) && s_dirtyByFilePath.contains(filePath))
+			loadHeightSubTexture2D(s_texturesByFilePath[filePath], s_dirtyByFilePath.take(filePath)
+				, s_heightsByFilePath[filePath], gl);
+		else if (s_heightsByFilePath.contains(filePath))
+			loadHeightTexture2D(s_texturesByFilePath[filePath], s_heightFormatsByFilePath[filePath]
+				, s_heightsByFilePath[filePath], gl);
+		else
+			loadTexture2D(s_texturesByFilePath[filePath], s_imagesByFilePath[filePath], gl);
 	}
 }
 
@@ -207,6 +530,78 @@ GLuint FileAssociatedTexture::loadTexture2D(
 	return texture;
 }
 
+GLuint FileAssociatedTexture::loadHeightTexture2D(
+	GLuint texture
+,	const GLenum internalFormat
+,	const Heights & heights
+,	OpenGLFunctions & gl)
+{
+	gl.glBindTexture(GL_TEXTURE_2D, texture);
+	gl.glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, heights.size.width(), heights.size.height()
+		, 0, GL_RED, GL_FLOAT, heights.values.constData());
+
+	return texture;
+}
+
+void FileAssociatedTexture::loadTextureLayers(
+	const LayersOfTexture & layers
+,	const QImage & image
+,	OpenGLFunctions & gl)
+{
+	if (image.width() != layers.tileSize.width() * layers.columns
+		|| image.height() != layers.tileSize.height() * layers.rows)
+	{
+		qWarning() << "Image size changed, texture array layers are not updated.";
+		return;
+	}
+
+	gl.glBindTexture(GL_TEXTURE_2D_ARRAY, layers.texture);
+
+	// tiles are uploaded straight from the image, selecting them by unpack skips
+
+	gl.glPixelStorei(GL_UNPACK_ROW_LENGTH, image.width());
+	for (int y = 0; y < layers.rows; ++y)
+		for (int x = 0; x < layers.columns; ++x)
+		{
+			gl.glPixelStorei(GL_UNPACK_SKIP_PIXELS, x * layers.tileSize.width());
+			gl.glPixelStorei(GL_UNPACK_SKIP_ROWS, y * layers.tileSize.height());
+
+			gl.glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layers.layer + y * layers.columns + x
+				, layers.tileSize.width(), layers.tileSize.height(), 1
+				, GL_BGRA, GL_UNSIGNED_BYTE, image.constBits());
+		}
+	gl.glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	gl.glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+	gl.glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+
+	// mip levels are filtered per layer, thus never bleed into neighbouring tiles
+	gl.glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+}
+
+void FileAssociatedTexture::loadHeightSubTexture2D(
+	GLuint texture
+,	const QRegion & region
+,	const Heights & heights
+,	OpenGLFunctions & gl)
+{
+	gl.glBindTexture(GL_TEXTURE_2D, texture);
+
+	// rects are uploaded straight from the heights, selecting them by unpack skips
+
+	gl.glPixelStorei(GL_UNPACK_ROW_LENGTH, heights.size.width());
+	foreach (const QRect & rect, region.rects())
+	{
+		gl.glPixelStorei(GL_UNPACK_SKIP_PIXELS, rect.x());
+		gl.glPixelStorei(GL_UNPACK_SKIP_ROWS, rect.y());
+
+		gl.glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x(), rect.y(), rect.width(), rect.height()
+			, GL_RED, GL_FLOAT, heights.values.constData());
+	}
+	gl.glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	gl.glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+	gl.glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+}
+
 GLuint FileAssociatedTexture::loadTextureCube(
     GLuint texture
 ,   const GLenum mag_filter
@@ -258,3 +653,26 @@ QImage FileAssociatedTexture::image(const QString & filePath)
 
 	return QImage();
 }
+
+FileAssociatedTexture::Heights FileAssociatedTexture::heights(const QString & filePath)
+{
+	if (s_heightsByFilePath.contains(filePath))
+		return s_heightsByFilePath[filePath];
+
+	return Heights();
+}
+
+bool FileAssociatedTexture::Heights::isNull() const
+{
+	return values.isEmpty();
+}
+
+float FileAssociatedTexture::Heights::at(
+	const int x
+,	const int y) const
+{
+	const int w(size.width());
+	const int h(size.height());
+
+	return values[((y % h + h) % h) * w + (x % w + w) % w];
+}
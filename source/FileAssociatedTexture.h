@@ -5,6 +5,9 @@
 #include <QMap>
 #include <QMultiMap>
 #include <QQueue>
+#include <QRegion>
+#include <QSize>
+#include <QVector>
 
 #include "OpenGLFunctions.h"
 
@@ -40,8 +43,70 @@ public:
     ,   const GLenum min_filter = GL_LINEAR
 	);
 
+	/** Texture array with a full mip chain per layer. Each file is split
+		into columns x rows equally sized tiles, one layer each, left to right
+		and top to bottom (e.g., "data/ground.png" with 4 columns). If fileNames
+		contains a questionmark '?' it is replaced by 0, 1, 2, ... for as long
+		as files exist, appending their tiles as further layers.
+	*/
+	static GLuint getOrCreate2DArray(
+		const QString & fileNames
+	,	OpenGLFunctions & gl
+	,	const int columns = 1
+	,	const int rows = 1
+	,	const GLenum wrap_s = GL_REPEAT
+	,	const GLenum wrap_t = GL_REPEAT
+	,	const GLenum mag_filter = GL_LINEAR
+	,	const GLenum min_filter = GL_LINEAR_MIPMAP_LINEAR);
+
+	/** Single channel height field texture, loaded from an image (16bit PNGs
+		keep their precision), or a raw square file of little endian 16bit
+		unsigned (.r16) or 32bit float (.r32) values. The internal format
+		defaults to GL_R32F for .r32 and GL_R16 otherwise; GL_R16F is an
+		alternative. Heights are sampled by .r and should be within [0;1].
+	*/
+	static GLuint getOrCreateHeight2D(
+		const QString & fileName
+	,	OpenGLFunctions & gl
+	,	const GLenum internalFormat = GL_NONE
+	,	const GLenum wrap_s = GL_REPEAT
+	,	const GLenum wrap_t = GL_REPEAT
+	,	const GLenum mag_filter = GL_LINEAR
+	,	const GLenum min_filter = GL_LINEAR);
+
+	/** cpu side copy of a height field loaded by getOrCreateHeight2D
+	*/
+	struct Heights
+	{
+		QSize size;
+		QVector<float> values; ///< row by row
+
+		bool isNull() const;
+
+		/** x and y are wrapped (as with GL_REPEAT) */
+		float at(int x, int y) const;
+	};
+
+	/** Replaces the heights within region (values are given row by row for
+		the region only) of a texture loaded by getOrCreateHeight2D, e.g., for
+		sculpting. The cpu side copy changes immediately, the texture with the
+		next process, which uploads only the regions changed since.
+	*/
+	static bool setHeights(
+		const QString & fileName
+	,	const QRect & region
+	,	const float * values);
+
+	/** Returns and forgets the regions of a height field that were reloaded
+		from its file since the last call (all of it if its size changed), so
+		that cpu side structures derived from the heights can follow. Edits by
+		setHeights are not included.
+	*/
+	static QRegion takeReloadedHeights(const QString & fileName);
+
 	static void process(OpenGLFunctions & gl);
 	static QImage image(const QString & filePath);
+	static Heights heights(const QString & filePath);
 
 protected:
 	static FileAssociatedTexture * instance();
@@ -54,10 +119,22 @@ protected:
         const QString & filePath
     ,   bool forceReload = false);
 
+    static Heights loadHeights(const QString & filePath);
+
     static GLuint loadTexture2D(
 		GLuint texture
 	,	const QImage & image
 	,	OpenGLFunctions & gl);
+	static GLuint loadHeightTexture2D(
+		GLuint texture
+	,	const GLenum internalFormat
+	,	const Heights & heights
+	,	OpenGLFunctions & gl);
+	static void loadHeightSubTexture2D(
+		GLuint texture
+	,	const QRegion & region
+	,	const Heights & heights
+	,	OpenGLFunctions & gl);
 	static GLuint loadTexture2D(
 		GLuint texture
 	,	const GLenum wrap_s
@@ -67,6 +144,19 @@ protected:
 	,	const QImage & image
 	,	OpenGLFunctions & gl);
 
+	struct LayersOfTexture
+	{
+		GLuint texture;
+		int layer; ///< layer of the first tile
+		int columns;
+		int rows;
+		QSize tileSize;
+	};
+	static void loadTextureLayers(
+		const LayersOfTexture & layers
+	,	const QImage & image
+	,	OpenGLFunctions & gl);
+
 	static GLuint loadTextureCube(
 		GLuint texture
     ,   const QMap<GLenum, QImage> & images
@@ -87,6 +177,11 @@ protected:
     static QMap<QString, QImage> s_imagesByFilePath;
 	static QMap<QString, GLuint> s_texturesByFilePath;
 
+    static QMap<QString, Heights> s_heightsByFilePath;
+    static QMap<QString, GLenum> s_heightFormatsByFilePath;
+    static QMap<QString, QRegion> s_dirtyByFilePath; ///< if absent, a queued height texture is reloaded entirely
+    static QMap<QString, QRegion> s_reloadedByFilePath;
+
     struct CubeFaceOfTexture
     {
         GLuint texture;
@@ -94,6 +189,8 @@ protected:
     };
     static QMultiMap<QString, CubeFaceOfTexture> s_cubefacesByFilePath;
 
+    static QMultiMap<QString, LayersOfTexture> s_layersByFilePath;
+
 	static QQueue<QString> s_queue;
 
 	QFileSystemWatcher * m_fileSystemWatcher;
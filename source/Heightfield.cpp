@@ -0,0 +1,591 @@
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HEIGHTFIELD_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "Heightfield.h"
+
+
+namespace
+{
+    const float Infinity = 1e30f;
+
+    // samples per finest cell before bisection (see refine)
+    const int RefineSamples = 4;
+    const int RefineBisections = 10;
+
+#ifdef HEIGHTFIELD_SSE2
+    inline __m128 floor4(const __m128 x)
+    {
+        // truncation rounds towards zero, thus correct negative fractions
+        const __m128 t(_mm_cvtepi32_ps(_mm_cvttps_epi32(x)));
+        return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.f)));
+    }
+#endif
+}
+
+Heightfield::Heightfield()
+: m_width(0)
+, m_height(0)
+{
+}
+
+Heightfield::~Heightfield()
+{
+}
+
+void Heightfield::setHeights(
+    const int width
+,   const int height
+,   const float * values)
+{
+    assert(width > 0 && height > 0);
+
+    m_width = width;
+    m_height = height;
+    m_values.assign(values, values + width * height);
+
+    buildPyramid();
+}
+
+void Heightfield::setHeights(
+    const QRect & region
+,   const float * values)
+{
+    assert(!isNull());
+    assert(region.x() >= 0 && region.y() >= 0
+        && region.right() < m_width && region.bottom() < m_height);
+
+    for (int y = 0; y < region.height(); ++y)
+        std::copy(values + y * region.width(), values + (y + 1) * region.width()
+            , m_values.begin() + (region.y() + y) * m_width + region.x());
+
+    // Level 0 cells bound their texel's neighbors too, thus the cells around
+    // the region change as well, which might wrap around the borders.
+
+    int xs[4];
+    int ys[4];
+    int nx(0);
+    int ny(0);
+
+    const int x0(region.x() - 1);
+    const int x1(region.right() + 1);
+    const int y0(region.y() - 1);
+    const int y1(region.bottom() + 1);
+
+    if (x1 - x0 + 1 >= m_width)
+    {
+        xs[nx++] = 0; xs[nx++] = m_width - 1;
+    }
+    else
+    {
+        xs[nx++] = std::max(x0, 0); xs[nx++] = std::min(x1, m_width - 1);
+        if (x0 < 0)
+        {
+            xs[nx++] = m_width - 1; xs[nx++] = m_width - 1;
+        }
+        if (x1 >= m_width)
+        {
+            xs[nx++] = 0; xs[nx++] = 0;
+        }
+    }
+
+    if (y1 - y0 + 1 >= m_height)
+    {
+        ys[ny++] = 0; ys[ny++] = m_height - 1;
+    }
+    else
+    {
+        ys[ny++] = std::max(y0, 0); ys[ny++] = std::min(y1, m_height - 1);
+        if (y0 < 0)
+        {
+            ys[ny++] = m_height - 1; ys[ny++] = m_height - 1;
+        }
+        if (y1 >= m_height)
+        {
+            ys[ny++] = 0; ys[ny++] = 0;
+        }
+    }
+
+    for (int j = 0; j < ny; j += 2)
+        for (int i = 0; i < nx; i += 2)
+            updatePyramid(xs[i], ys[j], xs[i + 1], ys[j + 1]);
+}
+
+void Heightfield::setTransform(const QMatrix4x4 & transform)
+{
+    m_transform = transform;
+    m_inverse = transform.inverted();
+}
+
+const QMatrix4x4 & Heightfield::transform() const
+{
+    return m_transform;
+}
+
+bool Heightfield::isNull() const
+{
+    return m_values.empty();
+}
+
+int Heightfield::width() const
+{
+    return m_width;
+}
+
+int Heightfield::height() const
+{
+    return m_height;
+}
+
+void Heightfield::buildPyramid()
+{
+    m_levels.clear();
+
+    const int w(m_width);
+    const int h(m_height);
+
+    // Level 0: a cell covers one texel footprint, in which bilinear sampling
+    // reads from the texel and its 8 (wrapped) neighbors at most.
+
+    std::vector<float> rowMins(w * h);
+    std::vector<float> rowMaxs(w * h);
+
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x)
+        {
+            const float * row(&m_values[y * w]);
+            const float l(row[(x + w - 1) % w]);
+            const float c(row[x]);
+            const float r(row[(x + 1) % w]);
+
+            rowMins[y * w + x] = std::min(l, std::min(c, r));
+            rowMaxs[y * w + x] = std::max(l, std::max(c, r));
+        }
+
+    Level finest;
+    finest.width = w;
+    finest.height = h;
+    finest.cellSize = 1;
+    finest.mins.resize(w * h);
+    finest.maxs.resize(w * h);
+
+    for (int y = 0; y < h; ++y)
+    {
+        const int above((y + h - 1) % h);
+        const int below((y + 1) % h);
+
+        for (int x = 0; x < w; ++x)
+        {
+            finest.mins[y * w + x] = std::min(rowMins[above * w + x]
+                , std::min(rowMins[y * w + x], rowMins[below * w + x]));
+            finest.maxs[y * w + x] = std::max(rowMaxs[above * w + x]
+                , std::max(rowMaxs[y * w + x], rowMaxs[below * w + x]));
+        }
+    }
+    m_levels.push_back(finest);
+
+    // coarser levels bound 2x2 cells of the previous one, up to a single cell
+
+    while (m_levels.back().width > 1 || m_levels.back().height > 1)
+    {
+        const Level & fine(m_levels.back());
+
+        Level coarse;
+        coarse.width = (fine.width + 1) / 2;
+        coarse.height = (fine.height + 1) / 2;
+        coarse.cellSize = fine.cellSize * 2;
+        coarse.mins.resize(coarse.width * coarse.height, Infinity);
+        coarse.maxs.resize(coarse.width * coarse.height, -Infinity);
+
+        for (int y = 0; y < fine.height; ++y)
+            for (int x = 0; x < fine.width; ++x)
+            {
+                const int i((y / 2) * coarse.width + x / 2);
+                coarse.mins[i] = std::min(coarse.mins[i], fine.mins[y * fine.width + x]);
+                coarse.maxs[i] = std::max(coarse.maxs[i], fine.maxs[y * fine.width + x]);
+            }
+        m_levels.push_back(coarse);
+    }
+}
+
+void Heightfield::updatePyramid(
+    const int x0
+,   const int y0
+,   const int x1
+,   const int y1)
+{
+    Level & finest(m_levels[0]);
+
+    for (int y = y0; y <= y1; ++y)
+        for (int x = x0; x <= x1; ++x)
+        {
+            float lo(Infinity);
+            float hi(-Infinity);
+
+            for (int j = -1; j <= 1; ++j)
+                for (int i = -1; i <= 1; ++i)
+                {
+                    const float value(texel(x + i, y + j));
+                    lo = std::min(lo, value);
+                    hi = std::max(hi, value);
+                }
+
+            finest.mins[y * m_width + x] = lo;
+            finest.maxs[y * m_width + x] = hi;
+        }
+
+    // the coarser cells covering the range are rebuilt from their 2x2 children
+
+    for (int l = 1; l < static_cast<int>(m_levels.size()); ++l)
+    {
+        const Level & fine(m_levels[l - 1]);
+        Level & coarse(m_levels[l]);
+
+        for (int y = y0 >> l; y <= y1 >> l; ++y)
+            for (int x = x0 >> l; x <= x1 >> l; ++x)
+            {
+                float lo(Infinity);
+                float hi(-Infinity);
+
+                for (int fy = y * 2; fy < std::min(y * 2 + 2, fine.height); ++fy)
+                    for (int fx = x * 2; fx < std::min(x * 2 + 2, fine.width); ++fx)
+                    {
+                        lo = std::min(lo, fine.mins[fy * fine.width + fx]);
+                        hi = std::max(hi, fine.maxs[fy * fine.width + fx]);
+                    }
+
+                coarse.mins[y * coarse.width + x] = lo;
+                coarse.maxs[y * coarse.width + x] = hi;
+            }
+    }
+}
+
+float Heightfield::texel(
+    const int x
+,   const int y) const
+{
+    assert(!isNull());
+
+    return m_values[((y % m_height + m_height) % m_height) * m_width + (x % m_width + m_width) % m_width];
+}
+
+float Heightfield::sample(
+    const float u
+,   const float v) const
+{
+    float height(0.f);
+    sample(&u, &v, &height, 1);
+
+    return height;
+}
+
+void Heightfield::sample(
+    const float * u
+,   const float * v
+,   float * heights
+,   const int count) const
+{
+    if (isNull())
+    {
+        std::fill(heights, heights + count, 0.f);
+        return;
+    }
+
+    const int w(m_width);
+    const int h(m_height);
+    const float * values(m_values.data());
+
+    int i = 0;
+
+#ifdef HEIGHTFIELD_SSE2
+    const __m128 half(_mm_set1_ps(0.5f));
+    const __m128 fw(_mm_set1_ps(static_cast<float>(w)));
+    const __m128 fh(_mm_set1_ps(static_cast<float>(h)));
+    const __m128i iw(_mm_set1_epi32(w));
+    const __m128i ih(_mm_set1_epi32(h));
+    const __m128i zero(_mm_setzero_si128());
+    const __m128i one(_mm_set1_epi32(1));
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 su(_mm_loadu_ps(u + i));
+        __m128 sv(_mm_loadu_ps(v + i));
+
+        // wrap into [0;1) and move to texel centers
+        su = _mm_sub_ps(su, floor4(su));
+        sv = _mm_sub_ps(sv, floor4(sv));
+
+        const __m128 x(_mm_sub_ps(_mm_mul_ps(su, fw), half));
+        const __m128 y(_mm_sub_ps(_mm_mul_ps(sv, fh), half));
+
+        const __m128 xf(floor4(x));
+        const __m128 yf(floor4(y));
+
+        const __m128 fx(_mm_sub_ps(x, xf));
+        const __m128 fy(_mm_sub_ps(y, yf));
+
+        // x0 in [-1;w-1] and x1 in [0;w], wrapped into [0;w-1]
+        __m128i x0(_mm_cvttps_epi32(xf));
+        __m128i y0(_mm_cvttps_epi32(yf));
+        x0 = _mm_add_epi32(x0, _mm_and_si128(_mm_cmplt_epi32(x0, zero), iw));
+        y0 = _mm_add_epi32(y0, _mm_and_si128(_mm_cmplt_epi32(y0, zero), ih));
+
+        __m128i x1(_mm_add_epi32(x0, one));
+        __m128i y1(_mm_add_epi32(y0, one));
+        x1 = _mm_sub_epi32(x1, _mm_and_si128(_mm_cmpgt_epi32(x1, _mm_sub_epi32(iw, one)), iw));
+        y1 = _mm_sub_epi32(y1, _mm_and_si128(_mm_cmpgt_epi32(y1, _mm_sub_epi32(ih, one)), ih));
+
+        int ix0[4], ix1[4], iy0[4], iy1[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(ix0), x0);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(ix1), x1);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(iy0), y0);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(iy1), y1);
+
+        // there is no gather in SSE2
+        float h00[4], h10[4], h01[4], h11[4];
+        for (int k = 0; k < 4; ++k)
+        {
+            h00[k] = values[iy0[k] * w + ix0[k]];
+            h10[k] = values[iy0[k] * w + ix1[k]];
+            h01[k] = values[iy1[k] * w + ix0[k]];
+            h11[k] = values[iy1[k] * w + ix1[k]];
+        }
+
+        const __m128 a(_mm_loadu_ps(h00));
+        const __m128 b(_mm_loadu_ps(h10));
+        const __m128 c(_mm_loadu_ps(h01));
+        const __m128 d(_mm_loadu_ps(h11));
+
+        const __m128 top(_mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), fx)));
+        const __m128 bottom(_mm_add_ps(c, _mm_mul_ps(_mm_sub_ps(d, c), fx)));
+
+        _mm_storeu_ps(heights + i, _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), fy)));
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        const float su(u[i] - std::floor(u[i]));
+        const float sv(v[i] - std::floor(v[i]));
+
+        const float x(su * w - 0.5f);
+        const float y(sv * h - 0.5f);
+
+        const float xf(std::floor(x));
+        const float yf(std::floor(y));
+
+        const float fx(x - xf);
+        const float fy(y - yf);
+
+        const int x0((static_cast<int>(xf) + w) % w);
+        const int y0((static_cast<int>(yf) + h) % h);
+        const int x1((x0 + 1) % w);
+        const int y1((y0 + 1) % h);
+
+        const float top(values[y0 * w + x0] + (values[y0 * w + x1] - values[y0 * w + x0]) * fx);
+        const float bottom(values[y1 * w + x0] + (values[y1 * w + x1] - values[y1 * w + x0]) * fx);
+
+        heights[i] = top + (bottom - top) * fy;
+    }
+}
+
+bool Heightfield::heightAt(
+    const QVector3D & position
+,   float & y) const
+{
+    if (isNull())
+        return false;
+
+    const QVector3D p(m_inverse * position);
+    if (p.x() < 0.f || p.x() > 1.f || p.z() < 0.f || p.z() > 1.f)
+        return false;
+
+    y = (m_transform * QVector3D(p.x(), sample(p.x(), p.z()), p.z())).y();
+    return true;
+}
+
+bool Heightfield::intersect(
+    const QVector3D & origin
+,   const QVector3D & direction
+,   QVector3D & hit) const
+{
+    if (isNull())
+        return false;
+
+    const QVector3D o(m_inverse * origin);
+    const QVector3D d(m_inverse.mapVector(direction));
+
+    const int top(static_cast<int>(m_levels.size()) - 1);
+
+    float t0(0.f);
+    float t1(Infinity);
+    if (!cellRange(top, 0, 0, o, d, t0, t1))
+        return false;
+
+    float t;
+    if (!intersect(top, 0, 0, o, d, t0, t1, t))
+        return false;
+
+    hit = m_transform * (o + t * d);
+    return true;
+}
+
+bool Heightfield::cellRange(
+    const int level
+,   const int x
+,   const int y
+,   const QVector3D & origin
+,   const QVector3D & direction
+,   float & t0
+,   float & t1) const
+{
+    const Level & l(m_levels[level]);
+    const int i(y * l.width + x);
+
+    const float llf[3] = { static_cast<float>(x * l.cellSize) / m_width, l.mins[i]
+        , static_cast<float>(y * l.cellSize) / m_height };
+    const float urb[3] = { static_cast<float>(std::min((x + 1) * l.cellSize, m_width)) / m_width, l.maxs[i]
+        , static_cast<float>(std::min((y + 1) * l.cellSize, m_height)) / m_height };
+
+    for (int a = 0; a < 3; ++a)
+    {
+        const float o(origin[a]);
+        const float d(direction[a]);
+
+        if (std::fabs(d) < 1e-12f)
+        {
+            if (o < llf[a] || o > urb[a])
+                return false;
+            continue;
+        }
+
+        float n((llf[a] - o) / d);
+        float f((urb[a] - o) / d);
+        if (n > f)
+            std::swap(n, f);
+
+        t0 = std::max(t0, n);
+        t1 = std::min(t1, f);
+
+        if (t0 > t1)
+            return false;
+    }
+    return true;
+}
+
+bool Heightfield::intersect(
+    const int level
+,   const int x
+,   const int y
+,   const QVector3D & origin
+,   const QVector3D & direction
+,   const float t0
+,   const float t1
+,   float & t) const
+{
+    if (0 == level)
+        return refine(origin, direction, t0, t1, t);
+
+    // visit the (up to) four children hit by the ray, front to back
+
+    const Level & fine(m_levels[level - 1]);
+
+    int children[4][2];
+    float ranges[4][2];
+    int count = 0;
+
+    for (int j = 0; j < 2; ++j)
+        for (int i = 0; i < 2; ++i)
+        {
+            const int cx(x * 2 + i);
+            const int cy(y * 2 + j);
+            if (cx >= fine.width || cy >= fine.height)
+                continue;
+
+            float n(t0);
+            float f(t1);
+            if (!cellRange(level - 1, cx, cy, origin, direction, n, f))
+                continue;
+
+            // insertion by entry
+            int k = count++;
+            for (; k > 0 && ranges[k - 1][0] > n; --k)
+            {
+                children[k][0] = children[k - 1][0];
+                children[k][1] = children[k - 1][1];
+                ranges[k][0] = ranges[k - 1][0];
+                ranges[k][1] = ranges[k - 1][1];
+            }
+            children[k][0] = cx;
+            children[k][1] = cy;
+            ranges[k][0] = n;
+            ranges[k][1] = f;
+        }
+
+    for (int k = 0; k < count; ++k)
+        if (intersect(level - 1, children[k][0], children[k][1], origin, direction, ranges[k][0], ranges[k][1], t))
+            return true;
+
+    return false;
+}
+
+bool Heightfield::refine(
+    const QVector3D & origin
+,   const QVector3D & direction
+,   const float t0
+,   const float t1
+,   float & t) const
+{
+    // signed height of the ray above the surface, sampled at the range start
+    // and at RefineSamples equidistant steps, then bisected at the first sign
+    // change (this might miss grazing hits in between steps)
+
+    float ts[RefineSamples + 1];
+    float us[RefineSamples + 1];
+    float vs[RefineSamples + 1];
+    float hs[RefineSamples + 1];
+
+    for (int k = 0; k <= RefineSamples; ++k)
+    {
+        ts[k] = t0 + (t1 - t0) * k / RefineSamples;
+        us[k] = origin.x() + ts[k] * direction.x();
+        vs[k] = origin.z() + ts[k] * direction.z();
+    }
+    sample(us, vs, hs, RefineSamples + 1);
+
+    if (origin.y() + ts[0] * direction.y() <= hs[0])
+    {
+        t = ts[0];
+        return true;
+    }
+
+    for (int k = 1; k <= RefineSamples; ++k)
+    {
+        if (origin.y() + ts[k] * direction.y() > hs[k])
+            continue;
+
+        float above(ts[k - 1]);
+        float below(ts[k]);
+
+        for (int b = 0; b < RefineBisections; ++b)
+        {
+            const float m((above + below) * 0.5f);
+            const float h(sample(origin.x() + m * direction.x(), origin.z() + m * direction.z()));
+
+            if (origin.y() + m * direction.y() > h)
+                above = m;
+            else
+                below = m;
+        }
+
+        t = below;
+        return true;
+    }
+    return false;
+}
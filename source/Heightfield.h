@@ -0,0 +1,148 @@
+#pragma once
+
+#include <vector>
+
+#include <QMatrix4x4>
+#include <QRect>
+#include <QVector3D>
+
+/** CPU side height field for queries that should not read back from the GPU
+    (picking, navigation anchors, keeping the camera above ground).
+
+    Heights are given in texture space, i.e., u and v in [0;1] and heights
+    within [0;1], and are sampled bilinearly with wrapping, as the terrain
+    shaders do with GL_LINEAR and GL_REPEAT. A transform maps texture space
+    (u, height, v) to world space; it is expected to keep y as up axis (e.g.,
+    scale and translate as used for the terrain).
+
+    For ray intersections a min/max pyramid is built: each level 0 cell covers
+    one texel footprint and bounds all heights bilinear sampling can yield
+    there, and each coarser cell bounds 2x2 finer ones. Rays descend only into
+    cells whose bounds they hit, front to back, and are refined by sampling and
+    bisection within the finest cells.
+*/
+class Heightfield
+{
+public:
+    Heightfield();
+    virtual ~Heightfield();
+
+    /** values are copied (row by row, v major) and the pyramid is rebuilt
+    */
+    void setHeights(
+        int width
+    ,   int height
+    ,   const float * values);
+
+    /** Replaces the heights within region (values row by row for the region
+        only, which has to be within the height field). Only the pyramid cells
+        affected are updated, thus edits are cheap for small regions.
+    */
+    void setHeights(
+        const QRect & region
+    ,   const float * values);
+
+    void setTransform(const QMatrix4x4 & transform);
+    const QMatrix4x4 & transform() const;
+
+    bool isNull() const;
+    int width() const;
+    int height() const;
+
+    /** height of a texel (x and y wrapped)
+    */
+    float texel(
+        int x
+    ,   int y) const;
+
+    /** bilinear height at texture coordinates (wrapped)
+    */
+    float sample(
+        float u
+    ,   float v) const;
+
+    /** Bilinear heights for count texture coordinates; four at a time with
+        SSE2 where available.
+    */
+    void sample(
+        const float * u
+    ,   const float * v
+    ,   float * heights
+    ,   int count) const;
+
+    /** World space height below/above position. Returns false if position is
+        not over the height field.
+    */
+    bool heightAt(
+        const QVector3D & position
+    ,   float & y) const;
+
+    /** Nearest world space intersection of the ray origin + t * direction
+        (t >= 0) with the height field.
+    */
+    bool intersect(
+        const QVector3D & origin
+    ,   const QVector3D & direction
+    ,   QVector3D & hit) const;
+
+protected:
+    struct Level
+    {
+        int width;
+        int height;
+        int cellSize; ///< in texels of level 0
+        std::vector<float> mins;
+        std::vector<float> maxs;
+    };
+
+    void buildPyramid();
+
+    /** updates the cells of all levels covering the texels [x0;x1]x[y0;y1]
+        (not wrapped), including the texels' neighbors on level 0
+    */
+    void updatePyramid(
+        int x0
+    ,   int y0
+    ,   int x1
+    ,   int y1);
+
+    /** ray is given in texture space, [t0;t1] is the range to search in
+    */
+    bool intersect(
+        int level
+    ,   int x
+    ,   int y
+    ,   const QVector3D & origin
+    ,   const QVector3D & direction
+    ,   float t0
+    ,   float t1
+    ,   float & t) const;
+
+    /** intersection with the bilinear surface within [t0;t1]
+    */
+    bool refine(
+        const QVector3D & origin
+    ,   const QVector3D & direction
+    ,   float t0
+    ,   float t1
+    ,   float & t) const;
+
+    bool cellRange(
+        int level
+    ,   int x
+    ,   int y
+    ,   const QVector3D & origin
+    ,   const QVector3D & direction
+    ,   float & t0
+    ,   float & t1) const;
+
+protected:
+    int m_width;
+    int m_height;
+    std::vector<float> m_values;
+
+    std::vector<Level> m_levels; ///< finest first
+
+    QMatrix4x4 m_transform;
+    QMatrix4x4 m_inverse;
+};
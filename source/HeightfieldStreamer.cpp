@@ -0,0 +1,396 @@
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include <QDebug>
+#include <QOpenGLShaderProgram>
+#include <QPair>
+
+#include "HeightfieldStreamer.h"
+
+
+namespace
+{
+    // the loader works on only a few tiles ahead, the rest is requested again
+    const int MaxRequests = 8;
+}
+
+
+HeightfieldStreamer::HeightfieldStreamer(
+    OpenGLFunctions & gl
+,   const int cacheTiles)
+: m_gl(gl)
+, m_loader(nullptr)
+, m_cacheTiles(cacheTiles)
+, m_range(1.5f)
+, m_tiles(0)
+, m_indirection(0)
+, m_frame(0)
+, m_indirectionDirty(false)
+{
+}
+
+HeightfieldStreamer::~HeightfieldStreamer()
+{
+    if (m_loader)
+    {
+        m_loader->stop();
+        delete m_loader;
+    }
+
+    if (m_tiles)
+        m_gl.glDeleteTextures(1, &m_tiles);
+    if (m_indirection)
+        m_gl.glDeleteTextures(1, &m_indirection);
+}
+
+bool HeightfieldStreamer::open(const QString & filePath)
+{
+    assert(!m_loader);
+
+    if (!m_file.open(filePath))
+        return false;
+
+    GLenum internal(GL_R16);
+    GLenum format(GL_RED);
+    GLenum type(GL_UNSIGNED_SHORT);
+
+    switch (m_file.format())
+    {
+    case TiledImageFile::R32F:
+        internal = GL_R32F;
+        type = GL_FLOAT;
+        break;
+    case TiledImageFile::RGBA8:
+        internal = GL_RGBA8;
+        format = GL_RGBA;
+        type = GL_UNSIGNED_BYTE;
+        break;
+    default:
+        break;
+    }
+
+    // the coarsest level needs to fit, since it stays resident
+    m_cacheTiles = qMax(m_cacheTiles, m_file.tilesX(m_file.levels() - 1) * m_file.tilesY(m_file.levels() - 1) + 1);
+
+    m_gl.glGenTextures(1, &m_tiles);
+    m_gl.glBindTexture(GL_TEXTURE_2D_ARRAY, m_tiles);
+
+    m_gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    m_gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    m_gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    m_gl.glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    m_gl.glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, internal, m_file.pageSize(), m_file.pageSize(), m_cacheTiles
+        , 0, format, type, nullptr);
+
+    m_gl.glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    m_gl.glGenTextures(1, &m_indirection);
+    m_gl.glBindTexture(GL_TEXTURE_2D, m_indirection);
+
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    m_gl.glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, m_file.tilesX(0), m_file.tilesY(0)
+        , 0, GL_RGBA, GL_FLOAT, nullptr);
+
+    m_gl.glBindTexture(GL_TEXTURE_2D, 0);
+
+    m_indirectionDirty = true;
+
+    m_loader = new TileLoader(m_file);
+    m_loader->start();
+
+    qDebug() << "Streaming" << m_file.width() << "x" << m_file.height() << "height field"
+        << filePath << "with" << m_cacheTiles << "cached tiles.";
+
+    return true;
+}
+
+bool HeightfieldStreamer::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+const TiledImageFile & HeightfieldStreamer::file() const
+{
+    return m_file;
+}
+
+void HeightfieldStreamer::setRange(const float range)
+{
+    m_range = range;
+}
+
+float HeightfieldStreamer::range() const
+{
+    return m_range;
+}
+
+int HeightfieldStreamer::resident() const
+{
+    return m_resident.size();
+}
+
+void HeightfieldStreamer::update(
+    OpenGLFunctions & gl
+,   const QVector2D & eye
+,   const int maxUploads)
+{
+    if (!isOpen())
+        return;
+
+    ++m_frame;
+
+    requestTiles(eye);
+    uploadTiles(gl, maxUploads);
+
+    if (m_indirectionDirty)
+        updateIndirection(gl);
+}
+
+void HeightfieldStreamer::requestTiles(const QVector2D & eye)
+{
+    // Collect the tiles within range of the eye for each level. The priority
+    // prefers coarse levels (a coarse tile is the fallback for finer ones),
+    // then the distance to the eye.
+
+    QList<QPair<float, Key> > required;
+
+    const int levels(m_file.levels());
+    for (int level = levels - 1; level >= 0; --level)
+    {
+        // tile extent in texture space
+        const float sx(static_cast<float>(m_file.tileSize()) / m_file.width(level));
+        const float sy(static_cast<float>(m_file.tileSize()) / m_file.height(level));
+
+        const float ex(eye.x() / sx);
+        const float ey(eye.y() / sy);
+
+        const int x0(qMax(0, static_cast<int>(std::floor(ex - m_range))));
+        const int x1(qMin(m_file.tilesX(level) - 1, static_cast<int>(std::floor(ex + m_range))));
+        const int y0(qMax(0, static_cast<int>(std::floor(ey - m_range))));
+        const int y1(qMin(m_file.tilesY(level) - 1, static_cast<int>(std::floor(ey + m_range))));
+
+        for (int y = y0; y <= y1; ++y)
+            for (int x = x0; x <= x1; ++x)
+            {
+                const float dx(qMax(0.f, qMax(x - ex, ex - (x + 1))));
+                const float dy(qMax(0.f, qMax(y - ey, ey - (y + 1))));
+                const float distance(std::sqrt(dx * dx + dy * dy));
+
+                if (level < levels - 1 && distance > m_range)
+                    continue;
+
+                Key key;
+                key.level = level;
+                key.x = x;
+                key.y = y;
+
+                required << qMakePair(levels - 1 - level + distance / (m_range + 2.f), key);
+            }
+
+        // the coarsest level is required entirely
+        if (level == levels - 1)
+            for (int y = 0; y < m_file.tilesY(level); ++y)
+                for (int x = 0; x < m_file.tilesX(level); ++x)
+                    if (x < x0 || x > x1 || y < y0 || y > y1)
+                    {
+                        Key key;
+                        key.level = level;
+                        key.x = x;
+                        key.y = y;
+
+                        required << qMakePair(0.f, key);
+                    }
+    }
+
+    std::stable_sort(required.begin(), required.end()
+        , [](const QPair<float, Key> & a, const QPair<float, Key> & b) { return a.first < b.first; });
+
+    // no more tiles than the cache holds are required
+
+    m_required.clear();
+    QList<Key> missing;
+
+    for (int i = 0; i < required.size() && i < m_cacheTiles; ++i)
+    {
+        const quint64 h(TileLoader::hash(required[i].second));
+        m_required[h] = required[i].first;
+
+        if (m_resident.contains(h))
+            m_pages[m_resident[h]].lastUsed = m_frame;
+        else if (missing.size() < MaxRequests)
+            missing << required[i].second;
+    }
+
+    m_loader->request(missing);
+}
+
+int HeightfieldStreamer::allocatePage()
+{
+    if (m_pages.size() < m_cacheTiles)
+    {
+        m_pages << Page();
+        return m_pages.size() - 1;
+    }
+
+    // evict the least recently required page that is not required now
+
+    int evict(-1);
+    for (int i = 0; i < m_pages.size(); ++i)
+    {
+        if (m_required.contains(TileLoader::hash(m_pages[i].key)))
+            continue;
+
+        if (evict < 0 || m_pages[i].lastUsed < m_pages[evict].lastUsed)
+            evict = i;
+    }
+
+    if (evict >= 0)
+    {
+        m_resident.remove(TileLoader::hash(m_pages[evict].key));
+        m_indirectionDirty = true;
+    }
+    return evict;
+}
+
+void HeightfieldStreamer::uploadTiles(
+    OpenGLFunctions & gl
+,   const int maxUploads)
+{
+    m_uploads << m_loader->take();
+    if (m_uploads.isEmpty())
+        return;
+
+    GLenum format(GL_RED);
+    GLenum type(GL_UNSIGNED_SHORT);
+
+    switch (m_file.format())
+    {
+    case TiledImageFile::R32F:
+        type = GL_FLOAT;
+        break;
+    case TiledImageFile::RGBA8:
+        format = GL_RGBA;
+        type = GL_UNSIGNED_BYTE;
+        break;
+    default:
+        break;
+    }
+
+    gl.glBindTexture(GL_TEXTURE_2D_ARRAY, m_tiles);
+    gl.glPixelStorei(GL_UNPACK_ALIGNMENT, m_file.bytesPerTexel() < 4 ? 2 : 4);
+
+    int uploads(0);
+    while (!m_uploads.isEmpty() && uploads < maxUploads)
+    {
+        const Loaded tile(m_uploads.takeFirst());
+        const quint64 h(TileLoader::hash(tile.key));
+
+        // no longer required or requested twice
+        if (!m_required.contains(h) || m_resident.contains(h))
+            continue;
+
+        const int layer(allocatePage());
+        if (layer < 0)
+            break;
+
+        gl.glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, m_file.pageSize(), m_file.pageSize(), 1
+            , format, type, tile.data.constData());
+
+        m_pages[layer].key = tile.key;
+        m_pages[layer].lastUsed = m_frame;
+        m_resident[h] = layer;
+
+        m_indirectionDirty = true;
+        ++uploads;
+    }
+
+    gl.glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    gl.glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void HeightfieldStreamer::updateIndirection(OpenGLFunctions & gl)
+{
+    // Resident tiles are written coarse to fine, each into all level 0 cells
+    // it covers, so every cell ends up referring to its finest resident tile.
+
+    const int width(m_file.tilesX(0));
+    const int height(m_file.tilesY(0));
+
+    std::vector<float> entries(width * height * 4, -1.f);
+
+    QList<int> layers(m_resident.values());
+    std::sort(layers.begin(), layers.end(), [this](int a, int b)
+        { return m_pages[a].key.level > m_pages[b].key.level; });
+
+    for (const int layer : layers)
+    {
+        const Key & key(m_pages[layer].key);
+
+        const int x0(key.x << key.level);
+        const int y0(key.y << key.level);
+        const int x1(qMin(width,  (key.x + 1) << key.level));
+        const int y1(qMin(height, (key.y + 1) << key.level));
+
+        for (int y = y0; y < y1; ++y)
+            for (int x = x0; x < x1; ++x)
+            {
+                float * entry(&entries[(y * width + x) * 4]);
+                entry[0] = static_cast<float>(layer);
+                entry[1] = static_cast<float>(key.level);
+                entry[2] = static_cast<float>(key.x);
+                entry[3] = static_cast<float>(key.y);
+            }
+    }
+
+    gl.glBindTexture(GL_TEXTURE_2D, m_indirection);
+    gl.glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_FLOAT, entries.data());
+    gl.glBindTexture(GL_TEXTURE_2D, 0);
+
+    m_indirectionDirty = false;
+}
+
+void HeightfieldStreamer::bind(
+    OpenGLFunctions & gl
+,   const GLenum tilesUnit
+,   const GLenum indirectionUnit)
+{
+    gl.glActiveTexture(tilesUnit);
+    gl.glBindTexture(GL_TEXTURE_2D_ARRAY, m_tiles);
+
+    gl.glActiveTexture(indirectionUnit);
+    gl.glBindTexture(GL_TEXTURE_2D, m_indirection);
+}
+
+void HeightfieldStreamer::release(
+    OpenGLFunctions & gl
+,   const GLenum tilesUnit
+,   const GLenum indirectionUnit)
+{
+    gl.glActiveTexture(indirectionUnit);
+    gl.glBindTexture(GL_TEXTURE_2D, 0);
+
+    gl.glActiveTexture(tilesUnit);
+    gl.glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void HeightfieldStreamer::setUniforms(
+    QOpenGLShaderProgram & program
+,   const int tilesUnit
+,   const int indirectionUnit) const
+{
+    program.setUniformValue("heightTiles", tilesUnit);
+    program.setUniformValue("heightIndirection", indirectionUnit);
+
+    program.setUniformValue("heightSize"
+        , QVector2D(static_cast<float>(m_file.width()), static_cast<float>(m_file.height())));
+    program.setUniformValue("heightTileSize"
+        , QVector2D(static_cast<float>(m_file.tileSize()), static_cast<float>(m_file.pageSize())));
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QVector2D>
+
+#include "OpenGLFunctions.h"
+#include "TiledImageFile.h"
+#include "TileLoader.h"
+
+class QOpenGLShaderProgram;
+
+/** Streams the tiles of a (memory mapped) TiledImageFile height field that
+    are required around the camera into a fixed size GPU tile cache.
+
+    The cache is a 2D texture array with one page (tile plus border) per
+    layer. An indirection texture with one texel per tile of level 0 refers
+    to the finest resident tile covering that cell (layer, level, tile x and
+    y), so the vertex shader can resolve a height with one fetch plus one
+    filtered lookup (see streamedHeight in data/terrain_streamed.vert).
+
+    Each update, tiles within range of the eye are requested for each level
+    (coarse first, then by distance), copied from the mapping by a loader
+    thread, and uploaded with a bounded number of glTexSubImage3D calls per
+    frame. The coarsest tile stays resident, and the least recently required
+    tiles are evicted first. RAM is bound by the pages the OS keeps mapped
+    plus a few in flight tiles, VRAM by the cache size.
+*/
+class HeightfieldStreamer
+{
+public:
+    HeightfieldStreamer(
+        OpenGLFunctions & gl
+    ,   int cacheTiles = 128);
+    virtual ~HeightfieldStreamer();
+
+    bool open(const QString & filePath);
+    bool isOpen() const;
+
+    const TiledImageFile & file() const;
+
+    /** tiles within range tiles of the eye are requested on each level
+    */
+    void setRange(float range);
+    float range() const;
+
+    /** Requests and uploads tiles around the eye, given in texture space of
+        the height field (i.e., [0;1]^2 covers level 0).
+    */
+    void update(
+        OpenGLFunctions & gl
+    ,   const QVector2D & eye
+    ,   int maxUploads = 4);
+
+    void bind(
+        OpenGLFunctions & gl
+    ,   GLenum tilesUnit
+    ,   GLenum indirectionUnit);
+    void release(
+        OpenGLFunctions & gl
+    ,   GLenum tilesUnit
+    ,   GLenum indirectionUnit);
+
+    /** heightTiles, heightIndirection, heightSize, and heightTileSize
+    */
+    void setUniforms(
+        QOpenGLShaderProgram & program
+    ,   int tilesUnit
+    ,   int indirectionUnit) const;
+
+    int resident() const;
+
+protected:
+    typedef TileLoader::Key Key;
+    typedef TileLoader::Loaded Loaded;
+
+    struct Page
+    {
+        Key key;
+        int lastUsed;
+    };
+
+    void requestTiles(const QVector2D & eye);
+    void uploadTiles(
+        OpenGLFunctions & gl
+    ,   int maxUploads);
+    int allocatePage();
+
+    void updateIndirection(OpenGLFunctions & gl);
+
+protected:
+    OpenGLFunctions & m_gl;
+
+    TiledImageFile m_file;
+    TileLoader * m_loader;
+
+    int m_cacheTiles;
+    float m_range;
+
+    GLuint m_tiles;
+    GLuint m_indirection;
+
+    QList<Page> m_pages;              ///< per layer
+    QHash<quint64, int> m_resident;   ///< key to layer
+    QHash<quint64, float> m_required; ///< key to priority (lower first)
+
+    QList<Loaded> m_uploads;          ///< loaded, but not uploaded yet
+
+    int m_frame;
+    bool m_indirectionDirty;
+};
@@ -113,11 +113,27 @@ void Icosahedron::draw(
 ,   const GLenum mode)
 {
     m_vao->bind();
-    gl.glPointSize(8.f);
+    if (GL_POINTS == mode)
+        gl.glPointSize(8.f);
     gl.glDrawElements(mode, m_size, GL_UNSIGNED_SHORT, nullptr);
     m_vao->release();
 }
 
+void Icosahedron::drawInstanced(
+    OpenGLFunctions & gl
+,   const GLsizei count
+,   const GLenum mode)
+{
+    if (count <= 0)
+        return;
+
+    m_vao->bind();
+    if (GL_POINTS == mode)
+        gl.glPointSize(8.f);
+    gl.glDrawElementsInstanced(mode, m_size, GL_UNSIGNED_SHORT, nullptr, count);
+    m_vao->release();
+}
+
 void Icosahedron::refine(
     std::vector<Icosahedron::vec3> & vertices
 ,   std::vector<Icosahedron::uvec3> & indices
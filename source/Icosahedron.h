@@ -55,6 +55,14 @@ public:
         OpenGLFunctions & gl
     ,   const GLenum mode = GL_TRIANGLES);
 
+    /** draws count instances with a single call, per instance data is expected
+        to be fetched via gl_InstanceID (e.g., from an InstanceBuffer).
+    */
+    void drawInstanced(
+        OpenGLFunctions & gl
+    ,   GLsizei count
+    ,   const GLenum mode = GL_TRIANGLES);
+
 private:
     /** Splits a triangle edge by adding an appropriate new point (normalized
         on sphere) to the points (if not already cached) and returns the index
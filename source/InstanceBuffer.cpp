@@ -0,0 +1,235 @@
+
+#include <cassert>
+#include <cmath>
+
+#include <QVector3D>
+
+#include "OcclusionCuller.h"
+
+#include "InstanceBuffer.h"
+
+
+InstanceBuffer::InstanceBuffer(OpenGLFunctions & gl)
+: m_gl(gl)
+, m_chunksUsed(0)
+, m_instancesPerChunk(0)
+, m_visible(0)
+{
+    GLint maxTexels(0);
+    gl.glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+
+    m_instancesPerChunk = qMax<int>(1, qMax<GLint>(65536, maxTexels) / TexelsPerInstance);
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+    for (Chunk & chunk : m_chunks)
+    {
+        m_gl.glDeleteTextures(1, &chunk.texture);
+        chunk.buffer.destroy();
+    }
+}
+
+void InstanceBuffer::clear()
+{
+    m_instances.clear();
+    m_visible = 0;
+    m_chunksUsed = 0;
+}
+
+int InstanceBuffer::append(
+    const QMatrix4x4 & transform
+,   const QVector4D & material
+,   const float radius)
+{
+    Instance instance;
+    instance.transform = transform;
+    instance.material = material;
+    instance.radius = radius;
+
+    updateBoundingSphere(instance);
+    m_instances.push_back(instance);
+
+    return static_cast<int>(m_instances.size()) - 1;
+}
+
+void InstanceBuffer::setTransform(
+    const int index
+,   const QMatrix4x4 & transform)
+{
+    assert(index >= 0 && index < size());
+
+    m_instances[index].transform = transform;
+    updateBoundingSphere(m_instances[index]);
+}
+
+void InstanceBuffer::setMaterial(
+    const int index
+,   const QVector4D & material)
+{
+    assert(index >= 0 && index < size());
+
+    m_instances[index].material = material;
+}
+
+int InstanceBuffer::size() const
+{
+    return static_cast<int>(m_instances.size());
+}
+
+int InstanceBuffer::visible() const
+{
+    return m_visible;
+}
+
+int InstanceBuffer::chunks() const
+{
+    return m_chunksUsed;
+}
+
+void InstanceBuffer::updateBoundingSphere(Instance & instance)
+{
+    const QMatrix4x4 & T(instance.transform);
+
+    // the largest axis scale bounds the transformed sphere conservatively
+
+    const float sx = T.column(0).toVector3D().length();
+    const float sy = T.column(1).toVector3D().length();
+    const float sz = T.column(2).toVector3D().length();
+
+    const QVector3D center(T.column(3).toVector3DAffine());
+
+    instance.sphere = QVector4D(center, instance.radius * qMax(sx, qMax(sy, sz)));
+}
+
+int InstanceBuffer::cull(
+    const QMatrix4x4 & viewProjection
+,   const OcclusionCuller * occlusion)
+{
+    // Extract the six frustum planes from the view projection (Gribb and
+    // Hartmann) and normalize them, so that the plane equation yields the
+    // signed distance that is compared against the sphere radius.
+
+    QVector4D planes[6] =
+    {
+        viewProjection.row(3) + viewProjection.row(0)
+    ,   viewProjection.row(3) - viewProjection.row(0)
+    ,   viewProjection.row(3) + viewProjection.row(1)
+    ,   viewProjection.row(3) - viewProjection.row(1)
+    ,   viewProjection.row(3) + viewProjection.row(2)
+    ,   viewProjection.row(3) - viewProjection.row(2)
+    };
+
+    for (int p = 0; p < 6; ++p)
+        planes[p] /= planes[p].toVector3D().length();
+
+    m_staging.clear();
+    m_staging.reserve(m_instances.size() * TexelsPerInstance * 4);
+
+    m_visible = 0;
+    m_chunksUsed = 0;
+
+    for (const Instance & instance : m_instances)
+    {
+        const QVector4D & s(instance.sphere);
+
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; ++p)
+            inside = planes[p].x() * s.x() + planes[p].y() * s.y()
+                + planes[p].z() * s.z() + planes[p].w() >= -s.w();
+
+        if (!inside)
+            continue;
+
+        if (occlusion && !occlusion->visible(
+            s.toVector3D() - QVector3D(s.w(), s.w(), s.w())
+        ,   s.toVector3D() + QVector3D(s.w(), s.w(), s.w())))
+            continue;
+
+        // QMatrix4x4 stores its data column-major, matching the texel order.
+
+        const float * transform(instance.transform.constData());
+        m_staging.insert(m_staging.end(), transform, transform + 16);
+
+        m_staging.push_back(instance.material.x());
+        m_staging.push_back(instance.material.y());
+        m_staging.push_back(instance.material.z());
+        m_staging.push_back(instance.material.w());
+
+        ++m_visible;
+    }
+
+    if (0 == m_visible)
+        return 0;
+
+    m_chunksUsed = (m_visible + m_instancesPerChunk - 1) / m_instancesPerChunk;
+
+    while (static_cast<int>(m_chunks.size()) < m_chunksUsed)
+    {
+        Chunk chunk;
+        chunk.buffer = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+        chunk.buffer.create();
+        chunk.buffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+        chunk.capacity = 0;
+        chunk.count = 0;
+
+        // The buffer object is referenced by a buffer texture, so reallocating its
+        // data store later does not require the texture to be updated.
+
+        m_gl.glGenTextures(1, &chunk.texture);
+        m_gl.glBindTexture(GL_TEXTURE_BUFFER, chunk.texture);
+        m_gl.glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, chunk.buffer.bufferId());
+        m_gl.glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+        m_chunks.push_back(chunk);
+    }
+
+    for (int i = 0; i < m_chunksUsed; ++i)
+    {
+        const int first(i * m_instancesPerChunk);
+        upload(m_chunks[i], m_staging.data() + first * TexelsPerInstance * 4
+            , qMin(m_instancesPerChunk, m_visible - first));
+    }
+    return m_visible;
+}
+
+void InstanceBuffer::upload(
+    Chunk & chunk
+,   const float * data
+,   const int count)
+{
+    const int bytes(count * TexelsPerInstance * 4 * static_cast<int>(sizeof(float)));
+
+    chunk.buffer.bind();
+    if (bytes > chunk.capacity)
+    {
+        chunk.buffer.allocate(data, bytes);
+        chunk.capacity = bytes;
+    }
+    else
+        chunk.buffer.write(0, data, bytes);
+    chunk.buffer.release();
+
+    chunk.count = count;
+}
+
+int InstanceBuffer::bind(
+    OpenGLFunctions & gl
+,   const GLenum textureUnit
+,   const int chunk)
+{
+    assert(chunk >= 0 && chunk < m_chunksUsed);
+
+    gl.glActiveTexture(textureUnit);
+    gl.glBindTexture(GL_TEXTURE_BUFFER, m_chunks[chunk].texture);
+
+    return m_chunks[chunk].count;
+}
+
+void InstanceBuffer::release(
+    OpenGLFunctions & gl
+,   const GLenum textureUnit)
+{
+    gl.glActiveTexture(textureUnit);
+    gl.glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
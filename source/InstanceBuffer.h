@@ -0,0 +1,117 @@
+#pragma once
+
+#include <vector>
+
+#include <QMatrix4x4>
+#include <QVector4D>
+#include <QOpenGLBuffer>
+
+#include "OpenGLFunctions.h"
+
+class OcclusionCuller;
+
+/** Per-instance transforms and materials for instanced drawing.
+
+    All instances are kept on the CPU and culled against the view frustum by
+    their bounding spheres. Only the visible ones are packed into a texture
+    buffer of RGBA32F texels (four transform columns followed by one material
+    texel per instance), which the vertex shader fetches using gl_InstanceID.
+    The draw call count thus stays constant, regardless of the instance count.
+
+    A buffer texture is limited to GL_MAX_TEXTURE_BUFFER_SIZE texels (only
+    65536 are guaranteed), so the visible instances are split into chunks
+    of at most that size, each with its own buffer texture and draw call.
+*/
+class InstanceBuffer
+{
+public:
+    static const int TexelsPerInstance = 5;
+
+public:
+    InstanceBuffer(OpenGLFunctions & gl);
+    virtual ~InstanceBuffer();
+
+    void clear();
+
+    /** Adds an instance and returns its index. The radius refers to the
+        bounding sphere of the instanced mesh in its own model space.
+    */
+    int append(
+        const QMatrix4x4 & transform
+    ,   const QVector4D & material
+    ,   float radius = 1.f);
+
+    void setTransform(
+        int index
+    ,   const QMatrix4x4 & transform);
+    void setMaterial(
+        int index
+    ,   const QVector4D & material);
+
+    int size() const;
+
+    /** number of instances that survived the last cull
+    */
+    int visible() const;
+
+    /** number of chunks the visible instances are split into
+    */
+    int chunks() const;
+
+    /** Tests all instances against the frustum of the given view projection
+        (and the occlusion culler, if given) and uploads the visible ones.
+        Returns the number of visible instances.
+    */
+    int cull(
+        const QMatrix4x4 & viewProjection
+    ,   const OcclusionCuller * occlusion = nullptr);
+
+    /** Binds the buffer texture of the given chunk and returns the number
+        of instances it holds, i.e., the instance count to draw.
+    */
+    int bind(
+        OpenGLFunctions & gl
+    ,   GLenum textureUnit
+    ,   int chunk = 0);
+    void release(
+        OpenGLFunctions & gl
+    ,   GLenum textureUnit);
+
+protected:
+    struct Instance
+    {
+        QMatrix4x4 transform;
+        QVector4D material;
+
+        float radius;    ///< model space bounding sphere radius
+        QVector4D sphere; ///< world space bounding sphere (xyz center, w radius)
+    };
+
+    struct Chunk
+    {
+        QOpenGLBuffer buffer;
+        GLuint texture;
+
+        int capacity; ///< allocated bytes
+        int count;    ///< instances uploaded by the last cull
+    };
+
+    static void updateBoundingSphere(Instance & instance);
+
+    void upload(
+        Chunk & chunk
+    ,   const float * data
+    ,   int count);
+
+protected:
+    OpenGLFunctions & m_gl;
+
+    std::vector<Instance> m_instances;
+    std::vector<float> m_staging;
+
+    std::vector<Chunk> m_chunks;
+    int m_chunksUsed;
+
+    int m_instancesPerChunk;
+    int m_visible;
+};
@@ -0,0 +1,174 @@
+#include <algorithm>
+
+#include "Model.h"
+
+
+Model::Model(OpenGLFunctions & gl)
+: m_gl(gl)
+, m_front(-1)
+, m_hasPending(false)
+, m_allocated(false)
+, m_uploaded(0)
+{
+    gl.glGenVertexArrays(2, m_vaos);
+    gl.glGenBuffers(2, m_vertices);
+    gl.glGenBuffers(2, m_indices);
+
+    // the attribute layout is the same for both sets of buffers
+
+    const GLsizei stride(ModelLoader::VertexComponents * sizeof(float));
+
+    for (int i = 0; i < 2; ++i)
+    {
+        gl.glBindVertexArray(m_vaos[i]);
+        gl.glBindBuffer(GL_ARRAY_BUFFER, m_vertices[i]);
+
+        gl.glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, nullptr);
+        gl.glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void *>(3 * sizeof(float)));
+        gl.glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void *>(6 * sizeof(float)));
+        gl.glEnableVertexAttribArray(0);
+        gl.glEnableVertexAttribArray(1);
+        gl.glEnableVertexAttribArray(2);
+
+        gl.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indices[i]);
+    }
+    gl.glBindVertexArray(0);
+    gl.glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+Model::~Model()
+{
+    m_gl.glDeleteVertexArrays(2, m_vaos);
+    m_gl.glDeleteBuffers(2, m_vertices);
+    m_gl.glDeleteBuffers(2, m_indices);
+}
+
+void Model::setGeometry(const ModelLoader::Geometry & geometry)
+{
+    m_pending = geometry;
+    m_hasPending = !geometry.isNull();
+    m_allocated = false;
+    m_uploaded = 0;
+}
+
+int Model::upload(
+    OpenGLFunctions & gl
+,   const int maxBytes)
+{
+    if (!m_hasPending)
+        return 0;
+
+    const int back(m_front < 0 ? 0 : 1 - m_front);
+
+    const size_t vertexBytes(m_pending.vertexBytes());
+    const size_t indexBytes(m_pending.indexBytes());
+
+    // binding the index buffer affects the bound vertex array
+    gl.glBindVertexArray(m_vaos[back]);
+    gl.glBindBuffer(GL_ARRAY_BUFFER, m_vertices[back]);
+
+    if (!m_allocated)
+    {
+        gl.glBufferData(GL_ARRAY_BUFFER, vertexBytes, nullptr, GL_STATIC_DRAW);
+        gl.glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, nullptr, GL_STATIC_DRAW);
+        m_allocated = true;
+    }
+
+    size_t budget(static_cast<size_t>(qMax(1, maxBytes)));
+    int uploaded(0);
+
+    if (m_uploaded < vertexBytes)
+    {
+        const size_t bytes(std::min(budget, vertexBytes - m_uploaded));
+        gl.glBufferSubData(GL_ARRAY_BUFFER, m_uploaded, bytes
+            , reinterpret_cast<const char *>(m_pending.vertexData()) + m_uploaded);
+
+        m_uploaded += bytes;
+        budget -= bytes;
+        uploaded += static_cast<int>(bytes);
+    }
+
+    if (budget > 0 && m_uploaded >= vertexBytes && m_uploaded < vertexBytes + indexBytes)
+    {
+        const size_t offset(m_uploaded - vertexBytes);
+        const size_t bytes(std::min(budget, indexBytes - offset));
+        gl.glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, bytes
+            , reinterpret_cast<const char *>(m_pending.indexData()) + offset);
+
+        m_uploaded += bytes;
+        uploaded += static_cast<int>(bytes);
+    }
+
+    gl.glBindVertexArray(0);
+    gl.glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (m_uploaded < vertexBytes + indexBytes)
+        return uploaded;
+
+    m_front = back;
+    m_parts = m_pending.parts;
+    m_lods = m_pending.lods;
+    m_bounds = m_pending.bounds;
+
+    m_pending = ModelLoader::Geometry();
+    m_hasPending = false;
+    m_allocated = false;
+    m_uploaded = 0;
+
+    return uploaded;
+}
+
+bool Model::isPending() const
+{
+    return m_hasPending;
+}
+
+bool Model::isNull() const
+{
+    return m_front < 0;
+}
+
+const AxisAlignedBoundingBox & Model::bounds() const
+{
+    return m_bounds;
+}
+
+void Model::draw(
+    OpenGLFunctions & gl
+,   DrawBatcher & batcher
+,   const float tolerance)
+{
+    if (m_front < 0)
+        return;
+
+    m_commands.clear();
+
+    for (const ModelLoader::Part & part : m_parts)
+    {
+        int firstIndex(part.firstIndex);
+        int count(part.count);
+
+        // levels are ordered from fine to coarse, with increasing errors
+        for (int i = part.firstLod; i < part.firstLod + part.lodCount; ++i)
+        {
+            if (m_lods[i].error > tolerance)
+                break;
+
+            firstIndex = m_lods[i].firstIndex;
+            count = m_lods[i].count;
+        }
+
+        DrawBatcher::DrawElementsIndirectCommand command;
+        command.count         = static_cast<GLuint>(count);
+        command.instanceCount = 1;
+        command.firstIndex    = static_cast<GLuint>(firstIndex);
+        command.baseVertex    = 0;
+        command.baseInstance  = 0;
+
+        m_commands.push_back(command);
+    }
+
+    gl.glBindVertexArray(m_vaos[m_front]);
+    batcher.submit(gl, m_commands, GL_TRIANGLES);
+    gl.glBindVertexArray(0);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+
+#include "AxisAlignedBoundingBox.h"
+#include "DrawBatcher.h"
+#include "ModelLoader.h"
+#include "OpenGLFunctions.h"
+
+/** GPU side of a loaded model: interleaved vertices (see ModelLoader) and
+    32bit indices, drawn per part.
+
+    Geometry is uploaded straight from the loader's arrays or the mapped
+    cache (see ModelCacheFile). New geometry is uploaded into a second set of
+    buffers in bounded chunks (see upload), while the previous geometry is
+    still drawn. The buffers are swapped once the upload is complete, thus a
+    reload never stalls a frame and never shows partial geometry.
+*/
+class Model
+{
+public:
+    Model(OpenGLFunctions & gl);
+    virtual ~Model();
+
+    /** replaces the geometry pending for upload (if any)
+    */
+    void setGeometry(const ModelLoader::Geometry & geometry);
+
+    /** Uploads up to maxBytes of the pending geometry and returns the bytes
+        uploaded. Buffers are swapped when the upload completes.
+    */
+    int upload(
+        OpenGLFunctions & gl
+    ,   int maxBytes);
+
+    /** true while geometry waits for (or is in) upload
+    */
+    bool isPending() const;
+
+    /** true until the first upload completed
+    */
+    bool isNull() const;
+
+    /** of the geometry drawn (model space)
+    */
+    const AxisAlignedBoundingBox & bounds() const;
+
+    /** Draws all parts with the currently bound program (attributes 0, 1,
+        and 2 are position, normal, and texture coordinate). Each part is
+        drawn with its coarsest level of detail whose error is within the
+        tolerance (model space, e.g., the size of a pixel at the model's
+        distance, see Camera::projectedSize). The parts are recorded as
+        indirect commands and submitted at once by the batcher.
+    */
+    void draw(
+        OpenGLFunctions & gl
+    ,   DrawBatcher & batcher
+    ,   float tolerance = 0.f);
+
+protected:
+    OpenGLFunctions & m_gl;
+
+    GLuint m_vaos[2];
+    GLuint m_vertices[2];
+    GLuint m_indices[2];
+    int m_front; ///< buffers drawn, -1 if none
+
+    std::vector<ModelLoader::Part> m_parts;
+    std::vector<ModelLoader::Lod> m_lods;
+    AxisAlignedBoundingBox m_bounds;
+
+    std::vector<DrawBatcher::DrawElementsIndirectCommand> m_commands;
+
+    ModelLoader::Geometry m_pending;
+    bool m_hasPending;
+    bool m_allocated;  ///< back buffers are sized for the pending geometry
+    size_t m_uploaded; ///< bytes of vertices, followed by indices
+};
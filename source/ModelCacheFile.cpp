@@ -0,0 +1,302 @@
+#include <cstring>
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QSaveFile>
+
+#include "ModelCacheFile.h"
+
+
+namespace
+{
+    const char Magic[4] = { 'M', 'D', 'L', 'C' };
+
+    // vertices start page aligned, which is friendly for mapped reads
+    const quint64 VertexAlignment = 4096;
+    const quint64 SectionAlignment = 16;
+
+    const qint64 PageSize = 4096;
+
+    // bytes hashed per call, which takes an int
+    const qint64 HashChunk = 1 << 30;
+
+    quint64 align(
+        const quint64 offset
+    ,   const quint64 alignment)
+    {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    // a section must start after the header, end within the file, and hold
+    // whole elements; the sizes are checked without overflowing the offsets
+    bool validSection(
+        const ModelCacheFile::Section & section
+    ,   const quint64 fileSize
+    ,   const quint64 elementBytes)
+    {
+        return section.offset >= sizeof(ModelCacheFile::Header)
+            && section.offset <= fileSize
+            && section.bytes <= fileSize - section.offset
+            && 0 == section.bytes % elementBytes;
+    }
+
+    template <typename T>
+    void readSection(
+        const uchar * data
+    ,   const ModelCacheFile::Section & section
+    ,   std::vector<T> & target)
+    {
+        target.resize(static_cast<size_t>(section.bytes / sizeof(T)));
+        if (!target.empty())
+            memcpy(target.data(), data, target.size() * sizeof(T));
+    }
+
+    bool writeSection(
+        QSaveFile & file
+    ,   const ModelCacheFile::Section & section
+    ,   const void * data)
+    {
+        if (0 == section.bytes)
+            return true;
+
+        return file.seek(static_cast<qint64>(section.offset))
+            && file.write(reinterpret_cast<const char *>(data), section.bytes) == static_cast<qint64>(section.bytes);
+    }
+}
+
+
+ModelCacheFile::ModelCacheFile()
+: m_data(nullptr)
+{
+    memset(&m_header, 0, sizeof(Header));
+}
+
+ModelCacheFile::~ModelCacheFile()
+{
+    close();
+}
+
+bool ModelCacheFile::open(
+    const QString & filePath
+,   const QByteArray & sourceHash
+,   const QByteArray & settingsHash)
+{
+    close();
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    Header header;
+    if (m_file.read(reinterpret_cast<char *>(&header), sizeof(Header)) != sizeof(Header)
+        || 0 != memcmp(header.magic, Magic, 4) || Version != header.version
+        || ModelLoader::VertexComponents != static_cast<int>(header.vertexComponents)
+        || sourceHash.size() != sizeof(header.sourceHash)
+        || 0 != memcmp(header.sourceHash, sourceHash.constData(), sizeof(header.sourceHash))
+        || settingsHash.size() != sizeof(header.settingsHash)
+        || 0 != memcmp(header.settingsHash, settingsHash.constData(), sizeof(header.settingsHash)))
+    {
+        m_file.close();
+        return false;
+    }
+
+    const quint64 fileSize(static_cast<quint64>(m_file.size()));
+
+    const Section * const sections[] = { &header.vertices, &header.indices
+        , &header.parts, &header.lods, &header.materials, &header.nodes };
+    const quint64 elementBytes[] = { ModelLoader::VertexComponents * sizeof(float), sizeof(GLuint)
+        , sizeof(ModelLoader::Part), sizeof(ModelLoader::Lod), sizeof(ModelLoader::Material), sizeof(ModelLoader::Node) };
+
+    quint64 size(sizeof(Header));
+    for (int i = 0; i < 6; ++i)
+    {
+        if (!validSection(*sections[i], fileSize, elementBytes[i]))
+        {
+            qWarning() << filePath << "is truncated or corrupt.";
+            m_file.close();
+            return false;
+        }
+        size = qMax(size, sections[i]->offset + sections[i]->bytes);
+    }
+
+    m_data = m_file.map(0, static_cast<qint64>(size));
+    if (!m_data)
+    {
+        qWarning() << "Mapping" << filePath << "failed.";
+        m_file.close();
+        return false;
+    }
+
+    m_header = header;
+    return true;
+}
+
+void ModelCacheFile::close()
+{
+    if (m_data)
+        m_file.unmap(m_data);
+    m_data = nullptr;
+
+    if (m_file.isOpen())
+        m_file.close();
+}
+
+bool ModelCacheFile::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+const uchar * ModelCacheFile::section(const Section & section) const
+{
+    return m_data + section.offset;
+}
+
+const void * ModelCacheFile::vertices() const
+{
+    return section(m_header.vertices);
+}
+
+size_t ModelCacheFile::vertexBytes() const
+{
+    return static_cast<size_t>(m_header.vertices.bytes);
+}
+
+const void * ModelCacheFile::indices() const
+{
+    return section(m_header.indices);
+}
+
+size_t ModelCacheFile::indexBytes() const
+{
+    return static_cast<size_t>(m_header.indices.bytes);
+}
+
+void ModelCacheFile::read(
+    const QSharedPointer<ModelCacheFile> & file
+,   ModelLoader::Geometry & geometry)
+{
+    const Header & header(file->m_header);
+
+    readSection(file->section(header.parts), header.parts, geometry.parts);
+    readSection(file->section(header.lods), header.lods, geometry.lods);
+    readSection(file->section(header.materials), header.materials, geometry.materials);
+    readSection(file->section(header.nodes), header.nodes, geometry.nodes);
+
+    geometry.bounds = AxisAlignedBoundingBox();
+    if (header.vertices.bytes > 0)
+    {
+        geometry.bounds.extend(QVector3D(header.llf[0], header.llf[1], header.llf[2]));
+        geometry.bounds.extend(QVector3D(header.urb[0], header.urb[1], header.urb[2]));
+    }
+
+    geometry.vertices.clear();
+    geometry.indices.clear();
+    geometry.cache = file;
+}
+
+void ModelCacheFile::prefault() const
+{
+    // the sum keeps the reads from being optimized away
+    volatile uchar sum(0);
+
+    const qint64 end(static_cast<qint64>(m_header.indices.offset + m_header.indices.bytes));
+    for (qint64 i = static_cast<qint64>(m_header.vertices.offset); i < end; i += PageSize)
+        sum += m_data[i];
+}
+
+bool ModelCacheFile::write(
+    const QString & filePath
+,   const ModelLoader::Geometry & geometry
+,   const QByteArray & sourceHash
+,   const QByteArray & settingsHash)
+{
+    if (sourceHash.size() != sizeof(Header::sourceHash)
+        || settingsHash.size() != sizeof(Header::settingsHash))
+        return false;
+
+    Header header;
+    memset(&header, 0, sizeof(Header));
+
+    memcpy(header.magic, Magic, 4);
+    header.version = Version;
+    header.vertexComponents = ModelLoader::VertexComponents;
+    memcpy(header.sourceHash, sourceHash.constData(), sizeof(header.sourceHash));
+    memcpy(header.settingsHash, settingsHash.constData(), sizeof(header.settingsHash));
+
+    const QVector3D & llf(geometry.bounds.llf());
+    const QVector3D & urb(geometry.bounds.urb());
+    for (int i = 0; i < 3; ++i)
+    {
+        header.llf[i] = llf[i];
+        header.urb[i] = urb[i];
+    }
+
+    header.vertices.offset  = align(sizeof(Header), VertexAlignment);
+    header.vertices.bytes   = geometry.vertexBytes();
+    header.indices.offset   = align(header.vertices.offset + header.vertices.bytes, SectionAlignment);
+    header.indices.bytes    = geometry.indexBytes();
+    header.parts.offset     = align(header.indices.offset + header.indices.bytes, SectionAlignment);
+    header.parts.bytes      = geometry.parts.size() * sizeof(ModelLoader::Part);
+    header.lods.offset      = align(header.parts.offset + header.parts.bytes, SectionAlignment);
+    header.lods.bytes       = geometry.lods.size() * sizeof(ModelLoader::Lod);
+    header.materials.offset = align(header.lods.offset + header.lods.bytes, SectionAlignment);
+    header.materials.bytes  = geometry.materials.size() * sizeof(ModelLoader::Material);
+    header.nodes.offset     = align(header.materials.offset + header.materials.bytes, SectionAlignment);
+    header.nodes.bytes      = geometry.nodes.size() * sizeof(ModelLoader::Node);
+
+    // written to a temporary file first, so that readers never map a partial cache
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qDebug() << "Writing model cache" << filePath << "failed.";
+        return false;
+    }
+
+    const bool written = file.resize(static_cast<qint64>(header.nodes.offset + header.nodes.bytes))
+        && file.write(reinterpret_cast<const char *>(&header), sizeof(Header)) == sizeof(Header)
+        && writeSection(file, header.vertices, geometry.vertexData())
+        && writeSection(file, header.indices, geometry.indexData())
+        && writeSection(file, header.parts, geometry.parts.data())
+        && writeSection(file, header.lods, geometry.lods.data())
+        && writeSection(file, header.materials, geometry.materials.data())
+        && writeSection(file, header.nodes, geometry.nodes.data());
+
+    if (!written)
+        file.cancelWriting();
+
+    if (!file.commit())
+    {
+        qDebug() << "Writing model cache" << filePath << "failed.";
+        return false;
+    }
+    return true;
+}
+
+QString ModelCacheFile::cacheFilePath(const QString & sourceFilePath)
+{
+    return sourceFilePath + ".cache";
+}
+
+QByteArray ModelCacheFile::hash(const QString & sourceFilePath)
+{
+    QFile file(sourceFilePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+
+    // mapped if possible, since sources (e.g., obj files) can be large
+    const qint64 size(file.size());
+    uchar * data(size > 0 ? file.map(0, size) : nullptr);
+    if (data)
+    {
+        for (qint64 offset = 0; offset < size; offset += HashChunk)
+            hash.addData(reinterpret_cast<const char *>(data) + offset, static_cast<int>(qMin(HashChunk, size - offset)));
+        file.unmap(data);
+    }
+    else
+        hash.addData(file.readAll());
+
+    return hash.result();
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include "ModelLoader.h"
+
+/** Memory mapped cache of a model converted by ModelLoader.
+
+    The file starts with a Header, whose sections locate the interleaved
+    vertices, the indices (including the levels of detail), and the parts,
+    levels of detail, materials, and nodes (as stored in
+    ModelLoader::Geometry). Vertices start page aligned, all other sections
+    are 16 byte aligned. The cache is keyed by the source file's content
+    hash and a hash of the post processing flags and importer properties
+    (see ModelLoader::settingsHash), thus edited models or changed
+    settings invalidate it.
+
+    Vertices and indices are never touched per element: they are handed to
+    glBufferSubData straight from the mapping.
+*/
+class ModelCacheFile
+{
+public:
+    struct Section
+    {
+        quint64 offset;
+        quint64 bytes;
+    };
+
+    struct Header
+    {
+        char    magic[4];           ///< "MDLC"
+        quint32 version;
+        quint32 vertexComponents;
+        char    sourceHash[16];     ///< MD5 of the source file
+        char    settingsHash[16];   ///< MD5 of the post processing and importer properties
+        float   llf[3];             ///< bounds of all vertices
+        float   urb[3];
+        Section vertices;
+        Section indices;
+        Section parts;
+        Section lods;
+        Section materials;
+        Section nodes;
+    };
+
+    static const quint32 Version = 3;
+
+public:
+    ModelCacheFile();
+    virtual ~ModelCacheFile();
+
+    /** Maps the cache, if it exists, matches the source and settings hashes
+        and this version of the format, and all sections lie within the file.
+    */
+    bool open(
+        const QString & filePath
+    ,   const QByteArray & sourceHash
+    ,   const QByteArray & settingsHash);
+    void close();
+
+    bool isOpen() const;
+
+    const void * vertices() const;
+    size_t vertexBytes() const;
+
+    const void * indices() const;
+    size_t indexBytes() const;
+
+    /** Copies the (small) parts, levels of detail, materials, nodes, and
+        bounds into geometry and references this file for the vertices and
+        indices.
+    */
+    static void read(
+        const QSharedPointer<ModelCacheFile> & file
+    ,   ModelLoader::Geometry & geometry);
+
+    /** Reads one byte per page of the vertices and indices, so that later
+        uploads do not block on I/O (call on a worker thread).
+    */
+    void prefault() const;
+
+    static bool write(
+        const QString & filePath
+    ,   const ModelLoader::Geometry & geometry
+    ,   const QByteArray & sourceHash
+    ,   const QByteArray & settingsHash);
+
+    /** cache file used for the given model file
+    */
+    static QString cacheFilePath(const QString & sourceFilePath);
+
+    /** MD5 of the file's content, empty if it cannot be read
+    */
+    static QByteArray hash(const QString & sourceFilePath);
+
+protected:
+    const uchar * section(const Section & section) const;
+
+protected:
+    QFile m_file;
+    uchar * m_data;
+
+    Header m_header;
+};
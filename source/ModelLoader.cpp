@@ -0,0 +1,359 @@
+#include <cstring>
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QMutexLocker>
+
+#include <assimp/Importer.hpp>
+#include <assimp/config.h>
+#include <assimp/material.h>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+#include "ModelCacheFile.h"
+
+#include "ModelLoader.h"
+
+
+namespace
+{
+    // importer properties, all part of the cache key (see settingsHash), thus
+    // the level of detail and vertex cache properties are set explicitly
+
+    struct IntProperty
+    {
+        const char * name;
+        int value;
+    };
+
+    struct FloatProperty
+    {
+        const char * name;
+        float value;
+    };
+
+    const IntProperty IntProperties[] =
+    {
+        { AI_CONFIG_PP_SBP_REMOVE, aiPrimitiveType_POINT | aiPrimitiveType_LINE }
+    ,   { AI_CONFIG_PP_PTV_KEEP_HIERARCHY, 1 }
+    ,   { AI_CONFIG_PP_GLOD_LEVELS, PP_GLOD_LEVELS }
+    ,   { AI_CONFIG_PP_OVC_CACHE_SIZE, PP_OVC_CACHE_SIZE }
+    };
+
+    const FloatProperty FloatProperties[] =
+    {
+        { AI_CONFIG_PP_GLOD_RATIO, PP_GLOD_RATIO }
+    ,   { AI_CONFIG_PP_GLOD_MAX_ERROR, PP_GLOD_MAX_ERROR }
+    ,   { AI_CONFIG_PP_OVC_OVERDRAW_THRESHOLD, PP_OVC_OVERDRAW_THRESHOLD }
+    };
+
+    ModelLoader::Material convert(const aiMaterial * source)
+    {
+        ModelLoader::Material material;
+
+        aiColor4D diffuse(0.8f, 0.8f, 0.8f, 1.f);
+        aiColor4D specular(0.f, 0.f, 0.f, 1.f);
+        float shininess(0.f);
+
+        aiGetMaterialColor(source, AI_MATKEY_COLOR_DIFFUSE, &diffuse);
+        aiGetMaterialColor(source, AI_MATKEY_COLOR_SPECULAR, &specular);
+        aiGetMaterialFloatArray(source, AI_MATKEY_SHININESS, &shininess, nullptr);
+
+        const float d[4] = { diffuse.r, diffuse.g, diffuse.b, diffuse.a };
+        const float s[4] = { specular.r, specular.g, specular.b, specular.a };
+        memcpy(material.diffuse, d, sizeof(d));
+        memcpy(material.specular, s, sizeof(s));
+        material.shininess = shininess;
+
+        return material;
+    }
+
+    /** appends the mesh's vertices and a part of its triangles (if any),
+        followed by the part's levels of detail
+    */
+    void append(
+        const aiMesh * mesh
+    ,   ModelLoader::Geometry & geometry)
+    {
+        if (!(mesh->mPrimitiveTypes & aiPrimitiveType_TRIANGLE))
+            return;
+
+        const GLuint base(static_cast<GLuint>(geometry.vertices.size() / ModelLoader::VertexComponents));
+
+        for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
+        {
+            const aiVector3D & position(mesh->mVertices[i]);
+            const aiVector3D normal(mesh->HasNormals() ? mesh->mNormals[i] : aiVector3D(0.f, 1.f, 0.f));
+            const aiVector3D texCoord(mesh->HasTextureCoords(0) ? mesh->mTextureCoords[0][i] : aiVector3D());
+
+            const float vertex[ModelLoader::VertexComponents] = {
+                position.x, position.y, position.z
+            ,   normal.x, normal.y, normal.z
+            ,   texCoord.x, texCoord.y };
+            geometry.vertices.insert(geometry.vertices.end(), vertex, vertex + ModelLoader::VertexComponents);
+
+            geometry.bounds.extend(QVector3D(position.x, position.y, position.z));
+        }
+
+        ModelLoader::Part part;
+        part.firstIndex = static_cast<int>(geometry.indices.size());
+        part.material = static_cast<int>(mesh->mMaterialIndex);
+
+        for (unsigned int f = 0; f < mesh->mNumFaces; ++f)
+        {
+            const aiFace & face(mesh->mFaces[f]);
+            if (3 != face.mNumIndices)
+                continue;
+
+            geometry.indices.push_back(base + face.mIndices[0]);
+            geometry.indices.push_back(base + face.mIndices[1]);
+            geometry.indices.push_back(base + face.mIndices[2]);
+        }
+
+        part.count = static_cast<int>(geometry.indices.size()) - part.firstIndex;
+        if (part.count <= 0)
+            return;
+
+        part.firstLod = static_cast<int>(geometry.lods.size());
+
+        for (unsigned int l = 0; l < mesh->mNumLODs; ++l)
+        {
+            const aiMeshLOD * source(mesh->mLODs[l]);
+
+            ModelLoader::Lod lod;
+            lod.firstIndex = static_cast<int>(geometry.indices.size());
+            lod.error = source->mError;
+
+            for (unsigned int f = 0; f < source->mNumFaces; ++f)
+            {
+                const aiFace & face(source->mFaces[f]);
+                geometry.indices.push_back(base + face.mIndices[0]);
+                geometry.indices.push_back(base + face.mIndices[1]);
+                geometry.indices.push_back(base + face.mIndices[2]);
+            }
+
+            lod.count = static_cast<int>(geometry.indices.size()) - lod.firstIndex;
+            geometry.lods.push_back(lod);
+        }
+
+        part.lodCount = static_cast<int>(geometry.lods.size()) - part.firstLod;
+        geometry.parts.push_back(part);
+    }
+}
+
+
+// Node transforms are baked into the vertices (keeping the hierarchy), thus
+// all meshes share the model's space; points and lines are dropped. Each
+// mesh gets a chain of simplified levels of detail, drawn by distance.
+const unsigned int ModelLoader::PostProcessing = aiProcess_Triangulate
+    | aiProcess_JoinIdenticalVertices
+    | aiProcess_GenSmoothNormals
+    | aiProcess_PreTransformVertices
+    | aiProcess_SortByPType
+    | aiProcess_GenLODs
+    | aiProcess_OptimizeVertexCache;
+
+
+QByteArray ModelLoader::settingsHash()
+{
+    QCryptographicHash hash(QCryptographicHash::Md5);
+
+    hash.addData(reinterpret_cast<const char *>(&PostProcessing), sizeof(PostProcessing));
+    for (const IntProperty & property : IntProperties)
+    {
+        hash.addData(property.name, static_cast<int>(strlen(property.name)) + 1);
+        hash.addData(reinterpret_cast<const char *>(&property.value), sizeof(property.value));
+    }
+    for (const FloatProperty & property : FloatProperties)
+    {
+        hash.addData(property.name, static_cast<int>(strlen(property.name)) + 1);
+        hash.addData(reinterpret_cast<const char *>(&property.value), sizeof(property.value));
+    }
+    return hash.result();
+}
+
+
+bool ModelLoader::Geometry::isNull() const
+{
+    return 0 == indexBytes();
+}
+
+const void * ModelLoader::Geometry::vertexData() const
+{
+    return cache ? cache->vertices() : vertices.data();
+}
+
+size_t ModelLoader::Geometry::vertexBytes() const
+{
+    return cache ? cache->vertexBytes() : vertices.size() * sizeof(float);
+}
+
+const void * ModelLoader::Geometry::indexData() const
+{
+    return cache ? cache->indices() : indices.data();
+}
+
+size_t ModelLoader::Geometry::indexBytes() const
+{
+    return cache ? cache->indexBytes() : indices.size() * sizeof(GLuint);
+}
+
+ModelLoader::ModelLoader()
+: m_stop(false)
+{
+}
+
+ModelLoader::~ModelLoader()
+{
+}
+
+void ModelLoader::request(const QString & filePath)
+{
+    QMutexLocker lock(&m_mutex);
+
+    if (m_pending.contains(filePath))
+        return;
+
+    m_pending << filePath;
+    m_condition.wakeOne();
+}
+
+QList<ModelLoader::Geometry> ModelLoader::take()
+{
+    QMutexLocker lock(&m_mutex);
+
+    const QList<Geometry> loaded(m_loaded);
+    m_loaded.clear();
+
+    return loaded;
+}
+
+void ModelLoader::stop()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_stop = true;
+        m_condition.wakeOne();
+    }
+    wait();
+}
+
+void ModelLoader::run()
+{
+    while (true)
+    {
+        QString filePath;
+        {
+            QMutexLocker lock(&m_mutex);
+            while (!m_stop && m_pending.isEmpty())
+                m_condition.wait(&m_mutex);
+
+            if (m_stop)
+                return;
+
+            filePath = m_pending.takeFirst();
+        }
+
+        const Geometry geometry(load(filePath));
+
+        QMutexLocker lock(&m_mutex);
+        m_loaded << geometry;
+    }
+}
+
+ModelLoader::Geometry ModelLoader::load(const QString & filePath)
+{
+    const QByteArray hash(ModelCacheFile::hash(filePath));
+    const QString cacheFilePath(ModelCacheFile::cacheFilePath(filePath));
+
+    QSharedPointer<ModelCacheFile> cache(new ModelCacheFile());
+    if (!hash.isEmpty() && cache->open(cacheFilePath, hash, settingsHash()))
+    {
+        // the render thread uploads straight from the mapping
+        cache->prefault();
+
+        Geometry geometry;
+        geometry.filePath = filePath;
+        ModelCacheFile::read(cache, geometry);
+
+        return geometry;
+    }
+
+    const Geometry geometry(import(filePath));
+    if (!geometry.isNull() && !hash.isEmpty())
+        ModelCacheFile::write(cacheFilePath, geometry, hash, settingsHash());
+
+    return geometry;
+}
+
+ModelLoader::Geometry ModelLoader::import(const QString & filePath)
+{
+    Geometry geometry;
+    geometry.filePath = filePath;
+
+    Assimp::Importer importer;
+    for (const IntProperty & property : IntProperties)
+        importer.SetPropertyInteger(property.name, property.value);
+    for (const FloatProperty & property : FloatProperties)
+        importer.SetPropertyFloat(property.name, property.value);
+
+    const aiScene * scene(importer.ReadFile(filePath.toLocal8Bit().constData(), PostProcessing));
+    if (!scene)
+    {
+        qWarning() << filePath << "could not be imported:" << importer.GetErrorString();
+        return geometry;
+    }
+
+    size_t vertexCount(0);
+    size_t indexCount(0);
+    for (unsigned int m = 0; m < scene->mNumMeshes; ++m)
+    {
+        const aiMesh * mesh(scene->mMeshes[m]);
+        vertexCount += mesh->mNumVertices;
+        indexCount += mesh->mNumFaces * 3;
+
+        for (unsigned int l = 0; l < mesh->mNumLODs; ++l)
+            indexCount += mesh->mLODs[l]->mNumFaces * 3;
+    }
+
+    geometry.vertices.reserve(vertexCount * VertexComponents);
+    geometry.indices.reserve(indexCount);
+
+    for (unsigned int m = 0; m < scene->mNumMaterials; ++m)
+        geometry.materials.push_back(convert(scene->mMaterials[m]));
+
+    // Nodes are visited depth first, each appending the parts of its meshes,
+    // thus every node's parts are contiguous.
+
+    QList<QPair<const aiNode *, int> > stack;
+    stack << qMakePair(static_cast<const aiNode *>(scene->mRootNode), -1);
+
+    while (!stack.isEmpty())
+    {
+        const QPair<const aiNode *, int> current(stack.takeLast());
+        const aiNode * source(current.first);
+
+        Node node;
+        memset(node.name, 0, sizeof(node.name));
+        strncpy(node.name, source->mName.C_Str(), sizeof(node.name) - 1);
+        node.parent = current.second;
+        node.firstPart = static_cast<int>(geometry.parts.size());
+
+        for (unsigned int m = 0; m < source->mNumMeshes; ++m)
+            append(scene->mMeshes[source->mMeshes[m]], geometry);
+
+        node.partCount = static_cast<int>(geometry.parts.size()) - node.firstPart;
+
+        const int index(static_cast<int>(geometry.nodes.size()));
+        geometry.nodes.push_back(node);
+
+        // reversed, so that the first child is visited next
+        for (unsigned int c = source->mNumChildren; c > 0; --c)
+            stack << qMakePair(static_cast<const aiNode *>(source->mChildren[c - 1]), index);
+    }
+
+    if (geometry.isNull())
+        qWarning() << filePath << "contains no triangles.";
+
+    return geometry;
+}
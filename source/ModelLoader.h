@@ -0,0 +1,142 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <vector>
+
+#include "AxisAlignedBoundingBox.h"
+#include "OpenGLFunctions.h"
+
+class ModelCacheFile;
+
+/** Imports model files with assimp and converts their meshes into GPU ready
+    geometry, all on this thread, so that the render thread only uploads
+    (see FileAssociatedModel).
+
+    Converted geometry is written to a cache file next to the model (see
+    ModelCacheFile). As long as the model's content, the post processing and
+    the importer properties do not change, the cache is mapped instead of importing the model again.
+*/
+class ModelLoader : public QThread
+{
+public:
+    /** position, normal, and texture coordinate (8 floats per vertex)
+    */
+    static const int VertexComponents = 8;
+
+    /** range of indices drawn with a single material, and its simplified
+        levels of detail (see Lod)
+    */
+    struct Part
+    {
+        int firstIndex;
+        int count;
+        int material;
+        int firstLod;
+        int lodCount; ///< levels are ordered from fine to coarse
+    };
+
+    /** Range of indices drawn instead of a part's, using the same vertices.
+        The error is the distance to the part's surface (in model space).
+    */
+    struct Lod
+    {
+        int firstIndex;
+        int count;
+        float error;
+    };
+
+    struct Material
+    {
+        float diffuse[4];
+        float specular[4];
+        float shininess;
+    };
+
+    /** Node of the scene's hierarchy, whose parts are contiguous. Vertices
+        are in model space already, the hierarchy is kept for reference.
+    */
+    struct Node
+    {
+        char name[64]; ///< zero terminated, truncated if longer
+        int parent;    ///< -1 for the root
+        int firstPart;
+        int partCount;
+    };
+
+    /** all meshes of a file, with indices into the shared vertices
+    */
+    struct Geometry
+    {
+        QString filePath;
+
+        std::vector<float> vertices;
+        std::vector<GLuint> indices;
+
+        /** mapped vertices and indices, used instead of the above if set
+        */
+        QSharedPointer<ModelCacheFile> cache;
+
+        std::vector<Part> parts;
+        std::vector<Lod> lods;
+        std::vector<Material> materials;
+        std::vector<Node> nodes; ///< depth first, parents precede children
+
+        AxisAlignedBoundingBox bounds;
+
+        bool isNull() const;
+
+        const void * vertexData() const;
+        size_t vertexBytes() const;
+
+        const void * indexData() const;
+        size_t indexBytes() const;
+    };
+
+    /** assimp post processing applied to all models (part of the cache key)
+    */
+    static const unsigned int PostProcessing;
+
+    /** MD5 of the post processing and the importer properties, which keys
+        the cache besides the model's content
+    */
+    static QByteArray settingsHash();
+
+public:
+    ModelLoader();
+    virtual ~ModelLoader();
+
+    /** queues the file, unless it is pending already
+    */
+    void request(const QString & filePath);
+
+    /** geometry loaded since the last call (null for files that failed)
+    */
+    QList<Geometry> take();
+
+    void stop();
+
+protected:
+    virtual void run();
+
+    /** maps the cache if it is up to date, imports the file otherwise
+    */
+    static Geometry load(const QString & filePath);
+
+    static Geometry import(const QString & filePath);
+
+protected:
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+
+    QStringList m_pending;
+    QList<Geometry> m_loaded;
+    bool m_stop;
+};
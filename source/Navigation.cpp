@@ -8,6 +8,7 @@
 #include "MathMacros.h"
 #include "AbstractCoordinateProvider.h"
 #include "Camera.h"
+#include "Heightfield.h"
 #include "NavigationMath.h"
 
 #include "Navigation.h"
@@ -24,6 +25,8 @@ namespace
     static const float DEFAULT_DIST_MIN   = 0.1f;
     static const float DEFAULT_DIST_MAX   = 4.0f;
 
+    static const float DEFAULT_GROUND_CLEARANCE = 0.05f;
+
     static const float ROTATION_HOR_DOF   = 0.8f * static_cast<float>(PI);
     static const float ROTATION_VER_DOF   = 0.8f * static_cast<float>(PI);
 
@@ -37,6 +40,7 @@ namespace
 Navigation::Navigation(Camera & camera)
 : m_camera(camera)
 , m_coordsProvider(nullptr)
+, m_heightfield(nullptr)
 , m_rotationHappened(false)
 , m_mode(NoInteraction)
 {
@@ -57,6 +61,11 @@ void Navigation::setCoordinateProvider(AbstractCoordinateProvider * provider)
     m_coordsProvider = provider;
 }
 
+void Navigation::setHeightfield(const Heightfield * heightfield)
+{
+    m_heightfield = heightfield;
+}
+
 void Navigation::reset(bool update)
 {
     m_camera.setEye(DEFAULT_EYE);
@@ -105,13 +114,42 @@ const QVector3D Navigation::mouseRayPlaneIntersection(
 const QVector3D Navigation::mouseRayPlaneIntersection(
     bool & intersects
 ,   const QPoint & mouse) const
+{
+    bool valid;
+    return mouseRaySceneIntersection(intersects, valid, mouse);
+}
+
+const QVector3D Navigation::mouseRaySceneIntersection(
+    bool & intersects
+,   bool & valid
+,   const QPoint & mouse) const
 {
     const float depth = m_coordsProvider->depthAt(mouse);
+    valid = NavigationMath::validDepth(depth);
+
+    if (m_heightfield)
+    {
+        // The terrain is intersected exactly on the cpu, whereas other scene
+        // objects are only known by depth. The depth hit is kept if it lies in
+        // front of the terrain (with a small tolerance for depth precision).
+        const QVector3D ln = m_coordsProvider->objAt(mouse, 0.0);
+        const QVector3D lf = m_coordsProvider->objAt(mouse, 1.0);
+
+        QVector3D i;
+        if (m_heightfield->intersect(ln, lf - ln, i) && (!valid
+            || (m_coordsProvider->objAt(mouse, depth) - ln).length() >= 0.99f * (i - ln).length()))
+        {
+            valid = true;
+            intersects = true;
+            return i;
+        }
+    }
 
     // no scene object was picked - simulate picking on xz-plane
-    if (depth >= 1.0 - std::numeric_limits<float>::epsilon())
+    if (!valid)
         return mouseRayPlaneIntersection(intersects, mouse, QVector3D());
 
+    intersects = true;
     return m_coordsProvider->objAt(mouse, depth);
 }
 
@@ -124,8 +162,9 @@ void Navigation::panningBegin(const QPoint & mouse)
     m_viewProjectionInverted = m_camera.viewProjectionInverted();
     
     bool intersects;
-    m_i0 = mouseRayPlaneIntersection(intersects, mouse);
-    m_i0Valid = intersects && NavigationMath::validDepth(m_coordsProvider->depthAt(mouse));
+    bool valid;
+    m_i0 = mouseRaySceneIntersection(intersects, valid, mouse);
+    m_i0Valid = intersects && valid;
 
     m_eye = m_camera.eye();
     m_center = m_camera.center();
@@ -170,6 +209,7 @@ void Navigation::pan(QVector3D t)
     m_camera.setEye(t + m_eye);
     m_camera.setCenter(t + m_center);
 
+    enforceGroundConstraint();
     m_camera.update();
 }
 
@@ -180,8 +220,9 @@ void Navigation::rotatingBegin(const QPoint & mouse)
     m_mode = RotateInteraction;
 
     bool intersects;
-    m_i0 = mouseRayPlaneIntersection(intersects, mouse);
-    m_i0Valid = intersects && NavigationMath::validDepth(m_coordsProvider->depthAt(mouse));
+    bool valid;
+    m_i0 = mouseRaySceneIntersection(intersects, valid, mouse);
+    m_i0Valid = intersects && valid;
 
     m_m0 = mouse;
 
@@ -235,6 +276,7 @@ void Navigation::rotate(
     m_camera.setEye(transform * m_eye);
     m_camera.setCenter(transform * m_center);
 
+    enforceGroundConstraint();
     m_camera.update();
 }
 
@@ -247,10 +289,11 @@ void Navigation::scaleAtMouse(
     const QVector3D lf = m_camera.center();
 
     bool intersects;
+    bool valid;
 
-    QVector3D i = mouseRayPlaneIntersection(intersects, mouse);
+    QVector3D i = mouseRaySceneIntersection(intersects, valid, mouse);
 
-    if(!intersects && !NavigationMath::validDepth(m_coordsProvider->depthAt(mouse)))
+    if(!intersects && !valid)
         return;
 
     // scale the distance between the pointed position in the scene and the 
@@ -270,6 +313,8 @@ void Navigation::scaleAtMouse(
     const QVector3D center = lf + scale * (lf - i);
 
     m_camera.setCenter(NavigationMath::rayPlaneIntersection(intersects, eye, center));
+
+    enforceGroundConstraint();
     m_camera.update();
 }
 
@@ -281,8 +326,9 @@ void Navigation::resetScaleAtMouse(const QPoint & mouse)
     // set the distance between pointed position in the scene and camera to 
     // default distance
     bool intersects;
-    QVector3D i = mouseRayPlaneIntersection(intersects, mouse);
-    if (!intersects && !NavigationMath::validDepth(m_coordsProvider->depthAt(mouse)))
+    bool valid;
+    QVector3D i = mouseRaySceneIntersection(intersects, valid, mouse);
+    if (!intersects && !valid)
         return;
 
     float scale = (DEFAULT_DISTANCE / (ln - i).length());
@@ -292,6 +338,7 @@ void Navigation::resetScaleAtMouse(const QPoint & mouse)
     m_camera.setEye(i - scale * (i - ln));
     m_camera.setCenter(i - scale * (i - lf));
 
+    enforceGroundConstraint();
     m_camera.update();
 }
 
@@ -310,6 +357,7 @@ void Navigation::scaleAtCenter(float scale)
     m_camera.setEye(ln + scale * (ln - i));
     m_camera.setCenter(lf + scale * (lf - i));
 
+    enforceGroundConstraint();
     m_camera.update();
 }
 
@@ -370,6 +418,26 @@ void Navigation::enforceScaleConstraints(
         scale = 0.0;
 }
 
+void Navigation::enforceGroundConstraint()
+{
+    // keep the eye above the height field, lifting center along to retain
+    // the view direction
+
+    if (!m_heightfield)
+        return;
+
+    const QVector3D eye(m_camera.eye());
+
+    float ground;
+    if (!m_heightfield->heightAt(eye, ground) || eye.y() >= ground + DEFAULT_GROUND_CLEARANCE)
+        return;
+
+    const QVector3D lift(0.f, ground + DEFAULT_GROUND_CLEARANCE - eye.y(), 0.f);
+
+    m_camera.setEye(eye + lift);
+    m_camera.setCenter(m_camera.center() + lift);
+}
+
 //void Navigation::enforceWholeMapVisible(const float offset)
 //{
 //    const float h(_swmBounds.urb.y());
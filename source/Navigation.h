@@ -19,6 +19,7 @@ class QWheelEvent;
 
 class AbstractCoordinateProvider;
 class Camera;
+class Heightfield;
 
 
 class Navigation: public QObject
@@ -39,6 +40,11 @@ public:
     void setBoundaryHint(const AxisAlignedBoundingBox & aabb);
     void setCoordinateProvider(AbstractCoordinateProvider * provider);
 
+    /** If set, picking intersects the mouse ray with the height field instead
+        of reading back depth, and the eye is kept above ground.
+    */
+    void setHeightfield(const Heightfield * heightfield);
+
 	virtual void reset(bool update = true);
 
 	// event handling
@@ -80,9 +86,18 @@ protected:
 	void enforceScaleConstraints(
 		float & scale
 	,	QVector3D & i) const;
+	void enforceGroundConstraint();
 
 	// math
 
+    /** Intersection with the scene (height field or depth buffer), or with
+        the xz-plane if nothing was picked (then valid is false).
+    */
+    const QVector3D mouseRaySceneIntersection(
+        bool & intersects
+    ,   bool & valid
+    ,   const QPoint & mouse) const;
+
 	const QVector3D mouseRayPlaneIntersection(
         bool & intersects
     ,   const QPoint & mouse) const;
@@ -101,6 +116,7 @@ protected:
     AxisAlignedBoundingBox m_aabb;
 
     AbstractCoordinateProvider * m_coordsProvider;
+    const Heightfield * m_heightfield;
 
     bool m_rotationHappened;
 	InteractionMode m_mode;
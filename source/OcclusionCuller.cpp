@@ -0,0 +1,222 @@
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include <QVector4D>
+
+#include "AxisAlignedBoundingBox.h"
+
+#include "OcclusionCuller.h"
+
+
+OcclusionCuller::OcclusionCuller()
+: m_pbo(QOpenGLBuffer::PixelPackBuffer)
+, m_captureWidth(0)
+, m_captureHeight(0)
+, m_pending(false)
+, m_culled(0)
+{
+    m_pbo.create();
+    m_pbo.setUsagePattern(QOpenGLBuffer::StreamRead);
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+    m_pbo.destroy();
+}
+
+void OcclusionCuller::capture(
+    OpenGLFunctions & gl
+,   const int width
+,   const int height
+,   const QMatrix4x4 & viewProjection)
+{
+    if (width <= 0 || height <= 0)
+        return;
+
+    m_pbo.bind();
+
+    const int bytes(width * height * static_cast<int>(sizeof(float)));
+    if (width != m_captureWidth || height != m_captureHeight)
+        m_pbo.allocate(bytes);
+
+    // with a pixel pack buffer bound, this returns immediately and the
+    // transfer completes asynchronously (mapped in the next frame's update)
+    gl.glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    gl.glReadPixels(0, 0, width, height, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+
+    m_pbo.release();
+
+    m_captureWidth = width;
+    m_captureHeight = height;
+    m_captureViewProjection = viewProjection;
+    m_pending = true;
+}
+
+void OcclusionCuller::update()
+{
+    m_culled = 0;
+
+    if (!m_pending)
+        return;
+
+    m_pending = false;
+
+    m_pbo.bind();
+    const float * depths(reinterpret_cast<const float *>(m_pbo.map(QOpenGLBuffer::ReadOnly)));
+
+    if (!depths)
+    {
+        m_pbo.release();
+        reset();
+        return;
+    }
+
+    if (m_levels.empty())
+        m_levels.resize(1);
+
+    Level & base(m_levels[0]);
+    base.width = m_captureWidth;
+    base.height = m_captureHeight;
+    base.depths.assign(depths, depths + m_captureWidth * m_captureHeight);
+
+    m_pbo.unmap();
+    m_pbo.release();
+
+    m_viewProjection = m_captureViewProjection;
+
+    buildPyramid();
+}
+
+void OcclusionCuller::reset()
+{
+    m_levels.clear();
+    m_pending = false;
+}
+
+void OcclusionCuller::buildPyramid()
+{
+    // Each level stores the farthest depth of the (up to) 2x2 texels below.
+    // Odd sizes are rounded up and the last row/column is clamped, so every
+    // texel of a level covers its footprint conservatively.
+
+    int levels(1);
+    while (m_levels[levels - 1].width > 1 || m_levels[levels - 1].height > 1)
+    {
+        // levels are reused between frames, so resizing happens rarely
+        if (static_cast<int>(m_levels.size()) <= levels)
+            m_levels.resize(levels + 1);
+
+        const Level & src(m_levels[levels - 1]);
+        Level & level(m_levels[levels]);
+
+        level.width  = std::max(1, (src.width  + 1) / 2);
+        level.height = std::max(1, (src.height + 1) / 2);
+        level.depths.resize(level.width * level.height);
+
+        for (int y = 0; y < level.height; ++y)
+        {
+            const int y0(std::min(y * 2, src.height - 1));
+            const int y1(std::min(y * 2 + 1, src.height - 1));
+
+            for (int x = 0; x < level.width; ++x)
+            {
+                const int x0(std::min(x * 2, src.width - 1));
+                const int x1(std::min(x * 2 + 1, src.width - 1));
+
+                level.depths[y * level.width + x] = std::max(
+                    std::max(src.depths[y0 * src.width + x0], src.depths[y0 * src.width + x1])
+                ,   std::max(src.depths[y1 * src.width + x0], src.depths[y1 * src.width + x1]));
+            }
+        }
+        ++levels;
+    }
+    m_levels.resize(levels);
+}
+
+bool OcclusionCuller::visible(const AxisAlignedBoundingBox & aabb) const
+{
+    return visible(aabb.llf(), aabb.urb());
+}
+
+bool OcclusionCuller::visible(
+    const QVector3D & llf
+,   const QVector3D & urb) const
+{
+    if (m_levels.empty())
+        return true;
+
+    // project the box and retrieve its screen rect and nearest depth
+
+    float minX( FLT_MAX), minY( FLT_MAX), minZ(FLT_MAX);
+    float maxX(-FLT_MAX), maxY(-FLT_MAX);
+
+    for (int i = 0; i < 8; ++i)
+    {
+        const QVector4D corner(
+            i & 1 ? urb.x() : llf.x()
+        ,   i & 2 ? urb.y() : llf.y()
+        ,   i & 4 ? urb.z() : llf.z(), 1.f);
+
+        const QVector4D p(m_viewProjection * corner);
+
+        // boxes intersecting the near plane are not tested
+        if (p.w() <= 1e-6f)
+            return true;
+
+        const float x(p.x() / p.w());
+        const float y(p.y() / p.w());
+        const float z(p.z() / p.w());
+
+        minX = std::min(minX, x); maxX = std::max(maxX, x);
+        minY = std::min(minY, y); maxY = std::max(maxY, y);
+        minZ = std::min(minZ, z);
+    }
+
+    // Boxes outside of the captured view are not known to be occluded. This
+    // is no frustum culling, the current view may differ from the captured.
+    if (maxX < -1.f || minX > 1.f || maxY < -1.f || minY > 1.f)
+        return true;
+
+    const float depth(minZ * 0.5f + 0.5f);
+    if (depth <= 0.f)
+        return true;
+
+    const Level & base(m_levels[0]);
+
+    int x0(static_cast<int>(std::floor((std::max(minX, -1.f) * 0.5f + 0.5f) * base.width)));
+    int x1(static_cast<int>(std::floor((std::min(maxX,  1.f) * 0.5f + 0.5f) * base.width)));
+    int y0(static_cast<int>(std::floor((std::max(minY, -1.f) * 0.5f + 0.5f) * base.height)));
+    int y1(static_cast<int>(std::floor((std::min(maxY,  1.f) * 0.5f + 0.5f) * base.height)));
+
+    x0 = std::max(0, std::min(x0, base.width  - 1));
+    x1 = std::max(0, std::min(x1, base.width  - 1));
+    y0 = std::max(0, std::min(y0, base.height - 1));
+    y1 = std::max(0, std::min(y1, base.height - 1));
+
+    // finest level where the rect spans at most 2x2 texels
+
+    int l(0);
+    while (l + 1 < static_cast<int>(m_levels.size())
+        && ((x1 >> l) - (x0 >> l) > 1 || (y1 >> l) - (y0 >> l) > 1))
+        ++l;
+
+    const Level & level(m_levels[l]);
+
+    float farthest(0.f);
+    for (int y = y0 >> l; y <= std::min(y1 >> l, level.height - 1); ++y)
+        for (int x = x0 >> l; x <= std::min(x1 >> l, level.width - 1); ++x)
+            farthest = std::max(farthest, level.depths[y * level.width + x]);
+
+    if (depth <= farthest)
+        return true;
+
+    ++m_culled;
+    return false;
+}
+
+int OcclusionCuller::culled() const
+{
+    return m_culled;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+
+#include <QMatrix4x4>
+#include <QVector3D>
+#include <QOpenGLBuffer>
+
+#include "OpenGLFunctions.h"
+
+class AxisAlignedBoundingBox;
+
+/** Hierarchical-Z occlusion culling on the CPU.
+
+    After the opaque passes of a frame, capture() reads the depth buffer back
+    into a pixel pack buffer asynchronously. With the next frame, update() maps
+    that buffer and builds a max-depth pyramid from it. visible() then projects
+    an axis-aligned bounding box with the view projection the depth was
+    rendered with, picks the pyramid level where the box covers about 2x2
+    texels, and reports it occluded if its nearest depth lies behind all of
+    the covered texels.
+
+    Since the previous frame's depth is used, newly disoccluded geometry may
+    appear one frame late; this is the usual trade-off for avoiding a stall.
+*/
+class OcclusionCuller
+{
+public:
+    OcclusionCuller();
+    virtual ~OcclusionCuller();
+
+    /** Starts reading back the currently bound framebuffer's depth. The view
+        projection has to be the one used for rendering that depth.
+    */
+    void capture(
+        OpenGLFunctions & gl
+    ,   int width
+    ,   int height
+    ,   const QMatrix4x4 & viewProjection);
+
+    /** Builds the depth pyramid from the last capture (if any).
+    */
+    void update();
+
+    /** invalidates the pyramid, everything is visible until the next update
+    */
+    void reset();
+
+    bool visible(const AxisAlignedBoundingBox & aabb) const;
+    bool visible(
+        const QVector3D & llf
+    ,   const QVector3D & urb) const;
+
+    /** number of boxes reported occluded since the last update
+    */
+    int culled() const;
+
+protected:
+    struct Level
+    {
+        int width;
+        int height;
+        std::vector<float> depths;
+    };
+
+    void buildPyramid();
+
+protected:
+    QOpenGLBuffer m_pbo;
+
+    int m_captureWidth;
+    int m_captureHeight;
+    QMatrix4x4 m_captureViewProjection;
+    bool m_pending;
+
+    std::vector<Level> m_levels;
+    QMatrix4x4 m_viewProjection;
+
+    mutable int m_culled;
+};
@@ -0,0 +1,722 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <random>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OCEAN_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <QDebug>
+#include <QOpenGLContext>
+#include <QOpenGLShaderProgram>
+#include <QRunnable>
+#include <QSurfaceFormat>
+#include <QThread>
+
+#include "Ocean.h"
+
+#ifndef GL_TEXTURE_FETCH_BARRIER_BIT
+#define GL_TEXTURE_FETCH_BARRIER_BIT        0x00000008
+#endif
+#ifndef GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT  0x00000020
+#endif
+#ifndef GL_TEXTURE_UPDATE_BARRIER_BIT
+#define GL_TEXTURE_UPDATE_BARRIER_BIT       0x00000100
+#endif
+
+
+namespace
+{
+    const float Pi = 3.14159265f;
+    const float Gravity = 9.81f;
+
+    // JONSWAP's distance over which the wind blows, in meters
+    const float Fetch = 100000.f;
+
+    // Pierson-Moskowitz constant, the Phillips spectrum is scaled by
+    const float PiersonMoskowitz = 0.0081f;
+
+    // waves running against the wind keep this part of their energy
+    const float AgainstWind = 0.07f;
+
+    // invocations per side of the compute shaders' work groups
+    const int GroupSize = 16;
+
+    class Task : public QRunnable
+    {
+    public:
+        Task(
+            const std::function<void(int, int)> & task
+        ,   const int begin
+        ,   const int end)
+        : m_task(task)
+        , m_begin(begin)
+        , m_end(end)
+        {
+            setAutoDelete(true);
+        }
+
+        virtual void run()
+        {
+            m_task(m_begin, m_end);
+        }
+
+    protected:
+        const std::function<void(int, int)> & m_task;
+        int m_begin;
+        int m_end;
+    };
+
+    /** normalized cosine squared spreading around the wind direction
+    */
+    float spreading(
+        const float kx
+    ,   const float kz
+    ,   const QVector2D & wind)
+    {
+        const float k(std::sqrt(kx * kx + kz * kz));
+        const float speed(wind.length());
+
+        if (k <= 0.f || speed <= 0.f)
+            return 0.f;
+
+        const float cosine((kx * wind.x() + kz * wind.y()) / (k * speed));
+        return 2.f / Pi * cosine * cosine * (cosine < 0.f ? AgainstWind : 1.f);
+    }
+
+    QOpenGLShaderProgram * createComputeProgram(const QString & fileName)
+    {
+        QOpenGLShaderProgram * program(new QOpenGLShaderProgram);
+
+        if (program->addShaderFromSourceFile(QOpenGLShader::Compute, fileName) && program->link())
+            return program;
+
+        delete program;
+        return nullptr;
+    }
+}
+
+
+Ocean::Ocean(
+    OpenGLFunctions & gl
+,   const int size
+,   const float length)
+: m_gl(gl)
+, m_size(size)
+, m_length(length)
+, m_wind(10.f, 4.f)
+, m_spectrum(Jonswap)
+, m_amplitude(1.f)
+, m_choppiness(1.f)
+, m_initialized(false)
+, m_maxAmplitude(0.f)
+, m_displacement(0)
+, m_slope(0)
+, m_dispatchCompute(nullptr)
+, m_bindImageTexture(nullptr)
+, m_memoryBarrier(nullptr)
+, m_spectrumProgram(nullptr)
+, m_fftProgram(nullptr)
+, m_resolveProgram(nullptr)
+, m_amplitudes(0)
+{
+    m_fields[0][0] = m_fields[0][1] = m_fields[1][0] = m_fields[1][1] = 0;
+
+    assert(size >= 4 && 0 == (size & (size - 1)));
+
+    const int n(size * size);
+
+    m_h0re.resize(n);
+    m_h0im.resize(n);
+    m_omega.resize(n);
+
+    for (int f = 0; f < Fields; ++f)
+    {
+        m_re[f].resize(n);
+        m_im[f].resize(n);
+    }
+
+    m_cos.resize(size / 2);
+    m_sin.resize(size / 2);
+    for (int i = 0; i < size / 2; ++i)
+    {
+        m_cos[i] = std::cos(2.f * Pi * i / size);
+        m_sin[i] = std::sin(2.f * Pi * i / size);
+    }
+
+    int bits(0);
+    while ((1 << bits) < size)
+        ++bits;
+
+    m_reversed.resize(size);
+    for (int i = 0; i < size; ++i)
+    {
+        int r(0);
+        for (int b = 0; b < bits; ++b)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        m_reversed[i] = r;
+    }
+
+    m_displacements.resize(n * 4);
+    m_slopes.resize(n * 2);
+
+    m_gl.glGenTextures(1, &m_displacement);
+    m_gl.glBindTexture(GL_TEXTURE_2D, m_displacement);
+
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    m_gl.glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, size, size, 0, GL_RGBA, GL_FLOAT, nullptr);
+
+    m_gl.glGenTextures(1, &m_slope);
+    m_gl.glBindTexture(GL_TEXTURE_2D, m_slope);
+
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    m_gl.glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, size, size, 0, GL_RG, GL_FLOAT, nullptr);
+    m_gl.glGenerateMipmap(GL_TEXTURE_2D); // complete, as required for image access
+
+    m_gl.glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (!initializeCompute())
+        qDebug() << "Compute shaders are not supported, the ocean is transformed on the cpu.";
+}
+
+Ocean::~Ocean()
+{
+    m_pool.waitForDone();
+
+    if (m_displacement)
+        m_gl.glDeleteTextures(1, &m_displacement);
+    if (m_slope)
+        m_gl.glDeleteTextures(1, &m_slope);
+
+    if (m_amplitudes)
+        m_gl.glDeleteTextures(1, &m_amplitudes);
+    if (m_fields[0][0])
+        m_gl.glDeleteTextures(4, &m_fields[0][0]);
+
+    delete m_spectrumProgram;
+    delete m_fftProgram;
+    delete m_resolveProgram;
+}
+
+bool Ocean::initializeCompute()
+{
+    // Compute shaders are not part of the 3.2 core functions, so the entry
+    // points are resolved manually if the context supports them.
+
+    QOpenGLContext * context(QOpenGLContext::currentContext());
+    assert(context);
+
+    const QSurfaceFormat format(context->format());
+    const bool core43 = format.majorVersion() > 4
+        || (format.majorVersion() == 4 && format.minorVersion() >= 3);
+
+    if (!(core43 || context->hasExtension("GL_ARB_compute_shader"))
+        || !QOpenGLShader::hasOpenGLShaders(QOpenGLShader::Compute))
+        return false;
+
+    m_dispatchCompute = reinterpret_cast<DISPATCHCOMPUTEPROC>(
+        context->getProcAddress("glDispatchCompute"));
+    m_bindImageTexture = reinterpret_cast<BINDIMAGETEXTUREPROC>(
+        context->getProcAddress("glBindImageTexture"));
+    m_memoryBarrier = reinterpret_cast<MEMORYBARRIERPROC>(
+        context->getProcAddress("glMemoryBarrier"));
+
+    if (!m_dispatchCompute || !m_bindImageTexture || !m_memoryBarrier)
+        return false;
+
+    m_spectrumProgram = createComputeProgram("data/ocean_spectrum.comp");
+    m_fftProgram = createComputeProgram("data/ocean_fft.comp");
+    m_resolveProgram = createComputeProgram("data/ocean_resolve.comp");
+
+    if (!m_spectrumProgram || !m_fftProgram || !m_resolveProgram)
+    {
+        delete m_spectrumProgram;
+        delete m_fftProgram;
+        delete m_resolveProgram;
+
+        m_spectrumProgram = m_fftProgram = m_resolveProgram = nullptr;
+        return false;
+    }
+
+    m_gl.glGenTextures(1, &m_amplitudes);
+    m_gl.glGenTextures(4, &m_fields[0][0]);
+
+    for (int i = 0; i < 5; ++i)
+    {
+        m_gl.glBindTexture(GL_TEXTURE_2D, 0 == i ? m_amplitudes : m_fields[(i - 1) / 2][(i - 1) % 2]);
+
+        m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        m_gl.glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, m_size, m_size, 0, GL_RGBA, GL_FLOAT, nullptr);
+    }
+    m_gl.glBindTexture(GL_TEXTURE_2D, 0);
+
+    return true;
+}
+
+void Ocean::setWind(const QVector2D & wind)
+{
+    m_wind = wind;
+    m_initialized = false;
+}
+
+const QVector2D & Ocean::wind() const
+{
+    return m_wind;
+}
+
+void Ocean::setSpectrum(const Spectrum spectrum)
+{
+    m_spectrum = spectrum;
+    m_initialized = false;
+}
+
+Ocean::Spectrum Ocean::spectrum() const
+{
+    return m_spectrum;
+}
+
+void Ocean::setAmplitude(const float amplitude)
+{
+    m_amplitude = amplitude;
+    m_initialized = false;
+}
+
+float Ocean::amplitude() const
+{
+    return m_amplitude;
+}
+
+void Ocean::setChoppiness(const float choppiness)
+{
+    m_choppiness = choppiness;
+}
+
+float Ocean::choppiness() const
+{
+    return m_choppiness;
+}
+
+int Ocean::size() const
+{
+    return m_size;
+}
+
+float Ocean::length() const
+{
+    return m_length;
+}
+
+bool Ocean::computed() const
+{
+    return m_fftProgram != nullptr;
+}
+
+QVector3D Ocean::maxDisplacement()
+{
+    if (!m_initialized)
+        initialize();
+
+    // the horizontal displacements scale each wave by at most |k_x| / |k|
+    const float horizontal(std::fabs(m_choppiness) * m_maxAmplitude);
+
+    return QVector3D(horizontal, m_maxAmplitude, horizontal);
+}
+
+float Ocean::phillips(
+    const float kx
+,   const float kz) const
+{
+    const float k2(kx * kx + kz * kz);
+    if (k2 <= 0.f)
+        return 0.f;
+
+    // largest wave arising from the wind, and suppression of much smaller ones
+    const float L(m_wind.lengthSquared() / Gravity);
+    const float l(L * 0.001f);
+
+    return PiersonMoskowitz * 0.5f / (k2 * k2) * std::exp(-1.f / (k2 * L * L)) * std::exp(-k2 * l * l)
+        * spreading(kx, kz, m_wind);
+}
+
+float Ocean::jonswap(
+    const float kx
+,   const float kz) const
+{
+    const float k(std::sqrt(kx * kx + kz * kz));
+    const float U(m_wind.length());
+    if (k <= 0.f || U <= 0.f)
+        return 0.f;
+
+    const float omega(std::sqrt(Gravity * k));
+
+    const float alpha(0.076f * std::pow(U * U / (Fetch * Gravity), 0.22f));
+    const float peak(22.f * std::pow(Gravity * Gravity / (U * Fetch), 1.f / 3.f));
+
+    const float sigma(omega <= peak ? 0.07f : 0.09f);
+    const float r(std::exp(-(omega - peak) * (omega - peak) / (2.f * sigma * sigma * peak * peak)));
+
+    const float S(alpha * Gravity * Gravity / std::pow(omega, 5.f)
+        * std::exp(-1.25f * std::pow(peak / omega, 4.f)) * std::pow(3.3f, r));
+
+    // from frequency to (2D) wave number: S(k) = S(omega) domega/dk / k
+    return S * Gravity / (2.f * omega) / k * spreading(kx, kz, m_wind);
+}
+
+void Ocean::initialize()
+{
+    // the same random numbers are used for each spectrum and wind
+    std::mt19937 generator(1337);
+    std::normal_distribution<float> gaussian;
+
+    const int N(m_size);
+    const float dk(2.f * Pi / m_length);
+
+    m_maxAmplitude = 0.f;
+
+    for (int m = 0; m < N; ++m)
+        for (int n = 0; n < N; ++n)
+        {
+            const float kx((n - N / 2) * dk);
+            const float kz((m - N / 2) * dk);
+
+            const float P(m_amplitude * (Jonswap == m_spectrum ? jonswap(kx, kz) : phillips(kx, kz)));
+            const float a(std::sqrt(P * dk * dk * 0.5f));
+
+            const int i(m * N + n);
+            m_h0re[i] = gaussian(generator) * a;
+            m_h0im[i] = gaussian(generator) * a;
+
+            m_omega[i] = std::sqrt(Gravity * std::sqrt(kx * kx + kz * kz));
+
+            // |h(k, t)| <= |h0(k)| + |h0(-k)|, so each h0 is counted twice
+            m_maxAmplitude += 2.f * std::sqrt(m_h0re[i] * m_h0re[i] + m_h0im[i] * m_h0im[i]);
+        }
+
+    if (computed())
+    {
+        std::vector<float> amplitudes(N * N * 4);
+        for (int i = 0; i < N * N; ++i)
+        {
+            amplitudes[i * 4 + 0] = m_h0re[i];
+            amplitudes[i * 4 + 1] = m_h0im[i];
+            amplitudes[i * 4 + 2] = m_omega[i];
+            amplitudes[i * 4 + 3] = 0.f;
+        }
+
+        m_gl.glBindTexture(GL_TEXTURE_2D, m_amplitudes);
+        m_gl.glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, N, N, GL_RGBA, GL_FLOAT, amplitudes.data());
+        m_gl.glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    m_initialized = true;
+}
+
+void Ocean::update(const float time)
+{
+    if (!m_initialized)
+        initialize();
+
+    if (computed())
+    {
+        compute(time);
+        return;
+    }
+
+    // spectra, FFT along y, transpose, FFT along x (results stay transposed)
+
+    parallel([this, time](int y0, int y1) { evaluate(y0, y1, time); });
+    parallel([this](int x0, int x1) { transformColumns(x0, x1); });
+    parallel([this](int y0, int y1) { transpose(y0, y1); });
+    parallel([this](int x0, int x1) { transformColumns(x0, x1); });
+    parallel([this](int y0, int y1) { gather(y0, y1); });
+
+    m_gl.glBindTexture(GL_TEXTURE_2D, m_displacement);
+    m_gl.glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_size, m_size, GL_RGBA, GL_FLOAT, m_displacements.data());
+
+    m_gl.glBindTexture(GL_TEXTURE_2D, m_slope);
+    m_gl.glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_size, m_size, GL_RG, GL_FLOAT, m_slopes.data());
+    m_gl.glGenerateMipmap(GL_TEXTURE_2D);
+
+    m_gl.glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Ocean::compute(const float time)
+{
+    const GLuint groups(static_cast<GLuint>((m_size + GroupSize - 1) / GroupSize));
+
+    m_spectrumProgram->bind();
+    m_spectrumProgram->setUniformValue("time", time);
+    m_spectrumProgram->setUniformValue("tileLength", m_length);
+    m_spectrumProgram->setUniformValue("choppiness", m_choppiness);
+
+    m_bindImageTexture(0, m_amplitudes, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+    m_bindImageTexture(1, m_fields[0][0], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    m_bindImageTexture(2, m_fields[0][1], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    m_dispatchCompute(groups, groups, 1);
+
+    m_spectrumProgram->release();
+
+    // all stages along x, then along y, ping ponging between the field pairs
+
+    int bits(0);
+    while ((1 << bits) < m_size)
+        ++bits;
+
+    int source(0);
+
+    m_fftProgram->bind();
+    for (int pass = 0; pass < 2 * bits; ++pass)
+    {
+        m_memoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+        m_fftProgram->setUniformValue("stage", pass % bits);
+        m_fftProgram->setUniformValue("vertical", static_cast<GLint>(pass >= bits));
+
+        m_bindImageTexture(0, m_fields[source][0], 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+        m_bindImageTexture(1, m_fields[source][1], 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+        m_bindImageTexture(2, m_fields[1 - source][0], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+        m_bindImageTexture(3, m_fields[1 - source][1], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+        m_dispatchCompute(groups, groups, 1);
+
+        source = 1 - source;
+    }
+    m_fftProgram->release();
+
+    m_memoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+    m_resolveProgram->bind();
+
+    m_bindImageTexture(0, m_fields[source][0], 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+    m_bindImageTexture(1, m_fields[source][1], 0, GL_FALSE, 0, GL_READ_ONLY, GL_RGBA32F);
+    m_bindImageTexture(2, m_displacement, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    m_bindImageTexture(3, m_slope, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG32F);
+    m_dispatchCompute(groups, groups, 1);
+
+    m_resolveProgram->release();
+
+    // the textures are sampled next, after the slopes' mip levels are derived
+    m_memoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    m_gl.glBindTexture(GL_TEXTURE_2D, m_slope);
+    m_gl.glGenerateMipmap(GL_TEXTURE_2D);
+    m_gl.glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Ocean::evaluate(
+    const int y0
+,   const int y1
+,   const float time)
+{
+    const int N(m_size);
+    const float dk(2.f * Pi / m_length);
+
+    for (int m = y0; m < y1; ++m)
+        for (int n = 0; n < N; ++n)
+        {
+            const int i(m * N + n);
+            const int j(((N - m) % N) * N + (N - n) % N); // -k
+
+            // h(k, t) = h0(k) e^(i w t) + conj(h0(-k)) e^(-i w t)
+
+            const float c(std::cos(m_omega[i] * time));
+            const float s(std::sin(m_omega[i] * time));
+
+            const float hr((m_h0re[i] + m_h0re[j]) * c - (m_h0im[i] + m_h0im[j]) * s);
+            const float hi((m_h0re[i] - m_h0re[j]) * s + (m_h0im[i] - m_h0im[j]) * c);
+
+            const float kx((n - N / 2) * dk);
+            const float kz((m - N / 2) * dk);
+            const float k(std::sqrt(kx * kx + kz * kz));
+
+            // Pairs of real fields are packed as a + i b, with b's spectrum
+            // multiplied by i: (height, dh/dx = i kx h), (x, z = -i k / |k| h
+            // times choppiness), and (dh/dz = i kz h, -).
+
+            m_re[0][i] = hr - kx * hr;
+            m_im[0][i] = hi - kx * hi;
+
+            const float p(k > 0.f ? m_choppiness * kz / k : 0.f);
+            const float q(k > 0.f ? m_choppiness * kx / k : 0.f);
+            m_re[1][i] = hr * p + hi * q;
+            m_im[1][i] = hi * p - hr * q;
+
+            m_re[2][i] = -kz * hi;
+            m_im[2][i] =  kz * hr;
+        }
+}
+
+void Ocean::transformColumns(
+    const int x0
+,   const int x1)
+{
+    const int N(m_size);
+
+    for (int f = 0; f < Fields; ++f)
+    {
+        float * re(m_re[f].data());
+        float * im(m_im[f].data());
+
+        for (int y = 0; y < N; ++y)
+        {
+            const int r(m_reversed[y]);
+            if (r <= y)
+                continue;
+
+            std::swap_ranges(re + y * N + x0, re + y * N + x1, re + r * N + x0);
+            std::swap_ranges(im + y * N + x0, im + y * N + x1, im + r * N + x0);
+        }
+    }
+
+    // radix-2 butterflies (inverse, thus positive exponent), each on a whole
+    // row range, which vectorizes over the columns
+
+    for (int half = 1; half < N; half *= 2)
+    {
+        const int step(N / (2 * half));
+
+        for (int start = 0; start < N; start += 2 * half)
+            for (int k = 0; k < half; ++k)
+            {
+                const float wr(m_cos[k * step]);
+                const float wi(m_sin[k * step]);
+
+                for (int f = 0; f < Fields; ++f)
+                {
+                    float * ar(m_re[f].data() + (start + k) * N);
+                    float * ai(m_im[f].data() + (start + k) * N);
+                    float * br(ar + half * N);
+                    float * bi(ai + half * N);
+
+                    int x(x0);
+#ifdef OCEAN_SSE2
+                    const __m128 wr4(_mm_set1_ps(wr));
+                    const __m128 wi4(_mm_set1_ps(wi));
+
+                    for (; x + 4 <= x1; x += 4)
+                    {
+                        const __m128 vbr(_mm_loadu_ps(br + x));
+                        const __m128 vbi(_mm_loadu_ps(bi + x));
+                        const __m128 var(_mm_loadu_ps(ar + x));
+                        const __m128 vai(_mm_loadu_ps(ai + x));
+
+                        const __m128 tr(_mm_sub_ps(_mm_mul_ps(wr4, vbr), _mm_mul_ps(wi4, vbi)));
+                        const __m128 ti(_mm_add_ps(_mm_mul_ps(wr4, vbi), _mm_mul_ps(wi4, vbr)));
+
+                        _mm_storeu_ps(br + x, _mm_sub_ps(var, tr));
+                        _mm_storeu_ps(bi + x, _mm_sub_ps(vai, ti));
+                        _mm_storeu_ps(ar + x, _mm_add_ps(var, tr));
+                        _mm_storeu_ps(ai + x, _mm_add_ps(vai, ti));
+                    }
+#endif
+                    for (; x < x1; ++x)
+                    {
+                        const float tr(wr * br[x] - wi * bi[x]);
+                        const float ti(wr * bi[x] + wi * br[x]);
+
+                        br[x] = ar[x] - tr;
+                        bi[x] = ai[x] - ti;
+                        ar[x] += tr;
+                        ai[x] += ti;
+                    }
+                }
+            }
+    }
+}
+
+void Ocean::transpose(
+    const int y0
+,   const int y1)
+{
+    const int N(m_size);
+
+    for (int f = 0; f < Fields; ++f)
+    {
+        float * re(m_re[f].data());
+        float * im(m_im[f].data());
+
+        for (int y = y0; y < y1; ++y)
+            for (int x = y + 1; x < N; ++x)
+            {
+                std::swap(re[y * N + x], re[x * N + y]);
+                std::swap(im[y * N + x], im[x * N + y]);
+            }
+    }
+}
+
+void Ocean::gather(
+    const int y0
+,   const int y1)
+{
+    const int N(m_size);
+
+    for (int y = y0; y < y1; ++y)
+        for (int x = 0; x < N; ++x)
+        {
+            // the spectra are centered at N / 2, which flips every other sign
+            const float sign((x + y) & 1 ? -1.f : 1.f);
+            const int t(x * N + y); // transposed
+
+            float * displacement(&m_displacements[(y * N + x) * 4]);
+            displacement[0] = sign * m_re[1][t];
+            displacement[1] = sign * m_re[0][t];
+            displacement[2] = sign * m_im[1][t];
+            displacement[3] = 0.f;
+
+            float * slope(&m_slopes[(y * N + x) * 2]);
+            slope[0] = sign * m_im[0][t];
+            slope[1] = sign * m_re[2][t];
+        }
+}
+
+void Ocean::parallel(const std::function<void(int, int)> & task)
+{
+    // ranges are multiples of four, so that rows stay aligned for SSE2
+
+    const int threads(qMax(1, qMin(QThread::idealThreadCount(), m_size / 4)));
+    const int range(((m_size + threads - 1) / threads + 3) & ~3);
+
+    for (int begin = range; begin < m_size; begin += range)
+        m_pool.start(new Task(task, begin, qMin(begin + range, m_size)));
+
+    // the first range is processed by this thread
+    task(0, qMin(range, m_size));
+
+    m_pool.waitForDone();
+}
+
+void Ocean::bind(
+    OpenGLFunctions & gl
+,   const GLenum displacementUnit
+,   const GLenum slopeUnit)
+{
+    gl.glActiveTexture(displacementUnit);
+    gl.glBindTexture(GL_TEXTURE_2D, m_displacement);
+
+    gl.glActiveTexture(slopeUnit);
+    gl.glBindTexture(GL_TEXTURE_2D, m_slope);
+}
+
+void Ocean::release(
+    OpenGLFunctions & gl
+,   const GLenum displacementUnit
+,   const GLenum slopeUnit)
+{
+    gl.glActiveTexture(slopeUnit);
+    gl.glBindTexture(GL_TEXTURE_2D, 0);
+
+    gl.glActiveTexture(displacementUnit);
+    gl.glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <QThreadPool>
+#include <QVector2D>
+#include <QVector3D>
+
+#include "OpenGLFunctions.h"
+
+class QOpenGLShaderProgram;
+
+/** Spectral ocean after Tessendorf: wave amplitudes are drawn once from a
+    Phillips or JONSWAP spectrum, advanced in time by the deep water
+    dispersion relation, and transformed by inverse 2D FFTs into a size x size
+    tile of heights, choppy horizontal displacements, and slopes, which
+    repeats every length meters.
+
+    Real fields are packed in pairs into complex ones, so three transforms
+    yield all five. With GL 4.3 or ARB_compute_shader (resolved at runtime,
+    as the sandbox uses the 3.2 core functions), the spectra, the radix-2
+    stages of both dimensions, and the unpacking run as compute shaders
+    (data/ocean_*.comp) writing the textures directly. Otherwise the FFTs run
+    on the CPU: radix-2 butterflies work on whole rows at once (four columns
+    per SSE2 instruction where available), the columns are split among a
+    thread pool, and the second dimension is transformed after a transpose.
+
+    Per update, the displacement texture (RGBA32F: x, height, z) and the
+    slope texture (RG32F: dh/dx, dh/dz, mipmapped) are written; see the
+    ocean branch of data/terrain_1_4.vert and .frag.
+*/
+class Ocean
+{
+public:
+    enum Spectrum
+    {
+        Phillips
+    ,   Jonswap
+    };
+
+public:
+    /** size has to be a power of two
+    */
+    Ocean(
+        OpenGLFunctions & gl
+    ,   int size = 256
+    ,   float length = 256.f);
+    virtual ~Ocean();
+
+    /** direction and speed in m/s
+    */
+    void setWind(const QVector2D & wind);
+    const QVector2D & wind() const;
+
+    void setSpectrum(Spectrum spectrum);
+    Spectrum spectrum() const;
+
+    /** scales the spectrum's energy (1 yields the physical one)
+    */
+    void setAmplitude(float amplitude);
+    float amplitude() const;
+
+    /** scales the horizontal displacements (0 yields plain height waves)
+    */
+    void setChoppiness(float choppiness);
+    float choppiness() const;
+
+    int size() const;
+    float length() const;
+
+    /** true if the transforms run as compute shaders
+    */
+    bool computed() const;
+
+    /** Bounds the absolute displacements (x, height, z) in meters for all
+        times: no sum of the waves exceeds the sum of their amplitudes.
+    */
+    QVector3D maxDisplacement();
+
+    /** evaluates the spectrum at time (in seconds), transforms, and uploads
+    */
+    void update(float time);
+
+    void bind(
+        OpenGLFunctions & gl
+    ,   GLenum displacementUnit
+    ,   GLenum slopeUnit);
+    void release(
+        OpenGLFunctions & gl
+    ,   GLenum displacementUnit
+    ,   GLenum slopeUnit);
+
+protected:
+    /** the spectrum's (initial) amplitudes, after changing its parameters
+    */
+    void initialize();
+
+    float phillips(
+        float kx
+    ,   float kz) const;
+    float jonswap(
+        float kx
+    ,   float kz) const;
+
+    /** packs the rows [y0;y1) of the time dependent spectra
+    */
+    void evaluate(
+        int y0
+    ,   int y1
+    ,   float time);
+
+    /** inverse FFT along y of the columns [x0;x1) of all fields
+    */
+    void transformColumns(
+        int x0
+    ,   int x1);
+
+    /** swaps the rows [y0;y1) with the corresponding columns of all fields
+    */
+    void transpose(
+        int y0
+    ,   int y1);
+
+    /** interleaves the rows [y0;y1) of the results for uploading
+    */
+    void gather(
+        int y0
+    ,   int y1);
+
+    /** runs task on disjoint ranges covering [0;size), in parallel
+    */
+    void parallel(const std::function<void(int, int)> & task);
+
+    /** compiles the compute programs if supported, returns false otherwise
+    */
+    bool initializeCompute();
+
+    void compute(float time);
+
+protected:
+    typedef void (APIENTRY * DISPATCHCOMPUTEPROC) (
+        GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+    typedef void (APIENTRY * BINDIMAGETEXTUREPROC) (
+        GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+    typedef void (APIENTRY * MEMORYBARRIERPROC) (GLbitfield barriers);
+
+    static const int Fields = 3; ///< (height, dh/dx), (x, z), (dh/dz, -)
+
+    OpenGLFunctions & m_gl;
+
+    int m_size;
+    float m_length;
+
+    QVector2D m_wind;
+    Spectrum m_spectrum;
+    float m_amplitude;
+    float m_choppiness;
+    bool m_initialized;
+
+    std::vector<float> m_h0re;   ///< h0(k)
+    std::vector<float> m_h0im;
+    std::vector<float> m_omega;  ///< dispersion per k
+
+    float m_maxAmplitude;        ///< sum of |h(k, t)| bounds, for all t
+
+    std::vector<float> m_re[Fields];
+    std::vector<float> m_im[Fields];
+
+    std::vector<float> m_cos;    ///< twiddles, size / 2
+    std::vector<float> m_sin;
+    std::vector<int> m_reversed; ///< bit reversed row indices
+
+    std::vector<float> m_displacements;
+    std::vector<float> m_slopes;
+
+    GLuint m_displacement;
+    GLuint m_slope;
+
+    QThreadPool m_pool;
+
+    DISPATCHCOMPUTEPROC m_dispatchCompute;
+    BINDIMAGETEXTUREPROC m_bindImageTexture;
+    MEMORYBARRIERPROC m_memoryBarrier;
+
+    QOpenGLShaderProgram * m_spectrumProgram;
+    QOpenGLShaderProgram * m_fftProgram;
+    QOpenGLShaderProgram * m_resolveProgram;
+
+    GLuint m_amplitudes;          ///< h0 and dispersion (RGBA32F)
+    GLuint m_fields[2][2];        ///< ping pong pairs of (fields01, fields2)
+};
@@ -1,12 +1,33 @@
 
 #include <cassert>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 #include <QKeyEvent>
+#include <QFileInfo>
+#include <QImage>
+#include <QRect>
+#include <QRegion>
+#include <QSet>
+#include <QStringList>
 
 #include "Terrain.h"
 #include "Icosahedron.h"
+#include "InstanceBuffer.h"
+#include "DrawBatcher.h"
+#include "OcclusionCuller.h"
+#include "HeightfieldStreamer.h"
+#include "Heightfield.h"
+#include "TessellatedTerrain.h"
+#include "ClipmapTerrain.h"
+#include "VirtualTexture.h"
+#include "Ocean.h"
+#include "CascadedShadowMap.h"
 #include "FileAssociatedShader.h"
 #include "FileAssociatedTexture.h"
+#include "FileAssociatedModel.h"
+#include "Model.h"
 #include "Camera.h"
 #include "Canvas.h"
 
@@ -18,6 +39,9 @@ namespace
 {
     const int CubeMapSize        = 256;
 
+    const int TerrainSize        = 256;
+    const int TerrainTiles       = 8; // per side
+
     const int EnvMapProgram      = AbstractPainter::PaintMode9 + 2;
     const int EnvMapCubeProgram  = AbstractPainter::PaintMode9 + 3;
 
@@ -27,8 +51,85 @@ namespace
     //const int TerrainProgram     = AbstractPainter::PaintMode9 + 6;
     const int TerrainCubeProgram = AbstractPainter::PaintMode9 + 7;
     const int WaterCubeProgram = AbstractPainter::PaintMode9 + 42;
+
+    const int SphereInstancedProgram = AbstractPainter::PaintMode9 + 8;
+    const int TerrainDepthProgram    = AbstractPainter::PaintMode9 + 9;
+    const int TerrainTessProgram     = AbstractPainter::PaintMode9 + 10;
+    const int TerrainClipmapProgram  = AbstractPainter::PaintMode9 + 11;
+    const int VirtualFeedbackProgram = AbstractPainter::PaintMode9 + 12;
+    const int TerrainShadowProgram   = AbstractPainter::PaintMode9 + 13;
+    const int SphereShadowProgram    = AbstractPainter::PaintMode9 + 14;
+    const int ModelProgram           = AbstractPainter::PaintMode9 + 15;
+    const int SphereCubeShadowProgram = AbstractPainter::PaintMode9 + 16;
+
+    const int FragmentReportFrames = 60;
+
+    // patches per side of the tessellated terrain, and the targeted edge
+    // length of its triangles in pixels
+    const int TerrainPatches = 32;
+    const float TessellationPixelsPerEdge = 8.f;
+
+    // texels per side of the cpu side height field, at most
+    const int MaxHeightfieldSize = 2048;
+
+    // brush radius in texels and height change per stroke (see sculpt)
+    const float SculptRadius = 12.f;
+    const float SculptStrength = 0.01f;
+
+    // texels per side and meters covered by an ocean tile, tiles per side of
+    // the water plane, and exaggeration of the ocean's heights (see Ocean)
+    const int OceanSize = 256;
+    const float OceanLength = 256.f;
+    const float OceanRepeat = 8.f;
+    const float OceanHeightScale = 8.f;
     // const int OtherProgram = AbstractPainter::PaintMode9 + 2;
     // ...
+
+    // texture units of the streamed height field (see HeightfieldStreamer)
+    const int HeightTilesUnit       = 9;
+    const int HeightIndirectionUnit = 10;
+
+    // texture unit of the geometry clipmap's levels (see ClipmapTerrain)
+    const int ClipmapUnit = 11;
+
+    // texture unit of the ground atlas' layers (see getOrCreate2DArray)
+    const int GroundLayersUnit = 12;
+
+    // texture units of the virtual ground texture (see VirtualTexture)
+    const int VirtualPagesUnit = 13;
+    const int VirtualTableUnit = 14;
+
+    // texture unit of the shadow cascades (see CascadedShadowMap)
+    const int ShadowMapUnit = 15;
+
+    // fragment shaders calling shadowing(), which is linked from data/shadowing.frag
+    const QStringList ShadowReceivers(QStringList()
+        << "data/sphere_instanced.frag" << "data/sphere_cube.frag" << "data/terrain_1_4_1.frag"
+        << "data/terrain_array.frag" << "data/terrain_virtual.frag");
+
+    // direction of the (directional) light, and the shadow resolutions cycled through
+    const QVector3D LightDirection(-1.f, -1.f, -0.5f);
+    const int MinShadowResolution = 512;
+    const int MaxShadowResolution = 4096;
+
+    // size of the (optional) model drawn at the reflecting sphere's center
+    const float ModelSize = 0.5f;
+
+    // error (in pixels) of the model's levels of detail tolerated on screen
+    const float ModelLodPixels = 1.f;
+
+    /** Prefers raw 32bit float or 16bit height fields over height.png (which
+        might be a 16bit PNG as well, see getOrCreateHeight2D).
+    */
+    QString heightFilePath()
+    {
+        const QStringList candidates(QStringList() << "data/height.r32" << "data/height.r16");
+        foreach (const QString & candidate, candidates)
+            if (QFileInfo(candidate).exists())
+                return candidate;
+
+        return "data/height.png";
+    }
 }
 
 Painter::Painter()
@@ -36,6 +137,27 @@ Painter::Painter()
 , m_quad(nullptr)
 , m_mapping(CubeMapping)
 , m_icosa(nullptr)
+, m_instances(nullptr)
+, m_instancesPerSide(64)
+, m_batcher(nullptr)
+, m_batched(true)
+, m_occlusion(nullptr)
+, m_occlusionCulling(true)
+, m_depthPrepass(true)
+, m_overdraw(false)
+, m_fragmentFrames(0)
+, m_streamer(nullptr)
+, m_heightfield(new Heightfield())
+, m_patches(nullptr)
+, m_tessellated(true)
+, m_clipmap(nullptr)
+, m_clipmapped(false)
+, m_virtual(nullptr)
+, m_ocean(nullptr)
+, m_oceanWaves(false)
+, m_shadows(nullptr)
+, m_model(nullptr)
+, m_modelLods(true)
 
 , m_cubeFBO(-1)
 , m_cubeTex(-1)
@@ -46,8 +168,23 @@ Painter::Painter()
 Painter::~Painter()
 {
     qDeleteAll(m_terrains);
+    delete m_batcher;
+    delete m_occlusion;
+    delete m_streamer;
+    delete m_heightfield;
+    delete m_patches;
+    delete m_clipmap;
+    delete m_virtual;
+    delete m_ocean;
+    delete m_shadows;
+
+    FileAssociatedModel::clear();
+
+    glDeleteQueries(FragmentPassCount, m_fragmentQueries);
     qDeleteAll(m_programs);
-    qDeleteAll(m_shaders);
+
+    // shaders shared by several programs are listed more than once
+    qDeleteAll(m_shaders.toSet());
 
 
     if (m_cubeFBO != -1)
@@ -61,6 +198,7 @@ Painter::~Painter()
 
     delete m_quad;
     delete m_icosa;
+    delete m_instances;
 
 }
 
@@ -78,16 +216,79 @@ bool Painter::initialize()
     m_transforms[0].scale(16.f, 2.f, 16.f);
     m_transforms[0].translate(-.5f, 0.f, -.5f);
 
-    m_terrains << new Terrain(256, *this);
-    m_terrains << new Terrain(256, *this); // this should give you a plane that you might use as a water plane ;)
+    m_terrains << new Terrain(TerrainSize, *this);
+    m_terrains << new Terrain(TerrainSize, *this); // this should give you a plane that you might use as a water plane ;)
+
+    // The same grid split into tiles, packed into shared buffers for batched
+    // drawing. Terrain and water use the same tiles (with different programs).
+
+    m_batcher = new DrawBatcher(*this);
+
+    std::vector<QVector3D> vertices;
+    std::vector<GLuint> indices;
+
+    for (int z = 0; z < TerrainTiles; ++z)
+        for (int x = 0; x < TerrainTiles; ++x)
+        {
+            Terrain::tile(TerrainSize, TerrainTiles, x, z, vertices, indices);
+            m_tiles << m_batcher->add(vertices, indices);
+        }
+    m_batcher->upload();
 
 
     // Note: You can absolutely modify/paint/change these textures if you like.
-    m_height    = FileAssociatedTexture::getOrCreate2D("data/height.png", *this); // e.g., there is a height2 or use L3DT (see moodle)
+    m_height    = FileAssociatedTexture::getOrCreateHeight2D(heightFilePath(), *this); // e.g., there is a height2 or use L3DT (see moodle)
     m_ground    = FileAssociatedTexture::getOrCreate2D("data/ground.png", *this);
+    m_groundLayers = FileAssociatedTexture::getOrCreate2DArray("data/ground.png", *this, 4);
     m_water     = FileAssociatedTexture::getOrCreate2D("data/water.png", *this);
     m_caustics  = FileAssociatedTexture::getOrCreate2D("data/caustics.png", *this);
 
+    // If a tiled height field exists (see TiledImageFile, convert with
+    // --convert-heightfield), its tiles are streamed around the camera
+    // instead of using the height texture (cube map passes still use it).
+
+    if (QFileInfo("data/height.timf").exists())
+    {
+        m_streamer = new HeightfieldStreamer(*this);
+        if (!m_streamer->open("data/height.timf"))
+        {
+            delete m_streamer;
+            m_streamer = nullptr;
+        }
+    }
+
+    // If a tiled RGBA8 ground texture exists (convert with --convert-texture),
+    // it is used as virtual texture spanning the terrain once, instead of the
+    // repeated ground atlas.
+
+    if (QFileInfo("data/ground.timf").exists())
+    {
+        m_virtual = new VirtualTexture(*this);
+        if (!m_virtual->open("data/ground.timf"))
+        {
+            delete m_virtual;
+            m_virtual = nullptr;
+        }
+    }
+
+    updateHeightfield();
+
+    // tiles hidden behind the terrain (previous frame's depth) are skipped
+    m_occlusion = new OcclusionCuller();
+    updateTileBounds();
+
+    // the clipmap samples the cpu side height field, repeated infinitely
+    m_clipmap = new ClipmapTerrain(*this);
+    m_clipmap->setSource(m_heightfield);
+
+
+    // the virtual ground texture or the ground atlas' tiles as mipmapped
+    // array layers, if available
+    QString terrainFragmentShader("data/terrain_1_4_1.frag");
+    if (m_virtual)
+        terrainFragmentShader = "data/terrain_virtual.frag";
+    else if (m_groundLayers != -1)
+        terrainFragmentShader = "data/terrain_array.frag";
 
     // uebung 1_1
     //m_programs[PaintMode1] = createBasicShaderProgram("data/terrain_1_1.vert", "data/terrain_1_1.frag");
@@ -100,7 +301,46 @@ bool Painter::initialize()
 
     // uebung 1_4 +
     m_programs[PaintMode4] = createBasicShaderProgram("data/terrain_1_4.vert", "data/terrain_1_4.frag");
-    m_programs[PaintMode5] = createBasicShaderProgram("data/terrain_1_4_1.vert", "data/terrain_1_4_1.frag");
+    m_programs[PaintMode5] = createBasicShaderProgram(m_streamer ? "data/terrain_streamed.vert" : "data/terrain_1_4_1.vert"
+        , terrainFragmentShader);
+
+    // records the virtual texture's tiles required by the terrain's fragments
+    if (m_virtual)
+        m_programs[VirtualFeedbackProgram] = createBasicShaderProgram(m_streamer ? "data/terrain_streamed.vert" : "data/terrain_1_4_1.vert"
+            , "data/virtual_feedback.frag");
+
+    // depth only variant of the terrain, to avoid shading occluded fragments
+    m_programs[TerrainDepthProgram] = createBasicShaderProgram(m_streamer ? "data/terrain_depth_streamed.vert" : "data/terrain_depth.vert"
+        , "data/depth.frag");
+
+    // the same for rendering the terrain into the shadow cascades
+    m_programs[TerrainShadowProgram] = createBasicShaderProgram(m_streamer ? "data/terrain_depth_streamed.vert" : "data/terrain_depth.vert"
+        , "data/depth.frag");
+
+    m_shadows = new CascadedShadowMap(*this);
+
+    // With GL 4.0 tessellation, the terrain's triangle density follows the
+    // view (the streamed height field is not supported by this path).
+
+    if (!m_streamer && TessellatedTerrain::supported())
+    {
+        m_programs[TerrainTessProgram] = createBasicShaderProgram("data/terrain_tess.vert"
+            , "data/terrain_tess.tcs", "data/terrain_tess.tes", terrainFragmentShader);
+
+        if (m_programs[TerrainTessProgram]->isLinked())
+            m_patches = new TessellatedTerrain(TerrainPatches, *this);
+    }
+    if (!m_patches)
+        qDebug() << "Tessellation shaders are not supported, the terrain is drawn as fixed grid.";
+
+    m_programs[TerrainClipmapProgram] = createBasicShaderProgram("data/terrain_clipmap.vert", terrainFragmentShader);
+
+    glGenQueries(FragmentPassCount, m_fragmentQueries);
+    for (int i = 0; i < FragmentPassCount; ++i)
+    {
+        m_fragmentQueried[i] = false;
+        m_fragments[i] = 0;
+    }
 
     //m_programs[PaintMode4] = createBasicShaderProgram("data/terrain_1_4.vert", "data/terrain_1_4.frag");
     //m_programs[PaintMode5] = createBasicShaderProgram("data/terrain_1_5.vert", "data/terrain_1_5.frag");
@@ -135,6 +375,27 @@ bool Painter::initialize()
 
     m_transforms << QMatrix4x4(); // 1
 
+    // uebung 2_4 - lots of small spheres drawn with a single instanced call
+
+    m_instances = new InstanceBuffer(*this);
+    m_programs[SphereInstancedProgram] = createBasicShaderProgram("data/sphere_instanced.vert", "data/sphere_instanced.frag");
+    m_programs[SphereShadowProgram] = createBasicShaderProgram("data/sphere_instanced.vert", "data/depth.frag");
+
+    populateInstances(m_instancesPerSide);
+
+    // If a model exists, it is imported on a loader thread (any format assimp
+    // supports, e.g., obj) and appears once uploaded (see FileAssociatedModel).
+
+    if (QFileInfo("data/model.obj").exists())
+    {
+        m_model = FileAssociatedModel::getOrCreate("data/model.obj", *this);
+
+        m_programs[ModelProgram] = createBasicShaderProgram("data/model.vert", "data/model.frag");
+        m_programs[ModelProgram]->bindAttributeLocation("a_normal", 1);
+        m_programs[ModelProgram]->bindAttributeLocation("a_texCoord", 2);
+        m_programs[ModelProgram]->link();
+    }
+
     // uebung 2_3
 
     //m_programs[TerrainProgram] = createBasicShaderProgram("data/terrain.vert", "data/terrain.frag");
@@ -142,7 +403,11 @@ bool Painter::initialize()
     m_waterheights = FileAssociatedTexture::getOrCreate2D("data/waterheights.png", *this);
     m_waternormals = FileAssociatedTexture::getOrCreate2D("data/waternormals.png", *this);
 
+    // replaces the water textures above if enabled (see paint_2_3_water)
+    m_ocean = new Ocean(*this, OceanSize, OceanLength);
+
     m_programs[SphereCubeProgram] = createBasicShaderProgram("data/sphere_cube.vert", "data/sphere_cube.frag");
+    m_programs[SphereCubeShadowProgram] = createBasicShaderProgram("data/default.vert", "data/depth.frag");
     m_programs[EnvMapCubeProgram] = createBasicShaderProgram("data/envmap_cube.vert", "data/envmap_cube.geom", "data/envmap_cube.frag");
 
     // Task_2_3 - ToDo Begin
@@ -244,7 +509,8 @@ void Painter::keyPressEvent(QKeyEvent * event)
         QList<QOpenGLShaderProgram *> programs;
         programs << m_programs[EnvMapProgram]
                  << m_programs[EnvMapCubeProgram]
-                 << m_programs[SphereProgram];
+                 << m_programs[SphereProgram]
+                 << m_programs[SphereInstancedProgram];
                //<< m_programs[...];
         update(programs);
         }
@@ -262,6 +528,97 @@ void Painter::keyPressEvent(QKeyEvent * event)
         m_icosa_center += QVector3D(0.f, 0.f, event->modifiers() && Qt::Key_Shift ? 0.01f : -0.01f);
         update();
         break;
+
+    case Qt::Key_B:
+        m_batched = !m_batched;
+        qDebug() << "Batched terrain tiles:" << m_batched;
+        break;
+
+    case Qt::Key_O:
+        m_occlusionCulling = !m_occlusionCulling;
+        if (!m_occlusionCulling)
+            m_occlusion->reset();
+        qDebug() << "Occlusion culling:" << m_occlusionCulling;
+        break;
+
+    case Qt::Key_C:
+        if (m_heightfield->isNull())
+            break;
+        m_clipmapped = !m_clipmapped;
+        qDebug() << "Geometry clipmap terrain:" << m_clipmapped;
+        break;
+
+    case Qt::Key_L:
+        if (!m_patches)
+            break;
+        m_tessellated = !m_tessellated;
+        qDebug() << "Tessellated terrain:" << m_tessellated;
+        break;
+
+    case Qt::Key_P:
+        m_depthPrepass = !m_depthPrepass;
+        qDebug() << "Terrain depth pre-pass:" << m_depthPrepass;
+        break;
+
+    case Qt::Key_V:
+        // additive overdraw visualization, also reports shaded fragment counts
+        m_overdraw = !m_overdraw;
+        m_fragmentFrames = 0;
+        for (int i = 0; i < FragmentPassCount; ++i)
+            m_fragments[i] = 0;
+
+        if (m_overdraw)
+            glClearColor(0.f, 0.f, 0.f, 0.f);
+        else
+            glClearColor(1.f, 1.f, 1.f, 0.f);
+
+        qDebug() << "Overdraw visualization:" << m_overdraw;
+        update();
+        break;
+
+    case Qt::Key_R:
+    case Qt::Key_F:
+        // raises (R) or lowers (F) the terrain at the center of the view
+        if (!m_heightfield->isNull())
+        {
+            QVector3D hit;
+            if (m_heightfield->intersect(camera()->eye(), camera()->center() - camera()->eye(), hit))
+                sculpt(hit, SculptRadius, Qt::Key_R == event->key() ? SculptStrength : -SculptStrength);
+        }
+        break;
+
+    case Qt::Key_W:
+        m_oceanWaves = !m_oceanWaves;
+        qDebug() << "FFT ocean:" << m_oceanWaves << (m_ocean->computed() ? "(compute shaders)" : "(cpu)");
+
+        // the waves displace the water beyond the textures' bounds
+        updateTileBounds();
+        m_occlusion->reset();
+        break;
+
+    case Qt::Key_S:
+        // cycles through the shadow cascades' count (0 disables shadows),
+        // or with shift, their resolution
+        if (event->modifiers() & Qt::ShiftModifier)
+        {
+            const int resolution(m_shadows->resolution() * 2);
+            m_shadows->setResolution(resolution > MaxShadowResolution ? MinShadowResolution : resolution);
+        }
+        else
+            m_shadows->setCascades((m_shadows->cascades() + 1) % (CascadedShadowMap::MaxCascades + 1));
+        qDebug() << "Shadow cascades:" << m_shadows->cascades() << "of" << m_shadows->resolution() << "texels per side";
+        break;
+
+    case Qt::Key_D:
+        m_modelLods = !m_modelLods;
+        qDebug() << "Model levels of detail:" << m_modelLods;
+        break;
+
+    case Qt::Key_I:
+        // cycle through 16^2 up to 256^2 instances
+        m_instancesPerSide = m_instancesPerSide >= 256 ? 16 : m_instancesPerSide * 2;
+        populateInstances(m_instancesPerSide);
+        break;
     default:
         break;
     }
@@ -281,10 +638,8 @@ QOpenGLShaderProgram * Painter::createBasicShaderProgram(
         QOpenGLShader::Vertex, vertexShaderFileName, *program);
     m_shaders << FileAssociatedShader::getOrCreate(
         QOpenGLShader::Fragment, fragmentShaderFileName, *program);
-    program->bindAttributeLocation("a_vertex", 0);
-    program->link();
 
-    return program;
+    return linkBasicShaderProgram(program, fragmentShaderFileName);
 }
 
 QOpenGLShaderProgram * Painter::createBasicShaderProgram(
@@ -300,6 +655,44 @@ QOpenGLShaderProgram * Painter::createBasicShaderProgram(
         QOpenGLShader::Geometry, geometryShaderFileName, *program);
     m_shaders << FileAssociatedShader::getOrCreate(
         QOpenGLShader::Fragment, fragmentShaderFileName, *program);
+
+    return linkBasicShaderProgram(program, fragmentShaderFileName);
+}
+
+QOpenGLShaderProgram * Painter::createBasicShaderProgram(
+    const QString & vertexShaderFileName
+    , const QString & tessellationControlShaderFileName
+    , const QString & tessellationEvaluationShaderFileName
+    , const QString & fragmentShaderFileName)
+{
+    QOpenGLShaderProgram * program = new QOpenGLShaderProgram();
+
+    m_shaders << FileAssociatedShader::getOrCreate(
+        QOpenGLShader::Vertex, vertexShaderFileName, *program);
+    m_shaders << FileAssociatedShader::getOrCreate(
+        QOpenGLShader::TessellationControl, tessellationControlShaderFileName, *program);
+    m_shaders << FileAssociatedShader::getOrCreate(
+        QOpenGLShader::TessellationEvaluation, tessellationEvaluationShaderFileName, *program);
+    m_shaders << FileAssociatedShader::getOrCreate(
+        QOpenGLShader::Fragment, fragmentShaderFileName, *program);
+
+    return linkBasicShaderProgram(program, fragmentShaderFileName);
+}
+
+QOpenGLShaderProgram * Painter::linkBasicShaderProgram(
+    QOpenGLShaderProgram * program
+    , const QString & fragmentShaderFileName)
+{
+    // Fragment shader objects shared by several programs: their functions are
+    // declared by prototype in the programs' own fragment shaders.
+
+    m_shaders << FileAssociatedShader::getOrCreate(
+        QOpenGLShader::Fragment, "data/overdraw.frag", *program);
+
+    if (ShadowReceivers.contains(fragmentShaderFileName))
+        m_shaders << FileAssociatedShader::getOrCreate(
+            QOpenGLShader::Fragment, "data/shadowing.frag", *program);
+
     program->bindAttributeLocation("a_vertex", 0);
     program->link();
 
@@ -352,6 +745,26 @@ void Painter::update(const QList<QOpenGLShaderProgram *> & programs)
             // GPU, to reduce vertex shader workload. So feel free to modify...
             program->setUniformValue("transform"
                 , camera()->viewProjection() * m_transforms[i == SphereProgram || i == SphereCubeProgram ? 1 : 0]);
+            program->setUniformValue("overdraw", static_cast<GLint>(m_overdraw));
+
+            if (m_streamer && (PaintMode5 == i || TerrainDepthProgram == i || TerrainShadowProgram == i
+                || VirtualFeedbackProgram == i))
+                m_streamer->setUniforms(*program, HeightTilesUnit, HeightIndirectionUnit);
+
+            if (m_virtual && (PaintMode5 == i || TerrainTessProgram == i || TerrainClipmapProgram == i
+                || VirtualFeedbackProgram == i))
+                m_virtual->setUniforms(*program, VirtualPagesUnit, VirtualTableUnit);
+
+            if (TerrainClipmapProgram == i)
+                program->setUniformValue("clipmap", ClipmapUnit);
+
+            if (TerrainTessProgram == i)
+            {
+                program->setUniformValue("modelView", camera()->view() * m_transforms[0]);
+                program->setUniformValue("projection", camera()->projection());
+                program->setUniformValue("pixelsPerEdge", TessellationPixelsPerEdge);
+                program->setUniformValue("roughness", 0.05f);
+            }
 
             switch (i)
             {
@@ -361,6 +774,8 @@ void Painter::update(const QList<QOpenGLShaderProgram *> & programs)
             case PaintMode7:
             case PaintMode6:
             case PaintMode5:
+            case TerrainTessProgram:
+            case TerrainClipmapProgram:
             case PaintMode4:
                 program->setUniformValue("mapping", m_mapping);
                 program->setUniformValue("water",   2);
@@ -373,6 +788,10 @@ void Painter::update(const QList<QOpenGLShaderProgram *> & programs)
                 program->setUniformValue("vpi", camera()->viewProjectionInverted());
             case PaintMode3:
                 program->setUniformValue("ground", 1);
+                program->setUniformValue("groundLayers", GroundLayersUnit);
+            case TerrainDepthProgram:
+            case TerrainShadowProgram:
+            case VirtualFeedbackProgram:
             case PaintMode2:
                 program->setUniformValue("height", 0);
             case PaintMode1:
@@ -475,6 +894,22 @@ void Painter::update(const QList<QOpenGLShaderProgram *> & programs)
 
                 break;
 
+            case SphereInstancedProgram:
+                program->setUniformValue("mapping", m_mapping);
+
+                program->setUniformValue("envmap", 0);
+                program->setUniformValue("cubemap", 1);
+                program->setUniformValue("instances", 2);
+
+                program->setUniformValue("viewProjection", camera()->viewProjection());
+                program->setUniformValue("eye", camera()->eye());
+                break;
+
+            case SphereShadowProgram:
+                // the view projection is set per cascade
+                program->setUniformValue("instances", 2);
+                break;
+
             case TerrainCubeProgram:
                 {
                 program->setUniformValue("height", 0);
@@ -587,6 +1022,37 @@ void Painter::paint(float timef)
 {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    // edits of the height file (the texture is reloaded by the canvas)
+    reloadHeights();
+
+    // builds the depth pyramid from the previous frame's capture
+    m_occlusion->update();
+
+    // eye in texture space of the height field
+    const QVector3D eye(m_transforms[0].inverted() * camera()->eye());
+
+    if (m_streamer)
+        m_streamer->update(*this, QVector2D(eye.x(), eye.z()));
+
+    if (m_clipmapped)
+        m_clipmap->update(QVector2D(eye.x(), eye.z()));
+
+    // evaluates the previous frame's feedback
+    if (m_virtual)
+        m_virtual->update(*this);
+
+    if (m_oceanWaves)
+        m_ocean->update(timef);
+
+    if (m_overdraw)
+    {
+        collectFragments();
+
+        // every shaded fragment adds its (overdraw) color
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+    }
+
     switch (mode())
     {
     case PaintMode1:
@@ -596,6 +1062,7 @@ void Painter::paint(float timef)
     case PaintMode3:
         paint_2_3(timef); break;
     case PaintMode4:
+        paint_2_4(timef); break;
         //paint_1_4(timef); break;
         //case PaintMode5:
         //    paint_1_5(timef); break;
@@ -603,6 +1070,9 @@ void Painter::paint(float timef)
     default:
         break;
     }
+
+    if (m_overdraw)
+        glDisable(GL_BLEND);
 }
 
 // Note: Feel free to remove your old code and start on minor cleanups and refactorings....
@@ -785,6 +1255,7 @@ void Painter::paint_2_1_envmap(
     // Quad, when its vertices z-components are equal to the far plane in NDC.
 
     // ToDo: configure depth state here
+    glEnable(GL_DEPTH_TEST); // the terrain passes disable it
     glDepthFunc(GL_EQUAL);
     glDepthMask(GL_FALSE);
 
@@ -820,13 +1291,22 @@ void Painter::paint_2_2_sphere(
     if (!program->isLinked())
         return;
 
+    // the reflecting sphere of task 2_3 receives shadows (see paint_2_3_shadows)
+    const bool shadowed(SphereCubeProgram == programIndex);
+
     bindEnvMaps(GL_TEXTURE0);
+    if (shadowed)
+        m_shadows->bind(*this, GL_TEXTURE0 + ShadowMapUnit);
 
     program->bind();
     program->setUniformValue("timef", timef);
+    if (shadowed)
+        m_shadows->setUniforms(*program, ShadowMapUnit, m_transforms[1]);
     m_icosa->draw(*this);
     program->release();
 
+    if (shadowed)
+        m_shadows->release(*this, GL_TEXTURE0 + ShadowMapUnit);
     unbindEnvMaps(GL_TEXTURE0);
 }
 
@@ -840,6 +1320,11 @@ void Painter::paint_2_2(float timef)
 void Painter::paint_2_3(float timef)
 {
     // Task_2_3 - ToDo Begin
+
+    // the scene might be rendered offscreen (e.g., with dynamic resolution)
+    GLint pushFramebuffer(0);
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &pushFramebuffer);
+
     glBindFramebuffer(GL_FRAMEBUFFER, m_cubeFBO);
 
     // ToDO: set viewport, clear buffer
@@ -857,17 +1342,31 @@ void Painter::paint_2_3(float timef)
 
     // ..
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, pushFramebuffer);
     glViewport(pushViewPort[ 0 ], pushViewPort[ 1 ], pushViewPort[ 2 ], pushViewPort[ 3 ]);
     // ... set viewport, setup depth test,
 
+    // Opaque passes are drawn front to back: the terrain's depth is laid
+    // out first (optional), then the sphere (usually in front of the
+    // terrain), the terrain, and the envmap quad last, so that the expensive
+    // fragment shaders run only for visible fragments.
+
+    paint_2_3_shadows(false);
+
+    if (m_virtual)
+        paint_2_3_feedback(VirtualFeedbackProgram);
+
+    if (m_depthPrepass && !tessellated() && !m_clipmapped)
+        paint_2_3_depth(TerrainDepthProgram);
+
     glEnable(GL_DEPTH_TEST);
     glActiveTexture(GL_TEXTURE2);
     glDisable(GL_TEXTURE_CUBE_MAP);
     glBindTexture(GL_TEXTURE_CUBE_MAP, m_cubeTex);
 
+    beginFragments(SphereFragments);
     paint_2_2_sphere(SphereCubeProgram, timef);
-    paint_2_1_envmap(EnvMapProgram, timef);
+    endFragments();
 
     glActiveTexture(GL_TEXTURE2);
     glDisable(GL_TEXTURE_CUBE_MAP);
@@ -877,9 +1376,21 @@ void Painter::paint_2_3(float timef)
     // .. draw scene geometry
 
 //    paint_2_3_terrain(TerrainProgram, timef);
+    beginFragments(TerrainFragments);
     paint_2_3_terrain(PaintMode5, timef);
+    endFragments();
+
+    beginFragments(EnvMapFragments);
+    paint_2_1_envmap(EnvMapProgram, timef);
+    endFragments();
+
+    // water is blended and thus no occluder
+    captureOcclusion();
+
     //paint_2_3_water(WaterCubeProgram, timef);
+    beginFragments(WaterFragments);
     paint_2_3_water(PaintMode4, timef);
+    endFragments();
 
     // Task_2_3 - ToDo End
 }
@@ -889,7 +1400,12 @@ void Painter::paint_2_3_terrain(
     const int programIndex
 ,   float timef)
 {
-    QOpenGLShaderProgram * program(m_programs[programIndex]);
+    // the clipmap or the tessellated terrain replace the grid (not for reflections)
+    const bool clipmapped(PaintMode5 == programIndex && m_clipmapped);
+    const bool patched(PaintMode5 == programIndex && tessellated() && !clipmapped);
+
+    QOpenGLShaderProgram * program(m_programs[clipmapped ? TerrainClipmapProgram
+        : (patched ? TerrainTessProgram : programIndex)]);
     Terrain * terrain(m_terrains[0]);
 
     if (!program->isLinked())
@@ -907,11 +1423,67 @@ void Painter::paint_2_3_terrain(
     glEnable(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, m_caustics);
 
+    glActiveTexture(GL_TEXTURE0 + GroundLayersUnit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_groundLayers);
+
+    const bool virtualTextured(m_virtual && PaintMode5 == programIndex);
+    if (virtualTextured)
+        m_virtual->bind(*this, GL_TEXTURE0 + VirtualPagesUnit, GL_TEXTURE0 + VirtualTableUnit);
+
+    const bool streamed(m_streamer && PaintMode5 == programIndex);
+    if (streamed)
+        m_streamer->bind(*this, GL_TEXTURE0 + HeightTilesUnit, GL_TEXTURE0 + HeightIndirectionUnit);
+
+    // with the depth pre-pass, only the nearest fragments pass (early-z)
+    const bool prepassed(m_depthPrepass && PaintMode5 == programIndex && !patched && !clipmapped);
+    if (prepassed)
+    {
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_FALSE);
+    }
+
+    // only the main pass receives shadows, the cascades fit its camera
+    const bool shadowed(PaintMode5 == programIndex);
+    if (shadowed)
+        m_shadows->bind(*this, GL_TEXTURE0 + ShadowMapUnit);
+
     program->bind();
     program->setUniformValue("a_time", timef);
-    terrain->draw(*this);
+    if (shadowed)
+        m_shadows->setUniforms(*program, ShadowMapUnit, m_transforms[0]);
+    if (clipmapped)
+        m_clipmap->draw(*this, *program, GL_TEXTURE0 + ClipmapUnit);
+    else if (patched)
+    {
+        // edge lengths are measured in pixels of the (scaled) rendered image
+        program->setUniformValue("viewport", QVector2D(renderSize().width(), renderSize().height()));
+        m_patches->draw(*this);
+    }
+    else if (m_batched)
+        drawTiles(programIndex);
+    else
+        terrain->draw(*this);
     program->release();
 
+    if (prepassed)
+    {
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LESS);
+    }
+
+    if (shadowed)
+        m_shadows->release(*this, GL_TEXTURE0 + ShadowMapUnit);
+
+    if (streamed)
+        m_streamer->release(*this, GL_TEXTURE0 + HeightTilesUnit, GL_TEXTURE0 + HeightIndirectionUnit);
+
+    if (virtualTextured)
+        m_virtual->release(*this, GL_TEXTURE0 + VirtualPagesUnit, GL_TEXTURE0 + VirtualTableUnit);
+
+    glActiveTexture(GL_TEXTURE0 + GroundLayersUnit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    glActiveTexture(GL_TEXTURE3);
     glBindTexture(GL_TEXTURE_2D, 0);
     glDisable(GL_TEXTURE_2D);
 
@@ -924,6 +1496,172 @@ void Painter::paint_2_3_terrain(
     glDisable(GL_TEXTURE_2D);
 }
 
+void Painter::paint_2_3_depth(const int programIndex)
+{
+    QOpenGLShaderProgram * program(m_programs[programIndex]);
+    Terrain * terrain(m_terrains[0]);
+
+    if (!program->isLinked())
+        return;
+
+    beginFragments(PrepassFragments);
+
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+    if (m_streamer)
+        m_streamer->bind(*this, GL_TEXTURE0 + HeightTilesUnit, GL_TEXTURE0 + HeightIndirectionUnit);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_height);
+
+    program->bind();
+    if (m_batched)
+        drawTiles(programIndex);
+    else
+        terrain->draw(*this);
+    program->release();
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (m_streamer)
+        m_streamer->release(*this, GL_TEXTURE0 + HeightTilesUnit, GL_TEXTURE0 + HeightIndirectionUnit);
+
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+    endFragments();
+}
+
+void Painter::paint_2_3_shadows(const bool instanced)
+{
+    if (0 == m_shadows->cascades())
+        return;
+
+    QOpenGLShaderProgram * terrainProgram(m_programs[TerrainShadowProgram]);
+    QOpenGLShaderProgram * sphereProgram(m_programs[SphereShadowProgram]);
+    QOpenGLShaderProgram * reflectingProgram(m_programs[SphereCubeShadowProgram]);
+    Terrain * terrain(m_terrains[0]);
+
+    // the reflecting sphere (unit icosahedron) is drawn by task 2_3 only
+    const bool reflecting(!instanced && reflectingProgram->isLinked());
+
+    // everything that might cast shadows: the terrain and the spheres on it
+    AxisAlignedBoundingBox casters;
+    for (const AxisAlignedBoundingBox & bounds : m_tileBounds)
+    {
+        casters.extend(bounds.llf());
+        casters.extend(bounds.urb());
+    }
+    if (reflecting)
+    {
+        casters.extend(m_transforms[1] * QVector3D(-1.f, -1.f, -1.f));
+        casters.extend(m_transforms[1] * QVector3D(+1.f, +1.f, +1.f));
+    }
+    m_shadows->update(*camera(), LightDirection, casters);
+
+    // the instances are culled once for all cascades
+    const bool spheres(instanced && sphereProgram->isLinked()
+        && m_instances->cull(m_shadows->casterViewProjection()) > 0);
+
+    if (m_streamer)
+        m_streamer->bind(*this, GL_TEXTURE0 + HeightTilesUnit, GL_TEXTURE0 + HeightIndirectionUnit);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_height);
+
+    m_shadows->begin(*this);
+
+    for (int i = 0; i < m_shadows->cascades(); ++i)
+    {
+        m_shadows->beginCascade(*this, i);
+
+        if (spheres)
+        {
+            glEnable(GL_DEPTH_TEST);
+
+            sphereProgram->bind();
+            sphereProgram->setUniformValue("viewProjection", m_shadows->viewProjection(i));
+            for (int c = 0; c < m_instances->chunks(); ++c)
+                m_icosa->drawInstanced(*this, m_instances->bind(*this, GL_TEXTURE2, c));
+            sphereProgram->release();
+            glActiveTexture(GL_TEXTURE0);
+
+            glDisable(GL_DEPTH_TEST);
+        }
+
+        if (reflecting)
+        {
+            glEnable(GL_DEPTH_TEST);
+
+            reflectingProgram->bind();
+            reflectingProgram->setUniformValue("transform", m_shadows->viewProjection(i) * m_transforms[1]);
+            m_icosa->draw(*this);
+            reflectingProgram->release();
+
+            glDisable(GL_DEPTH_TEST);
+        }
+
+        // the grid is used for the clipmap and tessellated terrain as well
+        if (terrainProgram->isLinked())
+        {
+            terrainProgram->bind();
+            terrainProgram->setUniformValue("transform", m_shadows->viewProjection(i) * m_transforms[0]);
+            if (m_batched)
+                drawTiles(TerrainShadowProgram);
+            else
+                terrain->draw(*this);
+            terrainProgram->release();
+        }
+    }
+
+    m_shadows->end(*this);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (m_streamer)
+        m_streamer->release(*this, GL_TEXTURE0 + HeightTilesUnit, GL_TEXTURE0 + HeightIndirectionUnit);
+
+    if (spheres)
+        m_instances->release(*this, GL_TEXTURE2);
+}
+
+void Painter::paint_2_3_feedback(const int programIndex)
+{
+    QOpenGLShaderProgram * program(m_programs[programIndex]);
+    Terrain * terrain(m_terrains[0]);
+
+    if (!program->isLinked())
+        return;
+
+    // the feedback must not be blended (e.g., by the overdraw visualization)
+    const GLboolean blend(glIsEnabled(GL_BLEND));
+    glDisable(GL_BLEND);
+
+    m_virtual->beginFeedback(*this);
+
+    if (m_streamer)
+        m_streamer->bind(*this, GL_TEXTURE0 + HeightTilesUnit, GL_TEXTURE0 + HeightIndirectionUnit);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_height);
+
+    program->bind();
+    if (m_batched)
+        drawTiles(programIndex);
+    else
+        terrain->draw(*this);
+    program->release();
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (m_streamer)
+        m_streamer->release(*this, GL_TEXTURE0 + HeightTilesUnit, GL_TEXTURE0 + HeightIndirectionUnit);
+
+    m_virtual->endFeedback(*this);
+
+    if (blend)
+        glEnable(GL_BLEND);
+}
+
 void Painter::paint_2_3_water(
     const int programIndex
 ,   float timef)
@@ -948,11 +1686,27 @@ void Painter::paint_2_3_water(
     glEnable(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, m_waternormals);
 
+    const bool ocean(m_oceanWaves && PaintMode4 == programIndex);
+    if (ocean)
+        m_ocean->bind(*this, GL_TEXTURE4, GL_TEXTURE5);
+
     glEnable(GL_BLEND);
     glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
     waterProgram->bind();
     waterProgram->setUniformValue("a_time", timef);
-    water->draw(*this);
+    if (PaintMode4 == programIndex)
+    {
+        // ocean tiles are OceanLength meters wide, the plane has unit size
+        const float scale(1.f / (OceanRepeat * OceanLength));
+
+        waterProgram->setUniformValue("ocean", static_cast<GLint>(ocean));
+        waterProgram->setUniformValue("oceanRepeat", OceanRepeat);
+        waterProgram->setUniformValue("oceanScale", QVector2D(scale, scale * OceanHeightScale));
+    }
+    if (m_batched)
+        drawTiles(programIndex);
+    else
+        water->draw(*this);
     waterProgram->release();
     glDisable(GL_BLEND);
 
@@ -978,3 +1732,499 @@ void Painter::paint_2_3_water(
     glDisable(GL_TEXTURE_2D);
 }
 
+void Painter::populateInstances(const int count)
+{
+    // Place count x count spheres on a jittered grid over the terrain, each
+    // resting on the height field (cpu side copy of the height map).
+
+    const FileAssociatedTexture::Heights height(FileAssociatedTexture::heights(
+        QFileInfo(heightFilePath()).absoluteFilePath()));
+
+    m_instances->clear();
+
+    for (int z = 0; z < count; ++z)
+        for (int x = 0; x < count; ++x)
+        {
+            // cheap deterministic hash in [0;1] for jitter, size, and tint
+            const float h0 = std::fabs(std::sin(x * 12.9898f + z * 78.233f));
+            const float h1 = std::fabs(std::sin(x * 39.3467f + z * 11.135f));
+
+            const float s = (x + 0.25f + 0.5f * h0) / count;
+            const float t = (z + 0.25f + 0.5f * h1) / count;
+
+            float y = 0.f;
+            if (!height.isNull())
+            {
+                const int px = qBound(0, static_cast<int>(s * height.size.width()), height.size.width() - 1);
+                const int py = qBound(0, static_cast<int>(t * height.size.height()), height.size.height() - 1);
+                y = height.at(px, py);
+            }
+
+            const float scale = (0.5f + 0.5f * h0) * 2.f / count;
+            const QVector3D position(m_transforms[0] * QVector3D(s, y, t));
+
+            QMatrix4x4 transform;
+            transform.translate(position + QVector3D(0.f, scale, 0.f));
+            transform.scale(scale);
+
+            m_instances->append(transform
+                , QVector4D(0.6f + 0.4f * h1, 0.8f, 0.6f + 0.4f * h0, h1), 1.f);
+        }
+}
+
+void Painter::paint_2_4_instances(
+    const int programIndex
+,   float timef)
+{
+    QOpenGLShaderProgram * program(m_programs[programIndex]);
+
+    if (!program->isLinked())
+        return;
+
+    // only the instances intersecting the view frustum and not hidden behind
+    // the terrain are uploaded and drawn
+    if (0 == m_instances->cull(camera()->viewProjection()
+        , m_occlusionCulling ? m_occlusion : nullptr))
+        return;
+
+    bindEnvMaps(GL_TEXTURE0);
+    m_shadows->bind(*this, GL_TEXTURE0 + ShadowMapUnit);
+
+    program->bind();
+    m_shadows->setUniforms(*program, ShadowMapUnit, QMatrix4x4());
+    for (int c = 0; c < m_instances->chunks(); ++c)
+        m_icosa->drawInstanced(*this, m_instances->bind(*this, GL_TEXTURE2, c));
+    program->release();
+
+    m_shadows->release(*this, GL_TEXTURE0 + ShadowMapUnit);
+    m_instances->release(*this, GL_TEXTURE2);
+    unbindEnvMaps(GL_TEXTURE0);
+}
+
+void Painter::paint_2_4_model(const int programIndex)
+{
+    if (!m_model || m_model->isNull() || !m_programs[programIndex]->isLinked())
+        return;
+
+    QOpenGLShaderProgram * program(m_programs[programIndex]);
+
+    // fits the model's bounds into a sphere of ModelSize diameter
+    const AxisAlignedBoundingBox & bounds(m_model->bounds());
+
+    QMatrix4x4 model;
+    model.translate(m_icosa_center);
+    model.scale(0.5f * ModelSize / qMax(bounds.radius(), 1e-6f));
+    model.translate(-bounds.center());
+
+    // the bounds' diameter covers that many pixels, thus a pixel covers
+    // diameter / pixels in model space
+    float tolerance(0.f);
+    if (m_modelLods)
+    {
+        const float pixels(camera()->projectedSize(m_icosa_center, 0.5f * ModelSize));
+        tolerance = ModelLodPixels * 2.f * bounds.radius() / qMax(pixels, 1.f);
+    }
+
+    program->bind();
+    program->setUniformValue("viewProjection", camera()->viewProjection());
+    program->setUniformValue("model", model);
+    program->setUniformValue("lightDirection", LightDirection);
+    m_model->draw(*this, *m_batcher, tolerance);
+    program->release();
+}
+
+void Painter::paint_2_4(float timef)
+{
+    paint_2_3_shadows(true);
+
+    if (m_virtual)
+        paint_2_3_feedback(VirtualFeedbackProgram);
+
+    if (m_depthPrepass && !tessellated() && !m_clipmapped)
+        paint_2_3_depth(TerrainDepthProgram);
+
+    glEnable(GL_DEPTH_TEST);
+
+    beginFragments(SphereFragments);
+    paint_2_4_instances(SphereInstancedProgram, timef);
+    endFragments();
+
+    beginFragments(ModelFragments);
+    paint_2_4_model(ModelProgram);
+    endFragments();
+
+    beginFragments(TerrainFragments);
+    paint_2_3_terrain(PaintMode5, timef);
+    endFragments();
+
+    beginFragments(EnvMapFragments);
+    paint_2_1_envmap(EnvMapProgram, timef);
+    endFragments();
+
+    captureOcclusion();
+}
+
+void Painter::drawTiles(const int programIndex)
+{
+    // render state equals the one used in Terrain::draw
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex(Terrain::restartIndex());
+    glEnable(GL_CULL_FACE);
+
+    // Only the passes from the main camera are culled, the cube map passes
+    // render from the sphere's position and thus do not match the depth.
+
+    const bool opaque(PaintMode5 == programIndex || TerrainDepthProgram == programIndex);
+
+    const QList<AxisAlignedBoundingBox> * bounds(nullptr);
+    if (m_occlusionCulling && opaque)
+        bounds = &m_tileBounds;
+    else if (m_occlusionCulling && PaintMode4 == programIndex)
+        bounds = &m_waterBounds;
+
+    // opaque tiles are drawn front to back (by their center's distance)
+
+    QList<QPair<float, int> > order;
+    for (int i = 0; i < m_tiles.size(); ++i)
+        if (!bounds || m_occlusion->visible((*bounds)[i]))
+            order << qMakePair(opaque ? (m_tileBounds[i].center() - camera()->eye()).lengthSquared() : 0.f, i);
+
+    if (opaque)
+        std::sort(order.begin(), order.end());
+
+    m_batcher->clear(programIndex);
+    for (const QPair<float, int> & tile : order)
+        m_batcher->record(programIndex, m_tiles[tile.second]);
+
+    m_batcher->submit(*this, programIndex, GL_TRIANGLE_STRIP);
+
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_PRIMITIVE_RESTART);
+    glDisable(GL_CULL_FACE);
+}
+
+void Painter::captureOcclusion()
+{
+    if (!m_occlusionCulling)
+        return;
+
+    // the viewport might be smaller than the window (dynamic resolution)
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    m_occlusion->capture(*this, viewport[2], viewport[3], camera()->viewProjection());
+}
+
+bool Painter::tessellated() const
+{
+    return m_patches && m_tessellated;
+}
+
+const Heightfield * Painter::heightfield() const
+{
+    return m_heightfield->isNull() ? nullptr : m_heightfield;
+}
+
+void Painter::updateHeightfield()
+{
+    m_heightfield->setTransform(m_transforms[0]);
+
+    if (m_streamer)
+    {
+        const TiledImageFile & file(m_streamer->file());
+
+        // the full resolution might not fit into memory
+        int level = 0;
+        while (level < file.levels() - 1 && file.width(level) > MaxHeightfieldSize)
+            ++level;
+
+        const int w(file.width(level));
+        const int h(file.height(level));
+
+        std::vector<float> values(w * h);
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                values[y * w + x] = file.texel(level, x, y);
+
+        m_heightfield->setHeights(w, h, values.data());
+        return;
+    }
+
+    const FileAssociatedTexture::Heights height(FileAssociatedTexture::heights(
+        QFileInfo(heightFilePath()).absoluteFilePath()));
+
+    if (!height.isNull())
+        m_heightfield->setHeights(height.size.width(), height.size.height(), height.values.constData());
+}
+
+void Painter::updateTileBounds()
+{
+    m_tileBounds.clear();
+    m_waterBounds.clear();
+
+    for (int i = 0; i < TerrainTiles * TerrainTiles; ++i)
+    {
+        m_tileBounds << AxisAlignedBoundingBox();
+        m_waterBounds << AxisAlignedBoundingBox();
+    }
+
+    for (int z = 0; z < TerrainTiles; ++z)
+        for (int x = 0; x < TerrainTiles; ++x)
+            updateTileBounds(x, z);
+}
+
+void Painter::updateTileBounds(
+    const int x
+,   const int z)
+{
+    // The tile bounds are derived from the cpu side copy of the height map.
+    // Since the height is sampled linearly, the 2x2 texels around each tile
+    // vertex are considered (wrapped as with GL_REPEAT).
+
+    std::vector<QVector3D> vertices;
+    std::vector<GLuint> indices;
+
+    Terrain::tile(TerrainSize, TerrainTiles, x, z, vertices, indices);
+
+    AxisAlignedBoundingBox terrain;
+    AxisAlignedBoundingBox water;
+
+    // see terrain_1_4.vert: an offset of .21 plus the wave height / 12, or
+    // plus the ocean's displacements on all axes, scaled as in paint_2_3_water
+    QVector3D waterLow(0.f, 0.21f, 0.f);
+    QVector3D waterHigh(0.f, 0.21f + 1.f / 12.f, 0.f);
+
+    if (m_oceanWaves)
+    {
+        const float scale(1.f / (OceanRepeat * OceanLength));
+        const QVector3D displacement(m_ocean->maxDisplacement() * QVector3D(scale, scale * OceanHeightScale, scale));
+
+        waterLow = QVector3D(0.f, 0.21f, 0.f) - displacement;
+        waterHigh = QVector3D(0.f, 0.21f, 0.f) + displacement;
+    }
+
+    for (const QVector3D & vertex : vertices)
+    {
+        float minY = 0.f;
+        float maxY = 1.f;
+
+        // streamed heights are not known on the cpu, stay conservative
+        if (!m_streamer && !m_heightfield->isNull())
+        {
+            const int w(m_heightfield->width());
+            const int h(m_heightfield->height());
+
+            const int px(static_cast<int>(std::floor(vertex.x() * w - 0.5f)));
+            const int py(static_cast<int>(std::floor(vertex.z() * h - 0.5f)));
+
+            minY = 1.f;
+            maxY = 0.f;
+            for (int j = 0; j < 2; ++j)
+                for (int i = 0; i < 2; ++i)
+                {
+                    const float y(m_heightfield->texel(px + i, py + j));
+                    minY = qMin(minY, y);
+                    maxY = qMax(maxY, y);
+                }
+        }
+
+        terrain.extend(m_transforms[0] * QVector3D(vertex.x(), minY, vertex.z()));
+        terrain.extend(m_transforms[0] * QVector3D(vertex.x(), maxY, vertex.z()));
+
+        water.extend(m_transforms[0] * (QVector3D(vertex.x(), 0.f, vertex.z()) + waterLow));
+        water.extend(m_transforms[0] * (QVector3D(vertex.x(), 0.f, vertex.z()) + waterHigh));
+    }
+
+    m_tileBounds[z * TerrainTiles + x] = terrain;
+    m_waterBounds[z * TerrainTiles + x] = water;
+}
+
+void Painter::sculpt(
+    const QVector3D & position
+,   const float radius
+,   const float strength)
+{
+    // the streamed height field is not edited, its tiles are read from file
+    if (m_streamer || m_heightfield->isNull())
+        return;
+
+    const int w(m_heightfield->width());
+    const int h(m_heightfield->height());
+
+    // brush center in texels (texel centers are at + .5)
+    const QVector3D uv(m_transforms[0].inverted() * position);
+    const float cx(uv.x() * w - 0.5f);
+    const float cy(uv.z() * h - 0.5f);
+
+    const QRect region(QRect(QPoint(static_cast<int>(std::floor(cx - radius)), static_cast<int>(std::floor(cy - radius)))
+        , QPoint(static_cast<int>(std::ceil(cx + radius)), static_cast<int>(std::ceil(cy + radius)))).intersected(QRect(0, 0, w, h)));
+
+    if (region.isEmpty())
+        return;
+
+    // smooth falloff towards the brush's border
+
+    std::vector<float> values(region.width() * region.height());
+    for (int y = 0; y < region.height(); ++y)
+        for (int x = 0; x < region.width(); ++x)
+        {
+            const float dx((region.x() + x - cx) / radius);
+            const float dy((region.y() + y - cy) / radius);
+            const float d2(qMin(1.f, dx * dx + dy * dy));
+
+            const float height(m_heightfield->texel(region.x() + x, region.y() + y));
+            values[y * region.width() + x] = qBound(0.f, height + strength * (1.f - d2) * (1.f - d2), 1.f);
+        }
+
+    // Only the region is uploaded (with the next process), and only the
+    // pyramid cells, clipmap texels, and tile bounds it touches are updated.
+    // Normals are derived from the heights in the shaders.
+
+    FileAssociatedTexture::setHeights(heightFilePath(), region, values.data());
+    m_heightfield->setHeights(region, values.data());
+
+    heightsChanged(region);
+}
+
+void Painter::reloadHeights()
+{
+    const QRegion reloaded(FileAssociatedTexture::takeReloadedHeights(heightFilePath()));
+
+    // the streamed height field is read from its tiled file instead
+    if (reloaded.isEmpty() || m_streamer)
+        return;
+
+    const FileAssociatedTexture::Heights height(FileAssociatedTexture::heights(
+        QFileInfo(heightFilePath()).absoluteFilePath()));
+
+    if (height.isNull())
+        return;
+
+    // a resized height field is rebuilt entirely
+    if (m_heightfield->isNull() || height.size != QSize(m_heightfield->width(), m_heightfield->height()))
+    {
+        updateHeightfield();
+        m_clipmap->setSource(m_heightfield);
+        updateTileBounds();
+        m_occlusion->reset();
+        return;
+    }
+
+    std::vector<float> values;
+    for (const QRect & rect : reloaded.rects())
+    {
+        values.resize(rect.width() * rect.height());
+        for (int y = 0; y < rect.height(); ++y)
+            memcpy(values.data() + y * rect.width()
+                , height.values.constData() + (rect.y() + y) * height.size.width() + rect.x(), rect.width() * sizeof(float));
+
+        m_heightfield->setHeights(rect, values.data());
+    }
+    heightsChanged(reloaded);
+}
+
+void Painter::heightsChanged(const QRegion & region)
+{
+    const int w(m_heightfield->width());
+    const int h(m_heightfield->height());
+
+    // tiles touched by any of the rects are updated once
+    QSet<int> tiles;
+
+    for (const QRect & rect : region.rects())
+    {
+        m_clipmap->invalidate(rect);
+
+        // bilinear sampling reaches one texel further (wrapped at the borders)
+
+        QList<int> columns;
+        QList<int> rows;
+
+        for (int x = qMax(0, (rect.left() - 1) * TerrainTiles / w); x <= qMin(TerrainTiles - 1, (rect.right() + 1) * TerrainTiles / w); ++x)
+            columns << x;
+        for (int z = qMax(0, (rect.top() - 1) * TerrainTiles / h); z <= qMin(TerrainTiles - 1, (rect.bottom() + 1) * TerrainTiles / h); ++z)
+            rows << z;
+
+        if (rect.left() == 0 && !columns.contains(TerrainTiles - 1))
+            columns << TerrainTiles - 1;
+        if (rect.right() == w - 1 && !columns.contains(0))
+            columns << 0;
+        if (rect.top() == 0 && !rows.contains(TerrainTiles - 1))
+            rows << TerrainTiles - 1;
+        if (rect.bottom() == h - 1 && !rows.contains(0))
+            rows << 0;
+
+        for (const int z : rows)
+            for (const int x : columns)
+                tiles << z * TerrainTiles + x;
+    }
+
+    for (const int tile : tiles)
+        updateTileBounds(tile % TerrainTiles, tile / TerrainTiles);
+
+    // the previous frame's depth no longer matches the terrain
+    m_occlusion->reset();
+}
+
+void Painter::beginFragments(const FragmentPass pass)
+{
+    if (!m_overdraw)
+        return;
+
+    glBeginQuery(GL_SAMPLES_PASSED, m_fragmentQueries[pass]);
+    m_fragmentQueried[pass] = true;
+}
+
+void Painter::endFragments()
+{
+    if (m_overdraw)
+        glEndQuery(GL_SAMPLES_PASSED);
+}
+
+void Painter::collectFragments()
+{
+    // The queries of the previous frame are read only if available, so the
+    // cpu never waits for the gpu (an unavailable result is just skipped).
+
+    for (int i = 0; i < FragmentPassCount; ++i)
+    {
+        if (!m_fragmentQueried[i])
+            continue;
+
+        GLuint available(GL_FALSE);
+        glGetQueryObjectuiv(m_fragmentQueries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            continue;
+
+        GLuint samples(0);
+        glGetQueryObjectuiv(m_fragmentQueries[i], GL_QUERY_RESULT, &samples);
+
+        m_fragments[i] += samples;
+        m_fragmentQueried[i] = false;
+    }
+
+    if (++m_fragmentFrames < FragmentReportFrames)
+        return;
+
+    quint64 total(0);
+    for (int i = 0; i < FragmentPassCount; ++i)
+        total += m_fragments[i];
+
+    // the rendered image is smaller than the window with dynamic resolution
+    const QSize size(renderSize());
+    const float pixels(static_cast<float>(qMax(1, size.width() * size.height())));
+
+    qDebug() << "Fragments per frame - pre-pass:" << m_fragments[PrepassFragments] / m_fragmentFrames
+        << "sphere:" << m_fragments[SphereFragments] / m_fragmentFrames
+        << "model:" << m_fragments[ModelFragments] / m_fragmentFrames
+        << "terrain:" << m_fragments[TerrainFragments] / m_fragmentFrames
+        << "envmap:" << m_fragments[EnvMapFragments] / m_fragmentFrames
+        << "water:" << m_fragments[WaterFragments] / m_fragmentFrames
+        << "overdraw:" << total / m_fragmentFrames / pixels;
+
+    m_fragmentFrames = 0;
+    for (int i = 0; i < FragmentPassCount; ++i)
+        m_fragments[i] = 0;
+}
@@ -6,14 +6,27 @@
 #include <QVector3D>
 
 #include "AbstractPainter.h"
+#include "AxisAlignedBoundingBox.h"
 
 class QOpenGLShader;
+class QRegion;
 class QOpenGLShaderProgram;
 
 class Camera;
 class Terrain;
 class ScreenAlignedQuad;
 class Icosahedron;
+class InstanceBuffer;
+class DrawBatcher;
+class OcclusionCuller;
+class HeightfieldStreamer;
+class Heightfield;
+class TessellatedTerrain;
+class ClipmapTerrain;
+class VirtualTexture;
+class Ocean;
+class CascadedShadowMap;
+class Model;
 
 
 class Painter : public AbstractPainter
@@ -34,6 +47,8 @@ public:
 
     void keyPressEvent(QKeyEvent * event);
 
+    virtual const Heightfield * heightfield() const;
+
 
 protected:
     void paint_1_1(float timef);
@@ -52,6 +67,36 @@ protected:
     void paint_2_3_terrain(const int programIndex, float timef);
     void paint_2_3_water(const int programIndex, float timef);
 
+    /** lays out the terrain's depth only (color writes disabled)
+    */
+    void paint_2_3_depth(const int programIndex);
+
+    /** renders the tiles the terrain requires into the virtual texture's
+        feedback buffer
+    */
+    void paint_2_3_feedback(const int programIndex);
+
+    /** fits the shadow cascades to the camera and renders the terrain and
+        the instanced spheres (task 2_4) or the reflecting sphere (task 2_3)
+        into them
+    */
+    void paint_2_3_shadows(bool instanced);
+
+    void paint_2_4_instances(const int programIndex, float timef);
+
+    /** draws the model (if loaded) at the reflecting sphere's center
+    */
+    void paint_2_4_model(const int programIndex);
+
+    /** draws all terrain tiles batched with the given program (bucket),
+        skipping tiles occluded in the previous frame for terrain and water
+    */
+    void drawTiles(const int programIndex);
+
+    /** reads back the depth of the opaque geometry for occlusion culling
+    */
+    void captureOcclusion();
+
     void paint_2_1(float timef);
     void paint_2_2(float timef);
     void paint_2_3(float timef);
@@ -59,6 +104,66 @@ protected:
     //void paint_2_5(float timef);
     //...
 
+    /** scatters count x count spheres over the terrain (see paint_2_4)
+    */
+    void populateInstances(int count);
+
+    /** world space bounds of all terrain and water tiles (see drawTiles)
+    */
+    void updateTileBounds();
+    void updateTileBounds(
+        int x
+    ,   int z);
+
+    /** Raises (or lowers, for negative strength) the terrain around position
+        (world space) with a brush of radius texels; only the touched region
+        is uploaded and updated in the cpu side structures.
+    */
+    void sculpt(
+        const QVector3D & position
+    ,   float radius
+    ,   float strength);
+
+    /** Applies heights reloaded from the height file (see
+        FileAssociatedTexture::takeReloadedHeights) to the cpu side copy.
+    */
+    void reloadHeights();
+
+    /** Updates the clipmap texels, tile bounds, and occlusion state derived
+        from the cpu side heights within region, after these changed.
+    */
+    void heightsChanged(const QRegion & region);
+
+    /** cpu side copy of the terrain's heights (from the tiled file's finest
+        level of moderate size when streaming)
+    */
+    void updateHeightfield();
+
+    /** true if the terrain is drawn with tessellation shaders
+    */
+    bool tessellated() const;
+
+    enum FragmentPass
+    {
+        PrepassFragments
+    ,   SphereFragments
+    ,   ModelFragments
+    ,   TerrainFragments
+    ,   EnvMapFragments
+    ,   WaterFragments
+    ,   FragmentPassCount
+    };
+
+    /** counts the fragments passing the depth test (GL_SAMPLES_PASSED) in
+        between, if the overdraw visualization is enabled
+    */
+    void beginFragments(FragmentPass pass);
+    void endFragments();
+
+    /** accumulates the available counts and reports them periodically
+    */
+    void collectFragments();
+
     enum EnvironmentMapping
     {
         CubeMapping
@@ -77,6 +182,19 @@ protected:
     ,   const QString & geometryShaderFileName
     ,   const QString & fragmentShaderFileName);
 
+    QOpenGLShaderProgram * createBasicShaderProgram(
+        const QString & vertexShaderFileName
+    ,   const QString & tessellationControlShaderFileName
+    ,   const QString & tessellationEvaluationShaderFileName
+    ,   const QString & fragmentShaderFileName);
+
+    /** attaches the shared fragment shaders (data/overdraw.frag, and
+        data/shadowing.frag for shadow receivers) and links
+    */
+    QOpenGLShaderProgram * linkBasicShaderProgram(
+        QOpenGLShaderProgram * program
+    ,   const QString & fragmentShaderFileName);
+
 protected:
     Camera * m_camera;
 
@@ -88,7 +206,47 @@ protected:
     Icosahedron * m_icosa;
     QVector3D m_icosa_center;
 
+    InstanceBuffer * m_instances;
+    int m_instancesPerSide;
+
     QList<Terrain *> m_terrains;
+
+    DrawBatcher * m_batcher;
+    QList<int> m_tiles;
+    bool m_batched;
+
+    OcclusionCuller * m_occlusion;
+    QList<AxisAlignedBoundingBox> m_tileBounds;
+    QList<AxisAlignedBoundingBox> m_waterBounds;
+    bool m_occlusionCulling;
+
+    bool m_depthPrepass;
+    bool m_overdraw;
+
+    GLuint m_fragmentQueries[FragmentPassCount];
+    bool m_fragmentQueried[FragmentPassCount];
+    quint64 m_fragments[FragmentPassCount];
+    int m_fragmentFrames;
+
+    HeightfieldStreamer * m_streamer; ///< nullptr if no tiled height field exists
+    Heightfield * m_heightfield;
+
+    TessellatedTerrain * m_patches; ///< nullptr if tessellation is not supported
+    bool m_tessellated;
+
+    ClipmapTerrain * m_clipmap;
+    bool m_clipmapped;
+
+    VirtualTexture * m_virtual; ///< nullptr if no tiled ground texture exists
+
+    Ocean * m_ocean;
+    bool m_oceanWaves; ///< FFT ocean instead of the scrolling water textures
+
+    CascadedShadowMap * m_shadows;
+
+    Model * m_model; ///< nullptr if no data/model.obj exists, owned by FileAssociatedModel
+    bool m_modelLods;  ///< levels of detail chosen by projected size, full detail otherwise
+
     QList<QMatrix4x4> m_transforms;
 
     QMap<int, QOpenGLShaderProgram *> m_programs;
@@ -97,6 +255,7 @@ protected:
     GLuint m_height;
 
     GLuint m_ground;
+    GLuint m_groundLayers; ///< ground atlas as texture array
     GLuint m_caustics;
     GLuint m_water;
 
@@ -70,6 +70,84 @@ void Terrain::draw(
     // Task_1_1 - ToDo End
 }
 
+unsigned int Terrain::restartIndex()
+{
+    return Terrain::primitiveRestartIndex;
+}
+
+void Terrain::tile(
+    const unsigned short size
+,   const unsigned short tiles
+,   const unsigned short tileX
+,   const unsigned short tileZ
+,   std::vector<QVector3D> & vertices
+,   std::vector<GLuint> & indices)
+{
+    assert(size > 1 && tiles > 0 && tileX < tiles && tileZ < tiles);
+
+    const int cells = size - 1;
+
+    const int x0 = cells * tileX / tiles;
+    const int x1 = cells * (tileX + 1) / tiles;
+    const int z0 = cells * tileZ / tiles;
+    const int z1 = cells * (tileZ + 1) / tiles;
+
+    const int width = x1 - x0 + 1;
+    const float factor = 1.f / cells;
+
+    vertices.clear();
+    indices.clear();
+
+    for (int z = z0; z <= z1; ++z)
+        for (int x = x0; x <= x1; ++x)
+            vertices.push_back(QVector3D(x * factor, 0.f, z * factor));
+
+    // same winding as strip(), so face culling behaves identically
+
+    for (int z = 0; z < z1 - z0; ++z)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            indices.push_back(z * width + x);
+            indices.push_back((z + 1) * width + x);
+        }
+        if (z < z1 - z0 - 1)
+            indices.push_back(Terrain::primitiveRestartIndex);
+    }
+}
+
+void Terrain::ring(
+    const unsigned short quads
+,   const unsigned short holeX
+,   const unsigned short holeZ
+,   const unsigned short holeSize
+,   std::vector<GLuint> & indices)
+{
+    assert(holeX + holeSize <= quads && holeZ + holeSize <= quads);
+
+    const int width = quads + 1;
+
+    indices.clear();
+
+    for (int z = 0; z < quads; ++z)
+        for (int x = 0; x < quads; ++x)
+        {
+            if (x >= holeX && x < holeX + holeSize && z >= holeZ && z < holeZ + holeSize)
+                continue;
+
+            const GLuint a = z * width + x;
+            const GLuint b = (z + 1) * width + x;
+
+            indices.push_back(a);
+            indices.push_back(b);
+            indices.push_back(a + 1);
+
+            indices.push_back(a + 1);
+            indices.push_back(b);
+            indices.push_back(b + 1);
+        }
+}
+
 void Terrain::strip(
 	const unsigned short size
 ,	QOpenGLBuffer & vertices
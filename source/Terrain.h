@@ -5,6 +5,7 @@
 
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLBuffer>
+#include <QVector3D>
 
 #include "OpenGLFunctions.h"
 
@@ -20,6 +21,33 @@ public:
 		OpenGLFunctions & gl
 	,	GLenum mode = GL_TRIANGLE_STRIP);
 
+    static unsigned int restartIndex();
+
+    /** Generates the vertices and (restart separated) triangle strip indices
+        of a single tile, when splitting the size x size grid into tiles x tiles
+        tiles. Neighbouring tiles share their border vertices, so there are no
+        cracks. The vertices are in the same [0;1] xz space as the whole grid.
+    */
+    static void tile(
+        unsigned short size
+    ,   unsigned short tiles
+    ,   unsigned short tileX
+    ,   unsigned short tileZ
+    ,   std::vector<QVector3D> & vertices
+    ,   std::vector<GLuint> & indices);
+
+    /** Generates triangle indices (same winding as the strips) of a grid of
+        quads x quads cells, i.e., (quads + 1)^2 vertices row by row, leaving
+        out a hole of holeSize x holeSize cells at (holeX, holeZ). These are
+        the rings of a geometry clipmap (see ClipmapTerrain).
+    */
+    static void ring(
+        unsigned short quads
+    ,   unsigned short holeX
+    ,   unsigned short holeZ
+    ,   unsigned short holeSize
+    ,   std::vector<GLuint> & indices);
+
 protected:
     static void strip(
         unsigned short size
@@ -0,0 +1,94 @@
+
+#include <cassert>
+#include <vector>
+
+#include <QOpenGLContext>
+#include <QSurfaceFormat>
+#include <QVector3D>
+
+#include "TessellatedTerrain.h"
+
+#ifndef GL_PATCHES
+#define GL_PATCHES          0x000E
+#endif
+#ifndef GL_PATCH_VERTICES
+#define GL_PATCH_VERTICES   0x8E72
+#endif
+
+
+TessellatedTerrain::TessellatedTerrain(
+    const unsigned short patches
+,   OpenGLFunctions & gl)
+: m_vertices(QOpenGLBuffer::VertexBuffer)
+, m_patches(patches)
+, m_patchParameteri(nullptr)
+{
+    QOpenGLContext * context(QOpenGLContext::currentContext());
+    assert(context);
+
+    m_patchParameteri = reinterpret_cast<PATCHPARAMETERIPROC>(
+        context->getProcAddress("glPatchParameteri"));
+
+    // four control points per patch, counterclockwise in xz
+
+    std::vector<QVector3D> vertices;
+    vertices.reserve(patches * patches * 4);
+
+    const float step(1.f / patches);
+
+    for (int z = 0; z < patches; ++z)
+        for (int x = 0; x < patches; ++x)
+        {
+            vertices.push_back(QVector3D( x      * step, 0.f,  z      * step));
+            vertices.push_back(QVector3D((x + 1) * step, 0.f,  z      * step));
+            vertices.push_back(QVector3D((x + 1) * step, 0.f, (z + 1) * step));
+            vertices.push_back(QVector3D( x      * step, 0.f, (z + 1) * step));
+        }
+
+    m_vao.create();
+    m_vao.bind();
+
+    m_vertices.create();
+    m_vertices.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    m_vertices.bind();
+    m_vertices.allocate(vertices.data(), static_cast<int>(vertices.size() * sizeof(QVector3D)));
+
+    gl.glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(QVector3D), nullptr);
+    gl.glEnableVertexAttribArray(0);
+
+    m_vao.release();
+}
+
+TessellatedTerrain::~TessellatedTerrain()
+{
+}
+
+bool TessellatedTerrain::supported()
+{
+    QOpenGLContext * context(QOpenGLContext::currentContext());
+    assert(context);
+
+    const QSurfaceFormat format(context->format());
+    const bool core40 = format.majorVersion() >= 4;
+
+    return (core40 || context->hasExtension("GL_ARB_tessellation_shader"))
+        && context->getProcAddress("glPatchParameteri");
+}
+
+void TessellatedTerrain::draw(OpenGLFunctions & gl)
+{
+    if (!m_patchParameteri)
+        return;
+
+    gl.glEnable(GL_DEPTH_TEST);
+    gl.glEnable(GL_CULL_FACE);
+
+    m_patchParameteri(GL_PATCH_VERTICES, 4);
+
+    m_vao.bind();
+    gl.glDrawArrays(GL_PATCHES, 0, m_patches * m_patches * 4);
+    m_vao.release();
+
+    gl.glDisable(GL_DEPTH_TEST);
+    gl.glDisable(GL_CULL_FACE);
+}
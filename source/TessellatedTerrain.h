@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QOpenGLVertexArrayObject>
+#include <QOpenGLBuffer>
+
+#include "OpenGLFunctions.h"
+
+/** Coarse grid of quad patches over the [0;1] xz space of the terrain, for
+    drawing with tessellation shaders (GL 4.0 or ARB_tessellation_shader):
+    the tessellation control shader chooses levels per edge, the evaluation
+    shader displaces by the height texture (see data/terrain_tess.*).
+
+    Since glPatchParameteri is not part of the 3.2 core functions, it is
+    resolved manually; supported() tells if that succeeded.
+*/
+class TessellatedTerrain
+{
+public:
+    TessellatedTerrain(
+        unsigned short patches
+    ,   OpenGLFunctions & gl);
+    virtual ~TessellatedTerrain();
+
+    /** requires a current context
+    */
+    static bool supported();
+
+    void draw(OpenGLFunctions & gl);
+
+protected:
+    typedef void (APIENTRY * PATCHPARAMETERIPROC)(GLenum pname, GLint value);
+
+protected:
+    QOpenGLVertexArrayObject m_vao;
+    QOpenGLBuffer m_vertices;
+
+    unsigned short m_patches;
+
+    PATCHPARAMETERIPROC m_patchParameteri;
+};
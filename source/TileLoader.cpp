@@ -0,0 +1,73 @@
+#include <QMutexLocker>
+
+#include "TiledImageFile.h"
+
+#include "TileLoader.h"
+
+
+TileLoader::TileLoader(const TiledImageFile & file)
+: m_file(file)
+, m_stop(false)
+{
+}
+
+TileLoader::~TileLoader()
+{
+}
+
+quint64 TileLoader::hash(const Key & key)
+{
+    return (static_cast<quint64>(key.level) << 48)
+        | (static_cast<quint64>(key.y) << 24) | static_cast<quint64>(key.x);
+}
+
+void TileLoader::request(const QList<Key> & keys)
+{
+    QMutexLocker lock(&m_mutex);
+    m_pending = keys;
+    m_condition.wakeOne();
+}
+
+QList<TileLoader::Loaded> TileLoader::take()
+{
+    QMutexLocker lock(&m_mutex);
+
+    const QList<Loaded> loaded(m_loaded);
+    m_loaded.clear();
+
+    return loaded;
+}
+
+void TileLoader::stop()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_stop = true;
+        m_condition.wakeOne();
+    }
+    wait();
+}
+
+void TileLoader::run()
+{
+    while (true)
+    {
+        Loaded tile;
+        {
+            QMutexLocker lock(&m_mutex);
+            while (!m_stop && m_pending.isEmpty())
+                m_condition.wait(&m_mutex);
+
+            if (m_stop)
+                return;
+
+            tile.key = m_pending.takeFirst();
+        }
+
+        tile.data = QByteArray(reinterpret_cast<const char *>(
+            m_file.tile(tile.key.level, tile.key.x, tile.key.y)), static_cast<int>(m_file.tileBytes()));
+
+        QMutexLocker lock(&m_mutex);
+        m_loaded << tile;
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+class TiledImageFile;
+
+/** Copies requested tiles out of a (memory mapped) TiledImageFile, so that
+    page faults (i.e., the actual file I/O) happen on this thread instead of
+    the render thread. Used by the HeightfieldStreamer and VirtualTexture.
+*/
+class TileLoader : public QThread
+{
+public:
+    struct Key
+    {
+        int level;
+        int x;
+        int y;
+    };
+
+    struct Loaded
+    {
+        Key key;
+        QByteArray data;
+    };
+
+    static quint64 hash(const Key & key);
+
+public:
+    TileLoader(const TiledImageFile & file);
+    virtual ~TileLoader();
+
+    /** replaces all pending requests
+    */
+    void request(const QList<Key> & keys);
+
+    /** tiles loaded since the last call
+    */
+    QList<Loaded> take();
+
+    void stop();
+
+protected:
+    virtual void run();
+
+protected:
+    const TiledImageFile & m_file;
+
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+
+    QList<Key> m_pending;
+    QList<Loaded> m_loaded;
+    bool m_stop;
+};
@@ -0,0 +1,578 @@
+
+#include <cassert>
+#include <cstring>
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QImage>
+
+#include "TiledImageFile.h"
+
+
+namespace
+{
+    const char Magic[4] = { 'T', 'I', 'M', 'F' };
+
+    // tiles start page aligned, which is friendly for mapped reads
+    const quint64 DataAlignment = 4096;
+
+    // limits of headers accepted when opening, which keep all tile counts
+    // and offsets far from overflowing
+    const quint32 MaxTileSize = 16384;
+    const quint32 MaxExtent = 1 << 24;
+
+    // number of levels down to a single texel
+    quint32 maxLevels(quint32 width, quint32 height)
+    {
+        quint32 levels(1);
+        for (; width > 1 || height > 1; ++levels)
+        {
+            width = qMax(1u, (width + 1) / 2);
+            height = qMax(1u, (height + 1) / 2);
+        }
+        return levels;
+    }
+}
+
+
+class TiledImageFile::ImageSource : public TiledImageFile::Source
+{
+public:
+    ImageSource(const QImage & image)
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    // keeps the precision of 16bit images (e.g., height fields)
+    : m_image(image.convertToFormat(QImage::Format_RGBA64))
+#else
+    : m_image(image.convertToFormat(QImage::Format_ARGB32))
+#endif
+    {
+    }
+
+    virtual int width() const
+    {
+        return m_image.width();
+    }
+
+    virtual int height() const
+    {
+        return m_image.height();
+    }
+
+    virtual void read(int x, int y, float * rgba) const
+    {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+        const QRgba64 pixel(reinterpret_cast<const QRgba64 *>(m_image.constScanLine(y))[x]);
+
+        rgba[0] = pixel.red()   / 65535.f;
+        rgba[1] = pixel.green() / 65535.f;
+        rgba[2] = pixel.blue()  / 65535.f;
+        rgba[3] = pixel.alpha() / 65535.f;
+#else
+        const QRgb pixel(reinterpret_cast<const QRgb *>(m_image.constScanLine(y))[x]);
+
+        rgba[0] = qRed(pixel)   / 255.f;
+        rgba[1] = qGreen(pixel) / 255.f;
+        rgba[2] = qBlue(pixel)  / 255.f;
+        rgba[3] = qAlpha(pixel) / 255.f;
+#endif
+    }
+
+protected:
+    const QImage m_image;
+};
+
+class TiledImageFile::RawSource : public TiledImageFile::Source
+{
+public:
+    RawSource(
+        const QString & filePath
+    ,   int width
+    ,   int height)
+    : m_file(filePath)
+    , m_data(nullptr)
+    , m_width(width)
+    , m_height(height)
+    , m_float(0 == QFileInfo(filePath).suffix().compare("r32", Qt::CaseInsensitive))
+    {
+        const qint64 bytes(static_cast<qint64>(width) * height * (m_float ? 4 : 2));
+
+        if (!m_file.open(QIODevice::ReadOnly))
+            return;
+
+        if (m_file.size() < bytes)
+        {
+            qWarning() << "Raw file" << filePath << "is smaller than" << width << "x" << height << "texels.";
+            return;
+        }
+        m_data = m_file.map(0, bytes);
+    }
+
+    virtual ~RawSource()
+    {
+        if (m_data)
+            m_file.unmap(m_data);
+    }
+
+    bool isValid() const
+    {
+        return m_data != nullptr;
+    }
+
+    virtual int width() const
+    {
+        return m_width;
+    }
+
+    virtual int height() const
+    {
+        return m_height;
+    }
+
+    virtual void read(int x, int y, float * rgba) const
+    {
+        const qint64 i(static_cast<qint64>(y) * m_width + x);
+
+        if (m_float)
+            rgba[0] = reinterpret_cast<const float *>(m_data)[i];
+        else
+            rgba[0] = reinterpret_cast<const quint16 *>(m_data)[i] / 65535.f;
+
+        rgba[1] = rgba[0];
+        rgba[2] = rgba[0];
+        rgba[3] = 1.f;
+    }
+
+protected:
+    QFile m_file;
+    uchar * m_data;
+
+    int m_width;
+    int m_height;
+    bool m_float;
+};
+
+
+TiledImageFile::TiledImageFile()
+: m_data(nullptr)
+{
+    memset(&m_header, 0, sizeof(Header));
+}
+
+TiledImageFile::~TiledImageFile()
+{
+    close();
+}
+
+bool TiledImageFile::open(const QString & filePath)
+{
+    close();
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Opening" << filePath << "failed.";
+        return false;
+    }
+
+    Header header;
+    if (m_file.read(reinterpret_cast<char *>(&header), sizeof(Header)) != sizeof(Header)
+        || 0 != memcmp(header.magic, Magic, 4) || Version != header.version)
+    {
+        qWarning() << filePath << "is not a tiled image file (version" << Version << ").";
+        m_file.close();
+        return false;
+    }
+
+    // a corrupt header must neither divide by zero nor index past the mapping
+
+    if (header.format > RGBA8 || 0 == header.tileSize || header.tileSize > MaxTileSize
+        || header.border >= header.tileSize
+        || 0 == header.width || 0 == header.height || header.width > MaxExtent || header.height > MaxExtent
+        || 0 == header.levels || header.levels > maxLevels(header.width, header.height)
+        || header.dataOffset < sizeof(Header) || header.dataOffset > static_cast<quint64>(m_file.size()))
+    {
+        qWarning() << filePath << "has an invalid header.";
+        m_file.close();
+        return false;
+    }
+
+    setup(header);
+
+    // each level's tiles have to be within the file
+    const qint64 tilesInFile((m_file.size() - static_cast<qint64>(m_header.dataOffset)) / tileBytes());
+    for (int level = 0; level < levels(); ++level)
+    {
+        if (m_firstTiles[level + 1] > tilesInFile)
+        {
+            qWarning() << filePath << "is truncated (level" << level << ").";
+            close();
+            return false;
+        }
+    }
+
+    const qint64 size(static_cast<qint64>(m_header.dataOffset)
+        + m_firstTiles.last() * tileBytes());
+
+    m_data = m_file.map(0, size);
+    if (!m_data)
+    {
+        qWarning() << "Mapping" << filePath << "failed.";
+        close();
+        return false;
+    }
+
+    m_filePath = filePath;
+    return true;
+}
+
+void TiledImageFile::close()
+{
+    if (m_data)
+        m_file.unmap(m_data);
+    m_data = nullptr;
+
+    if (m_file.isOpen())
+        m_file.close();
+
+    m_filePath.clear();
+}
+
+bool TiledImageFile::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+const QString & TiledImageFile::filePath() const
+{
+    return m_filePath;
+}
+
+void TiledImageFile::setup(const Header & header)
+{
+    m_header = header;
+
+    m_widths.clear();
+    m_heights.clear();
+    m_firstTiles.clear();
+
+    int w(header.width);
+    int h(header.height);
+    const int t(header.tileSize);
+
+    qint64 tiles(0);
+    for (quint32 level = 0; level < header.levels; ++level)
+    {
+        m_widths << w;
+        m_heights << h;
+        m_firstTiles << tiles;
+
+        tiles += static_cast<qint64>((w + t - 1) / t) * ((h + t - 1) / t);
+
+        w = qMax(1, (w + 1) / 2);
+        h = qMax(1, (h + 1) / 2);
+    }
+    // the total tile count, for convenience
+    m_firstTiles << tiles;
+}
+
+TiledImageFile::Format TiledImageFile::format() const
+{
+    return static_cast<Format>(m_header.format);
+}
+
+int TiledImageFile::width(const int level) const
+{
+    return m_widths[level];
+}
+
+int TiledImageFile::height(const int level) const
+{
+    return m_heights[level];
+}
+
+int TiledImageFile::levels() const
+{
+    return static_cast<int>(m_header.levels);
+}
+
+int TiledImageFile::tileSize() const
+{
+    return static_cast<int>(m_header.tileSize);
+}
+
+int TiledImageFile::border() const
+{
+    return static_cast<int>(m_header.border);
+}
+
+int TiledImageFile::pageSize() const
+{
+    return tileSize() + 2 * border();
+}
+
+int TiledImageFile::tilesX(const int level) const
+{
+    return (width(level) + tileSize() - 1) / tileSize();
+}
+
+int TiledImageFile::tilesY(const int level) const
+{
+    return (height(level) + tileSize() - 1) / tileSize();
+}
+
+int TiledImageFile::bytesPerTexel(const Format format)
+{
+    switch (format)
+    {
+    case R16:
+        return 2;
+    case R32F:
+    case RGBA8:
+    default:
+        return 4;
+    }
+}
+
+int TiledImageFile::bytesPerTexel() const
+{
+    return bytesPerTexel(format());
+}
+
+qint64 TiledImageFile::tileBytes() const
+{
+    return static_cast<qint64>(pageSize()) * pageSize() * bytesPerTexel();
+}
+
+qint64 TiledImageFile::tileOffset(
+    const int level
+,   const int x
+,   const int y) const
+{
+    assert(level >= 0 && level < levels());
+    assert(x >= 0 && x < tilesX(level) && y >= 0 && y < tilesY(level));
+
+    return static_cast<qint64>(m_header.dataOffset)
+        + (m_firstTiles[level] + static_cast<qint64>(y) * tilesX(level) + x) * tileBytes();
+}
+
+const uchar * TiledImageFile::tile(
+    const int level
+,   const int x
+,   const int y) const
+{
+    return m_data + tileOffset(level, x, y);
+}
+
+void TiledImageFile::encode(
+    const float * rgba
+,   uchar * texel) const
+{
+    switch (format())
+    {
+    case R16:
+        *reinterpret_cast<quint16 *>(texel) = static_cast<quint16>(qBound(0.f, rgba[0], 1.f) * 65535.f + 0.5f);
+        break;
+    case R32F:
+        *reinterpret_cast<float *>(texel) = rgba[0];
+        break;
+    case RGBA8:
+        for (int i = 0; i < 4; ++i)
+            texel[i] = static_cast<uchar>(qBound(0.f, rgba[i], 1.f) * 255.f + 0.5f);
+        break;
+    }
+}
+
+void TiledImageFile::decode(
+    const uchar * texel
+,   float * rgba) const
+{
+    switch (format())
+    {
+    case R16:
+        rgba[0] = *reinterpret_cast<const quint16 *>(texel) / 65535.f;
+        rgba[1] = rgba[2] = rgba[0];
+        rgba[3] = 1.f;
+        break;
+    case R32F:
+        rgba[0] = *reinterpret_cast<const float *>(texel);
+        rgba[1] = rgba[2] = rgba[0];
+        rgba[3] = 1.f;
+        break;
+    case RGBA8:
+        for (int i = 0; i < 4; ++i)
+            rgba[i] = texel[i] / 255.f;
+        break;
+    }
+}
+
+void TiledImageFile::texel(
+    const int level
+,   const int x
+,   const int y
+,   float * rgba) const
+{
+    const int cx(qBound(0, x, width(level) - 1));
+    const int cy(qBound(0, y, height(level) - 1));
+
+    const int t(tileSize());
+    const int b(border());
+
+    const uchar * page(tile(level, cx / t, cy / t));
+    const qint64 i(static_cast<qint64>(cy % t + b) * pageSize() + cx % t + b);
+
+    decode(page + i * bytesPerTexel(), rgba);
+}
+
+float TiledImageFile::texel(
+    const int level
+,   const int x
+,   const int y) const
+{
+    float rgba[4];
+    texel(level, x, y, rgba);
+
+    return rgba[0];
+}
+
+bool TiledImageFile::convert(
+    const QImage & image
+,   const QString & targetFilePath
+,   const Format format
+,   const int tileSize
+,   const int border)
+{
+    if (image.isNull())
+        return false;
+
+    return convert(ImageSource(image), targetFilePath, format, tileSize, border);
+}
+
+bool TiledImageFile::convertRaw(
+    const QString & sourceFilePath
+,   const int width
+,   const int height
+,   const QString & targetFilePath
+,   const Format format
+,   const int tileSize
+,   const int border)
+{
+    const RawSource source(sourceFilePath, width, height);
+    if (!source.isValid())
+    {
+        qWarning() << "Reading raw file" << sourceFilePath << "failed.";
+        return false;
+    }
+    return convert(source, targetFilePath, format, tileSize, border);
+}
+
+bool TiledImageFile::convert(
+    const Source & source
+,   const QString & targetFilePath
+,   const Format format
+,   const int tileSize
+,   const int border)
+{
+    assert(tileSize > 0 && border >= 0 && border < tileSize);
+
+    if (source.width() <= 0 || source.height() <= 0)
+        return false;
+
+    Header header;
+    memcpy(header.magic, Magic, 4);
+    header.version  = Version;
+    header.format   = format;
+    header.width    = source.width();
+    header.height   = source.height();
+    header.tileSize = tileSize;
+    header.border   = border;
+    header.dataOffset = DataAlignment;
+
+    // levels down to a single tile
+
+    header.levels = 1;
+    for (int w = source.width(), h = source.height(); w > tileSize || h > tileSize; ++header.levels)
+    {
+        w = qMax(1, (w + 1) / 2);
+        h = qMax(1, (h + 1) / 2);
+    }
+
+    TiledImageFile target;
+    target.setup(header);
+
+    const qint64 size(static_cast<qint64>(header.dataOffset)
+        + target.m_firstTiles.last() * target.tileBytes());
+
+    // The whole target is mapped writable and filled level by level, so that
+    // each level is filtered from the previous one without keeping it in
+    // memory explicitly.
+
+    target.m_file.setFileName(targetFilePath);
+    if (!target.m_file.open(QIODevice::ReadWrite | QIODevice::Truncate)
+        || !target.m_file.resize(size))
+    {
+        qWarning() << "Creating" << targetFilePath << "failed.";
+        return false;
+    }
+    target.m_file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+    target.m_file.flush();
+
+    target.m_data = target.m_file.map(0, size);
+    if (!target.m_data)
+    {
+        qWarning() << "Mapping" << targetFilePath << "failed.";
+        return false;
+    }
+
+    const int page(target.pageSize());
+    const int bpt(target.bytesPerTexel());
+
+    float rgba[4];
+    float sample[4];
+
+    for (int level = 0; level < target.levels(); ++level)
+    {
+        const int w(target.width(level));
+        const int h(target.height(level));
+
+        for (int ty = 0; ty < target.tilesY(level); ++ty)
+            for (int tx = 0; tx < target.tilesX(level); ++tx)
+            {
+                uchar * tile(target.m_data + target.tileOffset(level, tx, ty));
+
+                for (int py = 0; py < page; ++py)
+                {
+                    const int y(qBound(0, ty * tileSize - border + py, h - 1));
+
+                    for (int px = 0; px < page; ++px)
+                    {
+                        const int x(qBound(0, tx * tileSize - border + px, w - 1));
+
+                        if (0 == level)
+                            source.read(x, y, rgba);
+                        else
+                        {
+                            // 2x2 box filter of the previous level (clamped)
+                            rgba[0] = rgba[1] = rgba[2] = rgba[3] = 0.f;
+                            for (int j = 0; j < 2; ++j)
+                                for (int i = 0; i < 2; ++i)
+                                {
+                                    target.texel(level - 1, x * 2 + i, y * 2 + j, sample);
+                                    for (int c = 0; c < 4; ++c)
+                                        rgba[c] += sample[c] * 0.25f;
+                                }
+                        }
+                        target.encode(rgba, tile + (static_cast<qint64>(py) * page + px) * bpt);
+                    }
+                }
+            }
+    }
+
+    target.m_file.unmap(target.m_data);
+    target.m_data = nullptr;
+    target.m_file.close();
+
+    qDebug() << "Converted" << source.width() << "x" << source.height() << "texels into"
+        << target.m_firstTiles.last() << "tiles of" << targetFilePath;
+
+    return true;
+}
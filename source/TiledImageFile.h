@@ -0,0 +1,162 @@
+#pragma once
+
+#include <QFile>
+#include <QList>
+#include <QString>
+
+class QImage;
+
+/** Memory mapped, tiled mip-pyramid image container (e.g., for streaming
+    height fields or large textures that do not fit into memory).
+
+    The file starts with a Header, followed by all tiles of level 0 (row by
+    row), then all tiles of level 1, and so on, up to the coarsest level that
+    fits into a single tile. Every tile stores tileSize^2 texels plus a border
+    of duplicated neighbor texels on each side, so tiles can be filtered
+    linearly on their own (pageSize = tileSize + 2 * border). All tiles have
+    the same byte size and are stored uncompressed, so a tile's offset is
+    computed rather than looked up, and a tile can be handed to
+    glTexSubImage as it is. Level l + 1 is the 2x2 box filtered level l.
+
+    Opening a file maps it read only; the OS pages tiles in on access, so
+    memory usage is bound by what is actually touched.
+*/
+class TiledImageFile
+{
+public:
+    enum Format
+    {
+        R16     = 0 ///< unsigned normalized 16bit, e.g., heights
+    ,   R32F    = 1
+    ,   RGBA8   = 2
+    };
+
+    struct Header
+    {
+        char    magic[4];   ///< "TIMF"
+        quint32 version;
+        quint32 format;
+        quint32 width;      ///< of level 0
+        quint32 height;
+        quint32 tileSize;   ///< payload texels per side
+        quint32 border;
+        quint32 levels;
+        quint64 dataOffset; ///< of the first tile
+    };
+
+    static const quint32 Version = 1;
+
+public:
+    TiledImageFile();
+    virtual ~TiledImageFile();
+
+    bool open(const QString & filePath);
+    void close();
+
+    bool isOpen() const;
+    const QString & filePath() const;
+
+    Format format() const;
+    int width(int level = 0) const;
+    int height(int level = 0) const;
+    int levels() const;
+
+    int tileSize() const;
+    int border() const;
+    int pageSize() const;
+
+    int tilesX(int level) const;
+    int tilesY(int level) const;
+
+    int bytesPerTexel() const;
+    qint64 tileBytes() const;
+
+    /** Pointer into the mapped file (pageSize^2 texels, row by row). Reading
+        it might block on I/O, thus it should be copied by a worker thread.
+    */
+    const uchar * tile(
+        int level
+    ,   int x
+    ,   int y) const;
+
+    /** Decoded texel of level (x and y clamped), first channel only.
+    */
+    float texel(
+        int level
+    ,   int x
+    ,   int y) const;
+
+    static int bytesPerTexel(Format format);
+
+    /** Converts an image (first channel for R16 and R32F) into a tiled file.
+    */
+    static bool convert(
+        const QImage & image
+    ,   const QString & targetFilePath
+    ,   Format format
+    ,   int tileSize = 256
+    ,   int border = 1);
+
+    /** Converts a raw single channel file (16bit unsigned or 32bit float by
+        extension .r16 or .r32, little endian) into a tiled file. The source
+        is mapped too, so the conversion does not need to fit into memory.
+    */
+    static bool convertRaw(
+        const QString & sourceFilePath
+    ,   int width
+    ,   int height
+    ,   const QString & targetFilePath
+    ,   Format format
+    ,   int tileSize = 256
+    ,   int border = 1);
+
+protected:
+    class Source
+    {
+    public:
+        virtual ~Source() { }
+        virtual int width() const = 0;
+        virtual int height() const = 0;
+        virtual void read(int x, int y, float * rgba) const = 0;
+    };
+
+    class ImageSource;
+    class RawSource;
+
+    static bool convert(
+        const Source & source
+    ,   const QString & targetFilePath
+    ,   Format format
+    ,   int tileSize
+    ,   int border);
+
+    qint64 tileOffset(
+        int level
+    ,   int x
+    ,   int y) const;
+
+    void encode(const float * rgba, uchar * texel) const;
+    void decode(const uchar * texel, float * rgba) const;
+
+    /** decoded texel of the given level, reading from the mapped tiles
+    */
+    void texel(
+        int level
+    ,   int x
+    ,   int y
+    ,   float * rgba) const;
+
+    void setup(const Header & header);
+
+protected:
+    QString m_filePath;
+    QFile m_file;
+
+    uchar * m_data; ///< writable only while converting
+
+    Header m_header;
+
+    QList<int> m_widths;
+    QList<int> m_heights;
+    QList<qint64> m_firstTiles; ///< index of each level's first tile
+};
@@ -25,6 +25,7 @@ namespace
     const QString SETTINGS_STATE    ("State");
     
     const QString SETTINGS_ADAPTIVE_GRID("ShowAdaptiveGrid");
+    const QString SETTINGS_DYNAMIC_RESOLUTION("DynamicResolution");
 }
 
 Viewer::Viewer(
@@ -40,6 +41,7 @@ Viewer::Viewer(
 , m_fullscreenShortcut(nullptr)
 , m_swapIntervalShortcut(nullptr)
 , m_adaptiveGridShortcut(nullptr)
+, m_dynamicResolutionShortcut(nullptr)
 {
     m_ui->setupUi(this);
     setWindowTitle(Application::title());
@@ -83,6 +85,10 @@ void Viewer::restore()
     bool enable = s.value(SETTINGS_ADAPTIVE_GRID, true).toBool();
     m_canvas->setAdaptiveGrid(enable);
     m_ui->showAdaptiveGridAction->setChecked(enable);
+
+    enable = s.value(SETTINGS_DYNAMIC_RESOLUTION, true).toBool();
+    m_canvas->setDynamicResolution(enable);
+    m_ui->dynamicResolutionAction->setChecked(m_canvas->dynamicResolution());
 }
 
 void Viewer::store()
@@ -93,6 +99,7 @@ void Viewer::store()
 
     assert(m_canvas);
     s.setValue(SETTINGS_ADAPTIVE_GRID, m_canvas->adaptiveGrid());
+    s.setValue(SETTINGS_DYNAMIC_RESOLUTION, m_canvas->dynamicResolution());
 }
 
 void Viewer::setup()
@@ -109,6 +116,9 @@ void Viewer::setup()
     m_adaptiveGridShortcut.reset(new QShortcut(m_ui->showAdaptiveGridAction->shortcut(), this));
     connect(m_adaptiveGridShortcut.data(), &QShortcut::activated, this, &Viewer::toggleAdaptiveGrid);
 
+    m_dynamicResolutionShortcut.reset(new QShortcut(m_ui->dynamicResolutionAction->shortcut(), this));
+    connect(m_dynamicResolutionShortcut.data(), &QShortcut::activated, this, &Viewer::toggleDynamicResolution);
+
     m_toggleTimeShortcut.reset(new QShortcut(m_ui->toggleTimeAction->shortcut(), this));
     connect(m_toggleTimeShortcut.data(), &QShortcut::activated, this, &Viewer::toggleTime);
 
@@ -201,6 +211,7 @@ void Viewer::updateAfterFullScreenToggle()
     m_fullscreenShortcut->setEnabled(isFullScreen());
     m_swapIntervalShortcut->setEnabled(isFullScreen());
     m_adaptiveGridShortcut->setEnabled(isFullScreen());
+    m_dynamicResolutionShortcut->setEnabled(isFullScreen());
     m_toggleTimeShortcut->setEnabled(isFullScreen());
 }
 
@@ -227,6 +238,19 @@ void Viewer::toggleAdaptiveGrid()
     m_canvas->setAdaptiveGrid(!m_canvas->adaptiveGrid());
 }
 
+void Viewer::on_dynamicResolutionAction_triggered(bool checked)
+{
+    assert(m_canvas);
+    m_canvas->setDynamicResolution(checked);
+}
+
+void Viewer::toggleDynamicResolution()
+{
+    assert(m_canvas);
+    m_canvas->setDynamicResolution(!m_canvas->dynamicResolution());
+    m_ui->dynamicResolutionAction->setChecked(m_canvas->dynamicResolution());
+}
+
 void Viewer::on_toggleTimeAction_triggered(bool checked)
 {
     toggleTime();
@@ -41,6 +41,8 @@ protected slots:
     void toggleSwapInterval();
     void on_showAdaptiveGridAction_triggered(bool checked);
     void toggleAdaptiveGrid();
+    void on_dynamicResolutionAction_triggered(bool checked);
+    void toggleDynamicResolution();
     void on_toggleTimeAction_triggered(bool checked);
     void toggleTime();
 
@@ -72,5 +74,6 @@ protected:
     QScopedPointer<QShortcut> m_fullscreenShortcut;
     QScopedPointer<QShortcut> m_swapIntervalShortcut;
     QScopedPointer<QShortcut> m_adaptiveGridShortcut;
+    QScopedPointer<QShortcut> m_dynamicResolutionShortcut;
     QScopedPointer<QShortcut> m_toggleTimeShortcut;
 };
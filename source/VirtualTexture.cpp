@@ -0,0 +1,512 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include <QDebug>
+#include <QOpenGLShaderProgram>
+#include <QPair>
+#include <QSet>
+#include <QVector2D>
+
+#include "VirtualTexture.h"
+
+
+namespace
+{
+    // the loader works on only a few tiles ahead, the rest is requested again
+    const int MaxRequests = 16;
+}
+
+
+VirtualTexture::VirtualTexture(
+    OpenGLFunctions & gl
+,   const int pagesPerSide
+,   const int feedbackScale)
+: m_gl(gl)
+, m_loader(nullptr)
+, m_pagesPerSide(pagesPerSide)
+, m_feedbackScale(qMax(1, feedbackScale))
+, m_pages(0)
+, m_table(0)
+, m_tableSize(0)
+, m_feedbackFBO(0)
+, m_feedbackColor(0)
+, m_feedbackDepth(0)
+, m_pushFramebuffer(0)
+, m_pbo(QOpenGLBuffer::PixelPackBuffer)
+, m_pending(false)
+, m_frame(0)
+, m_tableDirty(false)
+{
+    m_pbo.create();
+    m_pbo.setUsagePattern(QOpenGLBuffer::StreamRead);
+}
+
+VirtualTexture::~VirtualTexture()
+{
+    if (m_loader)
+    {
+        m_loader->stop();
+        delete m_loader;
+    }
+
+    m_pbo.destroy();
+
+    if (m_pages)
+        m_gl.glDeleteTextures(1, &m_pages);
+    if (m_table)
+        m_gl.glDeleteTextures(1, &m_table);
+
+    if (m_feedbackFBO)
+        m_gl.glDeleteFramebuffers(1, &m_feedbackFBO);
+    if (m_feedbackColor)
+        m_gl.glDeleteTextures(1, &m_feedbackColor);
+    if (m_feedbackDepth)
+        m_gl.glDeleteRenderbuffers(1, &m_feedbackDepth);
+}
+
+bool VirtualTexture::open(const QString & filePath)
+{
+    assert(!m_loader);
+
+    if (!m_file.open(filePath))
+        return false;
+
+    if (TiledImageFile::RGBA8 != m_file.format())
+    {
+        qWarning() << filePath << "is no RGBA8 tiled file, thus it cannot be used as virtual texture.";
+        m_file.close();
+        return false;
+    }
+
+    // the physical cache has to fit into a single texture, and the page
+    // table refers to pages by 8bit coordinates
+
+    GLint maxSize(0);
+    m_gl.glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    m_pagesPerSide = qBound(1, qMin(m_pagesPerSide, maxSize / m_file.pageSize()), 255);
+
+    // the coarsest level needs to fit, since it stays resident
+    const int coarsest(m_file.tilesX(m_file.levels() - 1) * m_file.tilesY(m_file.levels() - 1));
+    if (coarsest >= m_pagesPerSide * m_pagesPerSide)
+    {
+        qWarning() << "The virtual texture's cache is too small for" << filePath;
+        m_file.close();
+        return false;
+    }
+
+    m_gl.glGenTextures(1, &m_pages);
+    m_gl.glBindTexture(GL_TEXTURE_2D, m_pages);
+
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    const int size(m_pagesPerSide * m_file.pageSize());
+    m_gl.glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    // The page table's levels match the file's levels: level 0 is padded to a
+    // power of two, so that halving it yields at least the tiles of the next.
+
+    m_tableSize = 1;
+    while (m_tableSize < qMax(m_file.tilesX(0), m_file.tilesY(0)))
+        m_tableSize <<= 1;
+
+    m_gl.glGenTextures(1, &m_table);
+    m_gl.glBindTexture(GL_TEXTURE_2D, m_table);
+
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    m_gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_file.levels() - 1);
+
+    for (int level = 0; level < m_file.levels(); ++level)
+    {
+        const int levelSize(qMax(1, m_tableSize >> level));
+        m_gl.glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, levelSize, levelSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+    m_gl.glBindTexture(GL_TEXTURE_2D, 0);
+
+    m_tableDirty = true;
+
+    m_loader = new TileLoader(m_file);
+    m_loader->start();
+
+    qDebug() << "Virtual texture" << m_file.width() << "x" << m_file.height() << filePath
+        << "with" << m_pagesPerSide * m_pagesPerSide << "cached pages.";
+
+    return true;
+}
+
+bool VirtualTexture::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+const TiledImageFile & VirtualTexture::file() const
+{
+    return m_file;
+}
+
+int VirtualTexture::resident() const
+{
+    return m_resident.size();
+}
+
+void VirtualTexture::beginFeedback(OpenGLFunctions & gl)
+{
+    gl.glGetIntegerv(GL_FRAMEBUFFER_BINDING, &m_pushFramebuffer);
+    gl.glGetIntegerv(GL_VIEWPORT, m_pushViewport);
+    gl.glGetFloatv(GL_COLOR_CLEAR_VALUE, m_pushClearColor);
+
+    const QSize size(qMax(1, m_pushViewport[2] / m_feedbackScale), qMax(1, m_pushViewport[3] / m_feedbackScale));
+
+    if (size != m_feedbackSize)
+    {
+        m_feedbackSize = size;
+
+        if (!m_feedbackFBO)
+        {
+            gl.glGenFramebuffers(1, &m_feedbackFBO);
+            gl.glGenTextures(1, &m_feedbackColor);
+            gl.glGenRenderbuffers(1, &m_feedbackDepth);
+        }
+
+        // tile coordinates exceed 8bit, thus the feedback is stored as float
+
+        gl.glBindTexture(GL_TEXTURE_2D, m_feedbackColor);
+        gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        gl.glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, size.width(), size.height(), 0, GL_RGBA, GL_FLOAT, nullptr);
+        gl.glBindTexture(GL_TEXTURE_2D, 0);
+
+        gl.glBindRenderbuffer(GL_RENDERBUFFER, m_feedbackDepth);
+        gl.glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size.width(), size.height());
+        gl.glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        gl.glBindFramebuffer(GL_FRAMEBUFFER, m_feedbackFBO);
+        gl.glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_feedbackColor, 0);
+        gl.glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_feedbackDepth);
+
+        if (GL_FRAMEBUFFER_COMPLETE != gl.glCheckFramebufferStatus(GL_FRAMEBUFFER))
+            qWarning() << "The virtual texture's feedback framebuffer is incomplete.";
+    }
+
+    gl.glBindFramebuffer(GL_FRAMEBUFFER, m_feedbackFBO);
+    gl.glViewport(0, 0, size.width(), size.height());
+
+    // alpha is 0 where no tile is required
+    gl.glClearColor(0.f, 0.f, 0.f, 0.f);
+    gl.glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void VirtualTexture::endFeedback(OpenGLFunctions & gl)
+{
+    m_pbo.bind();
+
+    const int bytes(m_feedbackSize.width() * m_feedbackSize.height() * 4 * static_cast<int>(sizeof(float)));
+    if (m_pbo.size() != bytes)
+        m_pbo.allocate(bytes);
+
+    // with a pixel pack buffer bound, this returns immediately and the
+    // transfer completes asynchronously (mapped in the next update)
+    gl.glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    gl.glReadPixels(0, 0, m_feedbackSize.width(), m_feedbackSize.height(), GL_RGBA, GL_FLOAT, nullptr);
+
+    m_pbo.release();
+    m_pending = true;
+
+    gl.glBindFramebuffer(GL_FRAMEBUFFER, m_pushFramebuffer);
+    gl.glViewport(m_pushViewport[0], m_pushViewport[1], m_pushViewport[2], m_pushViewport[3]);
+    gl.glClearColor(m_pushClearColor[0], m_pushClearColor[1], m_pushClearColor[2], m_pushClearColor[3]);
+}
+
+void VirtualTexture::update(
+    OpenGLFunctions & gl
+,   const int maxUploads)
+{
+    if (!isOpen())
+        return;
+
+    ++m_frame;
+
+    readFeedback();
+    requestTiles();
+    uploadTiles(gl, maxUploads);
+
+    if (m_tableDirty)
+        updateTable(gl);
+}
+
+void VirtualTexture::readFeedback()
+{
+    // without new feedback, the previous requests are kept
+    if (!m_pending)
+        return;
+
+    m_pending = false;
+
+    m_pbo.bind();
+    const float * texels(reinterpret_cast<const float *>(m_pbo.map(QOpenGLBuffer::ReadOnly)));
+
+    if (!texels)
+    {
+        m_pbo.release();
+        return;
+    }
+
+    m_feedback.clear();
+
+    const int levels(m_file.levels());
+    const int count(m_feedbackSize.width() * m_feedbackSize.height());
+
+    for (int i = 0; i < count; ++i)
+    {
+        const float * texel(&texels[i * 4]);
+        if (texel[3] <= 0.f)
+            continue;
+
+        Key key;
+        key.level = qBound(0, static_cast<int>(texel[2] + 0.5f), levels - 1);
+        key.x = qBound(0, static_cast<int>(texel[0] + 0.5f), m_file.tilesX(key.level) - 1);
+        key.y = qBound(0, static_cast<int>(texel[1] + 0.5f), m_file.tilesY(key.level) - 1);
+
+        const quint64 h(TileLoader::hash(key));
+        if (m_feedback.contains(h))
+            ++m_feedback[h].fragments;
+        else
+        {
+            Request request;
+            request.key = key;
+            request.fragments = 1;
+            m_feedback[h] = request;
+        }
+    }
+
+    m_pbo.unmap();
+    m_pbo.release();
+}
+
+void VirtualTexture::requestTiles()
+{
+    // Each required tile brings its parents along (they are the fallback
+    // until it is resident). The priority prefers coarse levels, then tiles
+    // covering many fragments. The coarsest level is required entirely.
+
+    QList<QPair<float, Key> > required;
+    QSet<quint64> collected;
+
+    const int levels(m_file.levels());
+    const int coarsest(levels - 1);
+
+    for (int y = 0; y < m_file.tilesY(coarsest); ++y)
+        for (int x = 0; x < m_file.tilesX(coarsest); ++x)
+        {
+            Key key;
+            key.level = coarsest;
+            key.x = x;
+            key.y = y;
+
+            collected.insert(TileLoader::hash(key));
+            required << qMakePair(0.f, key);
+        }
+
+    foreach (const Request & request, m_feedback)
+    {
+        Key key(request.key);
+        for (; key.level < coarsest; ++key.level, key.x >>= 1, key.y >>= 1)
+        {
+            const quint64 h(TileLoader::hash(key));
+            if (collected.contains(h))
+                break;
+
+            collected.insert(h);
+            required << qMakePair(coarsest - key.level + 1.f / (1.f + request.fragments), key);
+        }
+    }
+
+    std::stable_sort(required.begin(), required.end()
+        , [](const QPair<float, Key> & a, const QPair<float, Key> & b) { return a.first < b.first; });
+
+    // no more tiles than the cache holds are required
+
+    m_required.clear();
+    QList<Key> missing;
+
+    const int pages(m_pagesPerSide * m_pagesPerSide);
+    for (int i = 0; i < required.size() && i < pages; ++i)
+    {
+        const quint64 h(TileLoader::hash(required[i].second));
+        m_required[h] = required[i].first;
+
+        if (m_resident.contains(h))
+            m_cache[m_resident[h]].lastUsed = m_frame;
+        else if (missing.size() < MaxRequests)
+            missing << required[i].second;
+    }
+
+    m_loader->request(missing);
+}
+
+int VirtualTexture::allocatePage()
+{
+    if (m_cache.size() < m_pagesPerSide * m_pagesPerSide)
+    {
+        m_cache << Page();
+        return m_cache.size() - 1;
+    }
+
+    // reuse the least recently required page that is not required now
+
+    int evict(-1);
+    for (int i = 0; i < m_cache.size(); ++i)
+    {
+        if (m_required.contains(TileLoader::hash(m_cache[i].key)))
+            continue;
+
+        if (evict < 0 || m_cache[i].lastUsed < m_cache[evict].lastUsed)
+            evict = i;
+    }
+
+    if (evict >= 0)
+    {
+        m_resident.remove(TileLoader::hash(m_cache[evict].key));
+        m_tableDirty = true;
+    }
+    return evict;
+}
+
+void VirtualTexture::uploadTiles(
+    OpenGLFunctions & gl
+,   const int maxUploads)
+{
+    m_uploads << m_loader->take();
+    if (m_uploads.isEmpty())
+        return;
+
+    const int pageSize(m_file.pageSize());
+
+    gl.glBindTexture(GL_TEXTURE_2D, m_pages);
+
+    int uploads(0);
+    while (!m_uploads.isEmpty() && uploads < maxUploads)
+    {
+        const Loaded tile(m_uploads.takeFirst());
+        const quint64 h(TileLoader::hash(tile.key));
+
+        // no longer required or requested twice
+        if (!m_required.contains(h) || m_resident.contains(h))
+            continue;
+
+        const int page(allocatePage());
+        if (page < 0)
+            break;
+
+        gl.glTexSubImage2D(GL_TEXTURE_2D, 0, (page % m_pagesPerSide) * pageSize, (page / m_pagesPerSide) * pageSize
+            , pageSize, pageSize, GL_RGBA, GL_UNSIGNED_BYTE, tile.data.constData());
+
+        m_cache[page].key = tile.key;
+        m_cache[page].lastUsed = m_frame;
+        m_resident[h] = page;
+
+        m_tableDirty = true;
+        ++uploads;
+    }
+
+    gl.glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void VirtualTexture::updateTable(OpenGLFunctions & gl)
+{
+    // Levels are written coarse to fine: a cell refers to its own tile if
+    // resident, and to its parent cell's entry otherwise.
+
+    const int levels(m_file.levels());
+
+    std::vector<uchar> parent;
+    std::vector<uchar> entries;
+
+    gl.glBindTexture(GL_TEXTURE_2D, m_table);
+
+    for (int level = levels - 1; level >= 0; --level)
+    {
+        const int size(qMax(1, m_tableSize >> level));
+        const int parentSize(qMax(1, m_tableSize >> (level + 1)));
+
+        entries.assign(size * size * 4, 0);
+
+        Key key;
+        key.level = level;
+
+        for (key.y = 0; key.y < m_file.tilesY(level); ++key.y)
+            for (key.x = 0; key.x < m_file.tilesX(level); ++key.x)
+            {
+                uchar * entry(&entries[(key.y * size + key.x) * 4]);
+
+                const quint64 h(TileLoader::hash(key));
+                if (m_resident.contains(h))
+                {
+                    const int page(m_resident[h]);
+                    entry[0] = static_cast<uchar>(page % m_pagesPerSide);
+                    entry[1] = static_cast<uchar>(page / m_pagesPerSide);
+                    entry[2] = static_cast<uchar>(level);
+                    entry[3] = 255;
+                }
+                else if (level < levels - 1)
+                    memcpy(entry, &parent[((key.y >> 1) * parentSize + (key.x >> 1)) * 4], 4);
+            }
+
+        gl.glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, entries.data());
+        parent.swap(entries);
+    }
+
+    gl.glBindTexture(GL_TEXTURE_2D, 0);
+
+    m_tableDirty = false;
+}
+
+void VirtualTexture::bind(
+    OpenGLFunctions & gl
+,   const GLenum pagesUnit
+,   const GLenum tableUnit)
+{
+    gl.glActiveTexture(pagesUnit);
+    gl.glBindTexture(GL_TEXTURE_2D, m_pages);
+
+    gl.glActiveTexture(tableUnit);
+    gl.glBindTexture(GL_TEXTURE_2D, m_table);
+}
+
+void VirtualTexture::release(
+    OpenGLFunctions & gl
+,   const GLenum pagesUnit
+,   const GLenum tableUnit)
+{
+    gl.glActiveTexture(tableUnit);
+    gl.glBindTexture(GL_TEXTURE_2D, 0);
+
+    gl.glActiveTexture(pagesUnit);
+    gl.glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void VirtualTexture::setUniforms(
+    QOpenGLShaderProgram & program
+,   const int pagesUnit
+,   const int tableUnit) const
+{
+    program.setUniformValue("virtualPages", pagesUnit);
+    program.setUniformValue("virtualTable", tableUnit);
+
+    program.setUniformValue("virtualSize"
+        , QVector2D(static_cast<float>(m_file.width()), static_cast<float>(m_file.height())));
+    program.setUniformValue("virtualTileSize"
+        , QVector2D(static_cast<float>(m_file.tileSize()), static_cast<float>(m_file.pageSize())));
+    program.setUniformValue("virtualPagesPerSide", static_cast<float>(m_pagesPerSide));
+    program.setUniformValue("virtualLevels", static_cast<float>(m_file.levels()));
+
+    // the feedback's derivatives are feedbackScale times larger
+    program.setUniformValue("virtualFeedbackBias", -std::log(static_cast<float>(m_feedbackScale)) / std::log(2.f));
+}
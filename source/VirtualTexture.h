@@ -0,0 +1,143 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QOpenGLBuffer>
+#include <QSize>
+
+#include <vector>
+
+#include "OpenGLFunctions.h"
+#include "TiledImageFile.h"
+#include "TileLoader.h"
+
+class QOpenGLShaderProgram;
+
+/** Virtual texture for (RGBA8) TiledImageFile textures of arbitrary size,
+    using a fixed amount of VRAM.
+
+    The physical cache is a single 2D texture holding pagesPerSide^2 pages
+    (tile plus border each). The page table is a mipmapped texture with one
+    texel per tile of the corresponding level, referring to the page of the
+    finest resident tile covering it (page x, page y, level). See
+    virtualTexture in data/terrain_virtual.frag.
+
+    Which tiles are needed is decided by the GPU: a feedback pass renders the
+    geometry at a fraction of the viewport, writing the tile and level each
+    fragment would sample (data/virtual_feedback.frag). The result is read
+    back asynchronously and evaluated with the next update, where missing
+    tiles (and their parents) are requested from a loader thread, coarse
+    first, and uploaded with a bounded number of glTexSubImage2D calls per
+    frame. The coarsest tiles stay resident as fallback, and the least
+    recently required pages are reused first.
+*/
+class VirtualTexture
+{
+public:
+    VirtualTexture(
+        OpenGLFunctions & gl
+    ,   int pagesPerSide = 16
+    ,   int feedbackScale = 8);
+    virtual ~VirtualTexture();
+
+    bool open(const QString & filePath);
+    bool isOpen() const;
+
+    const TiledImageFile & file() const;
+
+    /** Binds (and if required resizes) the feedback framebuffer for the
+        currently set viewport and clears it; the feedback program should be
+        used for drawing until endFeedback.
+    */
+    void beginFeedback(OpenGLFunctions & gl);
+
+    /** starts reading back the feedback and restores framebuffer and viewport
+    */
+    void endFeedback(OpenGLFunctions & gl);
+
+    /** evaluates the last feedback, requests and uploads tiles
+    */
+    void update(
+        OpenGLFunctions & gl
+    ,   int maxUploads = 8);
+
+    void bind(
+        OpenGLFunctions & gl
+    ,   GLenum pagesUnit
+    ,   GLenum tableUnit);
+    void release(
+        OpenGLFunctions & gl
+    ,   GLenum pagesUnit
+    ,   GLenum tableUnit);
+
+    /** virtualPages, virtualTable, virtualSize, virtualTileSize,
+        virtualPagesPerSide, virtualLevels, and virtualFeedbackBias
+    */
+    void setUniforms(
+        QOpenGLShaderProgram & program
+    ,   int pagesUnit
+    ,   int tableUnit) const;
+
+    int resident() const;
+
+protected:
+    typedef TileLoader::Key Key;
+    typedef TileLoader::Loaded Loaded;
+
+    struct Page
+    {
+        Key key;
+        int lastUsed;
+    };
+
+    struct Request
+    {
+        Key key;
+        int fragments; ///< that sampled the tile in the last feedback
+    };
+
+    void readFeedback();
+    void requestTiles();
+    void uploadTiles(
+        OpenGLFunctions & gl
+    ,   int maxUploads);
+    int allocatePage();
+
+    void updateTable(OpenGLFunctions & gl);
+
+protected:
+    OpenGLFunctions & m_gl;
+
+    TiledImageFile m_file;
+    TileLoader * m_loader;
+
+    int m_pagesPerSide;
+    int m_feedbackScale;
+
+    GLuint m_pages;
+    GLuint m_table;
+    int m_tableSize; ///< of the table's level 0, a power of two
+
+    GLuint m_feedbackFBO;
+    GLuint m_feedbackColor;
+    GLuint m_feedbackDepth;
+    QSize m_feedbackSize;
+
+    GLint m_pushFramebuffer;
+    GLint m_pushViewport[4];
+    GLfloat m_pushClearColor[4];
+
+    QOpenGLBuffer m_pbo;
+    bool m_pending;
+
+    QHash<quint64, Request> m_feedback;
+
+    QList<Page> m_cache;              ///< per page
+    QHash<quint64, int> m_resident;   ///< key to page
+    QHash<quint64, float> m_required; ///< key to priority (lower first)
+
+    QList<Loaded> m_uploads;          ///< loaded, but not uploaded yet
+
+    int m_frame;
+    bool m_tableDirty;
+};
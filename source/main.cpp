@@ -1,16 +1,80 @@
 
+#include <QFileInfo>
+#include <QImage>
+#include <QStringList>
 #include <QSurfaceFormat>
 #include <QWidget>
 
 #include "Application.h"
+#include "TiledImageFile.h"
 #include "Viewer.h"
 
+namespace
+{
+    /** --convert-heightfield <source> <target> [<width> <height>]
+        converts an image or a raw height field (.r16, .r32, requires width
+        and height) into a tiled file for streaming (see TiledImageFile).
+    */
+    int convertHeightfield(const QStringList & arguments)
+    {
+        if (arguments.size() < 2)
+        {
+            qWarning("Usage: --convert-heightfield <source> <target> [<width> <height>]");
+            return 1;
+        }
+
+        const QString & source(arguments[0]);
+        const QString & target(arguments[1]);
+        const QString suffix(QFileInfo(source).suffix().toLower());
+
+        bool converted(false);
+
+        if ("r16" == suffix || "r32" == suffix)
+        {
+            if (arguments.size() < 4)
+            {
+                qWarning("Raw height fields require width and height.");
+                return 1;
+            }
+            converted = TiledImageFile::convertRaw(source, arguments[2].toInt(), arguments[3].toInt(), target
+                , "r16" == suffix ? TiledImageFile::R16 : TiledImageFile::R32F);
+        }
+        else
+            converted = TiledImageFile::convert(QImage(source), target, TiledImageFile::R16);
+
+        return converted ? 0 : 1;
+    }
+
+    /** --convert-texture <source> <target>
+        converts an image into a tiled RGBA8 file used as virtual texture
+        (see VirtualTexture).
+    */
+    int convertTexture(const QStringList & arguments)
+    {
+        if (arguments.size() < 2)
+        {
+            qWarning("Usage: --convert-texture <source> <target>");
+            return 1;
+        }
+        return TiledImageFile::convert(QImage(arguments[0]), arguments[1], TiledImageFile::RGBA8) ? 0 : 1;
+    }
+}
+
 int main(int argc, char * argv[])
 {
     int result = -1;
 
     Application app(argc, argv);
 
+    const QStringList arguments(app.arguments());
+    const int convert(arguments.indexOf("--convert-heightfield"));
+    if (convert > 0)
+        return convertHeightfield(arguments.mid(convert + 1));
+
+    const int convertToTexture(arguments.indexOf("--convert-texture"));
+    if (convertToTexture > 0)
+        return convertTexture(arguments.mid(convertToTexture + 1));
+
     QSurfaceFormat format;
 #ifdef NO_OPENGL_320
     format.setVersion(3, 0);